@@ -1,4 +1,7 @@
 #include "GCore/Components.h"
+
+#include <atomic>
+
 #include "global_stage.hpp"
 #include "stage/stage.hpp"
 
@@ -21,6 +24,12 @@ GeometryComponent::GeometryComponent(Geometry* attached_operand)
 #endif
 }
 
+uint64_t GeometryComponent::next_version()
+{
+    static std::atomic<uint64_t> counter{ 0 };
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
 Geometry* GeometryComponent::get_attached_operand() const
 {
     return attached_operand;
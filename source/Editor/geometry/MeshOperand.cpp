@@ -1,6 +1,12 @@
 #include "GCore/Components/MeshOperand.h"
 
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <set>
+
 #include "GCore/GOP.h"
+#include "GCore/algorithms/merge.h"
 #include "global_stage.hpp"
 #include "stage/stage.hpp"
 
@@ -91,6 +97,7 @@ GeometryComponentHandle MeshComponent::copy(Geometry* operand) const
     ret->set_face_vertex_indices(this->faceVertexIndices);
     ret->set_normals(this->normals);
     ret->set_display_color(this->displayColor);
+    ret->set_texcoords_array(this->texcoordsArray);
 #endif
     ret->set_vertex_scalar_quantities(this->vertex_scalar_quantities);
     ret->set_face_scalar_quantities(this->face_scalar_quantities);
@@ -102,6 +109,8 @@ GeometryComponentHandle MeshComponent::copy(Geometry* operand) const
         this->face_corner_parameterization_quantities);
     ret->set_vertex_parameterization_quantities(
         this->vertex_parameterization_quantities);
+    ret->topology_version_ = topology_version_;
+    ret->position_version_ = position_version_;
     return ret;
 }
 
@@ -118,45 +127,292 @@ pxr::UsdGeomMesh MeshComponent::get_usd_mesh() const
 }
 #endif
 
-void MeshComponent::append_mesh(const std::shared_ptr<MeshComponent>& mesh)
+namespace {
+
+// Layout of one input's per-element column relative to its topology.
+enum class Interpolation { Missing, Constant, Vertex, FaceVarying };
+
+Interpolation
+classify(size_t size, size_t vertex_count, size_t corner_count, bool allow_fv)
+{
+    if (size == 0) {
+        return Interpolation::Missing;
+    }
+    if (size == vertex_count) {
+        return Interpolation::Vertex;
+    }
+    if (allow_fv && size == corner_count) {
+        return Interpolation::FaceVarying;
+    }
+    if (size == 1) {
+        return Interpolation::Constant;
+    }
+    return Interpolation::Missing;
+}
+
+template<typename T>
+std::vector<const T*> pointers(const std::vector<T>& values)
+{
+    std::vector<const T*> ret(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ret[i] = &values[i];
+    }
+    return ret;
+}
+
+// Concatenates one column of every input into a presized array. Inputs whose
+// column is absent (nullptr) or has the wrong length are filled with `fill`.
+template<typename T>
+VtArray<T> concat_column(
+    const std::vector<const VtArray<T>*>& parts,
+    const std::vector<size_t>& offsets,
+    const T& fill)
+{
+    VtArray<T> out(offsets.back());
+    T* dst = out.data();
+    WorkParallelForN(parts.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t count = offsets[i + 1] - offsets[i];
+            if (parts[i] && parts[i]->size() == count) {
+                std::copy_n(parts[i]->cdata(), count, dst + offsets[i]);
+            }
+            else {
+                std::fill_n(dst + offsets[i], count, fill);
+            }
+        }
+    });
+    return out;
+}
+
+// Same as concat_column, over the union of the quantity names of all inputs.
+template<typename T>
+std::map<std::string, VtArray<T>> concat_quantities(
+    const std::vector<const std::map<std::string, VtArray<T>>*>& maps,
+    const std::vector<size_t>& offsets,
+    const T& fill)
+{
+    std::set<std::string> names;
+    for (const auto* map : maps) {
+        for (const auto& pair : *map) {
+            names.insert(pair.first);
+        }
+    }
+
+    std::map<std::string, VtArray<T>> ret;
+    for (const auto& name : names) {
+        std::vector<const VtArray<T>*> parts(maps.size(), nullptr);
+        for (size_t i = 0; i < maps.size(); ++i) {
+            auto it = maps[i]->find(name);
+            if (it != maps[i]->end()) {
+                parts[i] = &it->second;
+            }
+        }
+        ret[name] = concat_column(parts, offsets, fill);
+    }
+    return ret;
+}
 
+// Concatenates a primvar that may be vertex or face-varying per input. The
+// result is face-varying as soon as one input is, with vertex-interpolated
+// inputs expanded through their face vertex indices.
+template<typename T>
+VtArray<T> concat_primvar(
+    const std::vector<VtArray<T>>& values,
+    const std::vector<VtArray<int>>& indices,
+    const std::vector<size_t>& vertex_offsets,
+    const std::vector<size_t>& corner_offsets,
+    const T& fill,
+    bool allow_face_varying)
 {
-    auto this_vertices = get_vertices();
-    auto this_face_vertex_indices = get_face_vertex_indices();
+    const size_t n = values.size();
+    std::vector<Interpolation> interpolation(n);
+    bool any = false;
+    bool face_varying = false;
+    for (size_t i = 0; i < n; ++i) {
+        interpolation[i] = classify(
+            values[i].size(),
+            vertex_offsets[i + 1] - vertex_offsets[i],
+            corner_offsets[i + 1] - corner_offsets[i],
+            allow_face_varying);
+        any |= interpolation[i] != Interpolation::Missing;
+        face_varying |= interpolation[i] == Interpolation::FaceVarying;
+    }
+    if (!any) {
+        return {};
+    }
 
-    auto that_vertices = mesh->get_vertices();
+    const auto& offsets = face_varying ? corner_offsets : vertex_offsets;
+    VtArray<T> out(offsets.back());
+    T* dst = out.data();
+    WorkParallelForN(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            T* out_i = dst + offsets[i];
+            const size_t count = offsets[i + 1] - offsets[i];
+            const T* src = values[i].cdata();
+            switch (interpolation[i]) {
+                case Interpolation::Vertex:
+                    if (face_varying) {
+                        const int* index = indices[i].cdata();
+                        for (size_t k = 0; k < count; ++k) {
+                            out_i[k] = src[index[k]];
+                        }
+                    }
+                    else {
+                        std::copy_n(src, count, out_i);
+                    }
+                    break;
+                case Interpolation::FaceVarying:
+                    std::copy_n(src, count, out_i);
+                    break;
+                case Interpolation::Constant:
+                    std::fill_n(out_i, count, src[0]);
+                    break;
+                default: std::fill_n(out_i, count, fill); break;
+            }
+        }
+    });
+    return out;
+}
 
-    auto that_face_vertex_indices = mesh->get_face_vertex_indices();
+}  // namespace
 
-    int this_index_offset = this_vertices.size();
+void MeshComponent::append_mesh(const std::shared_ptr<MeshComponent>& mesh)
+{
+    append_meshes({ mesh });
+}
 
-    this_vertices.resize(this_vertices.size() + that_vertices.size());
-    memcpy(
-        this_vertices.data() + this_index_offset,
-        that_vertices.data(),
-        that_vertices.size() * sizeof(pxr::GfVec3f));
+void MeshComponent::append_meshes(
+    const std::vector<std::shared_ptr<MeshComponent>>& meshes)
+{
+    std::vector<const MeshComponent*> parts{ this };
+    for (const auto& mesh : meshes) {
+        if (mesh) {
+            parts.push_back(mesh.get());
+        }
+    }
+    if (parts.size() == 1) {
+        return;
+    }
 
-    // Append face vertex indices
-    for (auto& index : that_face_vertex_indices) {
-        this_face_vertex_indices.push_back(index + this_index_offset);
+    // Gather every column and compute the final sizes before allocating.
+    const size_t n = parts.size();
+    std::vector<VtArray<GfVec3f>> vertices(n), normals(n), colors(n);
+    std::vector<VtArray<GfVec2f>> texcoords(n);
+    std::vector<VtArray<int>> counts(n), indices(n);
+    std::vector<size_t> vertex_offsets(n + 1, 0);
+    std::vector<size_t> face_offsets(n + 1, 0);
+    std::vector<size_t> corner_offsets(n + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        vertices[i] = parts[i]->get_vertices();
+        normals[i] = parts[i]->get_normals();
+        colors[i] = parts[i]->get_display_color();
+        texcoords[i] = parts[i]->get_texcoords_array();
+        counts[i] = parts[i]->get_face_vertex_counts();
+        indices[i] = parts[i]->get_face_vertex_indices();
+        vertex_offsets[i + 1] = vertex_offsets[i] + vertices[i].size();
+        face_offsets[i + 1] = face_offsets[i] + counts[i].size();
+        corner_offsets[i + 1] = corner_offsets[i] + indices[i].size();
     }
 
-    set_vertices(this_vertices);
-    set_face_vertex_indices(this_face_vertex_indices);
+    auto merged_vertices =
+        concat_column(pointers(vertices), vertex_offsets, GfVec3f(0.0f));
+    auto merged_counts = concat_column(pointers(counts), face_offsets, 0);
 
-    auto this_vertex_counts = get_face_vertex_counts();
-    auto this_vertex_counts_size = this_vertex_counts.size();
-    auto that_vertex_counts = mesh->get_face_vertex_counts();
+    VtArray<int> merged_indices(corner_offsets.back());
+    int* index_dst = merged_indices.data();
+    WorkParallelForN(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            offset_indices(
+                indices[i].cdata(),
+                index_dst + corner_offsets[i],
+                indices[i].size(),
+                static_cast<int>(vertex_offsets[i]));
+        }
+    });
+
+    auto merged_normals = concat_primvar(
+        normals,
+        indices,
+        vertex_offsets,
+        corner_offsets,
+        GfVec3f(0.0f),
+        true);
+    auto merged_texcoords = concat_primvar(
+        texcoords,
+        indices,
+        vertex_offsets,
+        corner_offsets,
+        GfVec2f(0.0f),
+        true);
+    // Display color is always written with vertex interpolation.
+    auto merged_colors = concat_primvar(
+        colors,
+        indices,
+        vertex_offsets,
+        corner_offsets,
+        GfVec3f(0.5f),
+        false);
 
-    this_vertex_counts.resize(
-        this_vertex_counts.size() + that_vertex_counts.size());
+    auto collect = [&](auto member) {
+        using Map = std::remove_cvref_t<decltype(this->*member)>;
+        std::vector<const Map*> maps(n);
+        for (size_t i = 0; i < n; ++i) {
+            maps[i] = &(parts[i]->*member);
+        }
+        return maps;
+    };
 
-    memcpy(
-        this_vertex_counts.data() + this_vertex_counts_size,
-        that_vertex_counts.data(),
-        that_vertex_counts.size() * sizeof(int));
+    auto vertex_scalar = concat_quantities(
+        collect(&MeshComponent::vertex_scalar_quantities),
+        vertex_offsets,
+        0.0f);
+    auto face_scalar = concat_quantities(
+        collect(&MeshComponent::face_scalar_quantities), face_offsets, 0.0f);
+    auto vertex_color = concat_quantities(
+        collect(&MeshComponent::vertex_color_quantities),
+        vertex_offsets,
+        GfVec3f(0.0f));
+    auto face_color = concat_quantities(
+        collect(&MeshComponent::face_color_quantities),
+        face_offsets,
+        GfVec3f(0.0f));
+    auto vertex_vector = concat_quantities(
+        collect(&MeshComponent::vertex_vector_quantities),
+        vertex_offsets,
+        GfVec3f(0.0f));
+    auto face_vector = concat_quantities(
+        collect(&MeshComponent::face_vector_quantities),
+        face_offsets,
+        GfVec3f(0.0f));
+    auto face_corner_parameterization = concat_quantities(
+        collect(&MeshComponent::face_corner_parameterization_quantities),
+        corner_offsets,
+        GfVec2f(0.0f));
+    auto vertex_parameterization = concat_quantities(
+        collect(&MeshComponent::vertex_parameterization_quantities),
+        vertex_offsets,
+        GfVec2f(0.0f));
 
-    set_face_vertex_counts(this_vertex_counts);
+    set_vertices(merged_vertices);
+    set_face_vertex_counts(merged_counts);
+    set_face_vertex_indices(merged_indices);
+    if (!merged_normals.empty()) {
+        set_normals(merged_normals);
+    }
+    if (!merged_texcoords.empty()) {
+        set_texcoords_array(merged_texcoords);
+    }
+    if (!merged_colors.empty()) {
+        set_display_color(merged_colors);
+    }
+    set_vertex_scalar_quantities(vertex_scalar);
+    set_face_scalar_quantities(face_scalar);
+    set_vertex_color_quantities(vertex_color);
+    set_face_color_quantities(face_color);
+    set_vertex_vector_quantities(vertex_vector);
+    set_face_vector_quantities(face_vector);
+    set_face_corner_parameterization_quantities(face_corner_parameterization);
+    set_vertex_parameterization_quantities(vertex_parameterization);
 }
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -42,6 +42,7 @@ GeometryComponentHandle PointsComponent::copy(Geometry* operand) const
     ret->set_display_color(this->get_display_color());
     ret->set_width(this->get_width());
 #endif
+    ret->position_version_ = position_version_;
 
     return ret;
 }
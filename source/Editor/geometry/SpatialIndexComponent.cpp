@@ -0,0 +1,106 @@
+#include "GCore/Components/SpatialIndexComponent.h"
+
+#include <sstream>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/Components/PointsComponent.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+SpatialIndexComponent::SpatialIndexComponent(Geometry* attached_operand)
+    : GeometryComponent(attached_operand)
+{
+}
+
+std::string SpatialIndexComponent::to_string() const
+{
+    std::ostringstream out;
+    out << "Spatial index component. "
+        << "BVH triangles " << (bvh_ ? bvh_->triangle_count() : 0)
+        << ". k-d tree points " << (point_tree_ ? point_tree_->size() : 0)
+        << ".";
+    return out.str();
+}
+
+GeometryComponentHandle SpatialIndexComponent::copy(Geometry* operand) const
+{
+    auto ret = std::make_shared<SpatialIndexComponent>(operand);
+    std::lock_guard lock(mutex_);
+    ret->bvh_ = bvh_;
+    ret->bvh_topology_version_ = bvh_topology_version_;
+    ret->bvh_position_version_ = bvh_position_version_;
+    ret->point_tree_ = point_tree_;
+    ret->point_tree_version_ = point_tree_version_;
+    return ret;
+}
+
+std::shared_ptr<const TriangleBVH> SpatialIndexComponent::triangle_bvh(
+    const MeshComponent& mesh)
+{
+    std::lock_guard lock(mutex_);
+    const uint64_t topology = mesh.topology_version();
+    const uint64_t position = mesh.position_version();
+    if (bvh_ && bvh_topology_version_ == topology &&
+        bvh_position_version_ == position) {
+        return bvh_;
+    }
+
+    // Structures already handed out stay untouched; a refit works on a copy.
+    std::shared_ptr<TriangleBVH> bvh;
+    if (bvh_ && bvh_topology_version_ == topology) {
+        bvh = std::make_shared<TriangleBVH>(*bvh_);
+        bvh->refit(mesh.get_vertices());
+    }
+    else {
+        bvh = std::make_shared<TriangleBVH>();
+        if (!bvh->build(
+                mesh.get_vertices(),
+                mesh.get_face_vertex_counts(),
+                mesh.get_face_vertex_indices())) {
+            return nullptr;
+        }
+    }
+    bvh_ = bvh;
+    bvh_topology_version_ = topology;
+    bvh_position_version_ = position;
+    return bvh_;
+}
+
+std::shared_ptr<const PointKdTree> SpatialIndexComponent::point_tree(
+    const MeshComponent& mesh)
+{
+    return point_tree(mesh.get_vertices(), mesh.position_version());
+}
+
+std::shared_ptr<const PointKdTree> SpatialIndexComponent::point_tree(
+    const PointsComponent& points)
+{
+    return point_tree(points.get_vertices(), points.position_version());
+}
+
+std::shared_ptr<const PointKdTree> SpatialIndexComponent::point_tree(
+    const pxr::VtArray<pxr::GfVec3f>& points,
+    uint64_t version)
+{
+    std::lock_guard lock(mutex_);
+    if (point_tree_ && point_tree_version_ == version) {
+        return point_tree_;
+    }
+    auto tree = std::make_shared<PointKdTree>();
+    tree->build(points);
+    point_tree_ = tree;
+    point_tree_version_ = version;
+    return point_tree_;
+}
+
+std::shared_ptr<SpatialIndexComponent> SpatialIndexComponent::get_or_create(
+    Geometry& geometry)
+{
+    auto index = geometry.get_component<SpatialIndexComponent>();
+    if (!index) {
+        index = std::make_shared<SpatialIndexComponent>(&geometry);
+        geometry.attach_component(index);
+    }
+    return index;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
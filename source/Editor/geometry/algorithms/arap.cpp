@@ -0,0 +1,663 @@
+#include "GCore/algorithms/arap.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+#include "GCore/algorithms/triangulate.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 10;
+constexpr int kRotationSteps = 4;
+constexpr double kPi = 3.14159265358979323846;
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Muller et al.: rotates q towards the rotational part of a until the
+// torque between their columns vanishes.
+void extract_rotation(const Eigen::Matrix3d& a, Eigen::Quaterniond& q)
+{
+    for (int step = 0; step < kRotationSteps; ++step) {
+        const Eigen::Matrix3d r = q.toRotationMatrix();
+        const Eigen::Vector3d torque = r.col(0).cross(a.col(0)) +
+                                       r.col(1).cross(a.col(1)) +
+                                       r.col(2).cross(a.col(2));
+        const double scale =
+            std::abs(r.col(0).dot(a.col(0)) + r.col(1).dot(a.col(1)) +
+                     r.col(2).dot(a.col(2))) +
+            1e-12;
+        const Eigen::Vector3d omega = torque / scale;
+        const double angle = omega.norm();
+        if (angle < 1e-9) {
+            break;
+        }
+        q = Eigen::Quaterniond(Eigen::AngleAxisd(angle, omega / angle)) * q;
+        q.normalize();
+    }
+}
+
+}  // namespace
+
+bool ArapDeformer::prepare(
+    const pxr::VtArray<pxr::GfVec3f>& rest_positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    uint64_t topology_version,
+    uint64_t position_version,
+    const std::vector<uint32_t>& handles)
+{
+    const size_t before = solver_.numeric_count();
+    if (!solver_.prepare(
+            rest_positions,
+            face_vertex_counts,
+            face_vertex_indices,
+            topology_version,
+            position_version,
+            LaplacianWeights::Cotangent,
+            handles)) {
+        clear();
+        return false;
+    }
+    if (solver_.numeric_count() == before && !offsets_.empty()) {
+        return true;
+    }
+
+    // Same weights as the factored matrix, laid out per vertex for the
+    // local step and the right-hand side.
+    const size_t n = rest_positions.size();
+    std::vector<std::array<uint32_t, 3>> triangles;
+    fan_triangulate(face_vertex_counts, face_vertex_indices, n, triangles);
+    Eigen::SparseMatrix<double> L;
+    cotan_laplacian(rest_positions, triangles, L);
+
+    offsets_.assign(n + 1, 0);
+    for (int v = 0; v < L.outerSize(); ++v) {
+        uint32_t count = 0;
+        for (Eigen::SparseMatrix<double>::InnerIterator it(L, v); it; ++it) {
+            count += it.row() != v;
+        }
+        offsets_[v + 1] = offsets_[v] + count;
+    }
+    neighbors_.resize(offsets_[n]);
+    weights_.resize(offsets_[n]);
+    rest_edges_.resize(offsets_[n]);
+    rest_.resize(Eigen::Index(n), 3);
+    for (size_t v = 0; v < n; ++v) {
+        for (int k = 0; k < 3; ++k) {
+            rest_(v, k) = rest_positions[v][k];
+        }
+    }
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                uint32_t i = offsets_[v];
+                // L is symmetric, so column v lists the neighbors of v.
+                for (Eigen::SparseMatrix<double>::InnerIterator it(L, int(v));
+                     it;
+                     ++it) {
+                    if (it.row() == Eigen::Index(v)) {
+                        continue;
+                    }
+                    neighbors_[i] = uint32_t(it.row());
+                    weights_[i] = -it.value();
+                    rest_edges_[i] =
+                        (rest_.row(v) - rest_.row(it.row())).transpose();
+                    ++i;
+                }
+            }
+        },
+        kParallelGrain);
+
+    handles_ = handles;
+    rotations_.assign(n, Eigen::Quaterniond::Identity());
+    rotation_matrices_.resize(n);
+    current_ = rest_;
+    rhs_.resize(Eigen::Index(n), 3);
+    has_solution_ = false;
+    return true;
+}
+
+void ArapDeformer::clear()
+{
+    solver_.clear();
+    handles_.clear();
+    offsets_.clear();
+    neighbors_.clear();
+    weights_.clear();
+    rest_edges_.clear();
+    rest_.resize(0, 3);
+    current_.resize(0, 3);
+    rhs_.resize(0, 3);
+    rotations_.clear();
+    rotation_matrices_.clear();
+    has_solution_ = false;
+}
+
+void ArapDeformer::local_step()
+{
+    pxr::WorkParallelForN(
+        rotations_.size(),
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                // Deformed edges times rest edges transposed; its rotational
+                // part best maps the rest one-ring onto the deformed one.
+                Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+                for (uint32_t i = offsets_[v]; i < offsets_[v + 1]; ++i) {
+                    const Eigen::Vector3d edge =
+                        (current_.row(v) - current_.row(neighbors_[i]))
+                            .transpose();
+                    covariance +=
+                        weights_[i] * edge * rest_edges_[i].transpose();
+                }
+                extract_rotation(covariance, rotations_[v]);
+                rotation_matrices_[v] = rotations_[v].toRotationMatrix();
+            }
+        },
+        kParallelGrain);
+}
+
+void ArapDeformer::global_rhs()
+{
+    pxr::WorkParallelForN(
+        rotations_.size(),
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                const Eigen::Matrix3d& rv = rotation_matrices_[v];
+                Eigen::Vector3d b = Eigen::Vector3d::Zero();
+                for (uint32_t i = offsets_[v]; i < offsets_[v + 1]; ++i) {
+                    const Eigen::Matrix3d& rj =
+                        rotation_matrices_[neighbors_[i]];
+                    b += 0.5 * weights_[i] * ((rv + rj) * rest_edges_[i]);
+                }
+                rhs_.row(v) = b.transpose();
+            }
+        },
+        kParallelGrain);
+}
+
+bool ArapDeformer::deform(
+    const std::vector<pxr::GfVec3f>& handle_positions,
+    int iterations,
+    bool warm_start,
+    pxr::VtArray<pxr::GfVec3f>& out)
+{
+    if (offsets_.empty() || handle_positions.size() != handles_.size()) {
+        return false;
+    }
+    Eigen::MatrixXd fixed(Eigen::Index(handles_.size()), 3);
+    for (size_t h = 0; h < handles_.size(); ++h) {
+        for (int k = 0; k < 3; ++k) {
+            fixed(h, k) = handle_positions[h][k];
+        }
+    }
+
+    if (!warm_start || !has_solution_) {
+        current_ = rest_;
+        std::fill(
+            rotations_.begin(),
+            rotations_.end(),
+            Eigen::Quaterniond::Identity());
+    }
+    for (size_t h = 0; h < handles_.size(); ++h) {
+        current_.row(handles_[h]) = fixed.row(h);
+    }
+
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        local_step();
+        global_rhs();
+        if (!solver_.solve(fixed, rhs_, current_)) {
+            return false;
+        }
+    }
+    has_solution_ = true;
+
+    out.resize(rotations_.size());
+    for (size_t v = 0; v < rotations_.size(); ++v) {
+        out[v] = pxr::GfVec3f(
+            float(current_(v, 0)),
+            float(current_(v, 1)),
+            float(current_(v, 2)));
+    }
+    return true;
+}
+
+bool ArapParameterizer::prepare(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    uint64_t topology_version,
+    uint64_t position_version,
+    Mode mode)
+{
+    const size_t n = positions.size();
+    const bool topology_changed = topology_version != topology_version_ ||
+                                  vertex_triangles_.offsets.size() != n + 1;
+    const bool shape_changed =
+        topology_changed || position_version != position_version_;
+    if (topology_changed) {
+        if (!fan_triangulate(
+                face_vertex_counts,
+                face_vertex_indices,
+                n,
+                triangles_,
+                &face_of_triangle_)) {
+            clear();
+            return false;
+        }
+        vertex_triangles_.build(triangles_, n);
+        const size_t m = triangles_.size();
+        for (auto* a : { &area_,
+                         &edge_,
+                         &apex_x_,
+                         &apex_y_,
+                         &inverse00_,
+                         &inverse01_,
+                         &inverse11_,
+                         &fit_a_,
+                         &fit_b_,
+                         &energy_ }) {
+            a->resize(m);
+        }
+        for (auto& j : jacobian_) {
+            j.resize(m);
+        }
+        cot_.resize(3 * m);
+    }
+
+    if (shape_changed) {
+        pxr::WorkParallelForN(
+            triangles_.size(),
+            [&](size_t first, size_t last) {
+                for (size_t t = first; t < last; ++t) {
+                    const auto& tri = triangles_[t];
+                    const pxr::GfVec3d p[3] = {
+                        pxr::GfVec3d(positions[tri[0]]),
+                        pxr::GfVec3d(positions[tri[1]]),
+                        pxr::GfVec3d(positions[tri[2]]),
+                    };
+                    const pxr::GfVec3d e1 = p[1] - p[0], e2 = p[2] - p[0];
+                    const double l = e1.GetLength();
+                    const double area2 = pxr::GfCross(e1, e2).GetLength();
+                    if (!(l > 0.0 && area2 > 0.0)) {
+                        // Degenerate: no Jacobian, no weight.
+                        area_[t] = edge_[t] = apex_x_[t] = apex_y_[t] = 0.0;
+                        inverse00_[t] = inverse01_[t] = inverse11_[t] = 0.0;
+                        cot_[3 * t] = cot_[3 * t + 1] = cot_[3 * t + 2] = 0;
+                        continue;
+                    }
+                    const double x = pxr::GfDot(e1, e2) / l;
+                    const double y = area2 / l;
+                    area_[t] = 0.5 * area2;
+                    edge_[t] = l;
+                    apex_x_[t] = x;
+                    apex_y_[t] = y;
+                    inverse00_[t] = 1.0 / l;
+                    inverse01_[t] = -x / (l * y);
+                    inverse11_[t] = 1.0 / y;
+                    for (int k = 0; k < 3; ++k) {
+                        const int i = (k + 1) % 3, j = (k + 2) % 3;
+                        cot_[3 * t + k] =
+                            pxr::GfDot(p[i] - p[k], p[j] - p[k]) / area2;
+                    }
+                }
+            },
+            kParallelGrain);
+        total_area_ = std::accumulate(area_.begin(), area_.end(), 0.0);
+    }
+
+    if (shape_changed || mode != mode_ || pins_.empty()) {
+        // One pin per connected component, at its union-find root; ASAP
+        // adds the vertex farthest from it.
+        std::vector<uint32_t> parent(n);
+        std::iota(parent.begin(), parent.end(), 0u);
+        auto find = [&](uint32_t v) {
+            while (parent[v] != v) {
+                parent[v] = parent[parent[v]];
+                v = parent[v];
+            }
+            return v;
+        };
+        for (const auto& tri : triangles_) {
+            for (int k = 1; k < 3; ++k) {
+                const uint32_t a = find(tri[0]), b = find(tri[k]);
+                if (a != b) {
+                    parent[std::max(a, b)] = std::min(a, b);
+                }
+            }
+        }
+        pins_.clear();
+        std::vector<uint32_t> farthest(n, 0);
+        std::vector<float> distance(n, -1.0f);
+        for (uint32_t v = 0; v < n; ++v) {
+            const uint32_t root = find(v);
+            if (root == v) {
+                pins_.push_back(v);
+            }
+            const float d = (positions[v] - positions[root]).GetLengthSq();
+            if (d > distance[root]) {
+                distance[root] = d;
+                farthest[root] = v;
+            }
+        }
+        if (mode == Mode::Asap) {
+            const size_t roots = pins_.size();
+            for (size_t i = 0; i < roots; ++i) {
+                if (farthest[pins_[i]] != pins_[i]) {
+                    pins_.push_back(farthest[pins_[i]]);
+                }
+            }
+        }
+    }
+
+    mode_ = mode;
+    positions_ = positions;
+    face_vertex_counts_ = face_vertex_counts;
+    face_vertex_indices_ = face_vertex_indices;
+    topology_version_ = topology_version;
+    position_version_ = position_version;
+    if (!solver_.prepare(
+            positions,
+            face_vertex_counts,
+            face_vertex_indices,
+            topology_version,
+            position_version,
+            LaplacianWeights::Cotangent,
+            pins_)) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void ArapParameterizer::clear()
+{
+    solver_.clear();
+    harmonic_.clear();
+    positions_ = {};
+    face_vertex_counts_ = {};
+    face_vertex_indices_ = {};
+    topology_version_ = 0;
+    position_version_ = 0;
+    triangles_.clear();
+    face_of_triangle_.clear();
+    vertex_triangles_ = {};
+    pins_.clear();
+    total_area_ = 0;
+    for (auto* a : { &area_,
+                     &edge_,
+                     &apex_x_,
+                     &apex_y_,
+                     &inverse00_,
+                     &inverse01_,
+                     &inverse11_,
+                     &cot_,
+                     &fit_a_,
+                     &fit_b_,
+                     &energy_ }) {
+        a->clear();
+    }
+    for (auto& j : jacobian_) {
+        j.clear();
+    }
+    uv_.resize(0, 2);
+    rhs_.resize(0, 2);
+    stats_ = {};
+}
+
+bool ArapParameterizer::harmonic_initialization(
+    pxr::VtArray<pxr::GfVec2f>& uv)
+{
+    const size_t n = positions_.size();
+    std::vector<std::vector<uint32_t>> loops;
+    if (!boundary_loops(face_vertex_counts_, face_vertex_indices_, n, loops) ||
+        loops.empty()) {
+        return false;
+    }
+
+    // A vertex where the loop touches itself is fixed at its first visit.
+    std::vector<uint32_t> fixed;
+    std::vector<double> arc;
+    std::vector<uint8_t> seen(n, 0);
+    const auto& loop = loops.front();
+    double length = 0.0;
+    for (size_t i = 0; i < loop.size(); ++i) {
+        if (!seen[loop[i]]) {
+            seen[loop[i]] = 1;
+            fixed.push_back(loop[i]);
+            arc.push_back(length);
+        }
+        length +=
+            (positions_[loop[(i + 1) % loop.size()]] - positions_[loop[i]])
+                .GetLength();
+    }
+    if (!(length > 0.0) ||
+        !harmonic_.prepare(
+            positions_,
+            face_vertex_counts_,
+            face_vertex_indices_,
+            topology_version_,
+            position_version_,
+            LaplacianWeights::Cotangent,
+            fixed)) {
+        return false;
+    }
+
+    const double radius = length / (2.0 * kPi);
+    Eigen::MatrixXd circle(Eigen::Index(fixed.size()), 2);
+    for (size_t i = 0; i < fixed.size(); ++i) {
+        const double angle = 2.0 * kPi * arc[i] / length;
+        circle(i, 0) = radius * std::cos(angle);
+        circle(i, 1) = radius * std::sin(angle);
+    }
+    Eigen::MatrixXd solution;
+    if (!harmonic_.solve(circle, solution)) {
+        return false;
+    }
+    uv.resize(n);
+    for (size_t v = 0; v < n; ++v) {
+        uv[v] = pxr::GfVec2f(float(solution(v, 0)), float(solution(v, 1)));
+    }
+    return true;
+}
+
+double ArapParameterizer::local_step()
+{
+    pxr::WorkParallelForN(
+        triangles_.size(),
+        [&](size_t first, size_t last) {
+            double* j00 = jacobian_[0].data();
+            double* j01 = jacobian_[1].data();
+            double* j10 = jacobian_[2].data();
+            double* j11 = jacobian_[3].data();
+            for (size_t t = first; t < last; ++t) {
+                const auto& tri = triangles_[t];
+                const double du1 = uv_(tri[1], 0) - uv_(tri[0], 0);
+                const double dv1 = uv_(tri[1], 1) - uv_(tri[0], 1);
+                const double du2 = uv_(tri[2], 0) - uv_(tri[0], 0);
+                const double dv2 = uv_(tri[2], 1) - uv_(tri[0], 1);
+                j00[t] = du1 * inverse00_[t];
+                j01[t] = du1 * inverse01_[t] + du2 * inverse11_[t];
+                j10[t] = dv1 * inverse00_[t];
+                j11[t] = dv1 * inverse01_[t] + dv2 * inverse11_[t];
+            }
+
+            // The closest rotation to J is the rotation by the angle of
+            // (j00 + j11, j10 - j01), the closest similarity half that
+            // vector; neither needs an SVD, and the loops below have no
+            // branches so that they vectorize.
+            double* a = fit_a_.data();
+            double* b = fit_b_.data();
+            if (mode_ == Mode::Arap) {
+                for (size_t t = first; t < last; ++t) {
+                    const double c = j00[t] + j11[t];
+                    const double s = j10[t] - j01[t];
+                    const double r = std::sqrt(c * c + s * s);
+                    const double inverse = r > 0.0 ? 1.0 / r : 0.0;
+                    a[t] = r > 0.0 ? c * inverse : 1.0;
+                    b[t] = s * inverse;
+                }
+            }
+            else {
+                for (size_t t = first; t < last; ++t) {
+                    a[t] = 0.5 * (j00[t] + j11[t]);
+                    b[t] = 0.5 * (j10[t] - j01[t]);
+                }
+            }
+            for (size_t t = first; t < last; ++t) {
+                const double d00 = j00[t] - a[t], d01 = j01[t] + b[t];
+                const double d10 = j10[t] - b[t], d11 = j11[t] - a[t];
+                energy_[t] = area_[t] * (d00 * d00 + d01 * d01 + d10 * d10 +
+                                         d11 * d11);
+            }
+        },
+        kParallelGrain);
+    return std::accumulate(energy_.begin(), energy_.end(), 0.0);
+}
+
+void ArapParameterizer::global_rhs()
+{
+    // Gradient of the energy in u_v: the cotangent-weighted fitted map of
+    // every flat edge at v, halved to match the stiffness matrix.
+    const auto& offsets = vertex_triangles_.offsets;
+    const auto& corners = vertex_triangles_.corners;
+    pxr::WorkParallelForN(
+        positions_.size(),
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                double bu = 0.0, bv = 0.0;
+                for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+                    const uint32_t t = corners[c] / 3, k = corners[c] % 3;
+                    const double x[3] = { 0.0, edge_[t], apex_x_[t] };
+                    const double y[3] = { 0.0, 0.0, apex_y_[t] };
+                    for (uint32_t o = 1; o < 3; ++o) {
+                        const uint32_t j = (k + o) % 3;
+                        const double w = 0.5 * cot_[3 * t + 3 - k - j];
+                        const double dx = x[k] - x[j], dy = y[k] - y[j];
+                        bu += w * (fit_a_[t] * dx - fit_b_[t] * dy);
+                        bv += w * (fit_b_[t] * dx + fit_a_[t] * dy);
+                    }
+                }
+                rhs_(v, 0) = bu;
+                rhs_(v, 1) = bv;
+            }
+        },
+        kParallelGrain);
+}
+
+bool ArapParameterizer::parameterize(
+    const pxr::VtArray<pxr::GfVec2f>& initial,
+    const Options& options,
+    pxr::VtArray<pxr::GfVec2f>& uv)
+{
+    const size_t n = positions_.size();
+    if (n == 0 || initial.size() != n) {
+        return false;
+    }
+    const auto start = Clock::now();
+    stats_ = {};
+
+    // Bring the initialization to the area of the mesh, mirrored if it is
+    // inside out, so that iterations go to bending rather than scaling.
+    double signed_area = 0.0;
+    for (const auto& tri : triangles_) {
+        const pxr::GfVec2f e1 = initial[tri[1]] - initial[tri[0]];
+        const pxr::GfVec2f e2 = initial[tri[2]] - initial[tri[0]];
+        signed_area += 0.5 * (double(e1[0]) * e2[1] - double(e1[1]) * e2[0]);
+    }
+    const double scale = std::abs(signed_area) > 0.0
+                             ? std::sqrt(total_area_ / std::abs(signed_area))
+                             : 1.0;
+    const double mirror = signed_area < 0.0 ? -1.0 : 1.0;
+    uv_.resize(Eigen::Index(n), 2);
+    rhs_.resize(Eigen::Index(n), 2);
+    for (size_t v = 0; v < n; ++v) {
+        uv_(v, 0) = mirror * scale * initial[v][0];
+        uv_(v, 1) = scale * initial[v][1];
+    }
+    Eigen::MatrixXd pinned(Eigen::Index(pins_.size()), 2);
+    for (size_t i = 0; i < pins_.size(); ++i) {
+        pinned.row(i) = uv_.row(pins_[i]);
+    }
+
+    double energy = local_step();
+    stats_.initial_energy = energy;
+    for (int iteration = 0; iteration < options.max_iterations; ++iteration) {
+        global_rhs();
+        if (!solver_.solve(pinned, rhs_, uv_)) {
+            return false;
+        }
+        const double next = local_step();
+        ++stats_.iterations;
+        const bool converged =
+            energy - next <= options.tolerance * energy ||
+            next <= options.tolerance * options.tolerance * total_area_;
+        energy = next;
+        if (converged) {
+            break;
+        }
+    }
+    stats_.energy = energy;
+    for (size_t t = 0; t < triangles_.size(); ++t) {
+        const double det = jacobian_[0][t] * jacobian_[3][t] -
+                           jacobian_[1][t] * jacobian_[2][t];
+        stats_.flipped += area_[t] > 0.0 && det <= 0.0;
+    }
+
+    uv.resize(n);
+    for (size_t v = 0; v < n; ++v) {
+        uv[v] = pxr::GfVec2f(float(uv_(v, 0)), float(uv_(v, 1)));
+    }
+    stats_.seconds = seconds_since(start);
+    return true;
+}
+
+void ArapParameterizer::face_distortion(
+    pxr::VtArray<float>& energy,
+    pxr::VtArray<float>& area_ratio,
+    pxr::VtArray<float>& conformal_ratio) const
+{
+    const size_t faces = face_vertex_counts_.size();
+    std::vector<double> sums[4];
+    for (auto& s : sums) {
+        s.assign(faces, 0.0);
+    }
+    for (size_t t = 0; t < triangles_.size() && t < energy_.size(); ++t) {
+        const double j00 = jacobian_[0][t], j01 = jacobian_[1][t];
+        const double j10 = jacobian_[2][t], j11 = jacobian_[3][t];
+        // Singular values of a 2x2 matrix in closed form; s2 takes the
+        // sign of the determinant.
+        const double q = std::hypot(0.5 * (j00 + j11), 0.5 * (j10 - j01));
+        const double r = std::hypot(0.5 * (j00 - j11), 0.5 * (j10 + j01));
+        const double s1 = q + r, s2 = q - r;
+        const double a = area_[t];
+        const uint32_t f = face_of_triangle_[t];
+        sums[0][f] += a;
+        sums[1][f] += energy_[t];
+        sums[2][f] += a * s1 * s2;
+        sums[3][f] += a * s1 / std::max(std::abs(s2), 1e-12);
+    }
+    energy.resize(faces);
+    area_ratio.resize(faces);
+    conformal_ratio.resize(faces);
+    for (size_t f = 0; f < faces; ++f) {
+        const double a = sums[0][f];
+        energy[f] = a > 0.0 ? float(sums[1][f] / a) : 0.0f;
+        area_ratio[f] = a > 0.0 ? float(sums[2][f] / a) : 0.0f;
+        conformal_ratio[f] = a > 0.0 ? float(sums[3][f] / a) : 0.0f;
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,988 @@
+#include "GCore/algorithms/attribute_expression.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "GCore/Components/MeshOperand.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Vertices per block. A register holds three components of a block, one
+// after the other.
+constexpr size_t kBlock = 256;
+constexpr size_t kRegister = 3 * kBlock;
+// Blocks per parallel task.
+constexpr size_t kGrainBlocks = 64;
+
+constexpr float kPi = 3.14159265358979323846f;
+
+enum class Op : uint8_t {
+    Load,
+    Const,
+    Index,
+    Splat,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Min,
+    Max,
+    Pow,
+    Neg,
+    Sin,
+    Cos,
+    Abs,
+    Sqrt,
+    Floor,
+    Fract,
+    Exp,
+    Log,
+    Clamp,
+    Mix,
+    Dot,
+    Length,
+    Normalize,
+    Cross,
+    Make,
+    Extract,
+};
+
+struct Instruction {
+    Op op;
+    // Components of the result, 1 or 3.
+    uint8_t width;
+    uint16_t dst;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+    // Constant of Const, component of Extract, input of Load.
+    float value;
+};
+
+enum class Column {
+    Position,
+    Normal,
+    Color,
+    Texcoord,
+    Scalar,
+    Vector,
+    ColorQuantity,
+};
+
+struct Binding {
+    Column column;
+    std::string name;
+    uint16_t reg;
+    uint8_t width;
+};
+
+}  // namespace
+
+struct AttributeProgram::Code {
+    std::vector<Instruction> instructions;
+    // Read by the Load instructions, and written after the last instruction
+    // from their register.
+    std::vector<Binding> inputs;
+    std::vector<Binding> outputs;
+    size_t registers = 0;
+};
+
+namespace {
+
+struct SyntaxError {
+    std::string message;
+};
+
+// A register holding an intermediate result. Owned values hold a reference
+// that is released once they are consumed; the others belong to a variable.
+struct Value {
+    uint16_t reg = 0;
+    uint8_t width = 1;
+    bool owned = false;
+};
+
+enum class Token { End, Newline, Number, Name, Quantity, Symbol };
+
+// Recursive descent parser emitting bytecode directly. Registers are
+// reference counted and reused once the last value in them is consumed.
+class Compiler {
+   public:
+    Compiler(
+        const std::string& source,
+        const MeshComponent& mesh,
+        const std::map<std::string, float>& uniforms,
+        AttributeProgram::Code& code)
+        : source_(source),
+          mesh_(mesh),
+          uniforms_(uniforms),
+          code_(code)
+    {
+    }
+
+    void compile()
+    {
+        next();
+        while (token_ != Token::End) {
+            if (token_ == Token::Newline || is_symbol(';')) {
+                next();
+                continue;
+            }
+            statement();
+            if (token_ != Token::End && token_ != Token::Newline &&
+                !is_symbol(';')) {
+                fail("expected the end of the statement");
+            }
+        }
+        for (const std::string& key : written_) {
+            const Value& value = variables_.at(key);
+            Binding binding = column_of(key, value.width);
+            binding.reg = value.reg;
+            binding.width = value.width;
+            code_.outputs.push_back(binding);
+        }
+        code_.registers = refs_.size();
+    }
+
+    int line() const
+    {
+        return line_;
+    }
+
+   private:
+    [[noreturn]] void fail(const std::string& message)
+    {
+        throw SyntaxError{ message };
+    }
+
+    // Lexer
+
+    void next()
+    {
+        while (pos_ < source_.size()) {
+            const char c = source_[pos_];
+            if (c == ' ' || c == '\t' || c == '\r') {
+                ++pos_;
+            }
+            else if (c == '#') {
+                while (pos_ < source_.size() && source_[pos_] != '\n') {
+                    ++pos_;
+                }
+            }
+            else {
+                break;
+            }
+        }
+        if (token_ == Token::Newline) {
+            ++line_;
+        }
+        if (pos_ >= source_.size()) {
+            token_ = Token::End;
+            return;
+        }
+
+        auto is_name = [](char c, bool first) {
+            return std::isalpha(static_cast<unsigned char>(c)) || c == '_' ||
+                   (!first && std::isdigit(static_cast<unsigned char>(c)));
+        };
+        auto read_name = [&] {
+            const size_t begin = pos_;
+            while (pos_ < source_.size() && is_name(source_[pos_], false)) {
+                ++pos_;
+            }
+            text_.assign(source_, begin, pos_ - begin);
+        };
+
+        const char c = source_[pos_];
+        const bool digit = std::isdigit(static_cast<unsigned char>(c)) ||
+                           (c == '.' && pos_ + 1 < source_.size() &&
+                            std::isdigit(
+                                static_cast<unsigned char>(source_[pos_ + 1])));
+        if (c == '\n') {
+            token_ = Token::Newline;
+            ++pos_;
+        }
+        else if (digit) {
+            const char* begin = source_.data() + pos_;
+            const char* end = source_.data() + source_.size();
+            auto result = std::from_chars(begin, end, number_);
+            if (result.ec != std::errc()) {
+                fail("malformed number");
+            }
+            token_ = Token::Number;
+            pos_ += size_t(result.ptr - begin);
+        }
+        else if (is_name(c, true)) {
+            token_ = Token::Name;
+            read_name();
+        }
+        else if (c == '@') {
+            ++pos_;
+            if (pos_ >= source_.size() || !is_name(source_[pos_], true)) {
+                fail("expected a quantity name after '@'");
+            }
+            token_ = Token::Quantity;
+            read_name();
+        }
+        else if (std::string_view("+-*/(),=;.").find(c) !=
+                 std::string_view::npos) {
+            token_ = Token::Symbol;
+            symbol_ = c;
+            ++pos_;
+        }
+        else {
+            fail(std::string("unexpected character '") + c + "'");
+        }
+    }
+
+    bool is_symbol(char c) const
+    {
+        return token_ == Token::Symbol && symbol_ == c;
+    }
+
+    void expect(char c)
+    {
+        if (!is_symbol(c)) {
+            fail(std::string("expected '") + c + "'");
+        }
+        next();
+    }
+
+    // Registers
+
+    uint16_t allocate()
+    {
+        if (!free_.empty()) {
+            const uint16_t reg = free_.back();
+            free_.pop_back();
+            refs_[reg] = 1;
+            return reg;
+        }
+        if (refs_.size() > UINT16_MAX) {
+            fail("expression too long");
+        }
+        refs_.push_back(1);
+        return uint16_t(refs_.size() - 1);
+    }
+
+    void release(uint16_t reg)
+    {
+        if (--refs_[reg] == 0) {
+            free_.push_back(reg);
+        }
+    }
+
+    void drop(const Value& value)
+    {
+        if (value.owned) {
+            release(value.reg);
+        }
+    }
+
+    // Appends an instruction writing a new register; the operands are
+    // consumed afterwards, so the result never aliases them.
+    Value emit(
+        Op op,
+        uint8_t width,
+        Value a = {},
+        Value b = {},
+        Value c = {},
+        float value = 0)
+    {
+        const Value result{ allocate(), width, true };
+        code_.instructions.push_back(
+            { op, width, result.reg, a.reg, b.reg, c.reg, value });
+        drop(a);
+        drop(b);
+        drop(c);
+        return result;
+    }
+
+    Value constant(float value)
+    {
+        return emit(Op::Const, 1, {}, {}, {}, value);
+    }
+
+    Value widen(const Value& value)
+    {
+        return value.width == 3 ? value : emit(Op::Splat, 3, value);
+    }
+
+    Value componentwise(Op op, std::vector<Value> args)
+    {
+        uint8_t width = 1;
+        for (const Value& arg : args) {
+            width = std::max(width, arg.width);
+        }
+        if (width == 3) {
+            for (Value& arg : args) {
+                arg = widen(arg);
+            }
+        }
+        args.resize(3);
+        return emit(op, width, args[0], args[1], args[2]);
+    }
+
+    // Attributes
+
+    // Column of an attribute key ("P", "N", "Cd", "UV" or "@name") written
+    // with `width` components.
+    Binding column_of(const std::string& key, uint8_t width) const
+    {
+        if (key == "P") {
+            return { Column::Position, key, 0, 3 };
+        }
+        if (key == "N") {
+            return { Column::Normal, key, 0, 3 };
+        }
+        if (key == "Cd") {
+            return { Column::Color, key, 0, 3 };
+        }
+        if (key == "UV") {
+            return { Column::Texcoord, key, 0, 3 };
+        }
+        const std::string name = key.substr(1);
+        if (has(mesh_.get_vertex_color_quantity_names(), name)) {
+            return { Column::ColorQuantity, name, 0, 3 };
+        }
+        return { width == 1 ? Column::Scalar : Column::Vector, name, 0, width };
+    }
+
+    static bool is_attribute(const std::string& key)
+    {
+        return key == "P" || key == "N" || key == "Cd" || key == "UV" ||
+               key[0] == '@';
+    }
+
+    static bool has(const std::vector<std::string>& names, const std::string& n)
+    {
+        return std::find(names.begin(), names.end(), n) != names.end();
+    }
+
+    // Binding of an attribute read before it is assigned.
+    Binding input_of(const std::string& key) const
+    {
+        const size_t vertices = mesh_.get_vertices().size();
+        auto per_vertex = [&](size_t size, Column column) {
+            if (size != vertices) {
+                throw SyntaxError{ key + " is not stored per vertex" };
+            }
+            return Binding{ column, key, 0, 3 };
+        };
+        if (key == "P") {
+            return { Column::Position, key, 0, 3 };
+        }
+        if (key == "N") {
+            return per_vertex(mesh_.get_normals().size(), Column::Normal);
+        }
+        if (key == "Cd") {
+            return per_vertex(mesh_.get_display_color().size(), Column::Color);
+        }
+        if (key == "UV") {
+            return per_vertex(
+                mesh_.get_texcoords_array().size(), Column::Texcoord);
+        }
+        const std::string name = key.substr(1);
+        if (has(mesh_.get_vertex_scalar_quantity_names(), name)) {
+            return { Column::Scalar, name, 0, 1 };
+        }
+        if (has(mesh_.get_vertex_vector_quantity_names(), name)) {
+            return { Column::Vector, name, 0, 3 };
+        }
+        if (has(mesh_.get_vertex_color_quantity_names(), name)) {
+            return { Column::ColorQuantity, name, 0, 3 };
+        }
+        throw SyntaxError{ "unknown vertex quantity " + key };
+    }
+
+    Value variable(const std::string& key)
+    {
+        auto it = variables_.find(key);
+        if (it == variables_.end()) {
+            if (!is_attribute(key)) {
+                fail("unknown name '" + key + "'");
+            }
+            Binding binding = input_of(key);
+            const float input = float(code_.inputs.size());
+            // The variable keeps the reference of the loaded register.
+            Value loaded = emit(Op::Load, binding.width, {}, {}, {}, input);
+            binding.reg = loaded.reg;
+            code_.inputs.push_back(binding);
+            it = variables_.emplace(key, loaded).first;
+        }
+        return { it->second.reg, it->second.width, false };
+    }
+
+    // Grammar
+
+    void statement()
+    {
+        if (token_ != Token::Name && token_ != Token::Quantity) {
+            fail("expected an assignment");
+        }
+        std::string key = token_ == Token::Quantity ? "@" + text_ : text_;
+        if (key == "i" || key == "PI" || uniforms_.count(key)) {
+            fail("cannot assign to '" + key + "'");
+        }
+        next();
+        expect('=');
+        Value value = expression();
+
+        if (is_attribute(key)) {
+            const auto colors = mesh_.get_vertex_color_quantity_names();
+            if (key[0] != '@' || has(colors, key.substr(1))) {
+                value = widen(value);
+            }
+            if (std::find(written_.begin(), written_.end(), key) ==
+                written_.end()) {
+                written_.push_back(key);
+            }
+        }
+        if (!value.owned) {
+            ++refs_[value.reg];
+        }
+        auto it = variables_.find(key);
+        if (it != variables_.end()) {
+            release(it->second.reg);
+        }
+        variables_[key] = { value.reg, value.width, true };
+    }
+
+    Value expression()
+    {
+        Value left = term();
+        while (is_symbol('+') || is_symbol('-')) {
+            const Op op = symbol_ == '+' ? Op::Add : Op::Sub;
+            next();
+            left = componentwise(op, { left, term() });
+        }
+        return left;
+    }
+
+    Value term()
+    {
+        Value left = unary();
+        while (is_symbol('*') || is_symbol('/')) {
+            const Op op = symbol_ == '*' ? Op::Mul : Op::Div;
+            next();
+            left = componentwise(op, { left, unary() });
+        }
+        return left;
+    }
+
+    Value unary()
+    {
+        if (is_symbol('-')) {
+            next();
+            return componentwise(Op::Neg, { unary() });
+        }
+        Value value = primary();
+        while (is_symbol('.')) {
+            next();
+            const std::string components = "xyzrgb";
+            if (token_ != Token::Name || text_.size() != 1 ||
+                components.find(text_[0]) == std::string::npos) {
+                fail("expected x, y, z, r, g or b after '.'");
+            }
+            if (value.width != 3) {
+                fail("component of a scalar");
+            }
+            const float component = float(components.find(text_[0]) % 3);
+            next();
+            value = emit(Op::Extract, 1, value, {}, {}, component);
+        }
+        return value;
+    }
+
+    Value primary()
+    {
+        if (token_ == Token::Number) {
+            const float number = number_;
+            next();
+            return constant(number);
+        }
+        if (is_symbol('(')) {
+            next();
+            Value value = expression();
+            expect(')');
+            return value;
+        }
+        if (token_ == Token::Quantity) {
+            const std::string key = "@" + text_;
+            next();
+            return variable(key);
+        }
+        if (token_ != Token::Name) {
+            fail("expected a value");
+        }
+
+        const std::string name = text_;
+        next();
+        if (is_symbol('(')) {
+            next();
+            std::vector<Value> args;
+            if (!is_symbol(')')) {
+                args.push_back(expression());
+                while (is_symbol(',')) {
+                    next();
+                    args.push_back(expression());
+                }
+            }
+            expect(')');
+            return call(name, std::move(args));
+        }
+        if (variables_.count(name)) {
+            return variable(name);
+        }
+        if (name == "i") {
+            return emit(Op::Index, 1);
+        }
+        if (name == "PI") {
+            return constant(kPi);
+        }
+        auto uniform = uniforms_.find(name);
+        if (uniform != uniforms_.end()) {
+            return constant(uniform->second);
+        }
+        return variable(name);
+    }
+
+    Value call(const std::string& name, std::vector<Value> args)
+    {
+        struct Function {
+            const char* name;
+            size_t arity;
+            Op op;
+        };
+        static const Function kComponentwise[] = {
+            { "sin", 1, Op::Sin },     { "cos", 1, Op::Cos },
+            { "abs", 1, Op::Abs },     { "sqrt", 1, Op::Sqrt },
+            { "floor", 1, Op::Floor }, { "fract", 1, Op::Fract },
+            { "exp", 1, Op::Exp },     { "log", 1, Op::Log },
+            { "min", 2, Op::Min },     { "max", 2, Op::Max },
+            { "pow", 2, Op::Pow },     { "clamp", 3, Op::Clamp },
+            { "mix", 3, Op::Mix },
+        };
+        auto arity = [&](size_t count) {
+            if (args.size() != count) {
+                fail(
+                    name + " takes " + std::to_string(count) + " argument" +
+                    (count == 1 ? "" : "s"));
+            }
+        };
+        for (const Function& function : kComponentwise) {
+            if (name == function.name) {
+                arity(function.arity);
+                return componentwise(function.op, std::move(args));
+            }
+        }
+        if (name == "vec3") {
+            if (args.size() == 1) {
+                return widen(args[0]);
+            }
+            arity(3);
+            for (const Value& arg : args) {
+                if (arg.width != 1) {
+                    fail("vec3 takes scalars");
+                }
+            }
+            return emit(Op::Make, 3, args[0], args[1], args[2]);
+        }
+        if (name == "dot" || name == "cross") {
+            arity(2);
+            const Value a = widen(args[0]);
+            const Value b = widen(args[1]);
+            return name == "dot" ? emit(Op::Dot, 1, a, b)
+                                 : emit(Op::Cross, 3, a, b);
+        }
+        if (name == "length" || name == "normalize") {
+            arity(1);
+            const Value a = widen(args[0]);
+            return name == "length" ? emit(Op::Length, 1, a)
+                                    : emit(Op::Normalize, 3, a);
+        }
+        fail("unknown function '" + name + "'");
+    }
+
+    const std::string& source_;
+    const MeshComponent& mesh_;
+    const std::map<std::string, float>& uniforms_;
+    AttributeProgram::Code& code_;
+
+    size_t pos_ = 0;
+    int line_ = 1;
+    Token token_ = Token::End;
+    std::string text_;
+    float number_ = 0;
+    char symbol_ = 0;
+
+    std::vector<int> refs_;
+    std::vector<uint16_t> free_;
+    std::map<std::string, Value> variables_;
+    // Attribute keys in the order of their first assignment.
+    std::vector<std::string> written_;
+};
+
+struct Source {
+    const float* data;
+    size_t stride;
+};
+
+struct Target {
+    float* data;
+    size_t stride;
+};
+
+void run_blocks(
+    const AttributeProgram::Code& code,
+    const std::vector<Source>& sources,
+    const std::vector<Target>& targets,
+    size_t count,
+    size_t first_block,
+    size_t last_block,
+    float* registers)
+{
+    for (size_t block = first_block; block < last_block; ++block) {
+        const size_t first = block * kBlock;
+        const size_t n = std::min(kBlock, count - first);
+        for (const Instruction& ins : code.instructions) {
+            float* d = registers + ins.dst * kRegister;
+            const float* a = registers + ins.a * kRegister;
+            const float* b = registers + ins.b * kRegister;
+            const float* c = registers + ins.c * kRegister;
+            // Lanes past n hold stale values and are never stored.
+            const size_t lanes = ins.width * kBlock;
+            switch (ins.op) {
+                case Op::Load: {
+                    const Source& source = sources[size_t(ins.value)];
+                    for (size_t k = 0; k < ins.width; ++k) {
+                        float* out = d + k * kBlock;
+                        if (k >= source.stride) {
+                            std::fill(out, out + n, 0.0f);
+                            continue;
+                        }
+                        const float* in = source.data + first * source.stride;
+                        for (size_t i = 0; i < n; ++i) {
+                            out[i] = in[i * source.stride + k];
+                        }
+                    }
+                    break;
+                }
+                case Op::Const: std::fill(d, d + kBlock, ins.value); break;
+                case Op::Index:
+                    for (size_t i = 0; i < kBlock; ++i) {
+                        d[i] = float(first + i);
+                    }
+                    break;
+                case Op::Splat:
+                    for (size_t k = 0; k < 3; ++k) {
+                        std::copy(a, a + kBlock, d + k * kBlock);
+                    }
+                    break;
+                case Op::Add:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = a[i] + b[i];
+                    }
+                    break;
+                case Op::Sub:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = a[i] - b[i];
+                    }
+                    break;
+                case Op::Mul:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = a[i] * b[i];
+                    }
+                    break;
+                case Op::Div:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = a[i] / b[i];
+                    }
+                    break;
+                case Op::Min:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::min(a[i], b[i]);
+                    }
+                    break;
+                case Op::Max:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::max(a[i], b[i]);
+                    }
+                    break;
+                case Op::Pow:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::pow(a[i], b[i]);
+                    }
+                    break;
+                case Op::Neg:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = -a[i];
+                    }
+                    break;
+                case Op::Sin:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::sin(a[i]);
+                    }
+                    break;
+                case Op::Cos:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::cos(a[i]);
+                    }
+                    break;
+                case Op::Abs:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::abs(a[i]);
+                    }
+                    break;
+                case Op::Sqrt:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::sqrt(a[i]);
+                    }
+                    break;
+                case Op::Floor:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::floor(a[i]);
+                    }
+                    break;
+                case Op::Fract:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = a[i] - std::floor(a[i]);
+                    }
+                    break;
+                case Op::Exp:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::exp(a[i]);
+                    }
+                    break;
+                case Op::Log:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::log(a[i]);
+                    }
+                    break;
+                case Op::Clamp:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = std::min(std::max(a[i], b[i]), c[i]);
+                    }
+                    break;
+                case Op::Mix:
+                    for (size_t i = 0; i < lanes; ++i) {
+                        d[i] = a[i] + (b[i] - a[i]) * c[i];
+                    }
+                    break;
+                case Op::Dot:
+                    for (size_t i = 0; i < kBlock; ++i) {
+                        d[i] = a[i] * b[i] + a[i + kBlock] * b[i + kBlock] +
+                               a[i + 2 * kBlock] * b[i + 2 * kBlock];
+                    }
+                    break;
+                case Op::Length:
+                    for (size_t i = 0; i < kBlock; ++i) {
+                        d[i] = std::sqrt(
+                            a[i] * a[i] + a[i + kBlock] * a[i + kBlock] +
+                            a[i + 2 * kBlock] * a[i + 2 * kBlock]);
+                    }
+                    break;
+                case Op::Normalize:
+                    for (size_t i = 0; i < kBlock; ++i) {
+                        const float length = std::sqrt(
+                            a[i] * a[i] + a[i + kBlock] * a[i + kBlock] +
+                            a[i + 2 * kBlock] * a[i + 2 * kBlock]);
+                        const float scale = length > 0 ? 1 / length : 0;
+                        d[i] = a[i] * scale;
+                        d[i + kBlock] = a[i + kBlock] * scale;
+                        d[i + 2 * kBlock] = a[i + 2 * kBlock] * scale;
+                    }
+                    break;
+                case Op::Cross:
+                    for (size_t i = 0; i < kBlock; ++i) {
+                        const float ax = a[i], ay = a[i + kBlock],
+                                    az = a[i + 2 * kBlock];
+                        const float bx = b[i], by = b[i + kBlock],
+                                    bz = b[i + 2 * kBlock];
+                        d[i] = ay * bz - az * by;
+                        d[i + kBlock] = az * bx - ax * bz;
+                        d[i + 2 * kBlock] = ax * by - ay * bx;
+                    }
+                    break;
+                case Op::Make:
+                    std::copy(a, a + kBlock, d);
+                    std::copy(b, b + kBlock, d + kBlock);
+                    std::copy(c, c + kBlock, d + 2 * kBlock);
+                    break;
+                case Op::Extract: {
+                    const float* in = a + size_t(ins.value) * kBlock;
+                    std::copy(in, in + kBlock, d);
+                    break;
+                }
+            }
+        }
+
+        for (size_t o = 0; o < code.outputs.size(); ++o) {
+            const float* in = registers + code.outputs[o].reg * kRegister;
+            const Target& target = targets[o];
+            float* out = target.data + first * target.stride;
+            for (size_t k = 0; k < target.stride; ++k) {
+                for (size_t i = 0; i < n; ++i) {
+                    out[i * target.stride + k] = in[k * kBlock + i];
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+AttributeProgram::AttributeProgram() = default;
+
+AttributeProgram::~AttributeProgram() = default;
+
+bool AttributeProgram::compile(
+    const std::string& source,
+    const MeshComponent& mesh,
+    const std::map<std::string, float>& uniforms)
+{
+    auto code = std::make_unique<Code>();
+    Compiler compiler(source, mesh, uniforms, *code);
+    try {
+        compiler.compile();
+    }
+    catch (const SyntaxError& e) {
+        error_ = "line " + std::to_string(compiler.line()) + ": " + e.message;
+        code_.reset();
+        return false;
+    }
+    error_.clear();
+    code_ = std::move(code);
+    return true;
+}
+
+size_t AttributeProgram::instruction_count() const
+{
+    return code_ ? code_->instructions.size() : 0;
+}
+
+bool AttributeProgram::run(MeshComponent& mesh)
+{
+    if (!code_) {
+        error_ = "no compiled program";
+        return false;
+    }
+    const size_t count = mesh.get_vertices().size();
+
+    // The arrays stay alive while their data is read.
+    std::vector<pxr::VtArray<pxr::GfVec3f>> vectors;
+    std::vector<pxr::VtArray<pxr::GfVec2f>> texcoords;
+    std::vector<pxr::VtArray<float>> scalars;
+    std::vector<Source> sources;
+    for (const Binding& input : code_->inputs) {
+        size_t size;
+        if (input.column == Column::Texcoord) {
+            texcoords.push_back(mesh.get_texcoords_array());
+            size = texcoords.back().size();
+            sources.push_back({ texcoords.back().cdata()->data(), 2 });
+        }
+        else if (input.column == Column::Scalar) {
+            scalars.push_back(mesh.get_vertex_scalar_quantity(input.name));
+            size = scalars.back().size();
+            sources.push_back({ scalars.back().cdata(), 1 });
+        }
+        else {
+            switch (input.column) {
+                case Column::Position:
+                    vectors.push_back(mesh.get_vertices());
+                    break;
+                case Column::Normal:
+                    vectors.push_back(mesh.get_normals());
+                    break;
+                case Column::Color:
+                    vectors.push_back(mesh.get_display_color());
+                    break;
+                case Column::Vector:
+                    vectors.push_back(
+                        mesh.get_vertex_vector_quantity(input.name));
+                    break;
+                default:
+                    vectors.push_back(
+                        mesh.get_vertex_color_quantity(input.name));
+                    break;
+            }
+            size = vectors.back().size();
+            sources.push_back({ vectors.back().cdata()->data(), 3 });
+        }
+        if (size != count) {
+            error_ = input.name + " has " + std::to_string(size) +
+                     " values for " + std::to_string(count) + " vertices";
+            return false;
+        }
+    }
+
+    std::vector<pxr::VtArray<pxr::GfVec3f>> vector_outputs;
+    std::vector<pxr::VtArray<pxr::GfVec2f>> texcoord_outputs;
+    std::vector<pxr::VtArray<float>> scalar_outputs;
+    std::vector<Target> targets;
+    for (const Binding& output : code_->outputs) {
+        if (output.column == Column::Texcoord) {
+            texcoord_outputs.emplace_back(count);
+            targets.push_back({ texcoord_outputs.back().data()->data(), 2 });
+        }
+        else if (output.column == Column::Scalar) {
+            scalar_outputs.emplace_back(count);
+            targets.push_back({ scalar_outputs.back().data(), 1 });
+        }
+        else {
+            vector_outputs.emplace_back(count);
+            targets.push_back({ vector_outputs.back().data()->data(), 3 });
+        }
+    }
+
+    const size_t blocks = (count + kBlock - 1) / kBlock;
+    pxr::WorkParallelForN(
+        blocks,
+        [&](size_t begin, size_t end) {
+            std::vector<float> registers(code_->registers * kRegister);
+            run_blocks(
+                *code_, sources, targets, count, begin, end, registers.data());
+        },
+        kGrainBlocks);
+
+    size_t next_vector = 0, next_texcoord = 0, next_scalar = 0;
+    for (const Binding& output : code_->outputs) {
+        switch (output.column) {
+            case Column::Position:
+                mesh.set_vertices(vector_outputs[next_vector++]);
+                break;
+            case Column::Normal:
+                mesh.set_normals(vector_outputs[next_vector++]);
+                break;
+            case Column::Color:
+                mesh.set_display_color(vector_outputs[next_vector++]);
+                break;
+            case Column::Texcoord:
+                mesh.set_texcoords_array(texcoord_outputs[next_texcoord++]);
+                break;
+            case Column::Scalar:
+                mesh.add_vertex_scalar_quantity(
+                    output.name, scalar_outputs[next_scalar++]);
+                break;
+            case Column::Vector:
+                mesh.add_vertex_vector_quantity(
+                    output.name, vector_outputs[next_vector++]);
+                break;
+            case Column::ColorQuantity:
+                mesh.add_vertex_color_quantity(
+                    output.name, vector_outputs[next_vector++]);
+                break;
+        }
+    }
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
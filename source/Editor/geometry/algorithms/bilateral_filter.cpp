@@ -0,0 +1,259 @@
+#include "GCore/algorithms/bilateral_filter.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+
+}  // namespace
+
+bool BilateralNormalFilter::set_topology(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count,
+    Neighborhood neighborhood)
+{
+    clear();
+    if (!fan_triangulate(
+            face_vertex_counts,
+            face_vertex_indices,
+            vertex_count,
+            triangles_)) {
+        return false;
+    }
+    neighborhood_ = neighborhood;
+    vertex_triangles_.build(triangles_, vertex_count);
+    const auto& offsets = vertex_triangles_.offsets;
+    const auto& corners = vertex_triangles_.corners;
+
+    // A vertex is on the boundary if one of its edges has a single
+    // triangle, i.e. some neighbor shows up only once around it.
+    boundary_.resize(vertex_count);
+    pxr::WorkParallelForN(
+        vertex_count,
+        [&](size_t first, size_t last) {
+            std::vector<uint32_t> ring;
+            for (size_t v = first; v < last; ++v) {
+                ring.clear();
+                for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+                    const auto& tri = triangles_[corners[c] / 3];
+                    const uint32_t k = corners[c] % 3;
+                    ring.push_back(tri[(k + 1) % 3]);
+                    ring.push_back(tri[(k + 2) % 3]);
+                }
+                std::sort(ring.begin(), ring.end());
+                bool boundary = false;
+                for (size_t i = 0; i < ring.size();) {
+                    size_t j = i + 1;
+                    while (j < ring.size() && ring[j] == ring[i]) {
+                        ++j;
+                    }
+                    boundary |= j - i == 1;
+                    i = j;
+                }
+                boundary_[v] = boundary;
+            }
+        },
+        kParallelGrain);
+
+    // Neighbors of one face, sorted and without duplicates.
+    auto collect = [&](uint32_t f, std::vector<uint32_t>& out) {
+        out.clear();
+        const auto& tri = triangles_[f];
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t a = tri[k], b = tri[(k + 1) % 3];
+            for (uint32_t c = offsets[a]; c < offsets[a + 1]; ++c) {
+                const uint32_t t = corners[c] / 3;
+                if (t == f) {
+                    continue;
+                }
+                const auto& other = triangles_[t];
+                if (neighborhood == Neighborhood::Vertex ||
+                    other[0] == b || other[1] == b || other[2] == b) {
+                    out.push_back(t);
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    };
+
+    // Counted first and filled second, both in parallel over the faces.
+    const size_t face_count = triangles_.size();
+    neighbor_offsets_.assign(face_count + 1, 0);
+    pxr::WorkParallelForN(
+        face_count,
+        [&](size_t first, size_t last) {
+            std::vector<uint32_t> buffer;
+            for (size_t f = first; f < last; ++f) {
+                collect(uint32_t(f), buffer);
+                neighbor_offsets_[f + 1] = uint32_t(buffer.size());
+            }
+        },
+        kParallelGrain);
+    for (size_t f = 0; f < face_count; ++f) {
+        neighbor_offsets_[f + 1] += neighbor_offsets_[f];
+    }
+    neighbors_.resize(neighbor_offsets_[face_count]);
+    pxr::WorkParallelForN(
+        face_count,
+        [&](size_t first, size_t last) {
+            std::vector<uint32_t> buffer;
+            for (size_t f = first; f < last; ++f) {
+                collect(uint32_t(f), buffer);
+                std::copy(
+                    buffer.begin(),
+                    buffer.end(),
+                    neighbors_.begin() + neighbor_offsets_[f]);
+            }
+        },
+        kParallelGrain);
+    return true;
+}
+
+void BilateralNormalFilter::clear()
+{
+    triangles_.clear();
+    vertex_triangles_ = {};
+    boundary_.clear();
+    neighbor_offsets_.clear();
+    neighbors_.clear();
+}
+
+void BilateralNormalFilter::update_faces(
+    const pxr::VtArray<pxr::GfVec3f>& positions)
+{
+    const size_t face_count = triangles_.size();
+    area_.resize(face_count);
+    centroid_.resize(face_count);
+    normals_[0].resize(face_count);
+    normals_[1].resize(face_count);
+    pxr::WorkParallelForN(
+        face_count,
+        [&](size_t first, size_t last) {
+            for (size_t f = first; f < last; ++f) {
+                const auto& tri = triangles_[f];
+                const pxr::GfVec3f& a = positions[tri[0]];
+                const pxr::GfVec3f& b = positions[tri[1]];
+                const pxr::GfVec3f& c = positions[tri[2]];
+                pxr::GfVec3f normal = pxr::GfCross(b - a, c - a);
+                area_[f] = 0.5f * normal.Normalize();
+                centroid_[f] = (a + b + c) / 3.0f;
+                normals_[0][f] = normal;
+            }
+        },
+        kParallelGrain);
+}
+
+void BilateralNormalFilter::denoise(
+    pxr::VtArray<pxr::GfVec3f>& positions,
+    float sigma_s,
+    float multiple_sigma_c,
+    int normal_iterations,
+    int vertex_iterations)
+{
+    const size_t face_count = triangles_.size();
+    const size_t vertex_count = boundary_.size();
+    if (positions.size() != vertex_count || face_count == 0) {
+        return;
+    }
+    update_faces(positions);
+
+    double distance_sum = 0.0;
+    for (size_t f = 0; f < face_count; ++f) {
+        for (uint32_t i = neighbor_offsets_[f]; i < neighbor_offsets_[f + 1];
+             ++i) {
+            distance_sum +=
+                (centroid_[f] - centroid_[neighbors_[i]]).GetLength();
+        }
+    }
+    const float sigma_c =
+        neighbors_.empty()
+            ? 1.0f
+            : float(multiple_sigma_c * distance_sum / neighbors_.size());
+    const float spatial = sigma_c > 0.0f ? 1.0f / (2.0f * sigma_c * sigma_c)
+                                         : 0.0f;
+    const float range = sigma_s > 0.0f ? 1.0f / (2.0f * sigma_s * sigma_s)
+                                       : 0.0f;
+
+    int current = 0;
+    for (int iteration = 0; iteration < normal_iterations; ++iteration) {
+        const auto& in = normals_[current];
+        auto& out = normals_[1 - current];
+        pxr::WorkParallelForN(
+            face_count,
+            [&](size_t first, size_t last) {
+                for (size_t f = first; f < last; ++f) {
+                    pxr::GfVec3f sum(0.0f);
+                    for (uint32_t i = neighbor_offsets_[f];
+                         i < neighbor_offsets_[f + 1];
+                         ++i) {
+                        const uint32_t j = neighbors_[i];
+                        const float dc =
+                            (centroid_[f] - centroid_[j]).GetLengthSq();
+                        const float dn = (in[f] - in[j]).GetLengthSq();
+                        sum += in[j] * (area_[j] * std::exp(-dc * spatial -
+                                                            dn * range));
+                    }
+                    out[f] = sum.Normalize() > 0.0f ? sum : in[f];
+                }
+            },
+            kParallelGrain);
+        current = 1 - current;
+    }
+    const auto& filtered = normals_[current];
+
+    const auto& offsets = vertex_triangles_.offsets;
+    const auto& corners = vertex_triangles_.corners;
+    positions_[0].assign(positions.begin(), positions.end());
+    positions_[1].resize(vertex_count);
+    current = 0;
+    for (int iteration = 0; iteration < vertex_iterations; ++iteration) {
+        const auto& in = positions_[current];
+        auto& out = positions_[1 - current];
+        pxr::WorkParallelForN(
+            face_count,
+            [&](size_t first, size_t last) {
+                for (size_t f = first; f < last; ++f) {
+                    const auto& tri = triangles_[f];
+                    centroid_[f] = (in[tri[0]] + in[tri[1]] + in[tri[2]]) /
+                                   3.0f;
+                }
+            },
+            kParallelGrain);
+        // Move each vertex towards the planes through its faces' centroids
+        // with the filtered normals.
+        pxr::WorkParallelForN(
+            vertex_count,
+            [&](size_t first, size_t last) {
+                for (size_t v = first; v < last; ++v) {
+                    const uint32_t begin = offsets[v], end = offsets[v + 1];
+                    if (boundary_[v] || begin == end) {
+                        out[v] = in[v];
+                        continue;
+                    }
+                    pxr::GfVec3f shift(0.0f);
+                    for (uint32_t c = begin; c < end; ++c) {
+                        const uint32_t f = corners[c] / 3;
+                        const pxr::GfVec3f& n = filtered[f];
+                        shift += n * pxr::GfDot(n, centroid_[f] - in[v]);
+                    }
+                    out[v] = in[v] + shift / float(end - begin);
+                }
+            },
+            kParallelGrain);
+        current = 1 - current;
+    }
+    std::copy(
+        positions_[current].begin(),
+        positions_[current].end(),
+        positions.begin());
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
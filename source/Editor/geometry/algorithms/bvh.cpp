@@ -0,0 +1,504 @@
+#include "GCore/algorithms/bvh.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+#include "GCore/algorithms/triangulate.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr uint32_t kLeafSize = 4;
+// Subtrees with at least this many triangles build their children in
+// parallel.
+constexpr uint32_t kParallelBuild = 1 << 12;
+constexpr size_t kParallelGrain = 1 << 10;
+constexpr size_t kQueryGrain = 64;
+constexpr int kStackSize = 64;
+
+using Node = TriangleBVH::Node;
+
+struct Box {
+    pxr::GfVec3f lower{ TriangleBVH::kInfinity };
+    pxr::GfVec3f upper{ -TriangleBVH::kInfinity };
+
+    void extend(const pxr::GfVec3f& p)
+    {
+        for (int a = 0; a < 3; ++a) {
+            lower[a] = std::min(lower[a], p[a]);
+            upper[a] = std::max(upper[a], p[a]);
+        }
+    }
+
+    void extend(const Box& b)
+    {
+        extend(b.lower);
+        extend(b.upper);
+    }
+
+    int widest_axis() const
+    {
+        const pxr::GfVec3f e = upper - lower;
+        return e[0] >= e[1] ? (e[0] >= e[2] ? 0 : 2) : (e[1] >= e[2] ? 1 : 2);
+    }
+
+    void store(Node& node) const
+    {
+        for (int a = 0; a < 3; ++a) {
+            node.lower[a] = lower[a];
+            node.upper[a] = upper[a];
+        }
+    }
+};
+
+Box triangle_box(
+    const pxr::GfVec3f* p,
+    const std::array<uint32_t, 3>& t)
+{
+    Box b;
+    b.extend(p[t[0]]);
+    b.extend(p[t[1]]);
+    b.extend(p[t[2]]);
+    return b;
+}
+
+float box_distance2(const Node& node, const pxr::GfVec3f& q)
+{
+    float d2 = 0.0f;
+    for (int a = 0; a < 3; ++a) {
+        const float d =
+            std::max({ node.lower[a] - q[a], 0.0f, q[a] - node.upper[a] });
+        d2 += d * d;
+    }
+    return d2;
+}
+
+// Entry distance of the ray into the box, or infinity on a miss.
+float box_entry(
+    const Node& node,
+    const pxr::GfVec3f& origin,
+    const pxr::GfVec3f& inv_dir,
+    float t_min,
+    float t_max)
+{
+    for (int a = 0; a < 3; ++a) {
+        float t0 = (node.lower[a] - origin[a]) * inv_dir[a];
+        float t1 = (node.upper[a] - origin[a]) * inv_dir[a];
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        t_min = std::max(t_min, t0);
+        t_max = std::min(t_max, t1);
+    }
+    return t_min <= t_max ? t_min : TriangleBVH::kInfinity;
+}
+
+// Closest point on triangle abc (Ericson, Real-Time Collision Detection,
+// 5.1.5). Writes the barycentric weights of a, b, c.
+pxr::GfVec3f closest_on_triangle(
+    const pxr::GfVec3f& p,
+    const pxr::GfVec3f& a,
+    const pxr::GfVec3f& b,
+    const pxr::GfVec3f& c,
+    pxr::GfVec3f& bary)
+{
+    const pxr::GfVec3f ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = pxr::GfDot(ab, ap), d2 = pxr::GfDot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        bary = pxr::GfVec3f(1, 0, 0);
+        return a;
+    }
+    const pxr::GfVec3f bp = p - b;
+    const float d3 = pxr::GfDot(ab, bp), d4 = pxr::GfDot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        bary = pxr::GfVec3f(0, 1, 0);
+        return b;
+    }
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        const float v = d1 / (d1 - d3);
+        bary = pxr::GfVec3f(1 - v, v, 0);
+        return a + v * ab;
+    }
+    const pxr::GfVec3f cp = p - c;
+    const float d5 = pxr::GfDot(ab, cp), d6 = pxr::GfDot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        bary = pxr::GfVec3f(0, 0, 1);
+        return c;
+    }
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        const float w = d2 / (d2 - d6);
+        bary = pxr::GfVec3f(1 - w, 0, w);
+        return a + w * ac;
+    }
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        bary = pxr::GfVec3f(0, 1 - w, w);
+        return b + w * (c - b);
+    }
+    const float denom = 1.0f / (va + vb + vc);
+    const float v = vb * denom, w = vc * denom;
+    bary = pxr::GfVec3f(1 - v - w, v, w);
+    return a + ab * v + ac * w;
+}
+
+// Moller-Trumbore. Returns false on a miss or a hit outside [t_min, t_max].
+bool intersect_triangle(
+    const pxr::GfVec3f& origin,
+    const pxr::GfVec3f& dir,
+    const pxr::GfVec3f& p0,
+    const pxr::GfVec3f& p1,
+    const pxr::GfVec3f& p2,
+    float t_min,
+    float t_max,
+    float& t,
+    float& u,
+    float& v)
+{
+    const pxr::GfVec3f e1 = p1 - p0, e2 = p2 - p0;
+    const pxr::GfVec3f pv = pxr::GfCross(dir, e2);
+    const float det = pxr::GfDot(e1, pv);
+    if (det == 0.0f) {
+        return false;
+    }
+    const float inv_det = 1.0f / det;
+    const pxr::GfVec3f tv = origin - p0;
+    u = pxr::GfDot(tv, pv) * inv_det;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+    const pxr::GfVec3f qv = pxr::GfCross(tv, e1);
+    v = pxr::GfDot(dir, qv) * inv_det;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+    t = pxr::GfDot(e2, qv) * inv_det;
+    return t >= t_min && t <= t_max;
+}
+
+struct Builder {
+    const std::vector<Box>& boxes;
+    const std::vector<pxr::GfVec3f>& centroids;
+    std::vector<uint32_t>& order;
+    std::vector<Node>& nodes;
+    std::atomic<uint32_t> next_node{ 1 };
+
+    void run(uint32_t node_index, uint32_t begin, uint32_t end)
+    {
+        Box bounds, centroid_bounds;
+        for (uint32_t i = begin; i < end; ++i) {
+            bounds.extend(boxes[order[i]]);
+            centroid_bounds.extend(centroids[order[i]]);
+        }
+        Node& node = nodes[node_index];
+        bounds.store(node);
+
+        const int axis = centroid_bounds.widest_axis();
+        const uint32_t size = end - begin;
+        if (size <= kLeafSize ||
+            centroid_bounds.upper[axis] <= centroid_bounds.lower[axis]) {
+            node.first = begin;
+            node.count = size;
+            return;
+        }
+
+        const uint32_t mid = begin + size / 2;
+        std::nth_element(
+            order.begin() + begin,
+            order.begin() + mid,
+            order.begin() + end,
+            [&](uint32_t a, uint32_t b) {
+                return centroids[a][axis] < centroids[b][axis];
+            });
+
+        const uint32_t left = next_node.fetch_add(2);
+        node.first = left;
+        node.count = 0;
+
+        if (size >= kParallelBuild) {
+            pxr::WorkParallelForN(
+                2,
+                [&](size_t b, size_t e) {
+                    for (size_t i = b; i < e; ++i) {
+                        i == 0 ? run(left, begin, mid)
+                               : run(left + 1, mid, end);
+                    }
+                },
+                1);
+        }
+        else {
+            run(left, begin, mid);
+            run(left + 1, mid, end);
+        }
+    }
+};
+
+}  // namespace
+
+bool TriangleBVH::build(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices)
+{
+    clear();
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    std::vector<uint32_t> faces;
+    if (!fan_triangulate(
+            face_vertex_counts,
+            face_vertex_indices,
+            positions.size(),
+            triangles,
+            &faces)) {
+        return false;
+    }
+    positions_ = positions;
+
+    const size_t n = triangles.size();
+    if (n == 0) {
+        return true;
+    }
+
+    const pxr::GfVec3f* p = positions_.cdata();
+    std::vector<Box> boxes(n);
+    std::vector<pxr::GfVec3f> centroids(n);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                boxes[i] = triangle_box(p, triangles[i]);
+                centroids[i] = (boxes[i].lower + boxes[i].upper) * 0.5f;
+            }
+        },
+        kParallelGrain);
+
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+
+    // Every leaf holds at least two triangles, so 2n nodes always suffice.
+    nodes_.resize(2 * n);
+    Builder builder{ boxes, centroids, order, nodes_ };
+    builder.run(0, 0, uint32_t(n));
+    nodes_.resize(builder.next_node.load());
+    nodes_.shrink_to_fit();
+
+    triangles_.resize(n);
+    faces_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        triangles_[i] = triangles[order[i]];
+        faces_[i] = int(faces[order[i]]);
+    }
+    return true;
+}
+
+void TriangleBVH::refit(const pxr::VtArray<pxr::GfVec3f>& positions)
+{
+    positions_ = positions;
+    refit_nodes();
+}
+
+void TriangleBVH::refit_nodes()
+{
+    const pxr::GfVec3f* p = positions_.cdata();
+    // Leaves are independent; inner nodes then follow in reverse order since
+    // children are stored after their parent.
+    pxr::WorkParallelForN(
+        nodes_.size(),
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Node& node = nodes_[i];
+                if (node.count == 0) {
+                    continue;
+                }
+                Box b;
+                for (uint32_t t = 0; t < node.count; ++t) {
+                    b.extend(triangle_box(p, triangles_[node.first + t]));
+                }
+                b.store(node);
+            }
+        },
+        kParallelGrain);
+
+    for (size_t i = nodes_.size(); i-- > 0;) {
+        Node& node = nodes_[i];
+        if (node.count != 0) {
+            continue;
+        }
+        const Node& l = nodes_[node.first];
+        const Node& r = nodes_[node.first + 1];
+        for (int a = 0; a < 3; ++a) {
+            node.lower[a] = std::min(l.lower[a], r.lower[a]);
+            node.upper[a] = std::max(l.upper[a], r.upper[a]);
+        }
+    }
+}
+
+void TriangleBVH::clear()
+{
+    positions_ = {};
+    triangles_ = {};
+    faces_ = {};
+    nodes_ = {};
+}
+
+TriangleBVH::ClosestHit TriangleBVH::closest_point(
+    const pxr::GfVec3f& query,
+    float max_distance) const
+{
+    ClosestHit hit;
+    if (nodes_.empty()) {
+        return hit;
+    }
+    hit.distance2 = max_distance == kInfinity ? kInfinity
+                                              : max_distance * max_distance;
+
+    const pxr::GfVec3f* p = positions_.cdata();
+    uint32_t stack[kStackSize];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+        if (box_distance2(node, query) >= hit.distance2) {
+            continue;
+        }
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                const auto& t = triangles_[i];
+                pxr::GfVec3f bary;
+                const pxr::GfVec3f c =
+                    closest_on_triangle(query, p[t[0]], p[t[1]], p[t[2]], bary);
+                const float d2 = (c - query).GetLengthSq();
+                if (d2 < hit.distance2) {
+                    hit.distance2 = d2;
+                    hit.point = c;
+                    hit.barycentric = bary;
+                    hit.triangle = int(i);
+                    hit.face = faces_[i];
+                }
+            }
+            continue;
+        }
+        // Visit the nearer child first.
+        const float dl = box_distance2(nodes_[node.first], query);
+        const float dr = box_distance2(nodes_[node.first + 1], query);
+        if (dl < dr) {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+        }
+        else {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+        }
+    }
+    return hit;
+}
+
+TriangleBVH::RayHit TriangleBVH::intersect(
+    const pxr::GfVec3f& origin,
+    const pxr::GfVec3f& direction,
+    float t_min,
+    float t_max) const
+{
+    RayHit hit;
+    if (nodes_.empty()) {
+        return hit;
+    }
+    const pxr::GfVec3f inv_dir(
+        1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2]);
+    const pxr::GfVec3f* p = positions_.cdata();
+
+    uint32_t stack[kStackSize];
+    int top = 0;
+    if (box_entry(nodes_[0], origin, inv_dir, t_min, t_max) != kInfinity) {
+        stack[top++] = 0;
+    }
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                const auto& tri = triangles_[i];
+                float t, u, v;
+                if (intersect_triangle(
+                        origin,
+                        direction,
+                        p[tri[0]],
+                        p[tri[1]],
+                        p[tri[2]],
+                        t_min,
+                        t_max,
+                        t,
+                        u,
+                        v)) {
+                    t_max = t;
+                    hit.t = t;
+                    hit.u = u;
+                    hit.v = v;
+                    hit.triangle = int(i);
+                    hit.face = faces_[i];
+                }
+            }
+            continue;
+        }
+        const float tl =
+            box_entry(nodes_[node.first], origin, inv_dir, t_min, t_max);
+        const float tr =
+            box_entry(nodes_[node.first + 1], origin, inv_dir, t_min, t_max);
+        // Push the farther child first so the nearer one is popped next.
+        if (tl <= tr) {
+            if (tr != kInfinity) {
+                stack[top++] = node.first + 1;
+            }
+            if (tl != kInfinity) {
+                stack[top++] = node.first;
+            }
+        }
+        else {
+            if (tl != kInfinity) {
+                stack[top++] = node.first;
+            }
+            stack[top++] = node.first + 1;
+        }
+    }
+    return hit;
+}
+
+void TriangleBVH::closest_points(
+    const pxr::GfVec3f* queries,
+    size_t count,
+    ClosestHit* out,
+    float max_distance) const
+{
+    pxr::WorkParallelForN(
+        count,
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                out[i] = closest_point(queries[i], max_distance);
+            }
+        },
+        kQueryGrain);
+}
+
+void TriangleBVH::intersect_rays(
+    const pxr::GfVec3f* origins,
+    const pxr::GfVec3f* directions,
+    size_t count,
+    RayHit* out,
+    float t_max) const
+{
+    pxr::WorkParallelForN(
+        count,
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                out[i] = intersect(origins[i], directions[i], 0.0f, t_max);
+            }
+        },
+        kQueryGrain);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,148 @@
+#include "GCore/algorithms/compact_topology.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <atomic>
+#include <limits>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 16;
+
+// Narrows and range-checks the indices in one pass. Returns false if any
+// index is outside [0, vertex_count).
+template<typename Index>
+bool narrow_indices(
+    const pxr::VtArray<int>& src,
+    std::vector<Index>& dst,
+    size_t vertex_count)
+{
+    dst.resize(src.size());
+    const int* in = src.cdata();
+    Index* out = dst.data();
+    const unsigned limit = static_cast<unsigned>(vertex_count);
+    std::atomic<bool> valid{ true };
+    pxr::WorkParallelForN(
+        src.size(),
+        [&](size_t begin, size_t end) {
+            // Negative indices wrap to large unsigned values, so one compare
+            // covers both bounds.
+            bool ok = true;
+            for (size_t i = begin; i < end; ++i) {
+                const unsigned v = static_cast<unsigned>(in[i]);
+                ok &= v < limit;
+                out[i] = static_cast<Index>(v);
+            }
+            if (!ok) {
+                valid.store(false, std::memory_order_relaxed);
+            }
+        },
+        kParallelGrain);
+    return valid.load();
+}
+
+}  // namespace
+
+bool CompactTopology::build(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count)
+{
+    clear();
+    if (vertex_count > std::numeric_limits<int>::max()) {
+        return false;
+    }
+
+    const size_t face_count = face_vertex_counts.size();
+    int arity = face_count ? face_vertex_counts[0] : 0;
+    size_t corner_count = 0;
+    for (int count : face_vertex_counts) {
+        if (count <= 0) {
+            return false;
+        }
+        if (count != arity) {
+            arity = 0;
+        }
+        corner_count += count;
+    }
+    if (corner_count != face_vertex_indices.size() ||
+        corner_count > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    if (!arity) {
+        offsets_.resize(face_count + 1);
+        offsets_[0] = 0;
+        for (size_t f = 0; f < face_count; ++f) {
+            offsets_[f + 1] = offsets_[f] + face_vertex_counts[f];
+        }
+    }
+
+    bool valid;
+    if (vertex_count <= size_t(std::numeric_limits<uint16_t>::max()) + 1) {
+        width_ = IndexWidth::U16;
+        valid = narrow_indices(face_vertex_indices, indices16_, vertex_count);
+    }
+    else {
+        width_ = IndexWidth::U32;
+        valid = narrow_indices(face_vertex_indices, indices32_, vertex_count);
+    }
+    if (!valid) {
+        clear();
+        return false;
+    }
+
+    vertex_count_ = vertex_count;
+    face_count_ = face_count;
+    corner_count_ = corner_count;
+    arity_ = arity;
+    return true;
+}
+
+void CompactTopology::clear()
+{
+    vertex_count_ = face_count_ = corner_count_ = 0;
+    arity_ = 0;
+    width_ = IndexWidth::U16;
+    indices16_ = {};
+    indices32_ = {};
+    offsets_ = {};
+}
+
+size_t CompactTopology::memory_bytes() const
+{
+    return indices16_.size() * sizeof(uint16_t) +
+           indices32_.size() * sizeof(uint32_t) +
+           offsets_.size() * sizeof(uint32_t);
+}
+
+pxr::VtArray<int> CompactTopology::face_vertex_counts() const
+{
+    pxr::VtArray<int> counts(face_count_);
+    int* out = counts.data();
+    for (size_t f = 0; f < face_count_; ++f) {
+        out[f] = face_size(f);
+    }
+    return counts;
+}
+
+pxr::VtArray<int> CompactTopology::face_vertex_indices() const
+{
+    pxr::VtArray<int> indices(corner_count_);
+    int* out = indices.data();
+    visit_indices([&](const auto* in) {
+        pxr::WorkParallelForN(
+            corner_count_,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    out[i] = static_cast<int>(in[i]);
+                }
+            },
+            kParallelGrain);
+    });
+    return indices;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
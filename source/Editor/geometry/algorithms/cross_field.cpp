@@ -0,0 +1,389 @@
+#include "GCore/algorithms/cross_field.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+constexpr uint32_t kInvalid = ~0u;
+constexpr double kPi = 3.14159265358979323846;
+
+uint32_t find_root(std::vector<uint32_t>& parent, uint32_t x)
+{
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// Unit complex number for the direction of d in the frame (x, y); 1 for a
+// vector normal to the frame.
+std::complex<double> in_frame(
+    const pxr::GfVec3f& d,
+    const pxr::GfVec3f& x,
+    const pxr::GfVec3f& y)
+{
+    const std::complex<double> c(pxr::GfDot(d, x), pxr::GfDot(d, y));
+    const double length = std::abs(c);
+    return length > 0.0 ? c / length : std::complex<double>(1.0);
+}
+
+}  // namespace
+
+bool CrossFieldSolver::prepare(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    uint64_t topology_version,
+    uint64_t position_version,
+    int symmetry)
+{
+    if (symmetry < 1) {
+        return false;
+    }
+    const bool structure_changed =
+        topology_version != topology_version_ ||
+        face_vertex_counts.size() != free_row_.size() ||
+        face_vertex_indices.size() != face_vertices_.size() || !solver_;
+    const bool values_changed =
+        position_version != position_version_ || symmetry != symmetry_;
+    if (!structure_changed && !values_changed) {
+        return true;
+    }
+
+    if (structure_changed) {
+        clear();
+        if (!build(face_vertex_counts, face_vertex_indices, positions.size())) {
+            clear();
+            return false;
+        }
+        topology_version_ = topology_version;
+    }
+    position_version_ = position_version;
+    symmetry_ = symmetry;
+    if (!refactor(positions, structure_changed)) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool CrossFieldSolver::build(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count)
+{
+    const size_t faces = face_vertex_counts.size();
+    face_offsets_.resize(faces + 1);
+    face_offsets_[0] = 0;
+    for (size_t f = 0; f < faces; ++f) {
+        if (face_vertex_counts[f] < 0) {
+            return false;
+        }
+        face_offsets_[f + 1] = face_offsets_[f] + face_vertex_counts[f];
+    }
+    if (face_offsets_[faces] != face_vertex_indices.size()) {
+        return false;
+    }
+    face_vertices_.resize(face_vertex_indices.size());
+    for (size_t i = 0; i < face_vertex_indices.size(); ++i) {
+        const int v = face_vertex_indices[i];
+        if (v < 0 || size_t(v) >= vertex_count) {
+            return false;
+        }
+        face_vertices_[i] = uint32_t(v);
+    }
+
+    // Edges from sorting the polygon sides on their undirected vertex pair:
+    // one side is a boundary edge, two an interior one.
+    std::vector<std::pair<uint64_t, uint32_t>> sides(face_vertices_.size());
+    pxr::WorkParallelForN(
+        faces,
+        [&](size_t first, size_t last) {
+            for (size_t f = first; f < last; ++f) {
+                const uint32_t begin = face_offsets_[f];
+                const uint32_t end = face_offsets_[f + 1];
+                for (uint32_t c = begin; c < end; ++c) {
+                    const uint32_t a = face_vertices_[c];
+                    const uint32_t b =
+                        face_vertices_[c + 1 < end ? c + 1 : begin];
+                    sides[c] = { uint64_t(std::min(a, b)) << 32 |
+                                     std::max(a, b),
+                                 uint32_t(f) };
+                }
+            }
+        },
+        kParallelGrain);
+    std::sort(sides.begin(), sides.end());
+
+    std::vector<uint32_t> boundary_edge(2 * faces, kInvalid);
+    std::vector<uint32_t> parent(faces);
+    std::iota(parent.begin(), parent.end(), 0u);
+    for (size_t i = 0; i < sides.size();) {
+        size_t j = i + 1;
+        while (j < sides.size() && sides[j].first == sides[i].first) {
+            ++j;
+        }
+        const uint32_t a = uint32_t(sides[i].first >> 32);
+        const uint32_t b = uint32_t(sides[i].first);
+        if (j - i > 2) {
+            return false;
+        }
+        const uint32_t f = sides[i].second;
+        if (j - i == 1 && a != b) {
+            if (boundary_edge[2 * f] == kInvalid) {
+                boundary_edge[2 * f] = a;
+                boundary_edge[2 * f + 1] = b;
+            }
+        }
+        else if (j - i == 2 && f != sides[i + 1].second) {
+            const uint32_t g = sides[i + 1].second;
+            edge_faces_.insert(edge_faces_.end(), { f, g });
+            edge_vertices_.insert(edge_vertices_.end(), { a, b });
+            parent[find_root(parent, f)] = find_root(parent, g);
+        }
+        i = j;
+    }
+
+    // Faces on the boundary, and the first face of every component that has
+    // none, so that each component has something to align to.
+    std::vector<uint8_t> anchored(faces, 0);
+    for (size_t f = 0; f < faces; ++f) {
+        if (boundary_edge[2 * f] != kInvalid) {
+            anchored[find_root(parent, uint32_t(f))] = 1;
+        }
+    }
+    free_row_.assign(faces, 0);
+    for (uint32_t f = 0; f < faces; ++f) {
+        const uint32_t root = find_root(parent, f);
+        if (boundary_edge[2 * f] != kInvalid || !anchored[root]) {
+            anchored[root] = 1;
+            free_row_[f] = -1 - int(constrained_.size());
+            constrained_.push_back(f);
+            constraint_edges_.push_back(boundary_edge[2 * f]);
+            constraint_edges_.push_back(boundary_edge[2 * f + 1]);
+        }
+    }
+    int free_rows = 0;
+    for (int& row : free_row_) {
+        if (row == 0) {
+            row = free_rows++;
+        }
+    }
+    return true;
+}
+
+bool CrossFieldSolver::refactor(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    bool symbolic)
+{
+    const size_t faces = free_row_.size();
+
+    // Frames from the Newell normal and the first side of each polygon.
+    axis_x_.resize(faces);
+    axis_y_.resize(faces);
+    pxr::WorkParallelForN(
+        faces,
+        [&](size_t first, size_t last) {
+            for (size_t f = first; f < last; ++f) {
+                const uint32_t begin = face_offsets_[f];
+                const uint32_t end = face_offsets_[f + 1];
+                pxr::GfVec3f normal(0.0f);
+                for (uint32_t c = begin; c < end; ++c) {
+                    const pxr::GfVec3f& p = positions[face_vertices_[c]];
+                    const pxr::GfVec3f& q =
+                        positions[face_vertices_[c + 1 < end ? c + 1 : begin]];
+                    normal += pxr::GfCross(p, q);
+                }
+                if (normal.Normalize() == 0.0f) {
+                    normal = pxr::GfVec3f(0.0f, 0.0f, 1.0f);
+                }
+                pxr::GfVec3f x(1.0f, 0.0f, 0.0f);
+                if (end - begin >= 2) {
+                    x = positions[face_vertices_[begin + 1]] -
+                        positions[face_vertices_[begin]];
+                }
+                x -= pxr::GfDot(x, normal) * normal;
+                if (x.Normalize() == 0.0f) {
+                    x = std::abs(normal[0]) < 0.9f
+                            ? pxr::GfVec3f(1.0f, 0.0f, 0.0f)
+                            : pxr::GfVec3f(0.0f, 1.0f, 0.0f);
+                    x -= pxr::GfDot(x, normal) * normal;
+                    x.Normalize();
+                }
+                axis_x_[f] = x;
+                axis_y_[f] = pxr::GfCross(normal, x);
+            }
+        },
+        kParallelGrain);
+
+    boundary_directions_.resize(constrained_.size());
+    for (size_t i = 0; i < constrained_.size(); ++i) {
+        const uint32_t f = constrained_[i];
+        const uint32_t a = constraint_edges_[2 * i];
+        const uint32_t b = constraint_edges_[2 * i + 1];
+        boundary_directions_[i] =
+            a == kInvalid
+                ? axis_x_[f]
+                : pxr::GfCross(
+                      pxr::GfCross(axis_x_[f], axis_y_[f]),
+                      positions[b] - positions[a])
+                      .GetNormalized();
+    }
+
+    // Row z_f conj(e_f)^N - z_g conj(e_g)^N of the least squares system per
+    // interior edge; its contribution to the normal equations is written to
+    // four fixed slots, so the assembly runs in parallel.
+    const size_t edges = edge_faces_.size() / 2;
+    std::vector<Eigen::Triplet<Complex>> triplets(4 * edges);
+    pxr::WorkParallelForN(
+        edges,
+        [&](size_t first, size_t last) {
+            for (size_t e = first; e < last; ++e) {
+                const uint32_t f = edge_faces_[2 * e];
+                const uint32_t g = edge_faces_[2 * e + 1];
+                const pxr::GfVec3f d = positions[edge_vertices_[2 * e + 1]] -
+                                       positions[edge_vertices_[2 * e]];
+                const Complex rho_f =
+                    std::pow(std::conj(in_frame(d, axis_x_[f], axis_y_[f])),
+                             symmetry_);
+                const Complex rho_g =
+                    std::pow(std::conj(in_frame(d, axis_x_[g], axis_y_[g])),
+                             symmetry_);
+                const Complex coupling = -std::conj(rho_f) * rho_g;
+                triplets[4 * e] = { int(f), int(f), 1.0 };
+                triplets[4 * e + 1] = { int(g), int(g), 1.0 };
+                triplets[4 * e + 2] = { int(f), int(g), coupling };
+                triplets[4 * e + 3] = { int(g), int(f), std::conj(coupling) };
+            }
+        },
+        kParallelGrain);
+    const int rows = int(faces);
+    Eigen::SparseMatrix<Complex> equations(rows, rows);
+    equations.setFromTriplets(triplets.begin(), triplets.end());
+
+    // Split the columns into free and constrained faces, dropping the
+    // constrained rows; the pattern is the same on every call with the same
+    // structure.
+    const int free_count = int(faces - constrained_.size());
+    std::vector<Eigen::Triplet<Complex>> free_free, free_fixed;
+    free_free.reserve(equations.nonZeros());
+    for (int column = 0; column < equations.outerSize(); ++column) {
+        const int c = free_row_[column];
+        for (Eigen::SparseMatrix<Complex>::InnerIterator it(equations, column);
+             it;
+             ++it) {
+            const int r = free_row_[it.row()];
+            if (r < 0) {
+                continue;
+            }
+            if (c >= 0) {
+                free_free.emplace_back(r, c, it.value());
+            }
+            else {
+                free_fixed.emplace_back(r, -1 - c, it.value());
+            }
+        }
+    }
+    free_free_.resize(free_count, free_count);
+    free_free_.setFromTriplets(free_free.begin(), free_free.end());
+    free_fixed_.resize(free_count, int(constrained_.size()));
+    free_fixed_.setFromTriplets(free_fixed.begin(), free_fixed.end());
+
+    if (symbolic || !solver_) {
+        solver_ = std::make_shared<Solver>();
+        if (free_count > 0) {
+            solver_->analyzePattern(free_free_);
+        }
+        ++symbolic_count_;
+    }
+    if (free_count > 0) {
+        solver_->factorize(free_free_);
+        ++numeric_count_;
+        return solver_->info() == Eigen::Success;
+    }
+    return true;
+}
+
+CrossFieldSolver::Complex CrossFieldSolver::encode(
+    uint32_t f,
+    const pxr::GfVec3f& u) const
+{
+    return std::pow(in_frame(u, axis_x_[f], axis_y_[f]), symmetry_);
+}
+
+void CrossFieldSolver::boundary_directions(
+    std::vector<pxr::GfVec3f>& directions) const
+{
+    directions = boundary_directions_;
+}
+
+bool CrossFieldSolver::solve(
+    const std::vector<pxr::GfVec3f>& directions,
+    pxr::VtArray<pxr::GfVec3f>& field) const
+{
+    if (!solver_ || directions.size() != constrained_.size()) {
+        return false;
+    }
+    Eigen::VectorXcd fixed(constrained_.size());
+    for (size_t i = 0; i < constrained_.size(); ++i) {
+        fixed[i] = encode(constrained_[i], directions[i]);
+    }
+    Eigen::VectorXcd free;
+    if (free_free_.rows() > 0) {
+        free = solver_->solve(-(free_fixed_ * fixed));
+        if (solver_->info() != Eigen::Success) {
+            return false;
+        }
+    }
+
+    // Any N-th root of z, and its rotations by 2 pi / N.
+    const size_t n = size_t(symmetry_);
+    field.resize(free_row_.size() * n);
+    pxr::WorkParallelForN(
+        free_row_.size(),
+        [&](size_t first, size_t last) {
+            for (size_t f = first; f < last; ++f) {
+                const int row = free_row_[f];
+                const Complex z = row >= 0 ? free[row] : fixed[-1 - row];
+                const double angle = std::arg(z) / symmetry_;
+                for (size_t k = 0; k < n; ++k) {
+                    const double a = angle + 2.0 * kPi * k / symmetry_;
+                    field[f * n + k] = float(std::cos(a)) * axis_x_[f] +
+                                       float(std::sin(a)) * axis_y_[f];
+                }
+            }
+        },
+        kParallelGrain);
+    return true;
+}
+
+void CrossFieldSolver::clear()
+{
+    topology_version_ = 0;
+    position_version_ = 0;
+    symmetry_ = 0;
+    face_offsets_.clear();
+    face_vertices_.clear();
+    edge_faces_.clear();
+    edge_vertices_.clear();
+    free_row_.clear();
+    constrained_.clear();
+    constraint_edges_.clear();
+    axis_x_.clear();
+    axis_y_.clear();
+    boundary_directions_.clear();
+    free_free_.resize(0, 0);
+    free_fixed_.resize(0, 0);
+    solver_.reset();
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
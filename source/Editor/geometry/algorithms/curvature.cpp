@@ -0,0 +1,346 @@
+#include "GCore/algorithms/curvature.h"
+
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+constexpr double kPi = 3.14159265358979323846;
+
+// Any unit vector orthogonal to unit n.
+pxr::GfVec3d orthogonal(const pxr::GfVec3d& n)
+{
+    const pxr::GfVec3d axis = std::abs(n[0]) < 0.9 ? pxr::GfVec3d(1, 0, 0)
+                                                   : pxr::GfVec3d(0, 1, 0);
+    return pxr::GfCross(n, axis).GetNormalized();
+}
+
+// Solves the symmetric positive semi-definite system m x = b by Cramer's
+// rule. Returns false if m is singular.
+bool solve_3x3(const double m[3][3], const double b[3], double x[3])
+{
+    const double c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    const double c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    const double c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    const double det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    if (!(std::abs(det) > 0.0)) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        double column[3][3];
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                column[r][c] = c == i ? b[r] : m[r][c];
+            }
+        }
+        x[i] = (column[0][0] * (column[1][1] * column[2][2] -
+                                column[1][2] * column[2][1]) -
+                column[0][1] * (column[1][0] * column[2][2] -
+                                column[1][2] * column[2][0]) +
+                column[0][2] * (column[1][0] * column[2][1] -
+                                column[1][1] * column[2][0])) /
+               det;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool CurvatureKernel::set_topology(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count)
+{
+    clear();
+    if (!fan_triangulate(
+            face_vertex_counts,
+            face_vertex_indices,
+            vertex_count,
+            triangles_)) {
+        return false;
+    }
+    vertex_triangles_.build(triangles_, vertex_count);
+
+    const auto& offsets = vertex_triangles_.offsets;
+    const auto& corners = vertex_triangles_.corners;
+    kinds_.resize(vertex_count);
+    pxr::WorkParallelForN(
+        vertex_count,
+        [&](size_t first, size_t last) {
+            std::vector<std::pair<uint32_t, uint32_t>> fan;
+            for (size_t v = first; v < last; ++v) {
+                fan.clear();
+                for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+                    const auto& tri = triangles_[corners[c] / 3];
+                    const uint32_t k = corners[c] % 3;
+                    fan.emplace_back(tri[(k + 1) % 3], tri[(k + 2) % 3]);
+                }
+                kinds_[v] = classify(fan);
+            }
+        },
+        kParallelGrain);
+    non_manifold_vertex_count_ =
+        std::count(kinds_.begin(), kinds_.end(), VertexKind::NonManifold);
+    return true;
+}
+
+CurvatureKernel::VertexKind CurvatureKernel::classify(
+    std::vector<std::pair<uint32_t, uint32_t>>& fan)
+{
+    if (fan.empty()) {
+        return VertexKind::Boundary;
+    }
+    // Every triangle leads from its neighbor after the vertex to the one
+    // before it. On an oriented manifold each neighbor leads to at most one
+    // other and is reached from at most one, and following the steps from
+    // the start of the fan, or from anywhere on a closed fan, visits every
+    // triangle once.
+    std::sort(fan.begin(), fan.end());
+    std::vector<uint32_t> reached(fan.size());
+    for (size_t i = 0; i < fan.size(); ++i) {
+        if (i > 0 && fan[i].first == fan[i - 1].first) {
+            return VertexKind::NonManifold;
+        }
+        reached[i] = fan[i].second;
+    }
+    std::sort(reached.begin(), reached.end());
+    if (std::adjacent_find(reached.begin(), reached.end()) != reached.end()) {
+        return VertexKind::NonManifold;
+    }
+
+    size_t starts = 0;
+    uint32_t start = fan[0].first;
+    for (const auto& [from, to] : fan) {
+        if (!std::binary_search(reached.begin(), reached.end(), from)) {
+            ++starts;
+            start = from;
+        }
+    }
+    if (starts > 1) {
+        return VertexKind::NonManifold;
+    }
+
+    size_t steps = 0;
+    uint32_t at = start;
+    while (true) {
+        auto step = std::lower_bound(
+            fan.begin(),
+            fan.end(),
+            std::pair<uint32_t, uint32_t>(at, 0));
+        if (step == fan.end() || step->first != at) {
+            break;
+        }
+        at = step->second;
+        ++steps;
+        if (at == start) {
+            break;
+        }
+    }
+    if (steps != fan.size()) {
+        return VertexKind::NonManifold;
+    }
+    return starts == 0 ? VertexKind::Interior : VertexKind::Boundary;
+}
+
+void CurvatureKernel::clear()
+{
+    triangles_.clear();
+    vertex_triangles_ = {};
+    kinds_.clear();
+    non_manifold_vertex_count_ = 0;
+}
+
+void CurvatureKernel::compute(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    CurvatureField& out,
+    bool principal) const
+{
+    const size_t n = vertex_count();
+    out.area.resize(n);
+    out.normal.resize(n);
+    out.mean.resize(n);
+    out.gaussian.resize(n);
+    out.k1.resize(principal ? n : 0);
+    out.k2.resize(principal ? n : 0);
+    out.direction1.resize(principal ? n : 0);
+    out.direction2.resize(principal ? n : 0);
+
+    const pxr::GfVec3f* p = positions.cdata();
+    const auto& offsets = vertex_triangles_.offsets;
+    const auto& corners = vertex_triangles_.corners;
+
+    // The one-ring sums are done in double: on fine meshes the angle defect
+    // and the cotangent Laplacian are small differences of much larger
+    // terms, and float loses them well before 10^7 vertices.
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                const pxr::GfVec3d pi(p[v]);
+                double area = 0.0, angle = 0.0;
+                pxr::GfVec3d laplace(0.0), normal(0.0);
+                for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+                    const auto& tri = triangles_[corners[c] / 3];
+                    const uint32_t k = corners[c] % 3;
+                    const pxr::GfVec3d pj(p[tri[(k + 1) % 3]]);
+                    const pxr::GfVec3d pl(p[tri[(k + 2) % 3]]);
+                    const pxr::GfVec3d a = pj - pi, b = pl - pi, e = pl - pj;
+                    const pxr::GfVec3d cross = pxr::GfCross(a, b);
+                    const double area2 = cross.GetLength();
+                    if (!(area2 > 0.0)) {
+                        continue;
+                    }
+                    normal += cross;
+
+                    const double dot_i = pxr::GfDot(a, b);
+                    const double dot_j = -pxr::GfDot(a, e);
+                    const double dot_l = pxr::GfDot(b, e);
+                    const double cot_j = dot_j / area2, cot_l = dot_l / area2;
+                    angle += std::atan2(area2, dot_i);
+                    // Edge ij faces the angle at l, edge il the one at j.
+                    laplace -= a * cot_l + b * cot_j;
+
+                    // Voronoi area if the triangle is not obtuse, else half
+                    // or a quarter of it depending on where the obtuse angle
+                    // is.
+                    const double voronoi =
+                        (a.GetLengthSq() * cot_l + b.GetLengthSq() * cot_j) /
+                        8.0;
+                    area += dot_i < 0.0                    ? area2 / 4.0
+                            : dot_j < 0.0 || dot_l < 0.0 ? area2 / 8.0
+                                                          : voronoi;
+                }
+
+                normal.Normalize();
+                out.normal[v] = pxr::GfVec3f(normal);
+                out.area[v] = float(area);
+                const VertexKind kind = kinds_[v];
+                if (area > 0.0 && kind != VertexKind::NonManifold) {
+                    // laplace / 2A is the mean curvature normal 2 H n.
+                    const double h = laplace.GetLength() / (4.0 * area);
+                    const bool interior = kind == VertexKind::Interior;
+                    out.mean[v] = float(
+                        !interior                           ? 0.0
+                        : pxr::GfDot(laplace, normal) < 0.0 ? -h
+                                                            : h);
+                    out.gaussian[v] =
+                        float(((interior ? 2.0 * kPi : kPi) - angle) / area);
+                }
+                else {
+                    out.mean[v] = 0.0f;
+                    out.gaussian[v] = 0.0f;
+                }
+            }
+        },
+        kParallelGrain);
+
+    if (!principal) {
+        return;
+    }
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                const pxr::GfVec3d normal(out.normal[v]);
+                const pxr::GfVec3d t1 = orthogonal(normal);
+                const pxr::GfVec3d t2 = pxr::GfCross(normal, t1);
+
+                // Second fundamental form of every triangle around v, fitted
+                // to how the vertex normals change along its edges, turned
+                // into the tangent plane of v and weighted by area.
+                double m00 = 0.0, m01 = 0.0, m11 = 0.0;
+                for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+                    const auto& tri = triangles_[corners[c] / 3];
+                    const pxr::GfVec3d q[3] = { pxr::GfVec3d(p[tri[0]]),
+                                                pxr::GfVec3d(p[tri[1]]),
+                                                pxr::GfVec3d(p[tri[2]]) };
+                    const pxr::GfVec3d nq[3] = {
+                        pxr::GfVec3d(out.normal[tri[0]]),
+                        pxr::GfVec3d(out.normal[tri[1]]),
+                        pxr::GfVec3d(out.normal[tri[2]])
+                    };
+                    pxr::GfVec3d face = pxr::GfCross(q[1] - q[0], q[2] - q[0]);
+                    const double area2 = face.Normalize();
+                    if (!(area2 > 0.0)) {
+                        continue;
+                    }
+                    const pxr::GfVec3d u = (q[1] - q[0]).GetNormalized();
+                    const pxr::GfVec3d w = pxr::GfCross(face, u);
+
+                    // Least squares for the symmetric [[a, b], [b, c]] with
+                    // II e = dn on the three edges, via normal equations.
+                    double ata[3][3] = {}, atb[3] = {};
+                    for (int e = 0; e < 3; ++e) {
+                        const int from = (e + 1) % 3, to = (e + 2) % 3;
+                        const pxr::GfVec3d edge = q[to] - q[from];
+                        const pxr::GfVec3d dn = nq[to] - nq[from];
+                        const double eu = pxr::GfDot(edge, u);
+                        const double ew = pxr::GfDot(edge, w);
+                        const double rows[2][3] = { { eu, ew, 0.0 },
+                                                    { 0.0, eu, ew } };
+                        const double rhs[2] = { pxr::GfDot(dn, u),
+                                                pxr::GfDot(dn, w) };
+                        for (int r = 0; r < 2; ++r) {
+                            for (int i = 0; i < 3; ++i) {
+                                for (int j = 0; j < 3; ++j) {
+                                    ata[i][j] += rows[r][i] * rows[r][j];
+                                }
+                                atb[i] += rows[r][i] * rhs[r];
+                            }
+                        }
+                    }
+                    double abc[3];
+                    if (!solve_3x3(ata, atb, abc)) {
+                        continue;
+                    }
+
+                    // Tangent basis of v rotated onto the triangle's plane.
+                    pxr::GfVec3d r1 = t1, r2 = t2;
+                    const double cosine = pxr::GfDot(normal, face);
+                    if (cosine <= -1.0) {
+                        r1 = -r1;
+                        r2 = -r2;
+                    }
+                    else {
+                        const pxr::GfVec3d perp = face - normal * cosine;
+                        const pxr::GfVec3d shift =
+                            (normal + face) / (1.0 + cosine);
+                        r1 -= shift * pxr::GfDot(r1, perp);
+                        r2 -= shift * pxr::GfDot(r2, perp);
+                    }
+                    const double u1 = pxr::GfDot(r1, u), w1 = pxr::GfDot(r1, w);
+                    const double u2 = pxr::GfDot(r2, u), w2 = pxr::GfDot(r2, w);
+                    const double a = abc[0], b = abc[1], cc = abc[2];
+                    m00 += area2 * (a * u1 * u1 + 2 * b * u1 * w1 +
+                                    cc * w1 * w1);
+                    m01 += area2 * (a * u1 * u2 + b * (u1 * w2 + u2 * w1) +
+                                    cc * w1 * w2);
+                    m11 += area2 * (a * u2 * u2 + 2 * b * u2 * w2 +
+                                    cc * w2 * w2);
+                }
+
+                // Eigenvector of the larger eigenvalue.
+                const double theta = 0.5 * std::atan2(2.0 * m01, m00 - m11);
+                const pxr::GfVec3d d1 =
+                    t1 * std::cos(theta) + t2 * std::sin(theta);
+                out.direction1[v] = pxr::GfVec3f(d1);
+                out.direction2[v] = pxr::GfVec3f(pxr::GfCross(normal, d1));
+
+                const float h = out.mean[v];
+                const float spread =
+                    std::sqrt(std::max(h * h - out.gaussian[v], 0.0f));
+                out.k1[v] = h + spread;
+                out.k2[v] = h - spread;
+            }
+        },
+        kParallelGrain);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
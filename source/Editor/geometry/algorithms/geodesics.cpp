@@ -0,0 +1,328 @@
+#include "GCore/algorithms/geodesics.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "GCore/algorithms/dary_heap.h"
+#include "GCore/algorithms/laplacian.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+pxr::GfVec3d point(const pxr::VtArray<pxr::GfVec3f>& positions, uint32_t v)
+{
+    return pxr::GfVec3d(positions[v]);
+}
+
+}  // namespace
+
+bool HeatGeodesics::build(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    double time_scale)
+{
+    clear();
+    if (!fan_triangulate(
+            face_vertex_counts,
+            face_vertex_indices,
+            positions.size(),
+            triangles_)) {
+        return false;
+    }
+    vertex_triangles_.build(triangles_, positions.size());
+
+    triangle_data_.resize(triangles_.size());
+    pxr::WorkParallelForN(
+        triangles_.size(),
+        [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; ++t) {
+                const auto& tri = triangles_[t];
+                const pxr::GfVec3d p[3] = { point(positions, tri[0]),
+                                            point(positions, tri[1]),
+                                            point(positions, tri[2]) };
+                const pxr::GfVec3d n = pxr::GfCross(p[1] - p[0], p[2] - p[0]);
+                const double area2 = n.GetLength();
+                TriangleData& data = triangle_data_[t];
+                for (int k = 0; k < 3; ++k) {
+                    const int i = (k + 1) % 3, j = (k + 2) % 3;
+                    if (area2 > 0.0) {
+                        // grad phi_k = N x e_k / 2A, e_k the opposite edge
+                        // in counter-clockwise order; n is N * 2A.
+                        data.gradient[k] =
+                            pxr::GfCross(n, p[j] - p[i]) / (area2 * area2);
+                        data.cot[k] =
+                            pxr::GfDot(p[i] - p[k], p[j] - p[k]) / area2;
+                    }
+                    else {
+                        data.gradient[k] = pxr::GfVec3d(0.0);
+                        data.cot[k] = 0.0;
+                    }
+                }
+            }
+        },
+        kParallelGrain);
+
+    Eigen::SparseMatrix<double> L;
+    Eigen::VectorXd mass;
+    cotan_laplacian(positions, triangles_, L);
+    barycentric_mass(positions, triangles_, mass);
+
+    double edge_length = 0.0;
+    for (const auto& tri : triangles_) {
+        for (int k = 0; k < 3; ++k) {
+            edge_length += (point(positions, tri[(k + 1) % 3]) -
+                            point(positions, tri[k]))
+                               .GetLength();
+        }
+    }
+    if (!triangles_.empty()) {
+        edge_length /= 3.0 * triangles_.size();
+    }
+    const double t = time_scale * edge_length * edge_length;
+
+    Eigen::SparseMatrix<double> M(mass.size(), mass.size());
+    M.setIdentity();
+    M.diagonal() = mass;
+
+    auto heat_solver = std::make_shared<Solver>(M + t * L);
+    // L is singular on every connected component; the small mass term pins
+    // the constant without visibly changing the solution.
+    const double mean_mass = mass.size() ? mass.mean() : 1.0;
+    auto poisson_solver = std::make_shared<Solver>(
+        L + (1e-8 / std::max(mean_mass, 1e-30)) * M);
+    if (heat_solver->info() != Eigen::Success ||
+        poisson_solver->info() != Eigen::Success) {
+        clear();
+        return false;
+    }
+    heat_solver_ = std::move(heat_solver);
+    poisson_solver_ = std::move(poisson_solver);
+
+    positions_ = positions;
+    time_scale_ = time_scale;
+    return true;
+}
+
+void HeatGeodesics::clear()
+{
+    positions_ = {};
+    triangles_.clear();
+    triangle_data_.clear();
+    vertex_triangles_ = {};
+    heat_solver_.reset();
+    poisson_solver_.reset();
+    time_scale_ = 0.0;
+}
+
+void HeatGeodesics::compute(
+    const std::vector<uint32_t>& sources,
+    std::vector<float>& out) const
+{
+    const size_t n = positions_.size();
+    out.assign(n, 0.0f);
+    Eigen::VectorXd heat = Eigen::VectorXd::Zero(n);
+    size_t source_count = 0;
+    for (uint32_t s : sources) {
+        if (s < n && heat[s] == 0.0) {
+            heat[s] = 1.0;
+            ++source_count;
+        }
+    }
+    if (source_count == 0 || !heat_solver_) {
+        return;
+    }
+    const Eigen::VectorXd u = heat_solver_->solve(heat);
+
+    // Unit field pointing away from the sources, one vector per triangle.
+    std::vector<pxr::GfVec3d> field(triangles_.size());
+    pxr::WorkParallelForN(
+        triangles_.size(),
+        [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; ++t) {
+                const auto& tri = triangles_[t];
+                const auto& g = triangle_data_[t].gradient;
+                pxr::GfVec3d grad =
+                    g[0] * u[tri[0]] + g[1] * u[tri[1]] + g[2] * u[tri[2]];
+                const double length = grad.GetLength();
+                field[t] = length > 0.0 ? grad / -length : pxr::GfVec3d(0.0);
+            }
+        },
+        kParallelGrain);
+
+    // Divergence, gathered per vertex so that no two threads write the same
+    // entry: 1/2 sum over its triangles of cot(angle opposite each incident
+    // edge) times that edge dotted with the field.
+    Eigen::VectorXd divergence(n);
+    const auto& offsets = vertex_triangles_.offsets;
+    const auto& corners = vertex_triangles_.corners;
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                const pxr::GfVec3d pv = point(positions_, uint32_t(v));
+                double sum = 0.0;
+                for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+                    const uint32_t t = corners[c] / 3, k = corners[c] % 3;
+                    const uint32_t i = (k + 1) % 3, j = (k + 2) % 3;
+                    const auto& tri = triangles_[t];
+                    const auto& cot = triangle_data_[t].cot;
+                    const pxr::GfVec3d& x = field[t];
+                    sum += cot[j] *
+                               pxr::GfDot(point(positions_, tri[i]) - pv, x) +
+                           cot[i] *
+                               pxr::GfDot(point(positions_, tri[j]) - pv, x);
+                }
+                divergence[v] = 0.5 * sum;
+            }
+        },
+        kParallelGrain);
+
+    // L is the negated Laplacian, so L phi = -div X.
+    const Eigen::VectorXd phi = poisson_solver_->solve(-divergence);
+
+    double shift = 0.0;
+    for (uint32_t s : sources) {
+        if (s < n && heat[s] != 0.0) {
+            shift += phi[s];
+            heat[s] = 0.0;
+        }
+    }
+    shift /= double(source_count);
+    for (size_t v = 0; v < n; ++v) {
+        out[v] = float(phi[v] - shift);
+    }
+}
+
+bool FastMarching::build(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices)
+{
+    clear();
+    if (!fan_triangulate(
+            face_vertex_counts,
+            face_vertex_indices,
+            positions.size(),
+            triangles_)) {
+        return false;
+    }
+    vertex_triangles_.build(triangles_, positions.size());
+    positions_ = positions;
+    return true;
+}
+
+void FastMarching::clear()
+{
+    positions_ = {};
+    triangles_.clear();
+    vertex_triangles_ = {};
+}
+
+void FastMarching::compute(
+    const std::vector<uint32_t>& sources,
+    std::vector<float>& out) const
+{
+    struct Entry {
+        double key;
+        uint32_t vertex;
+
+        bool operator<(const Entry& o) const
+        {
+            return key < o.key;
+        }
+    };
+
+    const size_t n = positions_.size();
+    std::vector<double> distance(n, kInfinity);
+    std::vector<uint8_t> accepted(n, 0);
+    DaryHeap<Entry> heap;
+    for (uint32_t s : sources) {
+        if (s < n && distance[s] != 0.0) {
+            distance[s] = 0.0;
+            heap.push({ 0.0, s });
+        }
+    }
+
+    // Arrival time at x from accepted y and z, through the triangle if the
+    // wavefront crosses it, else along the shorter edge.
+    auto update = [&](uint32_t x, uint32_t y, uint32_t z) {
+        const pxr::GfVec3d px = point(positions_, x);
+        const pxr::GfVec3d a = point(positions_, y) - px;
+        const pxr::GfVec3d b = point(positions_, z) - px;
+        const double ty = distance[y], tz = distance[z];
+        double best = std::min(ty + a.GetLength(), tz + b.GetLength());
+
+        // Q = (V^T V)^-1 for V = [a b]; solve (p1 - t)^T Q (p1 - t) = 1.
+        const double aa = pxr::GfDot(a, a), ab = pxr::GfDot(a, b),
+                     bb = pxr::GfDot(b, b);
+        const double det = aa * bb - ab * ab;
+        if (det <= 1e-12 * aa * bb) {
+            return best;
+        }
+        const double q00 = bb / det, q01 = -ab / det, q11 = aa / det;
+        const double qa = q00 + 2.0 * q01 + q11;
+        const double qb = (q00 + q01) * ty + (q01 + q11) * tz;
+        const double qc =
+            q00 * ty * ty + 2.0 * q01 * ty * tz + q11 * tz * tz - 1.0;
+        const double disc = qb * qb - qa * qc;
+        if (qa <= 0.0 || disc < 0.0) {
+            return best;
+        }
+        const double p = (qb + std::sqrt(disc)) / qa;
+        // The front must reach x from inside the triangle: -grad lies in
+        // the cone of a and b, i.e. Q (p1 - t) >= 0.
+        const double wy = q00 * (p - ty) + q01 * (p - tz);
+        const double wz = q01 * (p - ty) + q11 * (p - tz);
+        if (p >= std::max(ty, tz) && wy >= 0.0 && wz >= 0.0) {
+            best = std::min(best, p);
+        }
+        return best;
+    };
+
+    const auto& offsets = vertex_triangles_.offsets;
+    const auto& corners = vertex_triangles_.corners;
+    while (!heap.empty()) {
+        const Entry e = heap.pop();
+        const uint32_t v = e.vertex;
+        if (accepted[v]) {
+            continue;
+        }
+        accepted[v] = 1;
+        for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+            const auto& tri = triangles_[corners[c] / 3];
+            const uint32_t k = corners[c] % 3;
+            for (uint32_t step = 1; step < 3; ++step) {
+                const uint32_t x = tri[(k + step) % 3];
+                const uint32_t other = tri[(k + 3 - step) % 3];
+                if (accepted[x] || x == v) {
+                    continue;
+                }
+                const double d =
+                    accepted[other] && other != x
+                        ? update(x, v, other)
+                        : distance[v] +
+                              (point(positions_, x) - point(positions_, v))
+                                  .GetLength();
+                if (d < distance[x]) {
+                    distance[x] = d;
+                    heap.push({ d, x });
+                }
+            }
+        }
+    }
+
+    out.resize(n);
+    for (size_t v = 0; v < n; ++v) {
+        out[v] = float(distance[v]);
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,223 @@
+#include "GCore/algorithms/kd_tree.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Ranges this small are scanned linearly.
+constexpr size_t kLeafSize = 8;
+constexpr size_t kParallelBuild = 1 << 13;
+constexpr size_t kQueryGrain = 64;
+
+struct Builder {
+    const pxr::GfVec3f* points;
+    std::vector<uint32_t>& order;
+    std::vector<uint8_t>& axes;
+
+    void run(size_t begin, size_t end)
+    {
+        if (end - begin <= kLeafSize) {
+            return;
+        }
+        pxr::GfVec3f lower(PointKdTree::kInfinity);
+        pxr::GfVec3f upper(-PointKdTree::kInfinity);
+        for (size_t i = begin; i < end; ++i) {
+            const pxr::GfVec3f& p = points[order[i]];
+            for (int a = 0; a < 3; ++a) {
+                lower[a] = std::min(lower[a], p[a]);
+                upper[a] = std::max(upper[a], p[a]);
+            }
+        }
+        const pxr::GfVec3f e = upper - lower;
+        const int axis =
+            e[0] >= e[1] ? (e[0] >= e[2] ? 0 : 2) : (e[1] >= e[2] ? 1 : 2);
+
+        const size_t mid = begin + (end - begin) / 2;
+        std::nth_element(
+            order.begin() + begin,
+            order.begin() + mid,
+            order.begin() + end,
+            [&](uint32_t a, uint32_t b) {
+                return points[a][axis] < points[b][axis];
+            });
+        axes[mid] = uint8_t(axis);
+
+        if (end - begin >= kParallelBuild) {
+            pxr::WorkParallelForN(
+                2,
+                [&](size_t b, size_t e) {
+                    for (size_t i = b; i < e; ++i) {
+                        i == 0 ? run(begin, mid) : run(mid + 1, end);
+                    }
+                },
+                1);
+        }
+        else {
+            run(begin, mid);
+            run(mid + 1, end);
+        }
+    }
+};
+
+}  // namespace
+
+void PointKdTree::build(const pxr::VtArray<pxr::GfVec3f>& points)
+{
+    clear();
+    const size_t n = points.size();
+    if (n == 0) {
+        return;
+    }
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    axes_.assign(n, 0);
+    Builder{ points.cdata(), order, axes_ }.run(0, n);
+
+    points_.resize(n);
+    indices_.resize(n);
+    pxr::WorkParallelForN(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            points_[i] = points[order[i]];
+            indices_[i] = int(order[i]);
+        }
+    });
+}
+
+void PointKdTree::clear()
+{
+    points_ = {};
+    indices_ = {};
+    axes_ = {};
+}
+
+// Calls visit(i, d2) for every point i (tree order) with d2 < bound2. The
+// visitor may tighten bound2 to prune the rest of the search.
+template<typename Visit>
+void PointKdTree::search(
+    const pxr::GfVec3f& query,
+    size_t begin,
+    size_t end,
+    float& bound2,
+    Visit& visit) const
+{
+    if (end - begin <= kLeafSize) {
+        for (size_t i = begin; i < end; ++i) {
+            const float d2 = (points_[i] - query).GetLengthSq();
+            if (d2 < bound2) {
+                visit(i, d2);
+            }
+        }
+        return;
+    }
+    const size_t mid = begin + (end - begin) / 2;
+    const int axis = axes_[mid];
+    const float diff = query[axis] - points_[mid][axis];
+
+    const float d2 = (points_[mid] - query).GetLengthSq();
+    if (d2 < bound2) {
+        visit(mid, d2);
+    }
+    if (diff < 0) {
+        search(query, begin, mid, bound2, visit);
+        if (diff * diff < bound2) {
+            search(query, mid + 1, end, bound2, visit);
+        }
+    }
+    else {
+        search(query, mid + 1, end, bound2, visit);
+        if (diff * diff < bound2) {
+            search(query, begin, mid, bound2, visit);
+        }
+    }
+}
+
+PointKdTree::Neighbor PointKdTree::nearest(
+    const pxr::GfVec3f& query,
+    float max_distance) const
+{
+    Neighbor best;
+    float bound2 = max_distance == kInfinity ? kInfinity
+                                             : max_distance * max_distance;
+    auto visit = [&](size_t i, float d2) {
+        best.index = indices_[i];
+        best.distance2 = d2;
+        bound2 = d2;
+    };
+    search(query, 0, points_.size(), bound2, visit);
+    return best;
+}
+
+void PointKdTree::k_nearest(
+    const pxr::GfVec3f& query,
+    size_t k,
+    std::vector<Neighbor>& out,
+    float max_distance) const
+{
+    out.clear();
+    if (k == 0) {
+        return;
+    }
+    auto farther = [](const Neighbor& a, const Neighbor& b) {
+        return a.distance2 < b.distance2;
+    };
+    // Max-heap on distance; its top bounds the search once it holds k.
+    std::priority_queue<Neighbor, std::vector<Neighbor>, decltype(farther)>
+        heap(farther);
+    float bound2 = max_distance == kInfinity ? kInfinity
+                                             : max_distance * max_distance;
+    auto visit = [&](size_t i, float d2) {
+        heap.push({ indices_[i], d2 });
+        if (heap.size() > k) {
+            heap.pop();
+        }
+        if (heap.size() == k) {
+            bound2 = heap.top().distance2;
+        }
+    };
+    search(query, 0, points_.size(), bound2, visit);
+
+    out.resize(heap.size());
+    for (size_t i = out.size(); i-- > 0;) {
+        out[i] = heap.top();
+        heap.pop();
+    }
+}
+
+void PointKdTree::radius_search(
+    const pxr::GfVec3f& query,
+    float radius,
+    std::vector<Neighbor>& out) const
+{
+    out.clear();
+    // Inclusive of points exactly at the radius.
+    float bound2 = std::nextafter(radius * radius, kInfinity);
+    auto visit = [&](size_t i, float d2) {
+        out.push_back({ indices_[i], d2 });
+    };
+    search(query, 0, points_.size(), bound2, visit);
+}
+
+void PointKdTree::nearest_batch(
+    const pxr::GfVec3f* queries,
+    size_t count,
+    Neighbor* out,
+    float max_distance) const
+{
+    pxr::WorkParallelForN(
+        count,
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                out[i] = nearest(queries[i], max_distance);
+            }
+        },
+        kQueryGrain);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,384 @@
+#include "GCore/algorithms/laplacian.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "GCore/algorithms/triangulate.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+
+pxr::GfVec3d point(const pxr::VtArray<pxr::GfVec3f>& positions, uint32_t v)
+{
+    return pxr::GfVec3d(positions[v]);
+}
+
+}  // namespace
+
+void cotan_laplacian(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const std::vector<std::array<uint32_t, 3>>& triangles,
+    Eigen::SparseMatrix<double>& L)
+{
+    // Each triangle contributes a fixed block of 12 entries, so the triplets
+    // are written in parallel at known offsets and summed by setFromTriplets.
+    std::vector<Eigen::Triplet<double>> triplets(12 * triangles.size());
+    pxr::WorkParallelForN(
+        triangles.size(),
+        [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; ++t) {
+                const auto& tri = triangles[t];
+                const pxr::GfVec3d p[3] = { point(positions, tri[0]),
+                                            point(positions, tri[1]),
+                                            point(positions, tri[2]) };
+                const double area2 =
+                    pxr::GfCross(p[1] - p[0], p[2] - p[0]).GetLength();
+                auto* out = triplets.data() + 12 * t;
+                for (int k = 0; k < 3; ++k) {
+                    // Edge (i, j) is opposite corner k.
+                    const int i = (k + 1) % 3, j = (k + 2) % 3;
+                    const double cot =
+                        area2 > 0.0
+                            ? pxr::GfDot(p[i] - p[k], p[j] - p[k]) / area2
+                            : 0.0;
+                    const double w = 0.5 * cot;
+                    *out++ = { int(tri[i]), int(tri[j]), -w };
+                    *out++ = { int(tri[j]), int(tri[i]), -w };
+                    *out++ = { int(tri[i]), int(tri[i]), w };
+                    *out++ = { int(tri[j]), int(tri[j]), w };
+                }
+            }
+        },
+        kParallelGrain);
+
+    const int n = int(positions.size());
+    L.resize(n, n);
+    L.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+void barycentric_mass(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const std::vector<std::array<uint32_t, 3>>& triangles,
+    Eigen::VectorXd& mass)
+{
+    mass.setZero(positions.size());
+    for (const auto& tri : triangles) {
+        const pxr::GfVec3d a = point(positions, tri[0]);
+        const double third =
+            pxr::GfCross(point(positions, tri[1]) - a,
+                         point(positions, tri[2]) - a)
+                .GetLength() /
+            6.0;
+        mass[tri[0]] += third;
+        mass[tri[1]] += third;
+        mass[tri[2]] += third;
+    }
+}
+
+void uniform_laplacian(
+    const MeshGraph& graph,
+    Eigen::SparseMatrix<double>& L)
+{
+    // One row per vertex, so every vertex writes its own triplets.
+    const auto& offsets = graph.offsets();
+    const auto& neighbors = graph.neighbors();
+    const size_t n = graph.vertex_count();
+    std::vector<Eigen::Triplet<double>> triplets(neighbors.size() + n);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                auto* out = triplets.data() + offsets[v] + v;
+                for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) {
+                    *out++ = { int(v), int(neighbors[i]), -1.0 };
+                }
+                *out = { int(v), int(v), double(offsets[v + 1] - offsets[v]) };
+            }
+        },
+        kParallelGrain);
+
+    L.resize(int(n), int(n));
+    L.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+void mean_value_laplacian(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const std::vector<std::array<uint32_t, 3>>& triangles,
+    Eigen::SparseMatrix<double>& L)
+{
+    std::vector<Eigen::Triplet<double>> triplets(12 * triangles.size());
+    pxr::WorkParallelForN(
+        triangles.size(),
+        [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; ++t) {
+                const auto& tri = triangles[t];
+                auto* out = triplets.data() + 12 * t;
+                for (int k = 0; k < 3; ++k) {
+                    // The angle at corner k weighs both edges leaving it.
+                    const uint32_t i = tri[k], j = tri[(k + 1) % 3],
+                                   l = tri[(k + 2) % 3];
+                    const pxr::GfVec3d a =
+                        point(positions, j) - point(positions, i);
+                    const pxr::GfVec3d b =
+                        point(positions, l) - point(positions, i);
+                    const double la = a.GetLength(), lb = b.GetLength();
+                    double wa = 0.0, wb = 0.0;
+                    if (la > 0.0 && lb > 0.0) {
+                        const double half_tan = std::tan(
+                            0.5 * std::atan2(
+                                      pxr::GfCross(a, b).GetLength(),
+                                      pxr::GfDot(a, b)));
+                        wa = half_tan / la;
+                        wb = half_tan / lb;
+                    }
+                    *out++ = { int(i), int(j), -wa };
+                    *out++ = { int(i), int(l), -wb };
+                    *out++ = { int(i), int(i), wa };
+                    *out++ = { int(i), int(i), wb };
+                }
+            }
+        },
+        kParallelGrain);
+
+    const int n = int(positions.size());
+    L.resize(n, n);
+    L.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+bool LaplacianSolver::prepare(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    uint64_t topology_version,
+    uint64_t position_version,
+    LaplacianWeights weights,
+    const std::vector<uint32_t>& fixed)
+{
+    const bool structure_changed = topology_version != topology_version_ ||
+                                   positions.size() != free_row_.size() ||
+                                   weights != weights_ || fixed != fixed_ ||
+                                   (!symmetric_ && !general_);
+    const bool weights_changed = weights != LaplacianWeights::Uniform &&
+                                 position_version != position_version_;
+    if (!structure_changed && !weights_changed) {
+        return true;
+    }
+
+    if (structure_changed) {
+        clear();
+        const size_t n = positions.size();
+        if (!graph_.build(positions, face_vertex_counts, face_vertex_indices) ||
+            !fan_triangulate(
+                face_vertex_counts, face_vertex_indices, n, triangles_)) {
+            return false;
+        }
+        free_row_.assign(n, 0);
+        int fixed_rows = 0;
+        for (uint32_t v : fixed) {
+            if (v >= n || free_row_[v] < 0) {
+                clear();
+                return false;
+            }
+            free_row_[v] = -1 - fixed_rows++;
+        }
+        int free_rows = 0;
+        for (int& row : free_row_) {
+            if (row == 0) {
+                row = free_rows++;
+            }
+        }
+        if (free_rows == 0 || fixed_rows == 0) {
+            clear();
+            return false;
+        }
+        fixed_ = fixed;
+        weights_ = weights;
+        topology_version_ = topology_version;
+    }
+    position_version_ = position_version;
+    if (!refactor(positions, structure_changed)) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool LaplacianSolver::refactor(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    bool symbolic)
+{
+    Eigen::SparseMatrix<double> L;
+    switch (weights_) {
+        case LaplacianWeights::Uniform: uniform_laplacian(graph_, L); break;
+        case LaplacianWeights::Cotangent:
+            cotan_laplacian(positions, triangles_, L);
+            break;
+        case LaplacianWeights::MeanValue:
+            mean_value_laplacian(positions, triangles_, L);
+            break;
+    }
+
+    // Split the columns into free and fixed vertices, dropping the fixed
+    // rows; the pattern is the same on every call with the same structure.
+    const int free_count = int(free_row_.size() - fixed_.size());
+    std::vector<Eigen::Triplet<double>> free_free, free_fixed;
+    free_free.reserve(L.nonZeros());
+    for (int column = 0; column < L.outerSize(); ++column) {
+        const int c = free_row_[column];
+        for (Eigen::SparseMatrix<double>::InnerIterator it(L, column); it;
+             ++it) {
+            const int r = free_row_[it.row()];
+            if (r < 0) {
+                continue;
+            }
+            if (c >= 0) {
+                free_free.emplace_back(r, c, it.value());
+            }
+            else {
+                free_fixed.emplace_back(r, -1 - c, it.value());
+            }
+        }
+    }
+    free_free_.resize(free_count, free_count);
+    free_free_.setFromTriplets(free_free.begin(), free_free.end());
+    free_fixed_.resize(free_count, int(fixed_.size()));
+    free_fixed_.setFromTriplets(free_fixed.begin(), free_fixed.end());
+
+    if (weights_ == LaplacianWeights::MeanValue) {
+        if (symbolic || !general_) {
+            general_ = std::make_shared<GeneralSolver>();
+            general_->analyzePattern(free_free_);
+            ++symbolic_count_;
+        }
+        general_->factorize(free_free_);
+        ++numeric_count_;
+        return general_->info() == Eigen::Success;
+    }
+    if (symbolic || !symmetric_) {
+        symmetric_ = std::make_shared<SymmetricSolver>();
+        symmetric_->analyzePattern(free_free_);
+        ++symbolic_count_;
+    }
+    symmetric_->factorize(free_free_);
+    ++numeric_count_;
+    return symmetric_->info() == Eigen::Success;
+}
+
+void LaplacianSolver::solve_symmetric(
+    const Eigen::MatrixXd& rhs,
+    Eigen::MatrixXd& out) const
+{
+    // x = P^-1 L^-T D^-1 L^-1 P b, like SimplicialLDLT::solve, but with the
+    // right-hand sides interleaved so that each triangular solve walks the
+    // factor once for all of them instead of once per column.
+    using RowMajor =
+        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    const auto& L = symmetric_->matrixL().nestedExpression();
+    const auto& d = symmetric_->vectorD();
+    const Eigen::Index n = rhs.rows(), k = rhs.cols();
+
+    RowMajor x = symmetric_->permutationP() * rhs;
+    double* data = x.data();
+    const int* outer = L.outerIndexPtr();
+    const int* inner = L.innerIndexPtr();
+    const double* values = L.valuePtr();
+    for (Eigen::Index j = 0; j < n; ++j) {
+        const double* xj = data + j * k;
+        for (int p = outer[j]; p < outer[j + 1]; ++p) {
+            double* xi = data + Eigen::Index(inner[p]) * k;
+            for (Eigen::Index c = 0; c < k; ++c) {
+                xi[c] -= values[p] * xj[c];
+            }
+        }
+    }
+    for (Eigen::Index j = 0; j < n; ++j) {
+        for (Eigen::Index c = 0; c < k; ++c) {
+            data[j * k + c] /= d[j];
+        }
+    }
+    for (Eigen::Index j = n - 1; j >= 0; --j) {
+        double* xj = data + j * k;
+        for (int p = outer[j]; p < outer[j + 1]; ++p) {
+            const double* xi = data + Eigen::Index(inner[p]) * k;
+            for (Eigen::Index c = 0; c < k; ++c) {
+                xj[c] -= values[p] * xi[c];
+            }
+        }
+    }
+    out = symmetric_->permutationPinv() * x;
+}
+
+void LaplacianSolver::clear()
+{
+    topology_version_ = 0;
+    position_version_ = 0;
+    fixed_.clear();
+    graph_.clear();
+    triangles_.clear();
+    free_row_.clear();
+    free_free_.resize(0, 0);
+    free_fixed_.resize(0, 0);
+    symmetric_.reset();
+    general_.reset();
+}
+
+bool LaplacianSolver::solve(
+    const Eigen::MatrixXd& fixed_values,
+    Eigen::MatrixXd& out) const
+{
+    return solve(
+        fixed_values,
+        Eigen::MatrixXd::Zero(
+            Eigen::Index(free_row_.size()), fixed_values.cols()),
+        out);
+}
+
+bool LaplacianSolver::solve(
+    const Eigen::MatrixXd& fixed_values,
+    const Eigen::MatrixXd& rhs,
+    Eigen::MatrixXd& out) const
+{
+    const Eigen::Index n = Eigen::Index(free_row_.size());
+    if ((!symmetric_ && !general_) ||
+        fixed_values.rows() != Eigen::Index(fixed_.size()) ||
+        rhs.rows() != n || rhs.cols() != fixed_values.cols()) {
+        return false;
+    }
+    Eigen::MatrixXd free_rhs = -(free_fixed_ * fixed_values);
+    for (Eigen::Index v = 0; v < n; ++v) {
+        if (free_row_[v] >= 0) {
+            free_rhs.row(free_row_[v]) += rhs.row(v);
+        }
+    }
+    Eigen::MatrixXd free_values;
+    if (general_) {
+        free_values = general_->solve(free_rhs);
+    }
+    else {
+        solve_symmetric(free_rhs, free_values);
+    }
+
+    out.resize(n, fixed_values.cols());
+    pxr::WorkParallelForN(
+        free_row_.size(),
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                const int row = free_row_[v];
+                if (row >= 0) {
+                    out.row(v) = free_values.row(row);
+                }
+                else {
+                    out.row(v) = fixed_values.row(-1 - row);
+                }
+            }
+        },
+        kParallelGrain);
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
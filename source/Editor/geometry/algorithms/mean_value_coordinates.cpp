@@ -0,0 +1,151 @@
+#include "GCore/algorithms/mean_value_coordinates.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Points per parallel task; each costs a few operations per polygon vertex.
+constexpr size_t kParallelGrain = 1 << 8;
+// Of the polygon's bounding box diagonal.
+constexpr double kRelativeTolerance = 1e-6;
+
+}  // namespace
+
+bool MeanValueCoordinates::set_polygon(
+    const std::vector<pxr::GfVec2f>& polygon)
+{
+    x_.clear();
+    y_.clear();
+    edge_length_.clear();
+    tolerance_ = 0;
+    const size_t m = polygon.size();
+    if (m < 3) {
+        return false;
+    }
+
+    x_.resize(m + 1);
+    y_.resize(m + 1);
+    edge_length_.resize(m);
+    pxr::GfVec2f lo = polygon[0], hi = polygon[0];
+    for (size_t i = 0; i <= m; ++i) {
+        const pxr::GfVec2f& p = polygon[i % m];
+        x_[i] = p[0];
+        y_[i] = p[1];
+        lo = pxr::GfVec2f(std::min(lo[0], p[0]), std::min(lo[1], p[1]));
+        hi = pxr::GfVec2f(std::max(hi[0], p[0]), std::max(hi[1], p[1]));
+    }
+    for (size_t i = 0; i < m; ++i) {
+        edge_length_[i] = std::hypot(x_[i + 1] - x_[i], y_[i + 1] - y_[i]);
+    }
+    tolerance_ = kRelativeTolerance * double((hi - lo).GetLength());
+    return true;
+}
+
+void MeanValueCoordinates::evaluate(const pxr::GfVec2f& point, float* weights)
+    const
+{
+    std::vector<double> scratch(4 * (vertex_count() + 1));
+    evaluate(point, weights, scratch.data());
+}
+
+void MeanValueCoordinates::evaluate(
+    const pxr::GfVec2f* points,
+    size_t count,
+    float* weights) const
+{
+    const size_t m = vertex_count();
+    pxr::WorkParallelForN(
+        count,
+        [&](size_t first, size_t last) {
+            std::vector<double> scratch(4 * (m + 1));
+            for (size_t p = first; p < last; ++p) {
+                evaluate(points[p], weights + p * m, scratch.data());
+            }
+        },
+        kParallelGrain);
+}
+
+void MeanValueCoordinates::evaluate(
+    const pxr::GfVec2f& point,
+    float* weights,
+    double* scratch) const
+{
+    const size_t m = vertex_count();
+    if (m == 0) {
+        return;
+    }
+    double* dx = scratch;
+    double* dy = dx + m + 1;
+    double* r = dy + m + 1;
+    // tan(a_i / 2) for the angle at the point over edge i, stored at i + 1
+    // so that t[i] and t[i + 1] flank vertex i.
+    double* t = r + m + 1;
+
+    const double px = point[0], py = point[1];
+    for (size_t i = 0; i <= m; ++i) {
+        dx[i] = x_[i] - px;
+        dy[i] = y_[i] - py;
+        r[i] = std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+    }
+
+    // tan(a / 2) = sin a / (1 + cos a) with the signed area for sin a, so
+    // angles of edges seen backwards count negatively. The denominator
+    // vanishes exactly on an edge, which the same pass detects without
+    // branching.
+    int degenerate = 0;
+    for (size_t i = 0; i < m; ++i) {
+        const double area = dx[i] * dy[i + 1] - dy[i] * dx[i + 1];
+        const double dot = dx[i] * dx[i + 1] + dy[i] * dy[i + 1];
+        t[i + 1] = area / (r[i] * r[i + 1] + dot);
+        degenerate |= int(r[i] <= tolerance_) |
+                      (int(std::abs(area) <= tolerance_ * edge_length_[i]) &
+                       int(dot <= 0.0));
+    }
+
+    if (degenerate) {
+        std::fill(weights, weights + m, 0.0f);
+        for (size_t i = 0; i < m; ++i) {
+            if (r[i] <= tolerance_) {
+                weights[i] = 1.0f;
+                return;
+            }
+        }
+        for (size_t i = 0; i < m; ++i) {
+            const double area = dx[i] * dy[i + 1] - dy[i] * dx[i + 1];
+            const double dot = dx[i] * dx[i + 1] + dy[i] * dy[i + 1];
+            if (std::abs(area) <= tolerance_ * edge_length_[i] &&
+                dot <= 0.0) {
+                // Linear along the edge.
+                const double s = std::clamp(r[i] / edge_length_[i], 0.0, 1.0);
+                weights[i] = float(1.0 - s);
+                weights[(i + 1) % m] = float(s);
+                return;
+            }
+        }
+    }
+
+    t[0] = t[m];
+    double* w = dx;
+    double sum = 0.0;
+    for (size_t i = 0; i < m; ++i) {
+        w[i] = (t[i] + t[i + 1]) / r[i];
+        sum += w[i];
+    }
+    if (!std::isfinite(sum) || sum == 0.0) {
+        // Only outside the polygon, where the signed weights can cancel.
+        std::fill(weights, weights + m, 0.0f);
+        weights[std::min_element(r, r + m) - r] = 1.0f;
+        return;
+    }
+    const double inverse = 1.0 / sum;
+    for (size_t i = 0; i < m; ++i) {
+        weights[i] = float(w[i] * inverse);
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
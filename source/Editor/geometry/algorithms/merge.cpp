@@ -0,0 +1,63 @@
+#include "GCore/algorithms/merge.h"
+
+#include <pxr/base/work/loops.h>
+
+#include "GCore/algorithms/simd.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 16;
+
+void offset_scalar(const int* src, int* dst, size_t count, int offset)
+{
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = src[i] + offset;
+    }
+}
+
+#if USTC_CG_SIMD_X86
+USTC_CG_TARGET_AVX2 void
+offset_avx2(const int* src, int* dst, size_t count, int offset)
+{
+    const __m256i off = _mm256_set1_epi32(offset);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(dst + i), _mm256_add_epi32(v, off));
+    }
+    offset_scalar(src + i, dst + i, count - i, offset);
+}
+#endif
+
+void offset_block(const int* src, int* dst, size_t count, int offset)
+{
+#if USTC_CG_SIMD_X86
+    if (cpu_has_avx2()) {
+        offset_avx2(src, dst, count, offset);
+        return;
+    }
+#endif
+    offset_scalar(src, dst, count, offset);
+}
+
+}  // namespace
+
+void offset_indices(const int* src, int* dst, size_t count, int offset)
+{
+    if (count < 2 * kParallelGrain) {
+        offset_block(src, dst, count, offset);
+        return;
+    }
+    pxr::WorkParallelForN(
+        count,
+        [&](size_t begin, size_t end) {
+            offset_block(src + begin, dst + begin, end - begin, offset);
+        },
+        kParallelGrain);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,379 @@
+#include "GCore/algorithms/mesh_topology.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <utility>
+
+#include "GCore/algorithms/triangulate.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 14;
+// Vertices per task of the vertex pass; each task keeps its own lists.
+constexpr size_t kChunk = 1 << 12;
+// Faces up to this size are checked for repeated vertices pairwise.
+constexpr uint32_t kPairwiseCheck = 16;
+
+// Union-find shared by all tasks. Parents always have lower indices than
+// their children, so the root of a set is its lowest vertex.
+uint32_t find_root(std::vector<uint32_t>& parent, uint32_t x)
+{
+    while (true) {
+        uint32_t p = std::atomic_ref<uint32_t>(parent[x]).load(
+            std::memory_order_relaxed);
+        if (p == x) {
+            return x;
+        }
+        const uint32_t g = std::atomic_ref<uint32_t>(parent[p]).load(
+            std::memory_order_relaxed);
+        if (g != p) {
+            // Path halving; losing the race only skips the shortcut.
+            std::atomic_ref<uint32_t>(parent[x]).compare_exchange_weak(
+                p, g, std::memory_order_relaxed);
+        }
+        x = g;
+    }
+}
+
+void unite(std::vector<uint32_t>& parent, uint32_t a, uint32_t b)
+{
+    while (true) {
+        a = find_root(parent, a);
+        b = find_root(parent, b);
+        if (a == b) {
+            return;
+        }
+        if (a < b) {
+            std::swap(a, b);
+        }
+        // Fails if another task linked a in the meantime.
+        uint32_t expected = a;
+        if (std::atomic_ref<uint32_t>(parent[a]).compare_exchange_strong(
+                expected, b, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+// Union-find over the corners of one vertex, for counting its fans.
+uint32_t find_local(std::vector<uint32_t>& parent, uint32_t x)
+{
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+bool has_repeated_vertex(
+    const int* corners,
+    uint32_t count,
+    std::vector<int>& scratch)
+{
+    if (count <= kPairwiseCheck) {
+        for (uint32_t i = 1; i < count; ++i) {
+            for (uint32_t j = 0; j < i; ++j) {
+                if (corners[i] == corners[j]) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    scratch.assign(corners, corners + count);
+    std::sort(scratch.begin(), scratch.end());
+    return std::adjacent_find(scratch.begin(), scratch.end()) !=
+           scratch.end();
+}
+
+// A face running from a vertex to `vertex` (out) or back (in), seen from
+// the vertex's local corner `corner`.
+struct Neighbor {
+    uint32_t vertex;
+    uint32_t corner;
+    bool out;
+};
+
+// What the vertex pass found in one chunk of vertices.
+struct ChunkResult {
+    size_t edges = 0;
+    size_t inconsistent_edges = 0;
+    size_t non_manifold_vertices = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> boundary;
+    std::vector<std::array<uint32_t, 2>> non_manifold_edges;
+};
+
+}  // namespace
+
+bool MeshTopology::analyze(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count,
+    uint64_t topology_version)
+{
+    if (topology_version != 0 && topology_version == topology_version_ &&
+        vertex_count == this->vertex_count()) {
+        return true;
+    }
+    clear();
+
+    const size_t face_count = face_vertex_counts.size();
+    const size_t corner_count = face_vertex_indices.size();
+    if (corner_count >= UINT32_MAX || vertex_count >= UINT32_MAX) {
+        return false;
+    }
+
+    std::vector<uint32_t> face_offsets(face_count + 1);
+    size_t corner = 0;
+    for (size_t f = 0; f < face_count; ++f) {
+        const int count = face_vertex_counts.cdata()[f];
+        if (count < 0 || corner + count > corner_count) {
+            return false;
+        }
+        face_offsets[f] = uint32_t(corner);
+        corner += count;
+    }
+    if (corner != corner_count) {
+        return false;
+    }
+    face_offsets[face_count] = uint32_t(corner_count);
+
+    // Face pass: validate the indices, find invalid faces and count the
+    // corners of each vertex.
+    const int* indices = face_vertex_indices.cdata();
+    std::vector<uint32_t> face_of_corner(corner_count);
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    std::atomic<bool> in_range = true;
+    std::atomic<size_t> invalid_faces = 0;
+    pxr::WorkParallelForN(
+        face_count,
+        [&](size_t first, size_t last) {
+            std::vector<int> scratch;
+            size_t invalid = 0;
+            for (size_t f = first; f < last; ++f) {
+                const uint32_t begin = face_offsets[f];
+                const uint32_t count = face_offsets[f + 1] - begin;
+                for (uint32_t c = begin; c < begin + count; ++c) {
+                    const int v = indices[c];
+                    if (v < 0 || size_t(v) >= vertex_count) {
+                        in_range = false;
+                        return;
+                    }
+                    face_of_corner[c] = uint32_t(f);
+                    std::atomic_ref<uint32_t>(offsets[v + 1])
+                        .fetch_add(1, std::memory_order_relaxed);
+                }
+                if (count < 3 ||
+                    has_repeated_vertex(indices + begin, count, scratch)) {
+                    ++invalid;
+                }
+            }
+            invalid_faces += invalid;
+        },
+        kParallelGrain);
+    if (!in_range) {
+        return false;
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    // Corners around each vertex; each range is sorted by the vertex pass,
+    // which keeps the results independent of the scheduling.
+    std::vector<uint32_t> vertex_corners(corner_count);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        pxr::WorkParallelForN(
+            corner_count,
+            [&](size_t first, size_t last) {
+                for (size_t c = first; c < last; ++c) {
+                    const uint32_t slot =
+                        std::atomic_ref<uint32_t>(cursor[indices[c]])
+                            .fetch_add(1, std::memory_order_relaxed);
+                    vertex_corners[slot] = uint32_t(c);
+                }
+            },
+            kParallelGrain);
+    }
+
+    // Vertex pass. Every vertex groups its corners' neighbours: the number
+    // of entries for a neighbour is the number of faces using that edge.
+    // Edges to higher neighbours are counted and classified here, and the
+    // corners sharing a two-face edge are joined into fans.
+    std::vector<uint32_t> parent(vertex_count);
+    std::iota(parent.begin(), parent.end(), 0u);
+    non_manifold_vertices_.assign(vertex_count, 0);
+    std::vector<ChunkResult> chunks((vertex_count + kChunk - 1) / kChunk);
+    pxr::WorkParallelForN(
+        chunks.size(),
+        [&](size_t first_chunk, size_t last_chunk) {
+            std::vector<Neighbor> neighbors;
+            std::vector<uint32_t> fans;
+            for (size_t i = first_chunk; i < last_chunk; ++i) {
+                ChunkResult& result = chunks[i];
+                const size_t last = std::min(vertex_count, (i + 1) * kChunk);
+                for (uint32_t v = uint32_t(i * kChunk); v < last; ++v) {
+                    uint32_t* corners = vertex_corners.data() + offsets[v];
+                    const uint32_t degree = offsets[v + 1] - offsets[v];
+                    if (degree == 0) {
+                        continue;
+                    }
+                    std::sort(corners, corners + degree);
+
+                    neighbors.clear();
+                    for (uint32_t k = 0; k < degree; ++k) {
+                        const uint32_t c = corners[k];
+                        const uint32_t f = face_of_corner[c];
+                        const uint32_t begin = face_offsets[f];
+                        const uint32_t count = face_offsets[f + 1] - begin;
+                        const uint32_t local = c - begin;
+                        const uint32_t next =
+                            indices[begin + (local + 1) % count];
+                        const uint32_t prev =
+                            indices[begin + (local + count - 1) % count];
+                        if (next != v) {
+                            neighbors.push_back({ next, k, true });
+                        }
+                        if (prev != v) {
+                            neighbors.push_back({ prev, k, false });
+                        }
+                    }
+                    std::sort(
+                        neighbors.begin(),
+                        neighbors.end(),
+                        [](const Neighbor& a, const Neighbor& b) {
+                            return a.vertex < b.vertex ||
+                                   (a.vertex == b.vertex &&
+                                    a.corner < b.corner);
+                        });
+
+                    fans.resize(degree);
+                    std::iota(fans.begin(), fans.end(), 0u);
+                    bool non_manifold = false;
+                    for (size_t a = 0; a < neighbors.size();) {
+                        const uint32_t w = neighbors[a].vertex;
+                        size_t b = a + 1;
+                        while (b < neighbors.size() &&
+                               neighbors[b].vertex == w) {
+                            ++b;
+                        }
+                        const size_t uses = b - a;
+                        if (uses == 2) {
+                            fans[find_local(fans, neighbors[a].corner)] =
+                                find_local(fans, neighbors[a + 1].corner);
+                        }
+                        else if (uses > 2) {
+                            non_manifold = true;
+                        }
+                        if (w > v) {
+                            ++result.edges;
+                            unite(parent, v, w);
+                            if (uses == 1) {
+                                result.boundary.push_back(
+                                    neighbors[a].out ? std::make_pair(v, w)
+                                                     : std::make_pair(w, v));
+                            }
+                            else if (uses == 2) {
+                                if (neighbors[a].out ==
+                                    neighbors[a + 1].out) {
+                                    ++result.inconsistent_edges;
+                                }
+                            }
+                            else {
+                                result.non_manifold_edges.push_back({ v, w });
+                            }
+                        }
+                        a = b;
+                    }
+
+                    uint32_t fan_count = 0;
+                    for (uint32_t k = 0; k < degree; ++k) {
+                        fan_count += find_local(fans, k) == k;
+                    }
+                    if (non_manifold || fan_count > 1) {
+                        non_manifold_vertices_[v] = 1;
+                        ++result.non_manifold_vertices;
+                    }
+                }
+            }
+        },
+        1);
+
+    std::vector<std::pair<uint32_t, uint32_t>> boundary;
+    for (ChunkResult& result : chunks) {
+        edge_count_ += result.edges;
+        inconsistent_edge_count_ += result.inconsistent_edges;
+        non_manifold_vertex_count_ += result.non_manifold_vertices;
+        boundary.insert(
+            boundary.end(), result.boundary.begin(), result.boundary.end());
+        non_manifold_edges_.insert(
+            non_manifold_edges_.end(),
+            result.non_manifold_edges.begin(),
+            result.non_manifold_edges.end());
+    }
+    boundary_edge_count_ = boundary.size();
+    invalid_face_count_ = invalid_faces;
+
+    // Components, numbered in the order of their roots. A root is the
+    // lowest vertex of its set, so it is numbered before its members.
+    pxr::WorkParallelForN(
+        vertex_count,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                std::atomic_ref<uint32_t>(parent[v]).store(
+                    find_root(parent, uint32_t(v)), std::memory_order_relaxed);
+            }
+        },
+        kParallelGrain);
+    for (uint32_t v = 0; v < vertex_count; ++v) {
+        parent[v] = parent[v] == v ? component_count_++ : parent[parent[v]];
+    }
+    vertex_components_ = std::move(parent);
+    face_components_.resize(face_count);
+    pxr::WorkParallelForN(
+        face_count,
+        [&](size_t first, size_t last) {
+            for (size_t f = first; f < last; ++f) {
+                face_components_[f] =
+                    face_offsets[f] == face_offsets[f + 1]
+                        ? kNoComponent
+                        : vertex_components_[indices[face_offsets[f]]];
+            }
+        },
+        kParallelGrain);
+
+    std::sort(boundary.begin(), boundary.end());
+    std::vector<std::vector<uint32_t>> loops;
+    walk_boundary_loops(boundary, loops);
+    for (const auto& loop : loops) {
+        loop_vertices_.insert(loop_vertices_.end(), loop.begin(), loop.end());
+        loop_offsets_.push_back(uint32_t(loop_vertices_.size()));
+    }
+
+    topology_version_ = topology_version;
+    return true;
+}
+
+void MeshTopology::clear()
+{
+    topology_version_ = 0;
+    vertex_components_.clear();
+    face_components_.clear();
+    component_count_ = 0;
+    edge_count_ = 0;
+    loop_offsets_.assign(1, 0);
+    loop_vertices_.clear();
+    boundary_edge_count_ = 0;
+    non_manifold_edges_.clear();
+    non_manifold_vertices_.clear();
+    non_manifold_vertex_count_ = 0;
+    inconsistent_edge_count_ = 0;
+    invalid_face_count_ = 0;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,783 @@
+#include "GCore/algorithms/primitives.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "Logger/Logger.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Below this many elements the loops run on the calling thread.
+constexpr size_t kParallelGrain = 1 << 14;
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Calls row(r) for r in [0, rows) in parallel, with rows of about
+// `row_size` elements.
+template<typename Row>
+void parallel_rows(size_t rows, size_t row_size, const Row& row)
+{
+    pxr::WorkParallelForN(
+        rows,
+        [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r) {
+                row(r);
+            }
+        },
+        std::max<size_t>(1, kParallelGrain / std::max<size_t>(row_size, 1)));
+}
+
+bool allocate(
+    PrimitiveMesh& mesh,
+    const char* name,
+    size_t vertices,
+    size_t faces,
+    size_t corners,
+    size_t normals,
+    size_t texcoords)
+{
+    if (vertices > size_t(INT_MAX) || corners > size_t(INT_MAX)) {
+        log::warning(
+            "%s: %zu vertices and %zu face corners exceed the index range",
+            name,
+            vertices,
+            corners);
+        return false;
+    }
+    mesh.positions.resize(vertices);
+    mesh.face_vertex_counts.resize(faces);
+    mesh.face_vertex_indices.resize(corners);
+    mesh.normals.resize(normals);
+    mesh.texcoords.resize(texcoords);
+    return true;
+}
+
+bool check_count(const char* name, const char* what, int count, int minimum)
+{
+    if (count < minimum) {
+        log::warning("%s: %s has to be at least %d", name, what, minimum);
+        return false;
+    }
+    return true;
+}
+
+// Raw pointers into the arrays, taken once outside the parallel loops since
+// non-const VtArray access checks for sharing on every call.
+struct Writer {
+    explicit Writer(PrimitiveMesh& mesh)
+        : positions(mesh.positions.data()),
+          counts(mesh.face_vertex_counts.data()),
+          indices(mesh.face_vertex_indices.data()),
+          normals(mesh.normals.data()),
+          texcoords(mesh.texcoords.data())
+    {
+    }
+
+    pxr::GfVec3f* positions;
+    int* counts;
+    int* indices;
+    pxr::GfVec3f* normals;
+    pxr::GfVec2f* texcoords;
+};
+
+pxr::GfVec3f unit_circle(size_t i, size_t count)
+{
+    const double angle = 2.0 * kPi * double(i) / double(count);
+    return pxr::GfVec3f(float(std::cos(angle)), float(std::sin(angle)), 0);
+}
+
+// Grid lattice shared by make_grid and make_terrain; `height(x)` offsets
+// the point x along `up`.
+template<typename Height>
+bool fill_grid(
+    const char* name,
+    const pxr::GfVec3f& origin,
+    const pxr::GfVec3f& edge_u,
+    const pxr::GfVec3f& edge_v,
+    int cells_u,
+    int cells_v,
+    const Height& height,
+    PrimitiveMesh& mesh)
+{
+    const int cells = std::min(cells_u, cells_v);
+    if (!check_count(name, "the number of cells", cells, 1)) {
+        return false;
+    }
+    const size_t nu = size_t(cells_u) + 1;
+    const size_t nv = size_t(cells_v) + 1;
+    const size_t faces = size_t(cells_u) * size_t(cells_v);
+    if (!allocate(mesh, name, nu * nv, faces, 4 * faces, nu * nv, nu * nv)) {
+        return false;
+    }
+
+    const pxr::GfVec3f up = pxr::GfCross(edge_v, edge_u).GetNormalized();
+    Writer out(mesh);
+    parallel_rows(nu, nv, [&](size_t i) {
+        const float u = float(i) / float(cells_u);
+        for (size_t j = 0; j < nv; ++j) {
+            const float v = float(j) / float(cells_v);
+            const size_t k = i * nv + j;
+            const pxr::GfVec3f p = origin + edge_u * u + edge_v * v;
+            out.positions[k] = p + up * height(p);
+            out.normals[k] = up;
+            out.texcoords[k] = pxr::GfVec2f(u, v);
+        }
+    });
+    parallel_rows(size_t(cells_u), size_t(cells_v), [&](size_t i) {
+        for (size_t j = 0; j < size_t(cells_v); ++j) {
+            const size_t f = i * size_t(cells_v) + j;
+            out.counts[f] = 4;
+            int* quad = out.indices + 4 * f;
+            quad[0] = int(i * nv + j);
+            quad[1] = int(i * nv + j + 1);
+            quad[2] = int((i + 1) * nv + j + 1);
+            quad[3] = int((i + 1) * nv + j);
+        }
+    });
+    return true;
+}
+
+// Integer hash of a lattice point for the gradient noise.
+uint32_t hash_lattice(int32_t x, int32_t y, uint32_t seed)
+{
+    uint32_t h = seed ^ (uint32_t(x) * 0x8da6b343u) ^
+                 (uint32_t(y) * 0xd8163841u);
+    h = (h ^ (h >> 16)) * 0x85ebca6bu;
+    h = (h ^ (h >> 13)) * 0xc2b2ae35u;
+    return h ^ (h >> 16);
+}
+
+// Perlin-style gradient noise in about [-1, 1].
+float gradient_noise(float x, float y, uint32_t seed)
+{
+    static const float kGradients[8][2] = {
+        { 1, 0 },
+        { -1, 0 },
+        { 0, 1 },
+        { 0, -1 },
+        { 0.7071f, 0.7071f },
+        { -0.7071f, 0.7071f },
+        { 0.7071f, -0.7071f },
+        { -0.7071f, -0.7071f },
+    };
+    const float fx = std::floor(x);
+    const float fy = std::floor(y);
+    const int32_t ix = int32_t(fx);
+    const int32_t iy = int32_t(fy);
+    const float dx = x - fx;
+    const float dy = y - fy;
+
+    auto dot = [&](int32_t cx, int32_t cy) {
+        const float* g = kGradients[hash_lattice(ix + cx, iy + cy, seed) & 7];
+        return g[0] * (dx - float(cx)) + g[1] * (dy - float(cy));
+    };
+    auto fade = [](float t) {
+        return t * t * t * (t * (t * 6 - 15) + 10);
+    };
+    const float sx = fade(dx);
+    const float sy = fade(dy);
+    const float bottom = dot(0, 0) + (dot(1, 0) - dot(0, 0)) * sx;
+    const float top = dot(0, 1) + (dot(1, 1) - dot(0, 1)) * sx;
+    return 1.4142f * (bottom + (top - bottom) * sy);
+}
+
+float fractal_noise(float x, float y, const TerrainNoise& noise)
+{
+    float sum = 0;
+    float amplitude = noise.amplitude;
+    float frequency = noise.frequency;
+    for (int octave = 0; octave < noise.octaves; ++octave) {
+        sum += amplitude * gradient_noise(
+                               x * frequency,
+                               y * frequency,
+                               noise.seed + uint32_t(octave) * 0x9e3779b9u);
+        amplitude *= noise.gain;
+        frequency *= noise.lacunarity;
+    }
+    return sum;
+}
+
+}  // namespace
+
+bool make_grid(
+    const pxr::GfVec3f& origin,
+    const pxr::GfVec3f& edge_u,
+    const pxr::GfVec3f& edge_v,
+    int cells_u,
+    int cells_v,
+    PrimitiveMesh& mesh)
+{
+    return fill_grid(
+        "Grid",
+        origin,
+        edge_u,
+        edge_v,
+        cells_u,
+        cells_v,
+        [](const pxr::GfVec3f&) { return 0.0f; },
+        mesh);
+}
+
+bool make_uv_sphere(float radius, int segments, int rings, PrimitiveMesh& mesh)
+{
+    if (!check_count("UV sphere", "segments", segments, 3) ||
+        !check_count("UV sphere", "rings", rings, 2)) {
+        return false;
+    }
+    // Vertex 0 is the north pole, then rings 1 .. rings - 1 of `segments`
+    // vertices each, then the south pole. Face rows are the north fan,
+    // rings - 2 rows of quads and the south fan.
+    const size_t s_count = size_t(segments);
+    const size_t r_count = size_t(rings);
+    const size_t vertices = 2 + (r_count - 1) * s_count;
+    const size_t faces = r_count * s_count;
+    const size_t corners = 6 * s_count + 4 * (r_count - 2) * s_count;
+    if (!allocate(
+            mesh, "UV sphere", vertices, faces, corners, vertices, corners)) {
+        return false;
+    }
+
+    Writer out(mesh);
+    const size_t south = vertices - 1;
+    auto vertex = [&](size_t ring, size_t s) -> int {
+        if (ring == 0) {
+            return 0;
+        }
+        if (ring == r_count) {
+            return int(south);
+        }
+        return int(1 + (ring - 1) * s_count + s % s_count);
+    };
+    auto set_vertex = [&](size_t k, const pxr::GfVec3f& normal) {
+        out.positions[k] = normal * radius;
+        out.normals[k] = normal;
+    };
+
+    set_vertex(0, pxr::GfVec3f(0, 0, 1));
+    set_vertex(south, pxr::GfVec3f(0, 0, -1));
+    parallel_rows(r_count - 1, s_count, [&](size_t r) {
+        const size_t ring = r + 1;
+        const double polar = kPi * double(ring) / double(r_count);
+        const float z = float(std::cos(polar));
+        const float planar = float(std::sin(polar));
+        for (size_t s = 0; s < s_count; ++s) {
+            pxr::GfVec3f normal = unit_circle(s, s_count) * planar;
+            normal[2] = z;
+            set_vertex(size_t(vertex(ring, s)), normal);
+        }
+    });
+
+    parallel_rows(r_count, s_count, [&](size_t ring) {
+        const float v0 = 1.0f - float(ring) / float(r_count);
+        const float v1 = 1.0f - float(ring + 1) / float(r_count);
+        // Rows before this one: the north fan, then quads.
+        const size_t first_face = ring * s_count;
+        size_t corner = ring == 0 ? 0 : 3 * s_count + 4 * (ring - 1) * s_count;
+        for (size_t s = 0; s < s_count; ++s) {
+            const float u0 = float(s) / float(s_count);
+            const float u1 = float(s + 1) / float(s_count);
+            const float mid = (float(s) + 0.5f) / float(s_count);
+            if (ring == 0) {
+                out.counts[first_face + s] = 3;
+                const int ids[3] = { 0, vertex(1, s), vertex(1, s + 1) };
+                const pxr::GfVec2f uvs[3] = {
+                    { mid, 1 }, { u0, v1 }, { u1, v1 }
+                };
+                for (int c = 0; c < 3; ++c, ++corner) {
+                    out.indices[corner] = ids[c];
+                    out.texcoords[corner] = uvs[c];
+                }
+            }
+            else if (ring + 1 == r_count) {
+                out.counts[first_face + s] = 3;
+                const int ids[3] = { int(south),
+                                     vertex(ring, s + 1),
+                                     vertex(ring, s) };
+                const pxr::GfVec2f uvs[3] = {
+                    { mid, 0 }, { u1, v0 }, { u0, v0 }
+                };
+                for (int c = 0; c < 3; ++c, ++corner) {
+                    out.indices[corner] = ids[c];
+                    out.texcoords[corner] = uvs[c];
+                }
+            }
+            else {
+                out.counts[first_face + s] = 4;
+                const int ids[4] = { vertex(ring, s),
+                                     vertex(ring + 1, s),
+                                     vertex(ring + 1, s + 1),
+                                     vertex(ring, s + 1) };
+                const pxr::GfVec2f uvs[4] = {
+                    { u0, v0 }, { u0, v1 }, { u1, v1 }, { u1, v0 }
+                };
+                for (int c = 0; c < 4; ++c, ++corner) {
+                    out.indices[corner] = ids[c];
+                    out.texcoords[corner] = uvs[c];
+                }
+            }
+        }
+    });
+    return true;
+}
+
+bool make_icosphere(float radius, int frequency, PrimitiveMesh& mesh)
+{
+    if (!check_count("Icosphere", "the frequency", frequency, 1)) {
+        return false;
+    }
+    static const double t = (1.0 + std::sqrt(5.0)) / 2.0;
+    static const double kCorners[12][3] = {
+        { -1, t, 0 }, { 1, t, 0 },  { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t },  { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 },  { -t, 0, -1 }, { -t, 0, 1 },
+    };
+    static const int kFaces[20][3] = {
+        { 0, 11, 5 }, { 0, 5, 1 },  { 0, 1, 7 },   { 0, 7, 10 }, { 0, 10, 11 },
+        { 1, 5, 9 },  { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+        { 3, 9, 4 },  { 3, 4, 2 },  { 3, 2, 6 },   { 3, 6, 8 },  { 3, 8, 9 },
+        { 4, 9, 5 },  { 2, 4, 11 }, { 6, 2, 10 },  { 8, 6, 7 },  { 9, 8, 1 },
+    };
+
+    // Vertices: the 12 corners, frequency - 1 per icosahedron edge, then
+    // the interior points of every face. Each face is a triangular lattice
+    // (a, b), a + b <= frequency, from corner 0 towards corners 1 and 2.
+    const size_t f = size_t(frequency);
+    const size_t per_edge = f - 1;
+    const size_t per_face = f >= 2 ? (f - 1) * (f - 2) / 2 : 0;
+    const size_t first_interior = 12 + 30 * per_edge;
+    const size_t vertices = first_interior + 20 * per_face;
+    const size_t faces = 20 * f * f;
+    const size_t corners = 3 * faces;
+    if (!allocate(
+            mesh, "Icosphere", vertices, faces, corners, vertices, corners)) {
+        return false;
+    }
+
+    int edge_of[12][12];
+    int edges[30][2];
+    int edge_count = 0;
+    for (const auto& face : kFaces) {
+        for (int k = 0; k < 3; ++k) {
+            const int x = std::min(face[k], face[(k + 1) % 3]);
+            const int y = std::max(face[k], face[(k + 1) % 3]);
+            if (std::none_of(edges, edges + edge_count, [&](const int* e) {
+                    return e[0] == x && e[1] == y;
+                })) {
+                edges[edge_count][0] = x;
+                edges[edge_count][1] = y;
+                edge_of[x][y] = edge_of[y][x] = edge_count++;
+            }
+        }
+    }
+
+    auto corner = [&](int c) {
+        return pxr::GfVec3d(kCorners[c][0], kCorners[c][1], kCorners[c][2]);
+    };
+    // Point at `step` of `f` steps from corner x towards corner y.
+    auto edge_vertex = [&](int x, int y, size_t step) -> int {
+        if (step == 0) {
+            return x;
+        }
+        if (step == f) {
+            return y;
+        }
+        const size_t from_low = x < y ? step : f - step;
+        return int(12 + size_t(edge_of[x][y]) * per_edge + from_low - 1);
+    };
+    auto lattice_vertex = [&](size_t face, size_t a, size_t b) -> int {
+        const int* c = kFaces[face];
+        if (b == 0) {
+            return edge_vertex(c[0], c[1], a);
+        }
+        if (a == 0) {
+            return edge_vertex(c[0], c[2], b);
+        }
+        if (a + b == f) {
+            return edge_vertex(c[1], c[2], b);
+        }
+        const size_t row = (a - 1) * (f - 1) - (a - 1) * a / 2;
+        return int(first_interior + face * per_face + row + b - 1);
+    };
+
+    Writer out(mesh);
+    auto set_vertex = [&](size_t k, const pxr::GfVec3d& direction) {
+        const pxr::GfVec3f normal(direction.GetNormalized());
+        out.positions[k] = normal * radius;
+        out.normals[k] = normal;
+    };
+    for (int c = 0; c < 12; ++c) {
+        set_vertex(size_t(c), corner(c));
+    }
+    parallel_rows(30, per_edge, [&](size_t e) {
+        const pxr::GfVec3d x = corner(edges[e][0]);
+        const pxr::GfVec3d y = corner(edges[e][1]);
+        for (size_t step = 1; step < f; ++step) {
+            const double w = double(step) / double(f);
+            set_vertex(12 + e * per_edge + step - 1, x + (y - x) * w);
+        }
+    });
+
+    auto lattice_point = [&](size_t face, size_t a, size_t b) {
+        const int* c = kFaces[face];
+        return corner(c[0]) * double(f - a - b) + corner(c[1]) * double(a) +
+               corner(c[2]) * double(b);
+    };
+    // Spherical texture coordinates; triangles across the seam get u > 1
+    // on their side towards u = 0.
+    auto set_corners = [&](size_t first, int i0, int i1, int i2) {
+        const int ids[3] = { i0, i1, i2 };
+        pxr::GfVec2f uvs[3];
+        for (int k = 0; k < 3; ++k) {
+            const pxr::GfVec3f& n = out.normals[ids[k]];
+            uvs[k] = pxr::GfVec2f(
+                float(0.5 + std::atan2(n[1], n[0]) / (2.0 * kPi)),
+                float(0.5 + std::asin(std::clamp(n[2], -1.0f, 1.0f)) / kPi));
+        }
+        const float low = std::min({ uvs[0][0], uvs[1][0], uvs[2][0] });
+        const float high = std::max({ uvs[0][0], uvs[1][0], uvs[2][0] });
+        for (int k = 0; k < 3; ++k) {
+            if (high - low > 0.5f && uvs[k][0] < 0.5f) {
+                uvs[k][0] += 1.0f;
+            }
+            out.indices[first + k] = ids[k];
+            out.texcoords[first + k] = uvs[k];
+        }
+    };
+
+    // One work item per lattice row a of a face: its interior points, then
+    // its 2 * (f - a) - 1 triangles, which start at face * f^2 + a (2f - a).
+    parallel_rows(20 * f, f, [&](size_t item) {
+        const size_t face = item / f;
+        const size_t a = item % f;
+        for (size_t b = 1; a >= 1 && a + b < f; ++b) {
+            set_vertex(
+                size_t(lattice_vertex(face, a, b)), lattice_point(face, a, b));
+        }
+    });
+    parallel_rows(20 * f, f, [&](size_t item) {
+        const size_t face = item / f;
+        const size_t a = item % f;
+        size_t triangle = face * f * f + a * (2 * f - a);
+        for (size_t b = 0; a + b < f; ++b) {
+            out.counts[triangle] = 3;
+            set_corners(
+                3 * triangle++,
+                lattice_vertex(face, a, b),
+                lattice_vertex(face, a + 1, b),
+                lattice_vertex(face, a, b + 1));
+            if (a + b + 1 < f) {
+                out.counts[triangle] = 3;
+                set_corners(
+                    3 * triangle++,
+                    lattice_vertex(face, a + 1, b),
+                    lattice_vertex(face, a + 1, b + 1),
+                    lattice_vertex(face, a, b + 1));
+            }
+        }
+    });
+    return true;
+}
+
+bool make_torus(
+    float major_radius,
+    float minor_radius,
+    int segments,
+    int sides,
+    PrimitiveMesh& mesh)
+{
+    if (!check_count("Torus", "segments", segments, 3) ||
+        !check_count("Torus", "sides", sides, 3)) {
+        return false;
+    }
+    const size_t s_count = size_t(segments);
+    const size_t t_count = size_t(sides);
+    const size_t faces = s_count * t_count;
+    if (!allocate(mesh, "Torus", faces, faces, 4 * faces, faces, 4 * faces)) {
+        return false;
+    }
+
+    Writer out(mesh);
+    parallel_rows(s_count, t_count, [&](size_t s) {
+        const pxr::GfVec3f radial = unit_circle(s, s_count);
+        for (size_t t = 0; t < t_count; ++t) {
+            const pxr::GfVec3f tube = unit_circle(t, t_count);
+            pxr::GfVec3f normal = radial * tube[0];
+            normal[2] = tube[1];
+            out.positions[s * t_count + t] =
+                radial * major_radius + normal * minor_radius;
+            out.normals[s * t_count + t] = normal;
+        }
+    });
+    parallel_rows(s_count, t_count, [&](size_t s) {
+        const size_t next = (s + 1) % s_count;
+        const float u0 = float(s) / float(s_count);
+        const float u1 = float(s + 1) / float(s_count);
+        for (size_t t = 0; t < t_count; ++t) {
+            const size_t f = s * t_count + t;
+            const size_t t1 = (t + 1) % t_count;
+            const float v0 = float(t) / float(t_count);
+            const float v1 = float(t + 1) / float(t_count);
+            out.counts[f] = 4;
+            int* quad = out.indices + 4 * f;
+            quad[0] = int(s * t_count + t);
+            quad[1] = int(next * t_count + t);
+            quad[2] = int(next * t_count + t1);
+            quad[3] = int(s * t_count + t1);
+            pxr::GfVec2f* uv = out.texcoords + 4 * f;
+            uv[0] = pxr::GfVec2f(u0, v0);
+            uv[1] = pxr::GfVec2f(u1, v0);
+            uv[2] = pxr::GfVec2f(u1, v1);
+            uv[3] = pxr::GfVec2f(u0, v1);
+        }
+    });
+    return true;
+}
+
+bool make_cube(float size, int cells, PrimitiveMesh& mesh)
+{
+    if (!check_count("Cube", "the number of cells", cells, 1)) {
+        return false;
+    }
+    // The vertices are the surface points (i, j, k) of the lattice
+    // [0, n]^3: the full bottom layer k = 0, the 4n points around each
+    // layer 0 < k < n, and the full top layer k = n.
+    const size_t n = size_t(cells);
+    const size_t layer = (n + 1) * (n + 1);
+    const size_t ring = 4 * n;
+    const size_t top = layer + (n - 1) * ring;
+    const size_t vertices = 2 * layer + (n - 1) * ring;
+    const size_t faces = 6 * n * n;
+    if (!allocate(
+            mesh, "Cube", vertices, faces, 4 * faces, 4 * faces, 4 * faces)) {
+        return false;
+    }
+
+    // Position around a layer, counterclockwise from (0, 0).
+    auto ring_index = [&](size_t i, size_t j) -> size_t {
+        if (j == 0 && i < n) {
+            return i;
+        }
+        if (i == n && j < n) {
+            return n + j;
+        }
+        if (j == n && i > 0) {
+            return 2 * n + (n - i);
+        }
+        return 3 * n + (n - j);
+    };
+    auto index = [&](const size_t* c) -> int {
+        if (c[2] == 0) {
+            return int(c[0] * (n + 1) + c[1]);
+        }
+        if (c[2] == n) {
+            return int(top + c[0] * (n + 1) + c[1]);
+        }
+        return int(layer + (c[2] - 1) * ring + ring_index(c[0], c[1]));
+    };
+
+    Writer out(mesh);
+    const float step = size / float(n);
+    const float half = size / 2;
+    auto set_position = [&](size_t v, size_t i, size_t j, size_t k) {
+        out.positions[v] = pxr::GfVec3f(
+            float(i) * step - half,
+            float(j) * step - half,
+            float(k) * step - half);
+    };
+    parallel_rows(n + 1, n + 1, [&](size_t i) {
+        for (size_t j = 0; j <= n; ++j) {
+            set_position(i * (n + 1) + j, i, j, 0);
+            set_position(top + i * (n + 1) + j, i, j, n);
+        }
+    });
+    parallel_rows(n - 1, ring, [&](size_t row) {
+        const size_t k = row + 1;
+        for (size_t r = 0; r < ring; ++r) {
+            size_t i, j;
+            if (r < n) {
+                i = r, j = 0;
+            }
+            else if (r < 2 * n) {
+                i = n, j = r - n;
+            }
+            else if (r < 3 * n) {
+                i = 3 * n - r, j = n;
+            }
+            else {
+                i = 0, j = 4 * n - r;
+            }
+            set_position(layer + row * ring + r, i, j, k);
+        }
+    });
+
+    // Side d * 2 + high is the face with lattice coordinate d at 0 or n.
+    // Its quads run along the next two axes, whose cross product is +d.
+    parallel_rows(6 * n, n, [&](size_t item) {
+        const size_t side = item / n;
+        const size_t a = item % n;
+        const size_t d = side / 2;
+        const bool high = side % 2 == 1;
+        const size_t axis_u = (d + 1) % 3;
+        const size_t axis_v = (d + 2) % 3;
+        pxr::GfVec3f normal(0);
+        normal[d] = high ? 1.0f : -1.0f;
+        static const size_t kSteps[4][2] = {
+            { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 }
+        };
+        for (size_t b = 0; b < n; ++b) {
+            const size_t f = (side * n + a) * n + b;
+            out.counts[f] = 4;
+            for (int c = 0; c < 4; ++c) {
+                // The low side runs the quad the other way around.
+                const auto& s = kSteps[high ? c : (4 - c) % 4];
+                size_t lattice[3];
+                lattice[d] = high ? n : 0;
+                lattice[axis_u] = a + s[0];
+                lattice[axis_v] = b + s[1];
+                out.indices[4 * f + c] = index(lattice);
+                out.normals[4 * f + c] = normal;
+                out.texcoords[4 * f + c] = pxr::GfVec2f(
+                    float(a + s[0]) / float(n), float(b + s[1]) / float(n));
+            }
+        }
+    });
+    return true;
+}
+
+bool make_cylinder(
+    float radius,
+    float height,
+    int segments,
+    int rings,
+    PrimitiveMesh& mesh)
+{
+    if (!check_count("Cylinder", "segments", segments, 3) ||
+        !check_count("Cylinder", "rings", rings, 1)) {
+        return false;
+    }
+    // Rings 0 .. rings of `segments` vertices from the bottom up, then the
+    // bottom and top centers. Faces are the side quads, then the bottom and
+    // the top fan.
+    const size_t s_count = size_t(segments);
+    const size_t r_count = size_t(rings);
+    const size_t bottom = (r_count + 1) * s_count;
+    const size_t vertices = bottom + 2;
+    const size_t quads = r_count * s_count;
+    const size_t faces = quads + 2 * s_count;
+    const size_t corners = 4 * quads + 6 * s_count;
+    if (!allocate(
+            mesh, "Cylinder", vertices, faces, corners, corners, corners)) {
+        return false;
+    }
+
+    Writer out(mesh);
+    const float half = height / 2;
+    out.positions[bottom] = pxr::GfVec3f(0, 0, -half);
+    out.positions[bottom + 1] = pxr::GfVec3f(0, 0, half);
+    parallel_rows(r_count + 1, s_count, [&](size_t r) {
+        const float z = height * float(r) / float(r_count) - half;
+        for (size_t s = 0; s < s_count; ++s) {
+            pxr::GfVec3f p = unit_circle(s, s_count) * radius;
+            p[2] = z;
+            out.positions[r * s_count + s] = p;
+        }
+    });
+
+    parallel_rows(r_count, s_count, [&](size_t r) {
+        const float v0 = float(r) / float(r_count);
+        const float v1 = float(r + 1) / float(r_count);
+        for (size_t s = 0; s < s_count; ++s) {
+            const size_t f = r * s_count + s;
+            const size_t next = (s + 1) % s_count;
+            const float u0 = float(s) / float(s_count);
+            const float u1 = float(s + 1) / float(s_count);
+            out.counts[f] = 4;
+            const int ids[4] = { int(r * s_count + s),
+                                 int(r * s_count + next),
+                                 int((r + 1) * s_count + next),
+                                 int((r + 1) * s_count + s) };
+            const pxr::GfVec2f uvs[4] = {
+                { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 }
+            };
+            for (int c = 0; c < 4; ++c) {
+                out.indices[4 * f + c] = ids[c];
+                out.normals[4 * f + c] =
+                    unit_circle(c == 0 || c == 3 ? s : next, s_count);
+                out.texcoords[4 * f + c] = uvs[c];
+            }
+        }
+    });
+
+    // Caps, with texture coordinates from the xy position.
+    parallel_rows(2, s_count, [&](size_t cap) {
+        const size_t rim = cap == 0 ? 0 : r_count * s_count;
+        const pxr::GfVec3f normal(0, 0, cap == 0 ? -1.0f : 1.0f);
+        for (size_t s = 0; s < s_count; ++s) {
+            const size_t f = quads + cap * s_count + s;
+            const size_t next = (s + 1) % s_count;
+            // The bottom fan runs clockwise seen from above.
+            const size_t first = cap == 0 ? next : s;
+            const size_t second = cap == 0 ? s : next;
+            const int ids[3] = { int(bottom + cap),
+                                 int(rim + first),
+                                 int(rim + second) };
+            out.counts[f] = 3;
+            const size_t corner = 4 * quads + 3 * (f - quads);
+            for (int c = 0; c < 3; ++c) {
+                const pxr::GfVec3f& p = out.positions[ids[c]];
+                out.indices[corner + c] = ids[c];
+                out.normals[corner + c] = normal;
+                out.texcoords[corner + c] = pxr::GfVec2f(
+                    0.5f + 0.5f * p[0] / radius, 0.5f + 0.5f * p[1] / radius);
+            }
+        }
+    });
+    return true;
+}
+
+bool make_terrain(
+    float size,
+    int cells,
+    const TerrainNoise& noise,
+    PrimitiveMesh& mesh)
+{
+    // Rows i run along y and columns j along x, so edge_v x edge_u is +z.
+    const float half = size / 2;
+    const bool ok = fill_grid(
+        "Terrain",
+        pxr::GfVec3f(-half, -half, 0),
+        pxr::GfVec3f(0, size, 0),
+        pxr::GfVec3f(size, 0, 0),
+        cells,
+        cells,
+        [&](const pxr::GfVec3f& p) { return fractal_noise(p[0], p[1], noise); },
+        mesh);
+    if (!ok) {
+        return false;
+    }
+
+    const size_t n = size_t(cells) + 1;
+    Writer out(mesh);
+    parallel_rows(n, n, [&](size_t i) {
+        const size_t i0 = i > 0 ? i - 1 : i;
+        const size_t i1 = i + 1 < n ? i + 1 : i;
+        for (size_t j = 0; j < n; ++j) {
+            const size_t j0 = j > 0 ? j - 1 : j;
+            const size_t j1 = j + 1 < n ? j + 1 : j;
+            const pxr::GfVec3f along_x =
+                out.positions[i * n + j1] - out.positions[i * n + j0];
+            const pxr::GfVec3f along_y =
+                out.positions[i1 * n + j] - out.positions[i0 * n + j];
+            out.normals[i * n + j] =
+                pxr::GfCross(along_x, along_y).GetNormalized();
+        }
+    });
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
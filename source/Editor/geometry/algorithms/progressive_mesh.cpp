@@ -0,0 +1,640 @@
+#include "GCore/algorithms/progressive_mesh.h"
+
+#include <pxr/base/work/loops.h>
+#include <pxr/base/work/threadLimits.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "GCore/algorithms/triangulate.h"
+#include "Logger/Logger.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+// Patches smaller than this are not worth a thread of their own.
+constexpr size_t kMinPatchFaces = 1 << 15;
+constexpr uint32_t kInvalid = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t kSeam = kInvalid - 1;
+
+constexpr char kMagic[8] = { 'U', 'S', 'T', 'C', 'P', 'M', 0, 0 };
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+using Clock = std::chrono::steady_clock;
+using Triangle = std::array<uint32_t, 3>;
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t vertex_count;
+    uint64_t base_vertex_count;
+    uint64_t face_count;
+    uint64_t split_count;
+    uint64_t corner_count;
+};
+
+// The collapse sequence of the whole mesh in input vertex and triangle ids,
+// gathered from the patch simplifiers and the seam pass.
+struct CollapseLog {
+    std::vector<QemSimplifier::Collapse> collapses;
+    std::vector<uint32_t> corners;
+    std::vector<uint32_t> triangles;
+
+    // Appends the collapses of `simplifier`, whose vertex v is vertices[v]
+    // and triangle t is faces[t] here.
+    template<typename VertexMap, typename FaceMap>
+    void append(
+        const QemSimplifier& simplifier,
+        VertexMap&& vertices,
+        FaceMap&& faces)
+    {
+        for (QemSimplifier::Collapse c : simplifier.collapses()) {
+            const uint32_t* c_corners =
+                simplifier.collapse_corners().data() + c.first_corner;
+            const uint32_t* c_triangles =
+                simplifier.collapse_triangles().data() + c.first_triangle;
+            c.survivor = vertices(c.survivor);
+            c.removed = vertices(c.removed);
+            c.first_corner = uint32_t(corners.size());
+            c.first_triangle = uint32_t(triangles.size());
+            for (uint32_t i = 0; i < c.corner_count; ++i) {
+                corners.push_back(
+                    3 * faces(c_corners[i] / 3) + c_corners[i] % 3);
+            }
+            for (uint32_t i = 0; i < c.triangle_count; ++i) {
+                triangles.push_back(faces(c_triangles[i]));
+            }
+            collapses.push_back(c);
+        }
+    }
+};
+
+// 30-bit Morton code of p inside [lower, lower + extent].
+uint32_t morton_code(
+    const pxr::GfVec3f& p,
+    const pxr::GfVec3f& lower,
+    const pxr::GfVec3f& extent)
+{
+    uint32_t code = 0;
+    uint32_t cell[3];
+    for (int a = 0; a < 3; ++a) {
+        const float t = extent[a] > 0 ? (p[a] - lower[a]) / extent[a] : 0.0f;
+        cell[a] = uint32_t(std::clamp(t, 0.0f, 1.0f) * 1023.0f);
+    }
+    for (int bit = 9; bit >= 0; --bit) {
+        for (int a = 0; a < 3; ++a) {
+            code = (code << 1) | ((cell[a] >> bit) & 1);
+        }
+    }
+    return code;
+}
+
+// Triangle ids sorted along a Morton curve through their centroids, so that
+// any contiguous run is a spatially coherent patch.
+std::vector<uint32_t> morton_order(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const std::vector<Triangle>& triangles)
+{
+    pxr::GfVec3f lower(std::numeric_limits<float>::max());
+    pxr::GfVec3f upper(-std::numeric_limits<float>::max());
+    for (const auto& p : positions) {
+        for (int a = 0; a < 3; ++a) {
+            lower[a] = std::min(lower[a], p[a]);
+            upper[a] = std::max(upper[a], p[a]);
+        }
+    }
+    const pxr::GfVec3f extent = upper - lower;
+
+    std::vector<std::pair<uint32_t, uint32_t>> keyed(triangles.size());
+    pxr::WorkParallelForN(
+        triangles.size(),
+        [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                const auto& tri = triangles[t];
+                const pxr::GfVec3f centroid =
+                    (positions[tri[0]] + positions[tri[1]] +
+                     positions[tri[2]]) /
+                    3.0f;
+                keyed[t] = { morton_code(centroid, lower, extent),
+                             uint32_t(t) };
+            }
+        },
+        kParallelGrain);
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<uint32_t> order(triangles.size());
+    for (size_t i = 0; i < keyed.size(); ++i) {
+        order[i] = keyed[i].second;
+    }
+    return order;
+}
+
+}  // namespace
+
+bool ProgressiveMesh::build(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    float ratio,
+    const QemSimplifier::Options& options,
+    size_t partitions)
+{
+    auto start = Clock::now();
+    *this = ProgressiveMesh();
+
+    const size_t n = positions.size();
+    std::vector<Triangle> triangles;
+    if (!fan_triangulate(
+            face_vertex_counts, face_vertex_indices, n, triangles)) {
+        return false;
+    }
+    const size_t face_count = triangles.size();
+    const size_t target = size_t(std::floor(ratio * face_count));
+
+    if (partitions == 0) {
+        partitions = pxr::WorkGetConcurrencyLimit();
+    }
+    partitions = std::max<size_t>(
+        1, std::min(partitions, face_count / kMinPatchFaces));
+
+    // Evolving state of the whole mesh in input ids.
+    pxr::VtArray<pxr::GfVec3f> current = positions;
+    std::vector<uint8_t> alive(face_count, 1);
+    // Quadrics accumulated by the patches, carried into the seam pass so it
+    // keeps their error history. Seam vertices only saw part of their faces
+    // and stay zero, i.e. are recomputed.
+    std::vector<Quadric> quadrics;
+    CollapseLog history;
+    stats_.input_faces = face_count;
+    stats_.setup_seconds += seconds_since(start);
+
+    if (partitions > 1) {
+        start = Clock::now();
+        const std::vector<uint32_t> order = morton_order(positions, triangles);
+        auto patch_begin = [&](size_t p) {
+            return p * face_count / partitions;
+        };
+
+        // Vertices used by more than one patch form the seams.
+        std::vector<uint32_t> owner(n, kInvalid);
+        for (size_t p = 0; p < partitions; ++p) {
+            for (size_t i = patch_begin(p); i < patch_begin(p + 1); ++i) {
+                for (uint32_t v : triangles[order[i]]) {
+                    if (owner[v] == kInvalid) {
+                        owner[v] = uint32_t(p);
+                    }
+                    else if (owner[v] != p) {
+                        owner[v] = kSeam;
+                    }
+                }
+            }
+        }
+
+        struct Patch {
+            std::vector<uint32_t> vertices;  // Local to input ids.
+            QemSimplifier simplifier;
+        };
+        std::vector<Patch> patches(partitions);
+        pxr::WorkParallelForN(
+            partitions,
+            [&](size_t begin, size_t end) {
+                for (size_t p = begin; p < end; ++p) {
+                    Patch& patch = patches[p];
+                    const uint32_t* faces = order.data() + patch_begin(p);
+                    const size_t patch_faces =
+                        patch_begin(p + 1) - patch_begin(p);
+
+                    auto& vertices = patch.vertices;
+                    for (size_t i = 0; i < patch_faces; ++i) {
+                        const auto& t = triangles[faces[i]];
+                        vertices.insert(vertices.end(), t.begin(), t.end());
+                    }
+                    std::sort(vertices.begin(), vertices.end());
+                    vertices.erase(
+                        std::unique(vertices.begin(), vertices.end()),
+                        vertices.end());
+                    auto local = [&](uint32_t v) {
+                        return uint32_t(
+                            std::lower_bound(
+                                vertices.begin(), vertices.end(), v) -
+                            vertices.begin());
+                    };
+
+                    pxr::VtArray<pxr::GfVec3f> patch_positions(
+                        vertices.size());
+                    QemSimplifier::Options patch_options = options;
+                    patch_options.pair_distance = 0;
+                    patch_options.record = true;
+                    patch_options.locked.resize(vertices.size());
+                    for (size_t v = 0; v < vertices.size(); ++v) {
+                        patch_positions[v] = positions[vertices[v]];
+                    }
+                    // Seam vertices have neighbors the patch cannot see, so
+                    // the link condition is only exact for collapses that
+                    // stay clear of them: their whole one-ring is locked.
+                    std::vector<Triangle> patch_triangles(patch_faces);
+                    for (size_t i = 0; i < patch_faces; ++i) {
+                        const auto& t = triangles[faces[i]];
+                        const bool on_seam = owner[t[0]] == kSeam ||
+                                             owner[t[1]] == kSeam ||
+                                             owner[t[2]] == kSeam;
+                        for (int k = 0; k < 3; ++k) {
+                            patch_triangles[i][k] = local(t[k]);
+                            if (on_seam) {
+                                patch_options.locked[patch_triangles[i][k]] =
+                                    1;
+                            }
+                        }
+                    }
+                    size_t locked_faces = 0;
+                    for (const auto& t : patch_triangles) {
+                        locked_faces += patch_options.locked[t[0]] ||
+                                        patch_options.locked[t[1]] ||
+                                        patch_options.locked[t[2]];
+                    }
+
+                    patch.simplifier.build(
+                        patch_positions,
+                        std::move(patch_triangles),
+                        patch_options);
+                    // Only the free interior is brought down to the ratio;
+                    // squeezing the whole patch target out of it would
+                    // over-simplify it next to the untouched seam band.
+                    patch.simplifier.simplify(
+                        locked_faces +
+                        size_t(std::floor(
+                            ratio * (patch_faces - locked_faces))));
+                }
+            },
+            1);
+
+        // Patches touch disjoint triangles and never move shared vertices,
+        // so their sequences concatenate into one valid sequence.
+        quadrics.resize(n);
+        for (size_t p = 0; p < partitions; ++p) {
+            const Patch& patch = patches[p];
+            const QemSimplifier& s = patch.simplifier;
+            const uint32_t* faces = order.data() + patch_begin(p);
+            auto vertex = [&](uint32_t v) { return patch.vertices[v]; };
+            auto face = [&](uint32_t t) { return faces[t]; };
+            history.append(s, vertex, face);
+            for (size_t v = 0; v < patch.vertices.size(); ++v) {
+                const uint32_t global = patch.vertices[v];
+                current[global] = pxr::GfVec3f(s.positions()[v]);
+                if (owner[global] != kSeam) {
+                    quadrics[global] = s.quadrics()[v];
+                }
+            }
+            for (size_t t = 0; t < s.triangles().size(); ++t) {
+                for (int k = 0; k < 3; ++k) {
+                    triangles[faces[t]][k] = vertex(s.triangles()[t][k]);
+                }
+                alive[faces[t]] = s.triangle_alive()[t];
+            }
+        }
+        patches.clear();
+        stats_.simplify_seconds += seconds_since(start);
+    }
+
+    // Seam pass over everything that survived, in input vertex ids.
+    start = Clock::now();
+    std::vector<uint32_t> surviving;
+    surviving.reserve(face_count);
+    for (uint32_t t = 0; t < face_count; ++t) {
+        if (alive[t]) {
+            surviving.push_back(t);
+        }
+    }
+    std::vector<Triangle> seam_triangles(surviving.size());
+    for (size_t i = 0; i < surviving.size(); ++i) {
+        seam_triangles[i] = triangles[surviving[i]];
+    }
+    QemSimplifier::Options seam_options = options;
+    if (partitions > 1) {
+        // The patches moved vertices away from the positions the tree was
+        // built over.
+        seam_options.point_tree = nullptr;
+    }
+    seam_options.record = true;
+    seam_options.quadrics = std::move(quadrics);
+    QemSimplifier seam;
+    seam.build(current, std::move(seam_triangles), seam_options);
+    seam.simplify(target);
+    stats_.non_edge_pairs = seam.stats().non_edge_pairs;
+    stats_.setup_seconds += seam.stats().setup_seconds;
+    stats_.simplify_seconds += seam.stats().simplify_seconds;
+
+    history.append(
+        seam,
+        [](uint32_t v) { return v; },
+        [&](uint32_t t) { return surviving[t]; });
+    for (size_t v = 0; v < n; ++v) {
+        current[v] = pxr::GfVec3f(seam.positions()[v]);
+    }
+    for (size_t i = 0; i < surviving.size(); ++i) {
+        triangles[surviving[i]] = seam.triangles()[i];
+        alive[surviving[i]] = seam.triangle_alive()[i];
+    }
+    seam = QemSimplifier();
+
+    // Renumber so that every level is a prefix: surviving vertices and
+    // triangles first, then whatever the last collapse removed, and so on.
+    start = Clock::now();
+    const size_t collapse_count = history.collapses.size();
+    base_vertex_count_ = n - collapse_count;
+    std::vector<uint32_t> vertex_id(n, kInvalid);
+    for (size_t i = 0; i < collapse_count; ++i) {
+        vertex_id[history.collapses[i].removed] =
+            uint32_t(base_vertex_count_ + collapse_count - 1 - i);
+    }
+    uint32_t next_vertex = 0;
+    for (size_t v = 0; v < n; ++v) {
+        if (vertex_id[v] == kInvalid) {
+            vertex_id[v] = next_vertex++;
+        }
+    }
+
+    std::vector<uint32_t> face_id(face_count);
+    uint32_t next_face = 0;
+    for (size_t t = 0; t < face_count; ++t) {
+        if (alive[t]) {
+            face_id[t] = next_face++;
+        }
+    }
+    face_offsets_.resize(collapse_count + 1);
+    face_offsets_[0] = next_face;
+    splits_.resize(collapse_count);
+    corners_.resize(history.corners.size());
+    uint32_t next_corner = 0;
+    for (size_t s = 0; s < collapse_count; ++s) {
+        const QemSimplifier::Collapse& c =
+            history.collapses[collapse_count - 1 - s];
+        for (uint32_t i = 0; i < c.triangle_count; ++i) {
+            face_id[history.triangles[c.first_triangle + i]] = next_face++;
+        }
+        face_offsets_[s + 1] = next_face;
+
+        VertexSplit& split = splits_[s];
+        split.vertex = vertex_id[c.survivor];
+        split.vertex_position = c.survivor_position;
+        split.new_position = c.removed_position;
+        split.collapsed_position = c.position;
+        split.first_corner = next_corner;
+        split.corner_count = c.corner_count;
+        split.added_faces = c.triangle_count;
+        for (uint32_t i = 0; i < c.corner_count; ++i) {
+            const uint32_t old_corner = history.corners[c.first_corner + i];
+            corners_[next_corner++] =
+                3 * face_id[old_corner / 3] + old_corner % 3;
+        }
+    }
+
+    positions_.assign(n, pxr::GfVec3f(0));
+    for (size_t v = 0; v < n; ++v) {
+        if (vertex_id[v] < base_vertex_count_) {
+            positions_[vertex_id[v]] = current[v];
+        }
+    }
+    indices_.resize(3 * face_count);
+    pxr::WorkParallelForN(
+        face_count,
+        [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                for (int k = 0; k < 3; ++k) {
+                    indices_[3 * face_id[t] + k] = vertex_id[triangles[t][k]];
+                }
+            }
+        },
+        kParallelGrain);
+    level_ = 0;
+
+    stats_.output_faces = face_offsets_[0];
+    stats_.collapses = collapse_count;
+    stats_.setup_seconds += seconds_since(start);
+    return true;
+}
+
+void ProgressiveMesh::apply_split(size_t split)
+{
+    const VertexSplit& s = splits_[split];
+    const uint32_t new_vertex = uint32_t(base_vertex_count_ + split);
+    positions_[s.vertex] = s.vertex_position;
+    positions_[new_vertex] = s.new_position;
+    for (uint32_t i = 0; i < s.corner_count; ++i) {
+        indices_[corners_[s.first_corner + i]] = new_vertex;
+    }
+}
+
+void ProgressiveMesh::undo_split(size_t split)
+{
+    const VertexSplit& s = splits_[split];
+    positions_[s.vertex] = s.collapsed_position;
+    for (uint32_t i = 0; i < s.corner_count; ++i) {
+        indices_[corners_[s.first_corner + i]] = s.vertex;
+    }
+}
+
+void ProgressiveMesh::set_level(size_t level)
+{
+    level = std::min(level, splits_.size());
+    for (; level_ < level; ++level_) {
+        apply_split(level_);
+    }
+    while (level_ > level) {
+        undo_split(--level_);
+    }
+}
+
+size_t ProgressiveMesh::level_for_face_count(size_t faces) const
+{
+    const auto it =
+        std::lower_bound(face_offsets_.begin(), face_offsets_.end(), faces);
+    if (it == face_offsets_.end()) {
+        return splits_.size();
+    }
+    return size_t(it - face_offsets_.begin());
+}
+
+void ProgressiveMesh::extract(
+    pxr::VtArray<pxr::GfVec3f>& positions,
+    pxr::VtArray<int>& face_vertex_counts,
+    pxr::VtArray<int>& face_vertex_indices) const
+{
+    positions.assign(positions_.begin(), positions_.begin() + vertex_count());
+    face_vertex_counts.assign(face_count(), 3);
+    face_vertex_indices.assign(
+        indices_.begin(), indices_.begin() + 3 * face_count());
+}
+
+std::vector<uint8_t> ProgressiveMesh::serialize() const
+{
+    // The stream holds level 0, so undo the current level on copies.
+    std::vector<pxr::GfVec3f> positions(
+        positions_.begin(), positions_.begin() + base_vertex_count_);
+    std::vector<uint32_t> indices = indices_;
+    for (size_t split = level_; split-- > 0;) {
+        const VertexSplit& s = splits_[split];
+        if (s.vertex < base_vertex_count_) {
+            positions[s.vertex] = s.collapsed_position;
+        }
+        for (uint32_t i = 0; i < s.corner_count; ++i) {
+            indices[corners_[s.first_corner + i]] = s.vertex;
+        }
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrderMark;
+    header.vertex_count = positions_.size();
+    header.base_vertex_count = base_vertex_count_;
+    header.face_count = indices_.size() / 3;
+    header.split_count = splits_.size();
+    header.corner_count = corners_.size();
+
+    std::vector<uint8_t> stream;
+    auto append = [&](const void* data, size_t bytes) {
+        const uint8_t* begin = static_cast<const uint8_t*>(data);
+        stream.insert(stream.end(), begin, begin + bytes);
+    };
+    stream.reserve(
+        sizeof(Header) + positions.size() * sizeof(pxr::GfVec3f) +
+        indices.size() * sizeof(uint32_t) +
+        splits_.size() * sizeof(VertexSplit) +
+        corners_.size() * sizeof(uint32_t));
+    append(&header, sizeof(header));
+    append(positions.data(), positions.size() * sizeof(pxr::GfVec3f));
+    append(indices.data(), indices.size() * sizeof(uint32_t));
+    append(splits_.data(), splits_.size() * sizeof(VertexSplit));
+    append(corners_.data(), corners_.size() * sizeof(uint32_t));
+    return stream;
+}
+
+bool ProgressiveMesh::deserialize(const uint8_t* data, size_t size)
+{
+    *this = ProgressiveMesh();
+
+    Header header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion || header.byte_order != kByteOrderMark ||
+        header.base_vertex_count + header.split_count != header.vertex_count ||
+        header.vertex_count > std::numeric_limits<uint32_t>::max() ||
+        header.face_count > std::numeric_limits<uint32_t>::max() / 3) {
+        return false;
+    }
+    const uint64_t expected =
+        sizeof(header) + header.base_vertex_count * sizeof(pxr::GfVec3f) +
+        header.face_count * 3 * sizeof(uint32_t) +
+        header.split_count * sizeof(VertexSplit) +
+        header.corner_count * sizeof(uint32_t);
+    if (size != expected) {
+        return false;
+    }
+
+    const uint8_t* cursor = data + sizeof(header);
+    auto read = [&](void* out, size_t bytes) {
+        std::memcpy(out, cursor, bytes);
+        cursor += bytes;
+    };
+    base_vertex_count_ = header.base_vertex_count;
+    positions_.assign(header.vertex_count, pxr::GfVec3f(0));
+    read(positions_.data(), base_vertex_count_ * sizeof(pxr::GfVec3f));
+    indices_.resize(header.face_count * 3);
+    read(indices_.data(), indices_.size() * sizeof(uint32_t));
+    splits_.resize(header.split_count);
+    read(splits_.data(), splits_.size() * sizeof(VertexSplit));
+    corners_.resize(header.corner_count);
+    read(corners_.data(), corners_.size() * sizeof(uint32_t));
+
+    // Validate everything a split will index, and rebuild the face counts.
+    face_offsets_.resize(splits_.size() + 1);
+    uint64_t faces = header.face_count;
+    for (const auto& s : splits_) {
+        faces -= std::min<uint64_t>(faces, s.added_faces);
+    }
+    face_offsets_[0] = uint32_t(faces);
+    for (size_t i = 0; i < splits_.size(); ++i) {
+        const VertexSplit& s = splits_[i];
+        face_offsets_[i + 1] = face_offsets_[i] + s.added_faces;
+        if (s.vertex >= base_vertex_count_ + i ||
+            uint64_t(s.first_corner) + s.corner_count > corners_.size()) {
+            *this = ProgressiveMesh();
+            return false;
+        }
+    }
+    const bool valid =
+        face_offsets_.back() == header.face_count &&
+        std::all_of(
+            corners_.begin(),
+            corners_.end(),
+            [&](uint32_t c) { return c < indices_.size(); }) &&
+        std::all_of(indices_.begin(), indices_.end(), [&](uint32_t v) {
+            return v < positions_.size();
+        });
+    if (!valid) {
+        *this = ProgressiveMesh();
+        return false;
+    }
+    stats_.input_faces = header.face_count;
+    stats_.output_faces = face_offsets_[0];
+    stats_.collapses = splits_.size();
+    return true;
+}
+
+bool ProgressiveMesh::write(const std::string& path) const
+{
+    const std::vector<uint8_t> stream = serialize();
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        log::warning(
+            "Cannot open progressive mesh %s for writing", path.c_str());
+        return false;
+    }
+    file.write(
+        reinterpret_cast<const char*>(stream.data()),
+        std::streamsize(stream.size()));
+    if (!file) {
+        log::warning("Failed to write progressive mesh %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ProgressiveMesh::read(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        log::warning("Cannot open progressive mesh %s", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> stream(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(
+        reinterpret_cast<char*>(stream.data()),
+        std::streamsize(stream.size()));
+    if (!file || !deserialize(stream.data(), stream.size())) {
+        log::warning("Malformed progressive mesh %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,755 @@
+#include "GCore/algorithms/qem.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+#include "GCore/algorithms/kd_tree.h"
+#include "GCore/algorithms/triangulate.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+// Non-edge partners kept per vertex, nearest first.
+constexpr size_t kMaxPartners = 4;
+// Squared sine of the corner angle below which a triangle counts as
+// degenerate; its normal has no reliable direction.
+constexpr double kDegenerateSine2 = 1e-12;
+// A surviving triangle may not shrink below this fraction of its area.
+constexpr double kMinAreaRatio = 1e-3;
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Unnormalized normal of triangle q, or zero if the triangle is degenerate.
+pxr::GfVec3d triangle_normal(const pxr::GfVec3d (&q)[3])
+{
+    const pxr::GfVec3d e1 = q[1] - q[0];
+    const pxr::GfVec3d e2 = q[2] - q[0];
+    const pxr::GfVec3d n = pxr::GfCross(e1, e2);
+    if (n.GetLengthSq() <=
+        kDegenerateSine2 * e1.GetLengthSq() * e2.GetLengthSq()) {
+        return pxr::GfVec3d(0.0);
+    }
+    return n;
+}
+
+}  // namespace
+
+Quadric Quadric::from_plane(const pxr::GfVec3d& n, double d, double weight)
+{
+    Quadric q;
+    q.a00 = weight * n[0] * n[0];
+    q.a01 = weight * n[0] * n[1];
+    q.a02 = weight * n[0] * n[2];
+    q.a11 = weight * n[1] * n[1];
+    q.a12 = weight * n[1] * n[2];
+    q.a22 = weight * n[2] * n[2];
+    q.b0 = weight * d * n[0];
+    q.b1 = weight * d * n[1];
+    q.b2 = weight * d * n[2];
+    q.c = weight * d * d;
+    return q;
+}
+
+Quadric& Quadric::operator+=(const Quadric& q)
+{
+    a00 += q.a00;
+    a01 += q.a01;
+    a02 += q.a02;
+    a11 += q.a11;
+    a12 += q.a12;
+    a22 += q.a22;
+    b0 += q.b0;
+    b1 += q.b1;
+    b2 += q.b2;
+    c += q.c;
+    return *this;
+}
+
+double Quadric::evaluate(const pxr::GfVec3d& p) const
+{
+    const double x = p[0], y = p[1], z = p[2];
+    return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + a11 * y * y +
+           2 * a12 * y * z + a22 * z * z + 2 * (b0 * x + b1 * y + b2 * z) + c;
+}
+
+bool Quadric::optimize(pxr::GfVec3d& p) const
+{
+    // Cofactors of the symmetric 3x3 block.
+    const double c00 = a11 * a22 - a12 * a12;
+    const double c01 = a02 * a12 - a01 * a22;
+    const double c02 = a01 * a12 - a02 * a11;
+    const double det = a00 * c00 + a01 * c01 + a02 * c02;
+    const double trace = a00 + a11 + a22;
+    // Relative test so the threshold does not depend on the model scale.
+    if (!(std::abs(det) > 1e-9 * trace * trace * trace)) {
+        return false;
+    }
+    const double c11 = a00 * a22 - a02 * a02;
+    const double c12 = a01 * a02 - a00 * a12;
+    const double c22 = a00 * a11 - a01 * a01;
+    const double inv = -1.0 / det;
+    p = pxr::GfVec3d(
+        inv * (c00 * b0 + c01 * b1 + c02 * b2),
+        inv * (c01 * b0 + c11 * b1 + c12 * b2),
+        inv * (c02 * b0 + c12 * b1 + c22 * b2));
+    return true;
+}
+
+bool QemSimplifier::build(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    const Options& options)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    if (!fan_triangulate(
+            face_vertex_counts,
+            face_vertex_indices,
+            positions.size(),
+            triangles)) {
+        return false;
+    }
+    return build(positions, std::move(triangles), options);
+}
+
+bool QemSimplifier::build(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    std::vector<std::array<uint32_t, 3>> triangles,
+    const Options& options)
+{
+    const auto start = Clock::now();
+    *this = QemSimplifier();
+
+    const size_t n = positions.size();
+    for (const auto& t : triangles) {
+        if (t[0] >= n || t[1] >= n || t[2] >= n) {
+            return false;
+        }
+    }
+    if ((!options.locked.empty() && options.locked.size() != n) ||
+        (!options.quadrics.empty() && options.quadrics.size() != n)) {
+        return false;
+    }
+    triangles_ = std::move(triangles);
+
+    positions_.resize(n);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                positions_[i] = pxr::GfVec3d(positions[i]);
+            }
+        },
+        kParallelGrain);
+
+    triangle_alive_.assign(triangles_.size(), 1);
+    alive_faces_ = triangles_.size();
+    versions_.assign(n, 0);
+    boundary_.assign(n, 0);
+    marks_.assign(n, 0);
+    if (options.locked.empty()) {
+        locked_.assign(n, 0);
+    }
+    else {
+        locked_ = options.locked;
+    }
+    record_ = options.record;
+
+    build_references();
+    // Vertices no triangle uses take no part; extract() drops them.
+    vertex_alive_.resize(n);
+    for (size_t v = 0; v < n; ++v) {
+        vertex_alive_[v] = ref_count_[v] > 0;
+    }
+    build_quadrics(options.boundary_weight);
+    if (!options.quadrics.empty()) {
+        for (size_t v = 0; v < n; ++v) {
+            if (!options.quadrics[v].is_zero()) {
+                quadrics_[v] = options.quadrics[v];
+            }
+        }
+    }
+    build_edge_pairs();
+    if (options.pair_distance > 0) {
+        build_non_edge_pairs(options.pair_distance, options.point_tree);
+    }
+
+    stats_.input_faces = triangles_.size();
+    stats_.output_faces = alive_faces_;
+    stats_.setup_seconds = seconds_since(start);
+    return true;
+}
+
+void QemSimplifier::build_references()
+{
+    const size_t n = positions_.size();
+    ref_count_.assign(n, 0);
+    for (const auto& t : triangles_) {
+        ++ref_count_[t[0]];
+        ++ref_count_[t[1]];
+        ++ref_count_[t[2]];
+    }
+    ref_begin_.resize(n);
+    uint32_t offset = 0;
+    for (size_t v = 0; v < n; ++v) {
+        ref_begin_[v] = offset;
+        offset += ref_count_[v];
+    }
+    references_.resize(offset);
+    std::vector<uint32_t> cursor = ref_begin_;
+    for (uint32_t t = 0; t < triangles_.size(); ++t) {
+        for (uint32_t v : triangles_[t]) {
+            references_[cursor[v]++] = t;
+        }
+    }
+}
+
+void QemSimplifier::build_quadrics(double boundary_weight)
+{
+    quadrics_.resize(positions_.size());
+    pxr::WorkParallelForN(
+        positions_.size(),
+        [&](size_t begin, size_t end) {
+            // (neighbor, number of triangles sharing the edge to it)
+            std::vector<std::pair<uint32_t, uint32_t>> edges;
+            for (size_t v = begin; v < end; ++v) {
+                Quadric q;
+                edges.clear();
+                const uint32_t* refs = references_.data() + ref_begin_[v];
+                for (uint32_t i = 0; i < ref_count_[v]; ++i) {
+                    const auto& t = triangles_[refs[i]];
+                    const pxr::GfVec3d& p0 = positions_[t[0]];
+                    pxr::GfVec3d normal = pxr::GfCross(
+                        positions_[t[1]] - p0, positions_[t[2]] - p0);
+                    const double area2 = normal.GetLength();
+                    if (area2 > 0) {
+                        normal /= area2;
+                        q += Quadric::from_plane(
+                            normal, -pxr::GfDot(normal, p0), 0.5 * area2);
+                    }
+                    for (uint32_t u : t) {
+                        if (u == v) {
+                            continue;
+                        }
+                        auto it = std::find_if(
+                            edges.begin(), edges.end(), [u](const auto& e) {
+                                return e.first == u;
+                            });
+                        if (it == edges.end()) {
+                            edges.push_back({ u, 1 });
+                        }
+                        else {
+                            ++it->second;
+                        }
+                    }
+                }
+                // Edges used by one triangle only are boundary edges. They are
+                // pinned by a plane through the edge, perpendicular to the
+                // face.
+                for (const auto& [u, count] : edges) {
+                    if (count != 1) {
+                        continue;
+                    }
+                    boundary_[v] = 1;
+                    for (uint32_t i = 0; i < ref_count_[v]; ++i) {
+                        const auto& t = triangles_[refs[i]];
+                        if (t[0] != u && t[1] != u && t[2] != u) {
+                            continue;
+                        }
+                        const pxr::GfVec3d& p0 = positions_[t[0]];
+                        const pxr::GfVec3d face_normal = pxr::GfCross(
+                            positions_[t[1]] - p0, positions_[t[2]] - p0);
+                        const pxr::GfVec3d edge = positions_[u] - positions_[v];
+                        pxr::GfVec3d normal = pxr::GfCross(edge, face_normal);
+                        const double length = normal.GetLength();
+                        if (length > 0) {
+                            normal /= length;
+                            q += Quadric::from_plane(
+                                normal,
+                                -pxr::GfDot(normal, positions_[v]),
+                                boundary_weight * edge.GetLengthSq());
+                        }
+                        break;
+                    }
+                }
+                quadrics_[v] = q;
+            }
+        },
+        kParallelGrain);
+}
+
+void QemSimplifier::build_edge_pairs()
+{
+    const size_t n = positions_.size();
+    // Each vertex owns its edges to higher-numbered neighbors. Counted first
+    // so the candidates can be written in parallel without locking.
+    auto upper_neighbors = [&](uint32_t v, std::vector<uint32_t>& out) {
+        out.clear();
+        const uint32_t* refs = references_.data() + ref_begin_[v];
+        for (uint32_t i = 0; i < ref_count_[v]; ++i) {
+            for (uint32_t u : triangles_[refs[i]]) {
+                if (u > v) {
+                    out.push_back(u);
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    };
+
+    std::vector<uint32_t> offsets(n + 1, 0);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t begin, size_t end) {
+            std::vector<uint32_t> neighbors;
+            for (size_t v = begin; v < end; ++v) {
+                upper_neighbors(uint32_t(v), neighbors);
+                offsets[v + 1] = uint32_t(neighbors.size());
+            }
+        },
+        kParallelGrain);
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<Candidate> candidates(offsets[n]);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t begin, size_t end) {
+            std::vector<uint32_t> neighbors;
+            for (size_t v = begin; v < end; ++v) {
+                upper_neighbors(uint32_t(v), neighbors);
+                for (size_t i = 0; i < neighbors.size(); ++i) {
+                    candidates[offsets[v] + i] =
+                        evaluate(uint32_t(v), neighbors[i]);
+                }
+            }
+        },
+        kParallelGrain);
+    heap_.assign(std::move(candidates));
+}
+
+void QemSimplifier::build_non_edge_pairs(
+    float pair_distance,
+    std::shared_ptr<const PointKdTree> tree)
+{
+    const size_t n = positions_.size();
+    if (n == 0) {
+        return;
+    }
+
+    // Connected components, to tell apart parts that no edge joins.
+    std::vector<uint32_t> parent(n);
+    std::iota(parent.begin(), parent.end(), 0u);
+    auto find = [&](uint32_t x) {
+        while (parent[x] != x) {
+            x = parent[x] = parent[parent[x]];
+        }
+        return x;
+    };
+    for (const auto& t : triangles_) {
+        for (int k = 0; k < 2; ++k) {
+            const uint32_t a = find(t[k]), b = find(t[k + 1]);
+            if (a != b) {
+                parent[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+    bool multiple_components = false;
+    uint32_t first_root = uint32_t(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        parent[v] = find(v);
+        if (vertex_alive_[v]) {
+            if (first_root == n) {
+                first_root = parent[v];
+            }
+            multiple_components |= parent[v] != first_root;
+        }
+    }
+
+    pxr::VtArray<pxr::GfVec3f> points(n);
+    pxr::GfVec3f lower(PointKdTree::kInfinity), upper(-PointKdTree::kInfinity);
+    for (size_t v = 0; v < n; ++v) {
+        points[v] = pxr::GfVec3f(positions_[v]);
+        for (int a = 0; a < 3; ++a) {
+            lower[a] = std::min(lower[a], points[v][a]);
+            upper[a] = std::max(upper[a], points[v][a]);
+        }
+    }
+    const float radius = pair_distance * (upper - lower).GetLength();
+    if (!tree || tree->size() != n) {
+        auto built = std::make_shared<PointKdTree>();
+        built->build(points);
+        tree = std::move(built);
+    }
+
+    partners_.resize(n);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t begin, size_t end) {
+            std::vector<PointKdTree::Neighbor> found;
+            for (size_t v = begin; v < end; ++v) {
+                if (!vertex_alive_[v] ||
+                    (!multiple_components && !boundary_[v])) {
+                    continue;
+                }
+                tree->k_nearest(points[v], kMaxPartners + 8, found, radius);
+                const uint32_t* refs = references_.data() + ref_begin_[v];
+                for (const auto& neighbor : found) {
+                    const uint32_t u = uint32_t(neighbor.index);
+                    if (u == v || !vertex_alive_[u] ||
+                        (locked_[u] && locked_[v]) ||
+                        (parent[u] == parent[v] &&
+                         !(boundary_[u] && boundary_[v]))) {
+                        continue;
+                    }
+                    bool is_edge = false;
+                    for (uint32_t i = 0; i < ref_count_[v] && !is_edge; ++i) {
+                        const auto& t = triangles_[refs[i]];
+                        is_edge = t[0] == u || t[1] == u || t[2] == u;
+                    }
+                    if (!is_edge) {
+                        partners_[v].push_back(u);
+                        if (partners_[v].size() == kMaxPartners) {
+                            break;
+                        }
+                    }
+                }
+            }
+        },
+        kParallelGrain);
+
+    for (uint32_t v = 0; v < n; ++v) {
+        for (uint32_t u : partners_[v]) {
+            heap_.push(evaluate(v, u));
+            ++stats_.non_edge_pairs;
+        }
+    }
+}
+
+pxr::GfVec3d
+QemSimplifier::target_position(const Quadric& q, uint32_t a, uint32_t b) const
+{
+    if (locked_[a]) {
+        return positions_[a];
+    }
+    pxr::GfVec3d p;
+    if (q.optimize(p)) {
+        return p;
+    }
+    // Near-singular system (flat or linear neighborhoods): best of the end
+    // points and the midpoint.
+    const pxr::GfVec3d options[3] = { positions_[a],
+                                      positions_[b],
+                                      (positions_[a] + positions_[b]) * 0.5 };
+    double best = q.evaluate(options[0]);
+    p = options[0];
+    for (int i = 1; i < 3; ++i) {
+        const double e = q.evaluate(options[i]);
+        if (e < best) {
+            best = e;
+            p = options[i];
+        }
+    }
+    return p;
+}
+
+QemSimplifier::Candidate QemSimplifier::evaluate(uint32_t a, uint32_t b) const
+{
+    // The survivor is the first vertex, so a locked one goes there.
+    if (locked_[b]) {
+        std::swap(a, b);
+    }
+    Quadric q = quadrics_[a];
+    q += quadrics_[b];
+    const double error = q.evaluate(target_position(q, a, b));
+    return { float(std::max(error, 0.0)), a, b, versions_[a] + versions_[b] };
+}
+
+bool QemSimplifier::is_current(const Candidate& c) const
+{
+    return vertex_alive_[c.a] && vertex_alive_[c.b] &&
+           c.stamp == versions_[c.a] + versions_[c.b];
+}
+
+// For an edge (a, b), the vertices adjacent to both must be exactly the
+// apexes of the triangles on the edge; otherwise the collapse pinches the
+// surface. Interior edges between two boundary vertices are refused for the
+// same reason.
+bool QemSimplifier::link_condition(uint32_t a, uint32_t b) const
+{
+    mark_epoch_ += 2;
+    const uint32_t seen = mark_epoch_, counted = mark_epoch_ + 1;
+
+    uint32_t shared_faces = 0;
+    const uint32_t* refs_a = references_.data() + ref_begin_[a];
+    for (uint32_t i = 0; i < ref_count_[a]; ++i) {
+        if (!triangle_alive_[refs_a[i]]) {
+            continue;
+        }
+        const auto& t = triangles_[refs_a[i]];
+        if (t[0] == b || t[1] == b || t[2] == b) {
+            ++shared_faces;
+        }
+        for (uint32_t u : t) {
+            marks_[u] = seen;
+        }
+    }
+    if (shared_faces == 0) {
+        return true;  // Non-edge pair.
+    }
+    if (shared_faces == 2 && boundary_[a] && boundary_[b]) {
+        return false;
+    }
+
+    uint32_t shared_neighbors = 0;
+    const uint32_t* refs_b = references_.data() + ref_begin_[b];
+    for (uint32_t i = 0; i < ref_count_[b]; ++i) {
+        if (!triangle_alive_[refs_b[i]]) {
+            continue;
+        }
+        for (uint32_t u : triangles_[refs_b[i]]) {
+            if (u != a && u != b && marks_[u] == seen) {
+                marks_[u] = counted;
+                ++shared_neighbors;
+            }
+        }
+    }
+    return shared_neighbors == shared_faces;
+}
+
+// True if moving a and b to p turns any surviving triangle over or squashes
+// it to (nearly) zero area. Triangles that are degenerate already have no
+// orientation to lose and are ignored.
+bool QemSimplifier::flips(uint32_t a, uint32_t b, const pxr::GfVec3d& p) const
+{
+    for (uint32_t v : { a, b }) {
+        const uint32_t other = v == a ? b : a;
+        const uint32_t* refs = references_.data() + ref_begin_[v];
+        for (uint32_t i = 0; i < ref_count_[v]; ++i) {
+            if (!triangle_alive_[refs[i]]) {
+                continue;
+            }
+            const auto& t = triangles_[refs[i]];
+            if (t[0] == other || t[1] == other || t[2] == other) {
+                continue;  // Removed by the collapse.
+            }
+            pxr::GfVec3d q[3] = { positions_[t[0]],
+                                  positions_[t[1]],
+                                  positions_[t[2]] };
+            const pxr::GfVec3d before = triangle_normal(q);
+            if (before.GetLengthSq() == 0) {
+                continue;
+            }
+            q[std::find(t.begin(), t.end(), v) - t.begin()] = p;
+            const pxr::GfVec3d after = triangle_normal(q);
+            if (after.GetLengthSq() <
+                    kMinAreaRatio * kMinAreaRatio * before.GetLengthSq() ||
+                pxr::GfDot(before, after) <= 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void QemSimplifier::collapse(uint32_t a, uint32_t b, const pxr::GfVec3d& p)
+{
+    if (record_) {
+        collapses_.push_back({ a,
+                               b,
+                               pxr::GfVec3f(positions_[a]),
+                               pxr::GfVec3f(positions_[b]),
+                               pxr::GfVec3f(p),
+                               uint32_t(collapse_corners_.size()),
+                               0,
+                               uint32_t(collapse_triangles_.size()),
+                               0 });
+    }
+    positions_[a] = p;
+    quadrics_[a] += quadrics_[b];
+    boundary_[a] |= boundary_[b];
+    vertex_alive_[b] = 0;
+    ++versions_[a];
+    ++versions_[b];
+
+    // The merged neighborhood is appended; triangles on the edge die, the
+    // rest of b's triangles are rewired to a.
+    const uint32_t begin = uint32_t(references_.size());
+    for (uint32_t v : { a, b }) {
+        for (uint32_t i = 0; i < ref_count_[v]; ++i) {
+            const uint32_t t = references_[ref_begin_[v] + i];
+            if (!triangle_alive_[t]) {
+                continue;
+            }
+            auto& tri = triangles_[t];
+            const bool has_a = tri[0] == a || tri[1] == a || tri[2] == a;
+            const bool has_b = tri[0] == b || tri[1] == b || tri[2] == b;
+            if (has_a && has_b) {
+                triangle_alive_[t] = 0;
+                --alive_faces_;
+                if (record_) {
+                    collapse_triangles_.push_back(t);
+                }
+                continue;
+            }
+            if (has_b) {
+                const uint32_t k = uint32_t(
+                    std::find(tri.begin(), tri.end(), b) - tri.begin());
+                tri[k] = a;
+                if (record_) {
+                    collapse_corners_.push_back(3 * t + k);
+                }
+            }
+            references_.push_back(t);
+        }
+    }
+    if (record_) {
+        Collapse& record = collapses_.back();
+        record.corner_count =
+            uint32_t(collapse_corners_.size()) - record.first_corner;
+        record.triangle_count =
+            uint32_t(collapse_triangles_.size()) - record.first_triangle;
+    }
+    ref_begin_[a] = begin;
+    ref_count_[a] = uint32_t(references_.size()) - begin;
+    ref_count_[b] = 0;
+
+    if (!partners_.empty()) {
+        partners_[a].insert(
+            partners_[a].end(), partners_[b].begin(), partners_[b].end());
+        partners_[b] = {};
+    }
+
+    ++stats_.collapses;
+    if (references_.size() > 6 * alive_faces_ + (size_t(1) << 16)) {
+        compact_references();
+    }
+    push_pairs(a);
+}
+
+void QemSimplifier::push_pairs(uint32_t v)
+{
+    mark_epoch_ += 2;
+    const uint32_t seen = mark_epoch_;
+    marks_[v] = seen;
+    auto push = [&](uint32_t u) {
+        if (marks_[u] == seen || !vertex_alive_[u] ||
+            (locked_[u] && locked_[v])) {
+            return;
+        }
+        marks_[u] = seen;
+        heap_.push(evaluate(v, u));
+    };
+
+    const uint32_t* refs = references_.data() + ref_begin_[v];
+    for (uint32_t i = 0; i < ref_count_[v]; ++i) {
+        if (!triangle_alive_[refs[i]]) {
+            continue;
+        }
+        for (uint32_t u : triangles_[refs[i]]) {
+            push(u);
+        }
+    }
+    if (!partners_.empty()) {
+        // Partners that were collapsed away are dropped; the collapse moved
+        // their own partner lists to the survivor.
+        auto& partners = partners_[v];
+        partners.erase(
+            std::remove_if(
+                partners.begin(),
+                partners.end(),
+                [&](uint32_t u) { return !vertex_alive_[u] || u == v; }),
+            partners.end());
+        for (uint32_t u : partners) {
+            push(u);
+        }
+    }
+}
+
+void QemSimplifier::compact_references()
+{
+    std::vector<uint32_t> compacted;
+    compacted.reserve(3 * alive_faces_);
+    for (size_t v = 0; v < ref_begin_.size(); ++v) {
+        const uint32_t begin = uint32_t(compacted.size());
+        for (uint32_t i = 0; i < ref_count_[v]; ++i) {
+            const uint32_t t = references_[ref_begin_[v] + i];
+            if (triangle_alive_[t]) {
+                compacted.push_back(t);
+            }
+        }
+        ref_begin_[v] = begin;
+        ref_count_[v] = uint32_t(compacted.size()) - begin;
+    }
+    references_ = std::move(compacted);
+}
+
+void QemSimplifier::simplify(size_t target_faces)
+{
+    const auto start = Clock::now();
+    // Once the heap has doubled since the last sweep, most of it is stale
+    // entries that only deepen it.
+    size_t sweep_at = 2 * heap_.size() + (size_t(1) << 16);
+    while (alive_faces_ > target_faces && !heap_.empty()) {
+        if (heap_.size() > sweep_at) {
+            heap_.filter([this](const Candidate& c) { return is_current(c); });
+            sweep_at = 2 * heap_.size() + (size_t(1) << 16);
+        }
+        const Candidate c = heap_.pop();
+        if (!is_current(c) || (locked_[c.a] && locked_[c.b])) {
+            continue;
+        }
+        Quadric q = quadrics_[c.a];
+        q += quadrics_[c.b];
+        const pxr::GfVec3d p = target_position(q, c.a, c.b);
+        if (!link_condition(c.a, c.b) || flips(c.a, c.b, p)) {
+            continue;
+        }
+        collapse(c.a, c.b, p);
+    }
+    stats_.output_faces = alive_faces_;
+    stats_.simplify_seconds += seconds_since(start);
+}
+
+void QemSimplifier::extract(
+    pxr::VtArray<pxr::GfVec3f>& positions,
+    pxr::VtArray<int>& face_vertex_counts,
+    pxr::VtArray<int>& face_vertex_indices) const
+{
+    std::vector<int> remap(positions_.size(), -1);
+    int vertex_count = 0;
+    face_vertex_indices.resize(3 * alive_faces_);
+    int* out = face_vertex_indices.data();
+    for (size_t t = 0; t < triangles_.size(); ++t) {
+        if (!triangle_alive_[t]) {
+            continue;
+        }
+        for (uint32_t v : triangles_[t]) {
+            if (remap[v] < 0) {
+                remap[v] = vertex_count++;
+            }
+            *out++ = remap[v];
+        }
+    }
+    face_vertex_counts.assign(alive_faces_, 3);
+
+    positions.resize(vertex_count);
+    pxr::GfVec3f* p = positions.data();
+    for (size_t v = 0; v < positions_.size(); ++v) {
+        if (remap[v] >= 0) {
+            p[remap[v]] = pxr::GfVec3f(positions_[v]);
+        }
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,1019 @@
+#include "GCore/algorithms/remeshing.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#include "GCore/algorithms/curvature.h"
+#include "GCore/algorithms/triangulate.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+constexpr uint32_t kInvalid = ~0u;
+// Every round applies at least the best candidate, so this only guards
+// against a bug turning into an endless loop.
+constexpr int kMaxRounds = 1 << 12;
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+uint32_t next(uint32_t h)
+{
+    return h % 3 == 2 ? h - 2 : h + 1;
+}
+
+uint32_t prev(uint32_t h)
+{
+    return h % 3 == 0 ? h + 2 : h - 1;
+}
+
+// A bijection on 32 bits, so that keys of different half-edges differ while
+// their order looks random.
+uint32_t scramble(uint32_t h)
+{
+    return (h + 1) * 0x9E3779B1u;
+}
+
+// Longest edges split first and shortest ones collapse first: in random
+// order a long edge can lose its reservation to ever more neighbors that
+// keep splitting around it. The ratio is bucketed by half octaves so that
+// edges of similar length still go in hash order; strictly ordered, a
+// smoothly varying length has few local maxima to apply per round.
+int priority(float ratio)
+{
+    return int(2.0f * std::log2(std::clamp(ratio, 1.0f, 1e6f)));
+}
+
+void claim(uint64_t& owner, uint64_t key)
+{
+    std::atomic_ref<uint64_t> ref(owner);
+    uint64_t current = ref.load(std::memory_order_relaxed);
+    while (current < key &&
+           !ref.compare_exchange_weak(
+               current, key, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+template<typename Fn>
+void IsotropicRemesher::for_each_outgoing(uint32_t v, Fn&& fn) const
+{
+    const uint32_t start = vertex_half_edge_[v];
+    if (start == kInvalid) {
+        return;
+    }
+    uint32_t h = start;
+    do {
+        fn(h);
+        h = twin_[prev(h)];
+    } while (h != kInvalid && h != start);
+}
+
+template<typename Fn>
+void IsotropicRemesher::for_each_neighbor(uint32_t v, Fn&& fn) const
+{
+    const uint32_t start = vertex_half_edge_[v];
+    if (start == kInvalid) {
+        return;
+    }
+    uint32_t h = start;
+    do {
+        fn(corner_vertex_[next(h)]);
+        const uint32_t incoming = prev(h);
+        h = twin_[incoming];
+        if (h == kInvalid) {
+            // The fan ends at the incoming boundary edge.
+            fn(corner_vertex_[incoming]);
+        }
+    } while (h != kInvalid && h != start);
+}
+
+template<typename Evaluate, typename Apply>
+size_t IsotropicRemesher::run_rounds(
+    Evaluate&& evaluate,
+    Apply&& apply,
+    size_t new_vertices,
+    size_t new_faces)
+{
+    // An edge is represented by its boundary half-edge or the lower of its
+    // two half-edges.
+    auto canonical = [&](uint32_t h) {
+        return twin_[h] != kInvalid && twin_[h] < h ? twin_[h] : h;
+    };
+
+    // The first round looks at every edge; later ones only at the losers
+    // and the edges around the vertices that changed.
+    std::vector<uint32_t> candidates;
+    candidates.reserve(corner_vertex_.size() / 2);
+    for (uint32_t h = 0; h < corner_vertex_.size(); ++h) {
+        if (corner_vertex_[h] != kInvalid && canonical(h) == h) {
+            candidates.push_back(h);
+        }
+    }
+    // Keys carry the round in their top bits, so that claims from earlier
+    // rounds never need clearing.
+    owner_.assign(positions_.size(), 0);
+
+    size_t total = 0;
+    std::vector<uint32_t> winners, touched;
+    std::vector<uint8_t> queued;
+    for (int round = 1; round <= kMaxRounds && !candidates.empty(); ++round) {
+        key_.assign(candidates.size(), 0);
+        pxr::WorkParallelForN(
+            candidates.size(),
+            [&](size_t first, size_t last) {
+                std::vector<uint32_t> claims;
+                for (size_t i = first; i < last; ++i) {
+                    const uint32_t h = candidates[i];
+                    if (corner_vertex_[h] == kInvalid) {
+                        continue;
+                    }
+                    claims.clear();
+                    const int priority = evaluate(h, claims);
+                    if (priority < 0) {
+                        continue;
+                    }
+                    key_[i] = uint64_t(round) << 48 |
+                              uint64_t(std::min(priority, 0xFFFF)) << 32 |
+                              scramble(h);
+                    for (uint32_t v : claims) {
+                        claim(owner_[v], key_[i]);
+                    }
+                }
+            },
+            kParallelGrain);
+
+        // The winners hold all of their claims, so they touch disjoint
+        // regions. Evaluating again gives the same claims: nothing has
+        // changed yet.
+        std::vector<uint8_t> won(candidates.size(), 0);
+        pxr::WorkParallelForN(
+            candidates.size(),
+            [&](size_t first, size_t last) {
+                std::vector<uint32_t> claims;
+                for (size_t i = first; i < last; ++i) {
+                    if (key_[i] == 0) {
+                        continue;
+                    }
+                    claims.clear();
+                    evaluate(candidates[i], claims);
+                    won[i] = std::all_of(
+                        claims.begin(), claims.end(), [&](uint32_t v) {
+                            return owner_[v] == key_[i];
+                        });
+                }
+            },
+            kParallelGrain);
+
+        winners.clear();
+        touched.clear();
+        size_t losers = 0;
+        std::vector<uint32_t> claims;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (won[i]) {
+                winners.push_back(candidates[i]);
+                claims.clear();
+                evaluate(candidates[i], claims);
+                touched.insert(touched.end(), claims.begin(), claims.end());
+            }
+            else if (key_[i] != 0) {
+                candidates[losers++] = candidates[i];
+            }
+        }
+        candidates.resize(losers);
+        if (winners.empty()) {
+            break;
+        }
+        ++stats_.rounds;
+
+        const size_t vertex_base = positions_.size();
+        const size_t face_base = corner_vertex_.size() / 3;
+        positions_.resize(vertex_base + new_vertices * winners.size());
+        sizing_.resize(positions_.size());
+        owner_.resize(positions_.size(), 0);
+        vertex_half_edge_.resize(positions_.size(), kInvalid);
+        valence_.resize(positions_.size(), 0);
+        boundary_.resize(positions_.size(), 0);
+        corner_vertex_.resize(
+            3 * (face_base + new_faces * winners.size()), kInvalid);
+        twin_.resize(corner_vertex_.size(), kInvalid);
+        pxr::WorkParallelForN(
+            winners.size(),
+            [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    apply(
+                        winners[i],
+                        uint32_t(vertex_base + new_vertices * i),
+                        uint32_t(face_base + new_faces * i));
+                }
+            },
+            kParallelGrain >> 4);
+        total += winners.size();
+
+        for (uint32_t v = uint32_t(vertex_base); v < positions_.size(); ++v) {
+            touched.push_back(v);
+        }
+        pxr::WorkParallelForN(
+            touched.size(),
+            [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    update_vertex(touched[i]);
+                }
+            },
+            kParallelGrain);
+        // Losers may have moved to the other half-edge of their edge or
+        // onto one already queued, and equal candidates would share a key.
+        queued.resize(corner_vertex_.size(), 0);
+        auto enqueue = [&](uint32_t h) {
+            h = canonical(h);
+            if (!queued[h]) {
+                queued[h] = 1;
+                candidates.push_back(h);
+            }
+        };
+        std::vector<uint32_t> lost;
+        lost.swap(candidates);
+        for (uint32_t h : lost) {
+            enqueue(h);
+        }
+        for (uint32_t v : touched) {
+            for_each_outgoing(v, [&](uint32_t h) {
+                enqueue(h);
+                enqueue(prev(h));
+            });
+        }
+        for (uint32_t h : candidates) {
+            queued[h] = 0;
+        }
+    }
+    return total;
+}
+
+bool IsotropicRemesher::remesh(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    const Options& options)
+{
+    const auto start = Clock::now();
+    options_ = options;
+    stats_ = {};
+    if (!(options_.target_length > 0.0f) ||
+        !build(positions, face_vertex_counts, face_vertex_indices)) {
+        return false;
+    }
+    stats_.input_faces = corner_vertex_.size() / 3;
+    set_sizing(positions, face_vertex_counts, face_vertex_indices);
+
+    for (int iteration = 0; iteration < options_.iterations; ++iteration) {
+        stats_.splits += split_edges();
+        stats_.collapses += collapse_edges();
+        stats_.flips += flip_edges();
+        relax();
+        collect_garbage();
+    }
+
+    stats_.output_faces = corner_vertex_.size() / 3;
+    stats_.seconds = seconds_since(start);
+    return true;
+}
+
+void IsotropicRemesher::extract(
+    pxr::VtArray<pxr::GfVec3f>& positions,
+    pxr::VtArray<int>& face_vertex_counts,
+    pxr::VtArray<int>& face_vertex_indices) const
+{
+    positions.assign(positions_.begin(), positions_.end());
+    face_vertex_counts.assign(corner_vertex_.size() / 3, 3);
+    face_vertex_indices.assign(corner_vertex_.begin(), corner_vertex_.end());
+}
+
+bool IsotropicRemesher::build(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices)
+{
+    const size_t n = positions.size();
+    std::vector<std::array<uint32_t, 3>> triangles;
+    if (!fan_triangulate(
+            face_vertex_counts, face_vertex_indices, n, triangles)) {
+        return false;
+    }
+    const size_t fan_triangles = triangles.size();
+    triangles.erase(
+        std::remove_if(
+            triangles.begin(),
+            triangles.end(),
+            [](const std::array<uint32_t, 3>& t) {
+                return t[0] == t[1] || t[1] == t[2] || t[2] == t[0];
+            }),
+        triangles.end());
+
+    positions_.assign(positions.begin(), positions.end());
+    corner_vertex_.resize(3 * triangles.size());
+    for (size_t t = 0; t < triangles.size(); ++t) {
+        std::copy_n(triangles[t].data(), 3, corner_vertex_.data() + 3 * t);
+    }
+
+    // Twins by sorting the half-edges on their undirected edge. An edge is
+    // fine with one half-edge (boundary) or two running opposite ways.
+    const size_t half_edges = corner_vertex_.size();
+    std::vector<std::pair<uint64_t, uint32_t>> edges(half_edges);
+    pxr::WorkParallelForN(
+        half_edges,
+        [&](size_t first, size_t last) {
+            for (uint32_t h = uint32_t(first); h < last; ++h) {
+                const uint32_t a = corner_vertex_[h];
+                const uint32_t b = corner_vertex_[next(h)];
+                edges[h] = { uint64_t(std::min(a, b)) << 32 | std::max(a, b),
+                             h };
+            }
+        },
+        kParallelGrain);
+    std::sort(edges.begin(), edges.end());
+    twin_.assign(half_edges, kInvalid);
+    for (size_t i = 0; i < half_edges;) {
+        size_t j = i + 1;
+        while (j < half_edges && edges[j].first == edges[i].first) {
+            ++j;
+        }
+        if (j - i > 2) {
+            return false;
+        }
+        if (j - i == 2) {
+            const uint32_t h = edges[i].second, g = edges[i + 1].second;
+            if (corner_vertex_[h] == corner_vertex_[g]) {
+                return false;
+            }
+            twin_[h] = g;
+            twin_[g] = h;
+        }
+        i = j;
+    }
+
+    // A vertex whose corners do not form a single fan is non-manifold.
+    update_vertices();
+    std::vector<uint32_t> corners(n, 0);
+    for (uint32_t v : corner_vertex_) {
+        ++corners[v];
+    }
+    std::atomic<bool> manifold(true);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (uint32_t v = uint32_t(first); v < last; ++v) {
+                uint32_t fan = 0;
+                for_each_outgoing(v, [&](uint32_t) { ++fan; });
+                if (fan != corners[v]) {
+                    manifold = false;
+                }
+            }
+        },
+        kParallelGrain);
+    if (!manifold) {
+        return false;
+    }
+
+    reference_ = options_.reference;
+    if (!reference_ || reference_->triangle_count() != fan_triangles) {
+        auto reference = std::make_shared<TriangleBVH>();
+        reference->build(positions, face_vertex_counts, face_vertex_indices);
+        reference_ = std::move(reference);
+    }
+    return true;
+}
+
+void IsotropicRemesher::set_sizing(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices)
+{
+    const size_t n = positions.size();
+    const float target = options_.target_length;
+    reference_sizing_.assign(n, target);
+    if (options_.adaptive_tolerance > 0.0f) {
+        pxr::VtArray<float> curvature = options_.curvature;
+        if (curvature.size() != n) {
+            // Largest principal curvature magnitude, |H| + sqrt(H^2 - K).
+            CurvatureKernel kernel;
+            CurvatureField field;
+            kernel.set_topology(face_vertex_counts, face_vertex_indices, n);
+            kernel.compute(positions, field);
+            curvature.resize(n);
+            for (size_t v = 0; v < n; ++v) {
+                const float h = field.mean[v], k = field.gaussian[v];
+                curvature[v] =
+                    std::abs(h) + std::sqrt(std::max(h * h - k, 0.0f));
+            }
+        }
+
+        // A chord of length L on a circle of radius 1 / k deviates from it
+        // by about k L^2 / 8; Dunyach et al. use the exact
+        // sqrt(6 e / k - 3 e^2).
+        const float e = options_.adaptive_tolerance * target;
+        pxr::WorkParallelForN(
+            n,
+            [&](size_t first, size_t last) {
+                for (size_t v = first; v < last; ++v) {
+                    const float k = std::abs(curvature[v]);
+                    const float length =
+                        k > 0.0f
+                            ? std::sqrt(std::max(6.0f * e / k - 3 * e * e, 0.f))
+                            : target;
+                    reference_sizing_[v] =
+                        std::clamp(length, 0.1f * target, target);
+                }
+            },
+            kParallelGrain);
+    }
+    sizing_ = reference_sizing_;
+}
+
+void IsotropicRemesher::update_vertices()
+{
+    const size_t n = positions_.size();
+    const size_t half_edges = corner_vertex_.size();
+    vertex_half_edge_.assign(n, kInvalid);
+    valence_.assign(n, 0);
+    boundary_.assign(n, 0);
+
+    // Any outgoing half-edge first, then the boundary ones on top. A vertex
+    // has as many neighbors as outgoing half-edges, plus one on the
+    // boundary for the incoming boundary edge.
+    pxr::WorkParallelForN(
+        half_edges,
+        [&](size_t first, size_t last) {
+            for (uint32_t h = uint32_t(first); h < last; ++h) {
+                const uint32_t v = corner_vertex_[h];
+                if (v == kInvalid) {
+                    continue;
+                }
+                std::atomic_ref<uint32_t>(vertex_half_edge_[v])
+                    .store(h, std::memory_order_relaxed);
+                std::atomic_ref<uint32_t>(valence_[v])
+                    .fetch_add(1, std::memory_order_relaxed);
+                if (twin_[h] == kInvalid) {
+                    const uint32_t u = corner_vertex_[next(h)];
+                    std::atomic_ref<uint32_t>(valence_[u])
+                        .fetch_add(1, std::memory_order_relaxed);
+                    std::atomic_ref<uint8_t>(boundary_[v])
+                        .store(1, std::memory_order_relaxed);
+                    std::atomic_ref<uint8_t>(boundary_[u])
+                        .store(1, std::memory_order_relaxed);
+                }
+            }
+        },
+        kParallelGrain);
+    pxr::WorkParallelForN(
+        half_edges,
+        [&](size_t first, size_t last) {
+            for (uint32_t h = uint32_t(first); h < last; ++h) {
+                if (corner_vertex_[h] != kInvalid && twin_[h] == kInvalid) {
+                    std::atomic_ref<uint32_t>(
+                        vertex_half_edge_[corner_vertex_[h]])
+                        .store(h, std::memory_order_relaxed);
+                }
+            }
+        },
+        kParallelGrain);
+}
+
+void IsotropicRemesher::update_vertex(uint32_t v)
+{
+    uint32_t h = vertex_half_edge_[v];
+    valence_[v] = 0;
+    boundary_[v] = 0;
+    if (h == kInvalid) {
+        return;
+    }
+    // Turn back until the outgoing boundary half-edge, if there is one.
+    const uint32_t start = h;
+    while (twin_[h] != kInvalid) {
+        h = next(twin_[h]);
+        if (h == start) {
+            break;
+        }
+    }
+    vertex_half_edge_[v] = h;
+    boundary_[v] = twin_[h] == kInvalid;
+    uint32_t valence = boundary_[v];
+    for_each_outgoing(v, [&](uint32_t) { ++valence; });
+    valence_[v] = valence;
+}
+
+float IsotropicRemesher::edge_target(uint32_t a, uint32_t b) const
+{
+    return std::min(sizing_[a], sizing_[b]);
+}
+
+size_t IsotropicRemesher::split_edges()
+{
+    auto evaluate = [&](uint32_t h, std::vector<uint32_t>& claims) {
+        const uint32_t a = corner_vertex_[h];
+        const uint32_t b = corner_vertex_[next(h)];
+        const float high = 4.0f / 3.0f * edge_target(a, b);
+        const float length = (positions_[b] - positions_[a]).GetLength();
+        if (length <= high) {
+            return -1;
+        }
+        claims = { a, b, corner_vertex_[prev(h)] };
+        if (twin_[h] != kInvalid) {
+            claims.push_back(corner_vertex_[prev(twin_[h])]);
+        }
+        return priority(length / high);
+    };
+
+    // Triangle (a, b, c) becomes (a, m, c) and (m, b, c); its neighbor
+    // (b, a, d) becomes (m, a, d) and (m, d, b). The half-edges a -> m,
+    // c -> a and a -> d keep their slots.
+    auto apply = [&](uint32_t h, uint32_t m, uint32_t t2) {
+        const uint32_t hn = next(h);
+        const uint32_t a = corner_vertex_[h], b = corner_vertex_[hn];
+        const uint32_t c = corner_vertex_[prev(h)];
+        positions_[m] = 0.5f * (positions_[a] + positions_[b]);
+        sizing_[m] = 0.5f * (sizing_[a] + sizing_[b]);
+
+        const uint32_t x = twin_[hn];
+        const uint32_t e0 = 3 * t2, e1 = e0 + 1, e2 = e0 + 2;
+        vertex_half_edge_[m] = e0;
+        vertex_half_edge_[b] = e1;
+        corner_vertex_[hn] = m;
+        corner_vertex_[e0] = m;
+        corner_vertex_[e1] = b;
+        corner_vertex_[e2] = c;
+        twin_[hn] = e2;
+        twin_[e2] = hn;
+        twin_[e1] = x;
+        if (x != kInvalid) {
+            twin_[x] = e1;
+        }
+
+        const uint32_t g = twin_[h];
+        if (g == kInvalid) {
+            twin_[e0] = kInvalid;
+            return;
+        }
+        const uint32_t gp = prev(g);
+        const uint32_t d = corner_vertex_[gp];
+        const uint32_t y = twin_[gp];
+        const uint32_t f0 = 3 * (t2 + 1), f1 = f0 + 1, f2 = f0 + 2;
+        corner_vertex_[g] = m;
+        corner_vertex_[f0] = m;
+        corner_vertex_[f1] = d;
+        corner_vertex_[f2] = b;
+        twin_[f0] = gp;
+        twin_[gp] = f0;
+        twin_[f1] = y;
+        if (y != kInvalid) {
+            twin_[y] = f1;
+        }
+        twin_[f2] = e0;
+        twin_[e0] = f2;
+    };
+
+    // A boundary split leaves its second new triangle unused; it stays
+    // flagged as removed until the garbage collection.
+    return run_rounds(evaluate, apply, 1, 2);
+}
+
+bool IsotropicRemesher::plan_collapse(
+    uint32_t h,
+    CollapsePlan& plan,
+    std::vector<uint32_t>& claims) const
+{
+    uint32_t a = corner_vertex_[h], b = corner_vertex_[next(h)];
+    const float low = 4.0f / 5.0f * edge_target(a, b);
+    if ((positions_[b] - positions_[a]).GetLengthSq() >= low * low) {
+        return false;
+    }
+
+    // Boundary vertices stay where they are: an edge with one of them
+    // collapses into it, and one between two of them only along the
+    // boundary, into the endpoint where the boundary turns more so that
+    // corners survive.
+    if (boundary_[a] && boundary_[b]) {
+        if (twin_[h] != kInvalid) {
+            return false;
+        }
+        // The fan of a ends at the incoming boundary edge, the one of b
+        // starts at the outgoing one.
+        uint32_t last = h;
+        for_each_outgoing(a, [&](uint32_t e) { last = e; });
+        const pxr::GfVec3f& before = positions_[corner_vertex_[prev(last)]];
+        const pxr::GfVec3f& after =
+            positions_[corner_vertex_[next(vertex_half_edge_[b])]];
+        const pxr::GfVec3f edge = positions_[b] - positions_[a];
+        const float straight_a = pxr::GfDot(
+            (positions_[a] - before).GetNormalized(), edge.GetNormalized());
+        const float straight_b = pxr::GfDot(
+            edge.GetNormalized(), (after - positions_[b]).GetNormalized());
+        plan.position =
+            straight_a >= straight_b ? positions_[b] : positions_[a];
+    }
+    else if (boundary_[a]) {
+        h = twin_[h];
+        std::swap(a, b);
+        plan.position = positions_[b];
+    }
+    else if (boundary_[b]) {
+        plan.position = positions_[b];
+    }
+    else {
+        plan.position = 0.5f * (positions_[a] + positions_[b]);
+    }
+    plan.half_edge = h;
+    if (twin_[prev(h)] == kInvalid) {
+        // A boundary ear; its tip would be left without a triangle.
+        return false;
+    }
+
+    claims.clear();
+    claims.push_back(a);
+    claims.push_back(b);
+    for_each_neighbor(a, [&](uint32_t v) { claims.push_back(v); });
+    const size_t ring_b = claims.size();
+    for_each_neighbor(b, [&](uint32_t v) { claims.push_back(v); });
+
+    // Link condition: a and b share exactly the neighbors opposite their
+    // edge, and these keep at least a triangle's worth of neighbors.
+    const uint32_t g = twin_[h];
+    const uint32_t c = corner_vertex_[prev(h)];
+    const uint32_t d = g == kInvalid ? kInvalid : corner_vertex_[prev(g)];
+    size_t shared = 0;
+    for (size_t i = 2; i < ring_b; ++i) {
+        if (std::find(claims.begin() + ring_b, claims.end(), claims[i]) !=
+            claims.end()) {
+            if (claims[i] != c && claims[i] != d) {
+                return false;
+            }
+            ++shared;
+        }
+    }
+    if (shared != (d == kInvalid ? 1u : 2u)) {
+        return false;
+    }
+    for (uint32_t v : { c, d }) {
+        if (v != kInvalid && valence_[v] <= (boundary_[v] ? 2u : 3u)) {
+            return false;
+        }
+    }
+
+    // No new edge may be long enough to be split again.
+    for (size_t i = 2; i < claims.size(); ++i) {
+        const uint32_t v = claims[i];
+        if (v == a || v == b) {
+            continue;
+        }
+        const float high = 4.0f / 3.0f * edge_target(v, b);
+        if ((positions_[v] - plan.position).GetLengthSq() >= high * high) {
+            return false;
+        }
+    }
+
+    // No remaining triangle around a or b may turn over.
+    bool flips = false;
+    auto check_fan = [&](uint32_t v, uint32_t other) {
+        const pxr::GfVec3f& p = positions_[v];
+        for_each_outgoing(v, [&](uint32_t e) {
+            const uint32_t u = corner_vertex_[next(e)];
+            const uint32_t w = corner_vertex_[prev(e)];
+            if (u == other || w == other) {
+                return;
+            }
+            const pxr::GfVec3f& pu = positions_[u];
+            const pxr::GfVec3f& pw = positions_[w];
+            const pxr::GfVec3f before = pxr::GfCross(pu - p, pw - p);
+            const pxr::GfVec3f after =
+                pxr::GfCross(pu - plan.position, pw - plan.position);
+            if (pxr::GfDot(before, after) <= 0.0f) {
+                flips = true;
+            }
+        });
+    };
+    check_fan(a, b);
+    if (plan.position != positions_[b]) {
+        check_fan(b, a);
+    }
+    return !flips;
+}
+
+size_t IsotropicRemesher::collapse_edges()
+{
+    auto evaluate = [&](uint32_t h, std::vector<uint32_t>& claims) {
+        CollapsePlan plan;
+        if (!plan_collapse(h, plan, claims)) {
+            return -1;
+        }
+        const uint32_t a = corner_vertex_[h], b = corner_vertex_[next(h)];
+        const float length = (positions_[b] - positions_[a]).GetLength();
+        return priority(edge_target(a, b) / std::max(length, 1e-30f));
+    };
+
+    // a merges into b. Around the removed triangles (a, b, c) and
+    // (b, a, d), the half-edges across c-a and c-b, and across a-d and
+    // d-b, become twins.
+    auto apply = [&](uint32_t h, uint32_t, uint32_t) {
+        thread_local std::vector<uint32_t> scratch;
+        CollapsePlan plan;
+        plan_collapse(h, plan, scratch);
+        const uint32_t e = plan.half_edge;
+        const uint32_t a = corner_vertex_[e], b = corner_vertex_[next(e)];
+
+        scratch.clear();
+        for_each_outgoing(a, [&](uint32_t o) { scratch.push_back(o); });
+
+        auto relink = [&](uint32_t x, uint32_t y) {
+            if (x != kInvalid) {
+                twin_[x] = y;
+            }
+            if (y != kInvalid) {
+                twin_[y] = x;
+            }
+        };
+        auto remove = [&](uint32_t t) {
+            for (uint32_t k = 0; k < 3; ++k) {
+                corner_vertex_[3 * t + k] = kInvalid;
+                twin_[3 * t + k] = kInvalid;
+            }
+        };
+        // The half-edges across c-a and a-d survive the collapse, as b-c and
+        // d-b.
+        const uint32_t g = twin_[e];
+        const uint32_t across_ca = twin_[prev(e)];
+        vertex_half_edge_[a] = kInvalid;
+        vertex_half_edge_[b] = across_ca;
+        vertex_half_edge_[corner_vertex_[prev(e)]] = next(across_ca);
+        if (g != kInvalid) {
+            vertex_half_edge_[corner_vertex_[prev(g)]] = twin_[next(g)];
+        }
+        relink(twin_[next(e)], across_ca);
+        if (g != kInvalid) {
+            relink(twin_[next(g)], twin_[prev(g)]);
+        }
+        for (uint32_t o : scratch) {
+            corner_vertex_[o] = b;
+        }
+        remove(e / 3);
+        if (g != kInvalid) {
+            remove(g / 3);
+        }
+        positions_[b] = plan.position;
+    };
+
+    return run_rounds(evaluate, apply, 0, 0);
+}
+
+int IsotropicRemesher::flip_gain(uint32_t h) const
+{
+    const uint32_t g = twin_[h];
+    if (g == kInvalid) {
+        return -1;
+    }
+    const uint32_t a = corner_vertex_[h], b = corner_vertex_[next(h)];
+    const uint32_t c = corner_vertex_[prev(h)], d = corner_vertex_[prev(g)];
+    if (c == d || valence_[a] <= (boundary_[a] ? 2u : 3u) ||
+        valence_[b] <= (boundary_[b] ? 2u : 3u)) {
+        return -1;
+    }
+
+    auto deviation = [&](uint32_t v, int change) {
+        const int off = int(valence_[v]) + change - (boundary_[v] ? 4 : 6);
+        return off * off;
+    };
+    const int gain = deviation(a, 0) + deviation(b, 0) + deviation(c, 0) +
+                     deviation(d, 0) - deviation(a, -1) - deviation(b, -1) -
+                     deviation(c, 1) - deviation(d, 1);
+    if (gain <= 0) {
+        return -1;
+    }
+
+    bool connected = false;
+    for_each_neighbor(c, [&](uint32_t v) { connected |= v == d; });
+    if (connected) {
+        return -1;
+    }
+
+    // Both new triangles must face the way the old pair did.
+    const pxr::GfVec3f &pa = positions_[a], &pb = positions_[b];
+    const pxr::GfVec3f &pc = positions_[c], &pd = positions_[d];
+    const pxr::GfVec3f normal =
+        pxr::GfCross(pb - pa, pc - pa) + pxr::GfCross(pa - pb, pd - pb);
+    if (pxr::GfDot(pxr::GfCross(pa - pc, pd - pc), normal) <= 0.0f ||
+        pxr::GfDot(pxr::GfCross(pb - pd, pc - pd), normal) <= 0.0f) {
+        return -1;
+    }
+    return gain;
+}
+
+size_t IsotropicRemesher::flip_edges()
+{
+    auto evaluate = [&](uint32_t h, std::vector<uint32_t>& claims) {
+        const int gain = flip_gain(h);
+        if (gain > 0) {
+            const uint32_t g = twin_[h];
+            claims = { corner_vertex_[h],
+                       corner_vertex_[g],
+                       corner_vertex_[prev(h)],
+                       corner_vertex_[prev(g)] };
+        }
+        return gain;
+    };
+
+    // (a, b, c) and (b, a, d) become (d, c, a) and (c, d, b) in the same
+    // slots; the four outer half-edges move with their new triangles.
+    auto apply = [&](uint32_t h, uint32_t, uint32_t) {
+        const uint32_t hn = next(h), hp = prev(h);
+        const uint32_t g = twin_[h], gn = next(g), gp = prev(g);
+        const uint32_t a = corner_vertex_[h], b = corner_vertex_[hn];
+        const uint32_t c = corner_vertex_[hp], d = corner_vertex_[gp];
+        const uint32_t across_bc = twin_[hn], across_ca = twin_[hp];
+        const uint32_t across_ad = twin_[gn], across_db = twin_[gp];
+
+        vertex_half_edge_[a] = hp;
+        vertex_half_edge_[b] = gp;
+        vertex_half_edge_[c] = hn;
+        vertex_half_edge_[d] = gn;
+        corner_vertex_[h] = d;
+        corner_vertex_[hn] = c;
+        corner_vertex_[hp] = a;
+        corner_vertex_[g] = c;
+        corner_vertex_[gn] = d;
+        corner_vertex_[gp] = b;
+
+        auto link = [&](uint32_t x, uint32_t y) {
+            twin_[x] = y;
+            if (y != kInvalid) {
+                twin_[y] = x;
+            }
+        };
+        link(h, g);
+        link(hn, across_ca);
+        link(hp, across_ad);
+        link(gn, across_db);
+        link(gp, across_bc);
+    };
+
+    return run_rounds(evaluate, apply, 0, 0);
+}
+
+void IsotropicRemesher::relax()
+{
+    const size_t n = positions_.size();
+
+    // A third of the area around each vertex weighs it in the centroids of
+    // its neighbors.
+    std::vector<float> area(n, 0.0f);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (uint32_t v = uint32_t(first); v < last; ++v) {
+                const pxr::GfVec3f& p = positions_[v];
+                float sum = 0.0f;
+                for_each_outgoing(v, [&](uint32_t h) {
+                    sum += pxr::GfCross(
+                               positions_[corner_vertex_[next(h)]] - p,
+                               positions_[corner_vertex_[prev(h)]] - p)
+                               .GetLength();
+                });
+                area[v] = sum / 6.0f;
+            }
+        },
+        kParallelGrain);
+
+    std::vector<uint32_t> movable;
+    movable.reserve(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        if (vertex_half_edge_[v] != kInvalid && !boundary_[v]) {
+            movable.push_back(v);
+        }
+    }
+
+    std::vector<pxr::GfVec3f> moved(movable.size());
+    const float lambda = options_.relaxation;
+    pxr::WorkParallelForN(
+        movable.size(),
+        [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                const uint32_t v = movable[i];
+                const pxr::GfVec3f& p = positions_[v];
+                pxr::GfVec3f normal(0.0f);
+                for_each_outgoing(v, [&](uint32_t h) {
+                    normal += pxr::GfCross(
+                        positions_[corner_vertex_[next(h)]] - p,
+                        positions_[corner_vertex_[prev(h)]] - p);
+                });
+                pxr::GfVec3f centroid(0.0f);
+                float weight = 0.0f;
+                for_each_neighbor(v, [&](uint32_t u) {
+                    centroid += area[u] * positions_[u];
+                    weight += area[u];
+                });
+                if (!(weight > 0.0f) || normal.Normalize() == 0.0f) {
+                    moved[i] = p;
+                    continue;
+                }
+                pxr::GfVec3f step = centroid / weight - p;
+                step -= pxr::GfDot(step, normal) * normal;
+                moved[i] = p + lambda * step;
+            }
+        },
+        kParallelGrain);
+
+    std::vector<TriangleBVH::ClosestHit> hits(movable.size());
+    reference_->closest_points(moved.data(), moved.size(), hits.data());
+    const bool adaptive = options_.adaptive_tolerance > 0.0f;
+    pxr::WorkParallelForN(
+        movable.size(),
+        [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                const uint32_t v = movable[i];
+                const auto& hit = hits[i];
+                if (!hit) {
+                    positions_[v] = moved[i];
+                    continue;
+                }
+                positions_[v] = hit.point;
+                if (adaptive) {
+                    const auto& t = reference_->triangle(hit.triangle);
+                    sizing_[v] = hit.barycentric[0] * reference_sizing_[t[0]] +
+                                 hit.barycentric[1] * reference_sizing_[t[1]] +
+                                 hit.barycentric[2] * reference_sizing_[t[2]];
+                }
+            }
+        },
+        kParallelGrain);
+}
+
+void IsotropicRemesher::collect_garbage()
+{
+    const size_t n = positions_.size();
+    const size_t faces = corner_vertex_.size() / 3;
+    std::vector<uint32_t> vertex_map(n, kInvalid);
+    uint32_t vertices = 0;
+    for (size_t v = 0; v < n; ++v) {
+        if (vertex_half_edge_[v] != kInvalid) {
+            vertex_map[v] = vertices++;
+        }
+    }
+    std::vector<uint32_t> face_map(faces, kInvalid);
+    uint32_t kept = 0;
+    for (size_t t = 0; t < faces; ++t) {
+        if (corner_vertex_[3 * t] != kInvalid) {
+            face_map[t] = kept++;
+        }
+    }
+
+    std::vector<pxr::GfVec3f> positions(vertices);
+    std::vector<float> sizing(vertices);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                if (vertex_map[v] != kInvalid) {
+                    positions[vertex_map[v]] = positions_[v];
+                    sizing[vertex_map[v]] = sizing_[v];
+                }
+            }
+        },
+        kParallelGrain);
+    std::vector<uint32_t> corner_vertex(3 * size_t(kept));
+    std::vector<uint32_t> twin(3 * size_t(kept));
+    pxr::WorkParallelForN(
+        faces,
+        [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; ++t) {
+                if (face_map[t] == kInvalid) {
+                    continue;
+                }
+                for (uint32_t k = 0; k < 3; ++k) {
+                    const uint32_t h = uint32_t(3 * t + k);
+                    const uint32_t to = 3 * face_map[t] + k;
+                    corner_vertex[to] = vertex_map[corner_vertex_[h]];
+                    twin[to] = twin_[h] == kInvalid
+                                   ? kInvalid
+                                   : 3 * face_map[twin_[h] / 3] + twin_[h] % 3;
+                }
+            }
+        },
+        kParallelGrain);
+
+    positions_ = std::move(positions);
+    sizing_ = std::move(sizing);
+    corner_vertex_ = std::move(corner_vertex);
+    twin_ = std::move(twin);
+    update_vertices();
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,329 @@
+#include "GCore/algorithms/shortest_path.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 12;
+
+}  // namespace
+
+bool MeshGraph::build(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices)
+{
+    clear();
+    const size_t n = positions.size();
+
+    // Every polygon edge counted at both ends, duplicates included.
+    std::vector<uint32_t> degree(n + 1, 0);
+    size_t corner = 0;
+    for (int count : face_vertex_counts) {
+        if (count < 0 || corner + count > face_vertex_indices.size()) {
+            return false;
+        }
+        const int* c = face_vertex_indices.cdata() + corner;
+        for (int k = 0; k < count; ++k) {
+            if (c[k] < 0 || size_t(c[k]) >= n) {
+                return false;
+            }
+        }
+        for (int k = 0; k < count && count > 1; ++k) {
+            ++degree[c[k]];
+            ++degree[c[(k + 1) % count]];
+        }
+        corner += count;
+    }
+
+    std::vector<uint32_t> begin(n + 1, 0);
+    for (size_t v = 0; v < n; ++v) {
+        begin[v + 1] = begin[v] + degree[v];
+    }
+    std::vector<uint32_t> scattered(begin[n]);
+    std::vector<uint32_t> cursor(begin.begin(), begin.end() - 1);
+    corner = 0;
+    for (int count : face_vertex_counts) {
+        const int* c = face_vertex_indices.cdata() + corner;
+        for (int k = 0; k < count && count > 1; ++k) {
+            const uint32_t a = c[k], b = c[(k + 1) % count];
+            scattered[cursor[a]++] = b;
+            scattered[cursor[b]++] = a;
+        }
+        corner += count;
+    }
+
+    // Interior edges were seen from both faces; sort and deduplicate each
+    // vertex's range, dropping self loops from degenerate faces.
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                uint32_t* b = scattered.data() + begin[v];
+                uint32_t* e = scattered.data() + begin[v + 1];
+                std::sort(b, e);
+                e = std::unique(b, e);
+                e = std::remove(b, e, uint32_t(v));
+                degree[v] = uint32_t(e - b);
+            }
+        },
+        kParallelGrain);
+
+    offsets_.resize(n + 1);
+    offsets_[0] = 0;
+    for (size_t v = 0; v < n; ++v) {
+        offsets_[v + 1] = offsets_[v] + degree[v];
+    }
+    neighbors_.resize(offsets_[n]);
+    pxr::WorkParallelForN(
+        n,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                std::copy_n(
+                    scattered.data() + begin[v],
+                    degree[v],
+                    neighbors_.data() + offsets_[v]);
+            }
+        },
+        kParallelGrain);
+
+    update_weights(positions);
+    return true;
+}
+
+void MeshGraph::update_weights(const pxr::VtArray<pxr::GfVec3f>& positions)
+{
+    positions_ = positions;
+    weights_.resize(neighbors_.size());
+    pxr::WorkParallelForN(
+        offsets_.empty() ? 0 : offsets_.size() - 1,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                for (uint32_t i = offsets_[v]; i < offsets_[v + 1]; ++i) {
+                    weights_[i] =
+                        (positions_[neighbors_[i]] - positions_[v]).GetLength();
+                }
+            }
+        },
+        kParallelGrain);
+}
+
+void MeshGraph::clear()
+{
+    offsets_.clear();
+    neighbors_.clear();
+    weights_.clear();
+    positions_ = {};
+}
+
+void ShortestPathSearch::begin_query(size_t vertex_count)
+{
+    for (Frontier* f : { &forward_, &backward_ }) {
+        if (f->distance.size() != vertex_count) {
+            f->distance.assign(vertex_count, kInfinity);
+            f->parent.assign(vertex_count, 0);
+            f->stamp.assign(vertex_count, 0);
+            f->settled.assign(vertex_count, 0);
+            epoch_ = 0;
+        }
+        f->heap.clear();
+    }
+    if (++epoch_ == 0) {
+        // Wrapped around: stamps from 2^32 queries ago would look current.
+        for (Frontier* f : { &forward_, &backward_ }) {
+            std::fill(f->stamp.begin(), f->stamp.end(), 0);
+            std::fill(f->settled.begin(), f->settled.end(), 0);
+        }
+        epoch_ = 1;
+    }
+}
+
+ShortestPathSearch::Result ShortestPathSearch::find(
+    const MeshGraph& graph,
+    uint32_t source,
+    uint32_t target,
+    Method method)
+{
+    const size_t n = graph.vertex_count();
+    if (source >= n || target >= n) {
+        return {};
+    }
+    if (source == target) {
+        return { { source }, 0.0f, 0 };
+    }
+
+    begin_query(n);
+    switch (method) {
+        case Method::Dijkstra:
+            return unidirectional(graph, source, target, false);
+        case Method::AStar: return unidirectional(graph, source, target, true);
+        case Method::Bidirectional:
+            return bidirectional(graph, source, target);
+    }
+    return {};
+}
+
+void ShortestPathSearch::distances(
+    const MeshGraph& graph,
+    const std::vector<uint32_t>& sources,
+    std::vector<float>& out)
+{
+    const auto& offsets = graph.offsets();
+    const auto& neighbors = graph.neighbors();
+    const auto& weights = graph.weights();
+    const size_t n = graph.vertex_count();
+
+    // Every vertex gets settled, so the output doubles as the distance array
+    // and a finished vertex is one whose heap key no longer matches.
+    out.assign(n, kInfinity);
+    auto& heap = forward_.heap;
+    heap.clear();
+    for (uint32_t s : sources) {
+        if (s < n && out[s] != 0.0f) {
+            out[s] = 0.0f;
+            heap.push({ 0.0f, s });
+        }
+    }
+    while (!heap.empty()) {
+        const Entry e = heap.pop();
+        if (e.key > out[e.vertex]) {
+            continue;
+        }
+        for (uint32_t i = offsets[e.vertex]; i < offsets[e.vertex + 1]; ++i) {
+            const uint32_t u = neighbors[i];
+            const float du = e.key + weights[i];
+            if (du < out[u]) {
+                out[u] = du;
+                heap.push({ du, u });
+            }
+        }
+    }
+}
+
+void ShortestPathSearch::trace(
+    const Frontier& frontier,
+    uint32_t from,
+    std::vector<uint32_t>& path)
+{
+    path.push_back(from);
+    while (frontier.parent[from] != from) {
+        from = frontier.parent[from];
+        path.push_back(from);
+    }
+}
+
+ShortestPathSearch::Result ShortestPathSearch::unidirectional(
+    const MeshGraph& graph,
+    uint32_t source,
+    uint32_t target,
+    bool guided)
+{
+    const auto& offsets = graph.offsets();
+    const auto& neighbors = graph.neighbors();
+    const auto& weights = graph.weights();
+    const pxr::GfVec3f goal = graph.positions()[target];
+    auto heuristic = [&](uint32_t v) {
+        return guided ? (graph.positions()[v] - goal).GetLength() : 0.0f;
+    };
+
+    Result result;
+    Frontier& f = forward_;
+    f.set(source, 0.0f, source, epoch_);
+    f.heap.push({ heuristic(source), source });
+    while (!f.heap.empty()) {
+        const uint32_t v = f.heap.pop().vertex;
+        if (f.settled[v] == epoch_) {
+            continue;
+        }
+        f.settled[v] = epoch_;
+        ++result.settled;
+        if (v == target) {
+            break;
+        }
+        const float dv = f.distance[v];
+        for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) {
+            const uint32_t u = neighbors[i];
+            const float du = dv + weights[i];
+            if (du < f.get(u, epoch_)) {
+                f.set(u, du, v, epoch_);
+                f.heap.push({ du + heuristic(u), u });
+            }
+        }
+    }
+
+    if (f.settled[target] != epoch_) {
+        return { {}, kInfinity, result.settled };
+    }
+    result.distance = f.distance[target];
+    trace(f, target, result.path);
+    std::reverse(result.path.begin(), result.path.end());
+    return result;
+}
+
+ShortestPathSearch::Result ShortestPathSearch::bidirectional(
+    const MeshGraph& graph,
+    uint32_t source,
+    uint32_t target)
+{
+    const auto& offsets = graph.offsets();
+    const auto& neighbors = graph.neighbors();
+    const auto& weights = graph.weights();
+
+    Result result;
+    float best = kInfinity;
+    uint32_t meeting = 0;
+    forward_.set(source, 0.0f, source, epoch_);
+    forward_.heap.push({ 0.0f, source });
+    backward_.set(target, 0.0f, target, epoch_);
+    backward_.heap.push({ 0.0f, target });
+
+    while (!forward_.heap.empty() && !backward_.heap.empty()) {
+        // No path through an unsettled vertex can beat the best meeting
+        // point once the two frontiers together are at least as far.
+        if (forward_.heap.top().key + backward_.heap.top().key >= best) {
+            break;
+        }
+        const bool forward =
+            forward_.heap.top().key <= backward_.heap.top().key;
+        Frontier& f = forward ? forward_ : backward_;
+        const Frontier& other = forward ? backward_ : forward_;
+
+        const uint32_t v = f.heap.pop().vertex;
+        if (f.settled[v] == epoch_) {
+            continue;
+        }
+        f.settled[v] = epoch_;
+        ++result.settled;
+        const float dv = f.distance[v];
+        for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) {
+            const uint32_t u = neighbors[i];
+            const float du = dv + weights[i];
+            if (du < f.get(u, epoch_)) {
+                f.set(u, du, v, epoch_);
+                f.heap.push({ du, u });
+            }
+            const float through = f.get(u, epoch_) + other.get(u, epoch_);
+            if (through < best) {
+                best = through;
+                meeting = u;
+            }
+        }
+    }
+
+    if (best == kInfinity) {
+        return { {}, kInfinity, result.settled };
+    }
+    result.distance = best;
+    trace(forward_, meeting, result.path);
+    std::reverse(result.path.begin(), result.path.end());
+    if (meeting != target) {
+        trace(backward_, backward_.parent[meeting], result.path);
+    }
+    return result;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,43 @@
+#include "GCore/algorithms/simd.h"
+
+#if USTC_CG_SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+static bool detect_avx2()
+{
+#if !USTC_CG_SIMD_X86
+    return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma) {
+        return false;
+    }
+    // The OS has to save the YMM registers on context switches.
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+bool cpu_has_avx2()
+{
+    static const bool has_avx2 = detect_avx2();
+    return has_avx2;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
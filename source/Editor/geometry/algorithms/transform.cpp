@@ -0,0 +1,239 @@
+#include "GCore/algorithms/transform.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <cmath>
+
+#include "GCore/algorithms/simd.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Below this many elements the kernels run on the calling thread.
+constexpr size_t kParallelGrain = 1 << 14;
+
+// Row-vector affine map: out = x * row[0] + y * row[1] + z * row[2] + row[3].
+struct Affine3x4 {
+    float row[4][3];
+};
+
+Affine3x4 affine_from_matrix(const pxr::GfMatrix4d& m)
+{
+    Affine3x4 a;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            a.row[i][j] = static_cast<float>(m[i][j]);
+        }
+    }
+    for (int j = 0; j < 3; ++j) {
+        a.row[3][j] = static_cast<float>(m[3][j]);
+    }
+    return a;
+}
+
+// Inverse transpose of the linear part up to a positive factor, which is all
+// normals need since they are renormalized anyway. Rows of the cofactor
+// matrix are r1 x r2, r2 x r0, r0 x r1; the sign of the determinant keeps
+// normals pointing outwards under mirroring.
+Affine3x4 normal_matrix(const pxr::GfMatrix4d& m)
+{
+    double r[3][3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            r[i][j] = m[i][j];
+        }
+    }
+    auto cross = [](const double* a, const double* b, float* out) {
+        out[0] = static_cast<float>(a[1] * b[2] - a[2] * b[1]);
+        out[1] = static_cast<float>(a[2] * b[0] - a[0] * b[2]);
+        out[2] = static_cast<float>(a[0] * b[1] - a[1] * b[0]);
+    };
+    Affine3x4 a;
+    cross(r[1], r[2], a.row[0]);
+    cross(r[2], r[0], a.row[1]);
+    cross(r[0], r[1], a.row[2]);
+    const double det = r[0][0] * a.row[0][0] + r[0][1] * a.row[0][1] +
+                       r[0][2] * a.row[0][2];
+    if (det < 0) {
+        for (auto& row : a.row) {
+            for (float& v : row) {
+                v = -v;
+            }
+        }
+    }
+    a.row[3][0] = a.row[3][1] = a.row[3][2] = 0.0f;
+    return a;
+}
+
+bool is_affine(const pxr::GfMatrix4d& m)
+{
+    return m[0][3] == 0.0 && m[1][3] == 0.0 && m[2][3] == 0.0 &&
+           m[3][3] == 1.0;
+}
+
+void affine_scalar(const Affine3x4& a, float* p, size_t count, bool normalize)
+{
+    for (size_t i = 0; i < count; ++i, p += 3) {
+        const float x = p[0], y = p[1], z = p[2];
+        float out[3];
+        for (int j = 0; j < 3; ++j) {
+            out[j] = x * a.row[0][j] + y * a.row[1][j] + z * a.row[2][j] +
+                     a.row[3][j];
+        }
+        if (normalize) {
+            const float len2 =
+                out[0] * out[0] + out[1] * out[1] + out[2] * out[2];
+            const float inv = len2 > 0.0f ? 1.0f / std::sqrt(len2) : 0.0f;
+            out[0] *= inv;
+            out[1] *= inv;
+            out[2] *= inv;
+        }
+        p[0] = out[0];
+        p[1] = out[1];
+        p[2] = out[2];
+    }
+}
+
+#if USTC_CG_SIMD_X86
+// Eight packed float3 (24 floats) are shuffled into x/y/z registers, mapped
+// with FMAs, and shuffled back. Each 128-bit lane carries four points, so the
+// shuffles never cross lanes.
+USTC_CG_TARGET_AVX2 void
+affine_avx2(const Affine3x4& a, float* p, size_t count, bool normalize)
+{
+    __m256 m[4][3];
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            m[i][j] = _mm256_set1_ps(a.row[i][j]);
+        }
+    }
+
+    const size_t blocks = count / 8;
+    for (size_t b = 0; b < blocks; ++b, p += 24) {
+        __m256 m03 = _mm256_castps128_ps256(_mm_loadu_ps(p + 0));
+        __m256 m14 = _mm256_castps128_ps256(_mm_loadu_ps(p + 4));
+        __m256 m25 = _mm256_castps128_ps256(_mm_loadu_ps(p + 8));
+        m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(p + 12), 1);
+        m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(p + 16), 1);
+        m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(p + 20), 1);
+
+        const __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+        const __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+        const __m256 x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+        const __m256 y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+        const __m256 z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+
+        __m256 out[3];
+        for (int j = 0; j < 3; ++j) {
+            out[j] = _mm256_fmadd_ps(
+                x,
+                m[0][j],
+                _mm256_fmadd_ps(
+                    y, m[1][j], _mm256_fmadd_ps(z, m[2][j], m[3][j])));
+        }
+
+        if (normalize) {
+            const __m256 len2 = _mm256_fmadd_ps(
+                out[0],
+                out[0],
+                _mm256_fmadd_ps(
+                    out[1], out[1], _mm256_mul_ps(out[2], out[2])));
+            const __m256 nonzero =
+                _mm256_cmp_ps(len2, _mm256_setzero_ps(), _CMP_GT_OQ);
+            const __m256 inv = _mm256_and_ps(
+                nonzero,
+                _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(len2)));
+            for (auto& o : out) {
+                o = _mm256_mul_ps(o, inv);
+            }
+        }
+
+        const __m256 rxy =
+            _mm256_shuffle_ps(out[0], out[1], _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 ryz =
+            _mm256_shuffle_ps(out[1], out[2], _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 rzx =
+            _mm256_shuffle_ps(out[2], out[0], _MM_SHUFFLE(3, 1, 2, 0));
+        const __m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+        const __m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+
+        _mm_storeu_ps(p + 0, _mm256_castps256_ps128(r03));
+        _mm_storeu_ps(p + 4, _mm256_castps256_ps128(r14));
+        _mm_storeu_ps(p + 8, _mm256_castps256_ps128(r25));
+        _mm_storeu_ps(p + 12, _mm256_extractf128_ps(r03, 1));
+        _mm_storeu_ps(p + 16, _mm256_extractf128_ps(r14, 1));
+        _mm_storeu_ps(p + 20, _mm256_extractf128_ps(r25, 1));
+    }
+
+    affine_scalar(a, p, count - blocks * 8, normalize);
+}
+#endif
+
+void affine_block(const Affine3x4& a, float* p, size_t count, bool normalize)
+{
+#if USTC_CG_SIMD_X86
+    if (cpu_has_avx2()) {
+        affine_avx2(a, p, count, normalize);
+        return;
+    }
+#endif
+    affine_scalar(a, p, count, normalize);
+}
+
+void affine_parallel(
+    const Affine3x4& a,
+    pxr::GfVec3f* data,
+    size_t count,
+    bool normalize)
+{
+    float* p = reinterpret_cast<float*>(data);
+    if (count < 2 * kParallelGrain) {
+        affine_block(a, p, count, normalize);
+        return;
+    }
+    pxr::WorkParallelForN(
+        count,
+        [&](size_t begin, size_t end) {
+            affine_block(a, p + 3 * begin, end - begin, normalize);
+        },
+        kParallelGrain);
+}
+
+}  // namespace
+
+void transform_points(
+    const pxr::GfMatrix4d& transform,
+    pxr::GfVec3f* points,
+    size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    if (!is_affine(transform)) {
+        pxr::WorkParallelForN(
+            count,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    points[i] = pxr::GfVec3f(transform.Transform(points[i]));
+                }
+            },
+            kParallelGrain);
+        return;
+    }
+    affine_parallel(affine_from_matrix(transform), points, count, false);
+}
+
+void transform_normals(
+    const pxr::GfMatrix4d& transform,
+    pxr::GfVec3f* normals,
+    size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    affine_parallel(normal_matrix(transform), normals, count, true);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
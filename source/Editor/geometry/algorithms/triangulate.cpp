@@ -0,0 +1,253 @@
+#include "GCore/algorithms/triangulate.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kParallelGrain = 1 << 14;
+
+}  // namespace
+
+bool fan_triangulate(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count,
+    std::vector<std::array<uint32_t, 3>>& triangles,
+    std::vector<uint32_t>* face_of_triangle)
+{
+    triangles.clear();
+    triangles.reserve(face_vertex_indices.size() / 3);
+    if (face_of_triangle) {
+        face_of_triangle->clear();
+        face_of_triangle->reserve(face_vertex_indices.size() / 3);
+    }
+    size_t corner = 0;
+    for (size_t f = 0; f < face_vertex_counts.size(); ++f) {
+        const int count = face_vertex_counts[f];
+        if (count < 0 || corner + count > face_vertex_indices.size()) {
+            return false;
+        }
+        const int* c = face_vertex_indices.cdata() + corner;
+        for (int k = 0; k < count; ++k) {
+            if (c[k] < 0 || size_t(c[k]) >= vertex_count) {
+                return false;
+            }
+        }
+        for (int k = 1; k + 1 < count; ++k) {
+            triangles.push_back(
+                { uint32_t(c[0]), uint32_t(c[k]), uint32_t(c[k + 1]) });
+            if (face_of_triangle) {
+                face_of_triangle->push_back(uint32_t(f));
+            }
+        }
+        corner += count;
+    }
+    return corner == face_vertex_indices.size();
+}
+
+bool boundary_vertices(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count,
+    std::vector<uint32_t>& boundary)
+{
+    boundary.clear();
+    std::vector<uint64_t> edges;
+    edges.reserve(face_vertex_indices.size());
+    size_t corner = 0;
+    for (int count : face_vertex_counts) {
+        if (count < 0 || corner + count > face_vertex_indices.size()) {
+            return false;
+        }
+        const int* c = face_vertex_indices.cdata() + corner;
+        for (int k = 0; k < count; ++k) {
+            const int a = c[k], b = c[(k + 1) % count];
+            if (a < 0 || b < 0 || size_t(a) >= vertex_count ||
+                size_t(b) >= vertex_count) {
+                return false;
+            }
+            edges.push_back(
+                uint64_t(std::min(a, b)) << 32 | uint32_t(std::max(a, b)));
+        }
+        corner += count;
+    }
+
+    std::sort(edges.begin(), edges.end());
+    std::vector<uint8_t> on_boundary(vertex_count, 0);
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j] == edges[i]) {
+            ++j;
+        }
+        if (j - i == 1) {
+            on_boundary[edges[i] >> 32] = 1;
+            on_boundary[edges[i] & 0xffffffffu] = 1;
+        }
+        i = j;
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        if (on_boundary[v]) {
+            boundary.push_back(uint32_t(v));
+        }
+    }
+    return true;
+}
+
+bool boundary_loops(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count,
+    std::vector<std::vector<uint32_t>>& loops)
+{
+    loops.clear();
+    struct Edge {
+        uint64_t key;
+        uint32_t from;
+        uint32_t to;
+    };
+    std::vector<Edge> edges;
+    edges.reserve(face_vertex_indices.size());
+    size_t corner = 0;
+    for (int count : face_vertex_counts) {
+        if (count < 0 || corner + count > face_vertex_indices.size()) {
+            return false;
+        }
+        const int* c = face_vertex_indices.cdata() + corner;
+        for (int k = 0; k < count; ++k) {
+            const int a = c[k], b = c[(k + 1) % count];
+            if (a < 0 || b < 0 || size_t(a) >= vertex_count ||
+                size_t(b) >= vertex_count) {
+                return false;
+            }
+            edges.push_back(
+                { uint64_t(std::min(a, b)) << 32 | uint32_t(std::max(a, b)),
+                  uint32_t(a),
+                  uint32_t(b) });
+        }
+        corner += count;
+    }
+
+    // Boundary half-edges, i.e. edges used once, sorted by their origin so
+    // the walk finds the edge leaving a vertex by binary search.
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+        return a.key < b.key;
+    });
+    std::vector<std::pair<uint32_t, uint32_t>> half_edges;
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j].key == edges[i].key) {
+            ++j;
+        }
+        if (j - i == 1 && edges[i].from != edges[i].to) {
+            half_edges.emplace_back(edges[i].from, edges[i].to);
+        }
+        i = j;
+    }
+    std::sort(half_edges.begin(), half_edges.end());
+    walk_boundary_loops(half_edges, loops);
+    return true;
+}
+
+void walk_boundary_loops(
+    const std::vector<std::pair<uint32_t, uint32_t>>& half_edges,
+    std::vector<std::vector<uint32_t>>& loops)
+{
+    loops.clear();
+    std::vector<uint8_t> used(half_edges.size(), 0);
+    for (size_t start = 0; start < half_edges.size(); ++start) {
+        if (used[start]) {
+            continue;
+        }
+        std::vector<uint32_t> loop;
+        size_t e = start;
+        while (true) {
+            used[e] = 1;
+            loop.push_back(half_edges[e].first);
+            const uint32_t next = half_edges[e].second;
+            if (next == half_edges[start].first) {
+                break;
+            }
+            auto it = std::lower_bound(
+                half_edges.begin(),
+                half_edges.end(),
+                std::make_pair(next, uint32_t(0)));
+            while (it != half_edges.end() && it->first == next &&
+                   used[it - half_edges.begin()]) {
+                ++it;
+            }
+            if (it == half_edges.end() || it->first != next) {
+                // Open chain on a non-manifold boundary; not a loop.
+                loop.clear();
+                break;
+            }
+            e = size_t(it - half_edges.begin());
+        }
+        if (!loop.empty()) {
+            loops.push_back(std::move(loop));
+        }
+    }
+    std::stable_sort(
+        loops.begin(),
+        loops.end(),
+        [](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+            return a.size() > b.size();
+        });
+}
+
+void VertexTriangles::build(
+    const std::vector<std::array<uint32_t, 3>>& triangles,
+    size_t vertex_count)
+{
+    // Counting sort with atomic counters, so both passes over the triangles
+    // run in parallel; the ranges are sorted afterwards to keep the order
+    // independent of the scheduling.
+    offsets.assign(vertex_count + 1, 0);
+    pxr::WorkParallelForN(
+        triangles.size(),
+        [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; ++t) {
+                for (uint32_t v : triangles[t]) {
+                    std::atomic_ref<uint32_t>(offsets[v + 1])
+                        .fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        },
+        kParallelGrain);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    corners.resize(offsets[vertex_count]);
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    pxr::WorkParallelForN(
+        triangles.size(),
+        [&](size_t first, size_t last) {
+            for (size_t t = first; t < last; ++t) {
+                for (uint32_t k = 0; k < 3; ++k) {
+                    const uint32_t slot =
+                        std::atomic_ref<uint32_t>(cursor[triangles[t][k]])
+                            .fetch_add(1, std::memory_order_relaxed);
+                    corners[slot] = uint32_t(3 * t + k);
+                }
+            }
+        },
+        kParallelGrain);
+    pxr::WorkParallelForN(
+        vertex_count,
+        [&](size_t first, size_t last) {
+            for (size_t v = first; v < last; ++v) {
+                std::sort(
+                    corners.begin() + offsets[v],
+                    corners.begin() + offsets[v + 1]);
+            }
+        },
+        kParallelGrain);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
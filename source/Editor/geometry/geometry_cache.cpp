@@ -0,0 +1,536 @@
+#include "GCore/geometry_cache.h"
+
+#include <pxr/base/gf/vec2f.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+
+#include "GCore/Components/CurveComponent.h"
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/Components/PointsComponent.h"
+#include "GCore/mapped_file.h"
+#include "Logger/Logger.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// File layout:
+//   Header                      64 bytes
+//   column data                 each chunk padded to start on 64 bytes
+//   ColumnEntry[column_count]   directory
+//   names                       concatenated column names
+constexpr char kMagic[8] = { 'U', 'S', 'T', 'C', 'G', 'E', 'O', '\0' };
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint64_t kAlignment = 64;
+
+enum class ColumnType : uint32_t { Int = 1, Float = 2, Vec2f = 3, Vec3f = 4 };
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t column_count;
+    uint64_t directory_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+    uint8_t reserved[16];
+};
+static_assert(sizeof(Header) == kAlignment);
+
+struct ColumnEntry {
+    uint64_t offset;
+    uint64_t count;
+    uint32_t type;
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t reserved;
+};
+static_assert(sizeof(ColumnEntry) == 32);
+
+template<typename T>
+constexpr ColumnType column_type();
+template<>
+constexpr ColumnType column_type<int>()
+{
+    return ColumnType::Int;
+}
+template<>
+constexpr ColumnType column_type<float>()
+{
+    return ColumnType::Float;
+}
+template<>
+constexpr ColumnType column_type<pxr::GfVec2f>()
+{
+    return ColumnType::Vec2f;
+}
+template<>
+constexpr ColumnType column_type<pxr::GfVec3f>()
+{
+    return ColumnType::Vec3f;
+}
+
+size_t element_size(ColumnType type)
+{
+    switch (type) {
+        case ColumnType::Int: return sizeof(int);
+        case ColumnType::Float: return sizeof(float);
+        case ColumnType::Vec2f: return sizeof(pxr::GfVec2f);
+        case ColumnType::Vec3f: return sizeof(pxr::GfVec3f);
+    }
+    return 0;
+}
+
+// Columns are gathered as type-erased byte ranges; `keep_alive` holds a
+// (copy-on-write) reference to the source array while the file is written.
+struct PendingColumn {
+    std::string name;
+    ColumnType type;
+    const void* data;
+    uint64_t count;
+    std::shared_ptr<const void> keep_alive;
+};
+
+class ColumnWriter {
+   public:
+    template<typename T>
+    void add(const std::string& name, const pxr::VtArray<T>& array)
+    {
+        if (array.empty()) {
+            return;
+        }
+        auto held = std::make_shared<const pxr::VtArray<T>>(array);
+        columns_.push_back(
+            { name, column_type<T>(), held->cdata(), held->size(), held });
+    }
+
+    // Adds every entry of a quantity map under "<prefix>/<name>".
+    template<typename T>
+    void add_quantities(
+        const std::string& prefix,
+        const std::vector<std::string>& names,
+        const std::function<pxr::VtArray<T>(const std::string&)>& get)
+    {
+        for (const auto& name : names) {
+            add(prefix + "/" + name, get(name));
+        }
+    }
+
+    bool write(const std::string& path) const;
+
+   private:
+    std::vector<PendingColumn> columns_;
+};
+
+bool ColumnWriter::write(const std::string& path) const
+{
+    // Arrays may still map the old file, and truncating it under them would
+    // fault on their next access. The new file is written next to it and
+    // renamed over it, which leaves existing mappings on the old contents on
+    // POSIX. Windows rejects the rename while the old file is mapped.
+    const std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        log::warning(
+            "Cannot open geometry cache %s for writing", temporary.c_str());
+        return false;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.byte_order = kByteOrderMark;
+    header.column_count = columns_.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<ColumnEntry> directory(columns_.size());
+    std::string names;
+    uint64_t position = sizeof(header);
+    static const char zeros[kAlignment] = {};
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        const PendingColumn& column = columns_[i];
+        const uint64_t padding = (kAlignment - position % kAlignment) %
+                                 kAlignment;
+        out.write(zeros, padding);
+        position += padding;
+
+        const uint64_t bytes = column.count * element_size(column.type);
+        out.write(static_cast<const char*>(column.data), bytes);
+
+        ColumnEntry& entry = directory[i];
+        entry.offset = position;
+        entry.count = column.count;
+        entry.type = static_cast<uint32_t>(column.type);
+        entry.name_offset = static_cast<uint32_t>(names.size());
+        entry.name_size = static_cast<uint32_t>(column.name.size());
+        names += column.name;
+        position += bytes;
+    }
+
+    const uint64_t padding = (kAlignment - position % kAlignment) % kAlignment;
+    out.write(zeros, padding);
+    position += padding;
+    header.directory_offset = position;
+    header.names_offset = position + directory.size() * sizeof(ColumnEntry);
+    header.names_size = names.size();
+    out.write(
+        reinterpret_cast<const char*>(directory.data()),
+        directory.size() * sizeof(ColumnEntry));
+    out.write(names.data(), names.size());
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.flush();
+    out.close();
+    std::error_code error;
+    if (!out) {
+        log::warning("Failed to write geometry cache %s", temporary.c_str());
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+#ifdef _WIN32
+        log::warning(
+            "Cannot replace geometry cache %s: %s (is it still mapped by "
+            "arrays read from it?)",
+            path.c_str(),
+            error.message().c_str());
+#else
+        log::warning(
+            "Cannot replace geometry cache %s: %s",
+            path.c_str(),
+            error.message().c_str());
+#endif
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+// Owner of the mapping on behalf of the VtArrays viewing one column. VtArray
+// counts references to it and calls `detached` once the last one is gone.
+struct MappedColumnSource : pxr::Vt_ArrayForeignDataSource {
+    explicit MappedColumnSource(std::shared_ptr<MappedFile> file)
+        : Vt_ArrayForeignDataSource(&MappedColumnSource::detached),
+          file(std::move(file))
+    {
+    }
+
+    static void detached(pxr::Vt_ArrayForeignDataSource* self)
+    {
+        delete static_cast<MappedColumnSource*>(self);
+    }
+
+    std::shared_ptr<MappedFile> file;
+};
+
+class ColumnReader {
+   public:
+    ColumnReader(
+        std::shared_ptr<MappedFile> file,
+        const std::vector<std::string>& requested)
+        : file_(std::move(file)),
+          requested_(requested)
+    {
+    }
+
+    // Validates the header and directory. Every column must lie inside the
+    // file and start on an aligned offset.
+    bool parse();
+
+    bool has_component(const std::string& component) const
+    {
+        const std::string prefix = component + "/";
+        for (const auto& entry : entries_) {
+            if (name_of(entry).compare(0, prefix.size(), prefix) == 0 &&
+                is_requested(name_of(entry))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Zero-copy view of the named column, or an empty array if it is absent,
+    // not requested, or of another type.
+    template<typename T>
+    pxr::VtArray<T> view(const std::string& name) const
+    {
+        for (const auto& entry : entries_) {
+            if (entry.type != static_cast<uint32_t>(column_type<T>()) ||
+                name_of(entry) != name || !is_requested(name)) {
+                continue;
+            }
+            T* data = reinterpret_cast<T*>(
+                const_cast<char*>(file_->data() + entry.offset));
+            return pxr::VtArray<T>(
+                new MappedColumnSource(file_), data, entry.count);
+        }
+        return {};
+    }
+
+    // Names of the quantities stored under "<prefix>/".
+    std::vector<std::string> names_under(const std::string& prefix) const
+    {
+        std::vector<std::string> names;
+        const std::string p = prefix + "/";
+        for (const auto& entry : entries_) {
+            const std::string name = name_of(entry);
+            if (name.compare(0, p.size(), p) == 0 && is_requested(name)) {
+                names.push_back(name.substr(p.size()));
+            }
+        }
+        return names;
+    }
+
+   private:
+    std::string name_of(const ColumnEntry& entry) const
+    {
+        return std::string(names_ + entry.name_offset, entry.name_size);
+    }
+
+    bool is_requested(const std::string& name) const
+    {
+        if (requested_.empty()) {
+            return true;
+        }
+        for (const auto& prefix : requested_) {
+            if (name.compare(0, prefix.size(), prefix) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::shared_ptr<MappedFile> file_;
+    const std::vector<std::string>& requested_;
+    std::vector<ColumnEntry> entries_;
+    const char* names_ = nullptr;
+};
+
+bool ColumnReader::parse()
+{
+    const size_t size = file_->size();
+    if (size < sizeof(Header)) {
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, file_->data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kFormatVersion ||
+        header.byte_order != kByteOrderMark) {
+        return false;
+    }
+    const uint64_t directory_bytes = header.column_count * sizeof(ColumnEntry);
+    if (header.column_count > size / sizeof(ColumnEntry) ||
+        header.directory_offset > size - directory_bytes ||
+        header.names_offset > size ||
+        header.names_size > size - header.names_offset) {
+        return false;
+    }
+    names_ = file_->data() + header.names_offset;
+
+    // The directory is tiny; copy it out instead of relying on its alignment.
+    entries_.resize(header.column_count);
+    std::memcpy(
+        entries_.data(),
+        file_->data() + header.directory_offset,
+        directory_bytes);
+    for (const auto& entry : entries_) {
+        const size_t elem = element_size(static_cast<ColumnType>(entry.type));
+        if (elem == 0 || entry.offset % kAlignment != 0 ||
+            entry.offset > size || entry.count > (size - entry.offset) / elem ||
+            uint64_t(entry.name_offset) + entry.name_size > header.names_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool write_geometry_cache(const Geometry& geometry, const std::string& path)
+{
+    ColumnWriter writer;
+
+    if (auto mesh = geometry.get_component<MeshComponent>()) {
+        writer.add("mesh/vertices", mesh->get_vertices());
+        writer.add("mesh/face_vertex_counts", mesh->get_face_vertex_counts());
+        writer.add("mesh/face_vertex_indices", mesh->get_face_vertex_indices());
+        writer.add("mesh/normals", mesh->get_normals());
+        writer.add("mesh/display_color", mesh->get_display_color());
+        writer.add("mesh/texcoords", mesh->get_texcoords_array());
+
+        const MeshComponent* m = mesh.get();
+        writer.add_quantities<float>(
+            "mesh/vertex_scalar",
+            m->get_vertex_scalar_quantity_names(),
+            [m](const std::string& n) {
+                return m->get_vertex_scalar_quantity(n);
+            });
+        writer.add_quantities<float>(
+            "mesh/face_scalar",
+            m->get_face_scalar_quantity_names(),
+            [m](const std::string& n) {
+                return m->get_face_scalar_quantity(n);
+            });
+        writer.add_quantities<pxr::GfVec3f>(
+            "mesh/vertex_color",
+            m->get_vertex_color_quantity_names(),
+            [m](const std::string& n) {
+                return m->get_vertex_color_quantity(n);
+            });
+        writer.add_quantities<pxr::GfVec3f>(
+            "mesh/face_color",
+            m->get_face_color_quantity_names(),
+            [m](const std::string& n) {
+                return m->get_face_color_quantity(n);
+            });
+        writer.add_quantities<pxr::GfVec3f>(
+            "mesh/vertex_vector",
+            m->get_vertex_vector_quantity_names(),
+            [m](const std::string& n) {
+                return m->get_vertex_vector_quantity(n);
+            });
+        writer.add_quantities<pxr::GfVec3f>(
+            "mesh/face_vector",
+            m->get_face_vector_quantity_names(),
+            [m](const std::string& n) {
+                return m->get_face_vector_quantity(n);
+            });
+        writer.add_quantities<pxr::GfVec2f>(
+            "mesh/face_corner_parameterization",
+            m->get_face_corner_parameterization_quantity_names(),
+            [m](const std::string& n) {
+                return m->get_face_corner_parameterization_quantity(n);
+            });
+        writer.add_quantities<pxr::GfVec2f>(
+            "mesh/vertex_parameterization",
+            m->get_vertex_parameterization_quantity_names(),
+            [m](const std::string& n) {
+                return m->get_vertex_parameterization_quantity(n);
+            });
+    }
+
+    if (auto points = geometry.get_component<PointsComponent>()) {
+        writer.add("points/vertices", points->get_vertices());
+        writer.add("points/display_color", points->get_display_color());
+        writer.add("points/width", points->get_width());
+    }
+
+    if (auto curve = geometry.get_component<CurveComponent>()) {
+        writer.add("curve/vertices", curve->get_vertices());
+        writer.add("curve/vert_count", curve->get_vert_count());
+        writer.add("curve/width", curve->get_width());
+        writer.add("curve/display_color", curve->get_display_color());
+        writer.add("curve/normals", curve->get_curve_normals());
+        writer.add(
+            "curve/periodic",
+            pxr::VtArray<int>(1, curve->get_periodic() ? 1 : 0));
+    }
+
+    return writer.write(path);
+}
+
+bool read_geometry_cache(
+    const std::string& path,
+    Geometry& geometry,
+    const std::vector<std::string>& columns)
+{
+    auto file = MappedFile::open(path);
+    if (!file) {
+        log::warning("Cannot map geometry cache %s", path.c_str());
+        return false;
+    }
+    ColumnReader reader(file, columns);
+    if (!reader.parse()) {
+        log::warning("Malformed geometry cache %s", path.c_str());
+        return false;
+    }
+
+    if (reader.has_component("mesh")) {
+        auto mesh = std::make_shared<MeshComponent>(&geometry);
+        mesh->set_vertices(reader.view<pxr::GfVec3f>("mesh/vertices"));
+        mesh->set_face_vertex_counts(
+            reader.view<int>("mesh/face_vertex_counts"));
+        mesh->set_face_vertex_indices(
+            reader.view<int>("mesh/face_vertex_indices"));
+        mesh->set_normals(reader.view<pxr::GfVec3f>("mesh/normals"));
+        mesh->set_display_color(
+            reader.view<pxr::GfVec3f>("mesh/display_color"));
+        mesh->set_texcoords_array(
+            reader.view<pxr::GfVec2f>("mesh/texcoords"));
+
+        auto load = [&](const std::string& prefix, auto add) {
+            for (const auto& name : reader.names_under(prefix)) {
+                add(name, prefix + "/" + name);
+            }
+        };
+        load("mesh/vertex_scalar", [&](auto& name, auto column) {
+            mesh->add_vertex_scalar_quantity(
+                name, reader.view<float>(column));
+        });
+        load("mesh/face_scalar", [&](auto& name, auto column) {
+            mesh->add_face_scalar_quantity(name, reader.view<float>(column));
+        });
+        load("mesh/vertex_color", [&](auto& name, auto column) {
+            mesh->add_vertex_color_quantity(
+                name, reader.view<pxr::GfVec3f>(column));
+        });
+        load("mesh/face_color", [&](auto& name, auto column) {
+            mesh->add_face_color_quantity(
+                name, reader.view<pxr::GfVec3f>(column));
+        });
+        load("mesh/vertex_vector", [&](auto& name, auto column) {
+            mesh->add_vertex_vector_quantity(
+                name, reader.view<pxr::GfVec3f>(column));
+        });
+        load("mesh/face_vector", [&](auto& name, auto column) {
+            mesh->add_face_vector_quantity(
+                name, reader.view<pxr::GfVec3f>(column));
+        });
+        load("mesh/face_corner_parameterization", [&](auto& name, auto column) {
+            mesh->add_face_corner_parameterization_quantity(
+                name, reader.view<pxr::GfVec2f>(column));
+        });
+        load("mesh/vertex_parameterization", [&](auto& name, auto column) {
+            mesh->add_vertex_parameterization_quantity(
+                name, reader.view<pxr::GfVec2f>(column));
+        });
+        geometry.attach_component(mesh);
+    }
+
+    if (reader.has_component("points")) {
+        auto points = std::make_shared<PointsComponent>(&geometry);
+        points->set_vertices(reader.view<pxr::GfVec3f>("points/vertices"));
+        points->set_display_color(
+            reader.view<pxr::GfVec3f>("points/display_color"));
+        points->set_width(reader.view<float>("points/width"));
+        geometry.attach_component(points);
+    }
+
+    if (reader.has_component("curve")) {
+        auto curve = std::make_shared<CurveComponent>(&geometry);
+        curve->set_vertices(reader.view<pxr::GfVec3f>("curve/vertices"));
+        curve->set_vert_count(reader.view<int>("curve/vert_count"));
+        curve->set_width(reader.view<float>("curve/width"));
+        curve->set_display_color(
+            reader.view<pxr::GfVec3f>("curve/display_color"));
+        curve->set_curve_normals(reader.view<pxr::GfVec3f>("curve/normals"));
+        const auto periodic = reader.view<int>("curve/periodic");
+        curve->set_periodic(!periodic.empty() && periodic[0] != 0);
+        geometry.attach_component(curve);
+    }
+
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "GCore/api.h"
 #include "GOP.h"
 
@@ -16,6 +18,11 @@ struct GEOMETRY_API GeometryComponent {
 
     virtual void apply_transform(const pxr::GfMatrix4d& transform) = 0;
 
+    // Process-wide, strictly increasing change stamp. Components take a fresh
+    // one whenever a column is replaced, so caches (spatial indices,
+    // factorizations) can be keyed on stamps instead of hashing data.
+    static uint64_t next_version();
+
    protected:
     Geometry* attached_operand;
 #if USE_USD_SCRATCH_BUFFER
@@ -3,6 +3,7 @@
 
 #include "GCore/Components.h"
 #include "GCore/GOP.h"
+#include "GCore/algorithms/transform.h"
 #include "pxr/usd/usdGeom/basisCurves.h"
 #include "pxr/usd/usdGeom/curves.h"
 #include "pxr/usd/usdGeom/xform.h"
@@ -16,10 +17,14 @@ struct GEOMETRY_API CurveComponent : public GeometryComponent {
     void apply_transform(const pxr::GfMatrix4d& transform) override
     {
         auto vertices = get_vertices();
-        for (auto& vertex : vertices) {
-            vertex = pxr::GfVec3f(transform.Transform(vertex));
-        }
+        transform_points(transform, vertices.data(), vertices.size());
         set_vertices(vertices);
+
+        auto normals = get_curve_normals();
+        if (!normals.empty()) {
+            transform_normals(transform, normals.data(), normals.size());
+            set_curve_normals(normals);
+        }
     }
 
     [[nodiscard]] pxr::VtArray<pxr::GfVec3f> get_vertices() const
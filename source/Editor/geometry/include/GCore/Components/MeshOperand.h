@@ -7,6 +7,7 @@
 
 #include "GCore/Components.h"
 #include "GCore/GOP.h"
+#include "GCore/algorithms/transform.h"
 #include "pxr/usd/usdGeom/primvarsAPI.h"
 #include "pxr/usd/usdGeom/xform.h"
 
@@ -19,15 +20,24 @@ struct GEOMETRY_API MeshComponent : public GeometryComponent {
     void apply_transform(const pxr::GfMatrix4d& transform) override
     {
         auto vertices = get_vertices();
-        for (auto& vertex : vertices) {
-            vertex = pxr::GfVec3f(transform.Transform(vertex));
-        }
+        transform_points(transform, vertices.data(), vertices.size());
         set_vertices(vertices);
+
+        auto normals = get_normals();
+        if (!normals.empty()) {
+            transform_normals(transform, normals.data(), normals.size());
+            set_normals(normals);
+        }
     }
 
     std::string to_string() const override;
     GeometryComponentHandle copy(Geometry* operand) const override;
 
+    // Without the USD scratch buffer, getters return handles that share
+    // storage with the component and setters adopt the given array's
+    // storage; neither copies elements. VtArray is copy-on-write, so writing
+    // to a returned array detaches it and leaves the component unchanged.
+    // copy() shares every array with the source in the same way.
     [[nodiscard]] pxr::VtArray<pxr::GfVec3f> get_vertices() const
     {
 #if USE_USD_SCRATCH_BUFFER
@@ -261,6 +271,18 @@ struct GEOMETRY_API MeshComponent : public GeometryComponent {
         return names;
     }
 
+    // Change stamps for caches derived from this mesh. The topology stamp
+    // changes with the face counts or indices, the position stamp with the
+    // vertices. A copy keeps the stamps of its source.
+    [[nodiscard]] uint64_t topology_version() const
+    {
+        return topology_version_;
+    }
+    [[nodiscard]] uint64_t position_version() const
+    {
+        return position_version_;
+    }
+
     void set_vertices(const pxr::VtArray<pxr::GfVec3f>& vertices)
     {
 #if USE_USD_SCRATCH_BUFFER
@@ -268,6 +290,7 @@ struct GEOMETRY_API MeshComponent : public GeometryComponent {
 #else
         this->vertices = vertices;
 #endif
+        position_version_ = next_version();
     }
 
     void set_face_vertex_counts(const pxr::VtArray<int>& face_vertex_counts)
@@ -277,6 +300,7 @@ struct GEOMETRY_API MeshComponent : public GeometryComponent {
 #else
         this->faceVertexCounts = face_vertex_counts;
 #endif
+        topology_version_ = next_version();
     }
 
     void set_face_vertex_indices(const pxr::VtArray<int>& face_vertex_indices)
@@ -286,6 +310,7 @@ struct GEOMETRY_API MeshComponent : public GeometryComponent {
 #else
         this->faceVertexIndices = face_vertex_indices;
 #endif
+        topology_version_ = next_version();
     }
 
     void set_normals(const pxr::VtArray<pxr::GfVec3f>& normals)
@@ -441,6 +466,15 @@ struct GEOMETRY_API MeshComponent : public GeometryComponent {
 #endif
     void append_mesh(const std::shared_ptr<MeshComponent>& mesh);
 
+    // Appends all meshes in one pass. Final sizes are computed first and each
+    // column (topology, normals, texcoords, display color and every polyscope
+    // quantity) is written once, in parallel over the inputs. Columns missing
+    // from some inputs are filled with defaults (zero, or gray for colors).
+    // Normals and texcoords are promoted to face-varying when the inputs mix
+    // vertex and face-varying interpolation.
+    void append_meshes(
+        const std::vector<std::shared_ptr<MeshComponent>>& meshes);
+
    private:
 #if USE_USD_SCRATCH_BUFFER
     pxr::UsdGeomMesh mesh;
@@ -455,6 +489,9 @@ struct GEOMETRY_API MeshComponent : public GeometryComponent {
     pxr::VtArray<pxr::GfVec2f> texcoordsArray;
 #endif
 
+    uint64_t topology_version_ = next_version();
+    uint64_t position_version_ = next_version();
+
     // After adding these quantities, you need to modify the copy() function
 
     // Quantities for polyscope
@@ -3,6 +3,7 @@
 
 #include "GCore/Components.h"
 #include "GCore/GOP.h"
+#include "GCore/algorithms/transform.h"
 #include "pxr/usd/usdGeom/points.h"
 #include "pxr/usd/usdGeom/xform.h"
 
@@ -15,9 +16,7 @@ struct GEOMETRY_API PointsComponent : public GeometryComponent {
     void apply_transform(const pxr::GfMatrix4d& transform) override
     {
         auto vertices = get_vertices();
-        for (auto& vertex : vertices) {
-            vertex = pxr::GfVec3f(transform.Transform(vertex));
-        }
+        transform_points(transform, vertices.data(), vertices.size());
         set_vertices(vertices);
     }
 
@@ -53,6 +52,12 @@ struct GEOMETRY_API PointsComponent : public GeometryComponent {
         return width;
     }
 
+    // Changes whenever the vertices are replaced; kept by copy().
+    [[nodiscard]] uint64_t position_version() const
+    {
+        return position_version_;
+    }
+
     void set_vertices(const pxr::VtArray<pxr::GfVec3f>& vertices)
     {
 #if USE_USD_SCRATCH_BUFFER
@@ -60,6 +65,7 @@ struct GEOMETRY_API PointsComponent : public GeometryComponent {
 #else
         this->vertices = vertices;
 #endif
+        position_version_ = next_version();
     }
 
     void set_display_color(const pxr::VtArray<pxr::GfVec3f>& display_color)
@@ -95,6 +101,7 @@ struct GEOMETRY_API PointsComponent : public GeometryComponent {
     pxr::VtArray<pxr::GfVec3f> displayColor;
     pxr::VtArray<float> width;
 #endif
+    uint64_t position_version_ = next_version();
 };
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
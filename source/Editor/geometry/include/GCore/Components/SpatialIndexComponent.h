@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "GCore/Components.h"
+#include "GCore/GOP.h"
+#include "GCore/algorithms/bvh.h"
+#include "GCore/algorithms/kd_tree.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+struct MeshComponent;
+struct PointsComponent;
+
+// Cached spatial indices for the other components of a Geometry. The
+// structures are built on first use and keyed on the version stamps of the
+// component they were built from: a topology change rebuilds the BVH, a
+// position-only change refits it. Built structures are immutable and shared,
+// so copying the Geometry keeps them warm for downstream nodes.
+struct GEOMETRY_API SpatialIndexComponent : public GeometryComponent {
+    explicit SpatialIndexComponent(Geometry* attached_operand);
+
+    std::string to_string() const override;
+    GeometryComponentHandle copy(Geometry* operand) const override;
+
+    // The indices follow the version stamps of their sources, which change
+    // with the transformed positions.
+    void apply_transform(const pxr::GfMatrix4d& transform) override
+    {
+    }
+
+    // BVH over the faces of `mesh`; nullptr if its topology is invalid.
+    std::shared_ptr<const TriangleBVH> triangle_bvh(const MeshComponent& mesh);
+
+    // k-d tree over the vertices of `mesh` or `points`.
+    std::shared_ptr<const PointKdTree> point_tree(const MeshComponent& mesh);
+    std::shared_ptr<const PointKdTree> point_tree(
+        const PointsComponent& points);
+
+    // The index component of `geometry`, attached on first request.
+    static std::shared_ptr<SpatialIndexComponent> get_or_create(
+        Geometry& geometry);
+
+   private:
+    std::shared_ptr<const PointKdTree> point_tree(
+        const pxr::VtArray<pxr::GfVec3f>& points,
+        uint64_t version);
+
+    mutable std::mutex mutex_;
+
+    std::shared_ptr<const TriangleBVH> bvh_;
+    uint64_t bvh_topology_version_ = 0;
+    uint64_t bvh_position_version_ = 0;
+
+    std::shared_ptr<const PointKdTree> point_tree_;
+    uint64_t point_tree_version_ = 0;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
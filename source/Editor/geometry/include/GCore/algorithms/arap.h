@@ -0,0 +1,196 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <pxr/base/gf/vec2f.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "GCore/algorithms/laplacian.h"
+#include "GCore/algorithms/triangulate.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// As-rigid-as-possible surface deformation (Sorkine and Alexa, 2007) with
+// cotangent weights and a set of handle vertices moved by the user.
+//
+// Meant to persist between executions, e.g. in node storage, while handles
+// are dragged. The cotangent Laplacian restricted to the free vertices is
+// factored once per (topology, rest shape, handle set); each frame then
+// alternates a local step, parallel over the vertices, with a global step
+// that is one back-substitution for x, y and z together. Positions and
+// rotations of the previous frame are kept to warm-start the next one.
+//
+// The local step extracts each rotation with the iteration of Muller et
+// al., "A Robust Method to Extract the Rotational Part of Deformations"
+// (2016), started from the vertex's previous rotation. Unlike a closed-form
+// polar decomposition it stays well defined when a one-ring is flat and its
+// covariance rank-deficient, and a warm start needs one or two steps.
+class GEOMETRY_API ArapDeformer {
+   public:
+    // Returns false if the topology refers to missing vertices, a handle is
+    // out of range or repeated, or the factorization fails.
+    bool prepare(
+        const pxr::VtArray<pxr::GfVec3f>& rest_positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        uint64_t topology_version,
+        uint64_t position_version,
+        const std::vector<uint32_t>& handles);
+    void clear();
+
+    // Runs `iterations` local/global steps with the handles at
+    // handle_positions (in the order given to prepare()). With warm_start,
+    // continues from the previous result if there is one, else from the rest
+    // shape.
+    bool deform(
+        const std::vector<pxr::GfVec3f>& handle_positions,
+        int iterations,
+        bool warm_start,
+        pxr::VtArray<pxr::GfVec3f>& out);
+
+   private:
+    void local_step();
+    void global_rhs();
+
+    LaplacianSolver solver_;
+    std::vector<uint32_t> handles_;
+    // Cotangent weights and rest edges p0_i - p0_j per directed edge, in CSR
+    // order: the edges of i are [offsets_[i], offsets_[i + 1]).
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> neighbors_;
+    std::vector<double> weights_;
+    std::vector<Eigen::Vector3d> rest_edges_;
+
+    Eigen::MatrixXd rest_;
+    Eigen::MatrixXd current_;
+    Eigen::MatrixXd rhs_;
+    std::vector<Eigen::Quaterniond> rotations_;
+    std::vector<Eigen::Matrix3d> rotation_matrices_;
+    bool has_solution_ = false;
+};
+
+// As-rigid-as-possible (or as-similar-as-possible) parameterization, after
+// Liu et al., "A Local/Global Approach to Mesh Parameterization" (2008).
+//
+// Every triangle is laid flat isometrically in its own frame. The local
+// step fits a rotation (ARAP) or a similarity (ASAP) to each triangle's
+// Jacobian in closed form -- the 2x2 polar decomposition needs no SVD -- as
+// a branch-free pass over structure-of-arrays data. The global step is one
+// back-substitution for u and v with the cotangent Laplacian, which is
+// factored once per (topology, rest shape, mode) like in ArapDeformer.
+//
+// One vertex per connected component is pinned to its initial position;
+// ASAP pins a second one, as the energy would otherwise let a component
+// shrink to a point. Polygons are fan-triangulated.
+class GEOMETRY_API ArapParameterizer {
+   public:
+    enum class Mode {
+        Arap,
+        Asap,
+    };
+
+    struct Options {
+        int max_iterations = 20;
+        // Stops once an iteration lowers the energy by less than this
+        // fraction of it, or the mean energy density falls below its
+        // square.
+        double tolerance = 1e-4;
+    };
+
+    struct Stats {
+        int iterations = 0;
+        double initial_energy = 0;
+        double energy = 0;
+        // Triangles whose Jacobian has a non-positive determinant.
+        size_t flipped = 0;
+        double seconds = 0;
+    };
+
+    // Returns false if the topology refers to missing vertices or the
+    // factorization fails.
+    bool prepare(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        uint64_t topology_version,
+        uint64_t position_version,
+        Mode mode);
+    void clear();
+
+    // Harmonic (cotangent) map of the prepared mesh with its longest
+    // boundary loop fixed, by arc length, to a circle of the same length.
+    // Returns false if there is no boundary.
+    bool harmonic_initialization(pxr::VtArray<pxr::GfVec2f>& uv);
+
+    // Starts from `initial`, one point per vertex, rescaled to the area of
+    // the mesh, and runs local/global iterations until the options say
+    // stop.
+    bool parameterize(
+        const pxr::VtArray<pxr::GfVec2f>& initial,
+        const Options& options,
+        pxr::VtArray<pxr::GfVec2f>& uv);
+
+    const Stats& stats() const
+    {
+        return stats_;
+    }
+
+    // Distortion of the last result per input face, area-weighted over its
+    // triangles: the energy density |J - L|^2, the area ratio s1 * s2 and
+    // the conformal ratio s1 / |s2| of the singular values of the Jacobian
+    // J (s2 < 0 on flipped triangles).
+    void face_distortion(
+        pxr::VtArray<float>& energy,
+        pxr::VtArray<float>& area_ratio,
+        pxr::VtArray<float>& conformal_ratio) const;
+
+   private:
+    // Jacobians of the current uv_ and their best fits, returning the
+    // energy.
+    double local_step();
+    void global_rhs();
+
+    LaplacianSolver solver_;
+    LaplacianSolver harmonic_;
+    Mode mode_ = Mode::Arap;
+    pxr::VtArray<pxr::GfVec3f> positions_;
+    pxr::VtArray<int> face_vertex_counts_;
+    pxr::VtArray<int> face_vertex_indices_;
+    uint64_t topology_version_ = 0;
+    uint64_t position_version_ = 0;
+
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    std::vector<uint32_t> face_of_triangle_;
+    VertexTriangles vertex_triangles_;
+    std::vector<uint32_t> pins_;
+    double total_area_ = 0;
+
+    // Per triangle, structure of arrays. The flat frame puts the corners at
+    // (0, 0), (edge_, 0) and (apex_x_, apex_y_); inverse_* is the upper
+    // triangular inverse of the matrix of its edge vectors.
+    std::vector<double> area_;
+    std::vector<double> edge_;
+    std::vector<double> apex_x_;
+    std::vector<double> apex_y_;
+    std::vector<double> inverse00_;
+    std::vector<double> inverse01_;
+    std::vector<double> inverse11_;
+    std::vector<double> cot_;  // Three per triangle, by corner.
+    std::vector<double> jacobian_[4];  // Row-major.
+    // The fitted map [[fit_a_, -fit_b_], [fit_b_, fit_a_]].
+    std::vector<double> fit_a_;
+    std::vector<double> fit_b_;
+    std::vector<double> energy_;
+
+    Eigen::MatrixXd uv_;
+    Eigen::MatrixXd rhs_;
+    Stats stats_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
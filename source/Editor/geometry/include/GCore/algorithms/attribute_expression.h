@@ -0,0 +1,68 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+struct MeshComponent;
+
+// Per-vertex attribute expressions, e.g.
+//
+//     d = normalize(P) * a
+//     P = P + d * sin(P.z * 10)
+//     Cd = mix(vec3(0, 0, 1), vec3(1, 0, 0), length(d))
+//     @height = P.z
+//
+// Statements are separated by newlines or ';' and '#' starts a comment.
+// Names refer to the position P, normal N, display color Cd and texture
+// coordinate UV (read with z = 0), to vertex quantities as @name, to the
+// vertex index i, to PI, to the uniforms passed to compile(), and to local
+// variables assigned earlier. Values are floats or 3-vectors; scalars
+// broadcast in arithmetic, and .x/.y/.z (or .r/.g/.b) select a component.
+// Functions: sin cos abs sqrt floor fract exp log min max pow clamp mix
+// dot length normalize cross vec3. Assigning @name creates or replaces a
+// scalar or vector quantity (a color quantity keeps being one).
+//
+// A program is compiled to register bytecode and run over blocks of
+// vertices in parallel. Registers hold a block in structure-of-arrays
+// layout, so every instruction is a flat loop the compiler vectorizes, and
+// a chain of edits that would take one node (and one full-size array) per
+// step is a single pass over memory.
+class GEOMETRY_API AttributeProgram {
+   public:
+    AttributeProgram();
+    ~AttributeProgram();
+
+    // Compiles `source` against the attributes present on `mesh`, which fix
+    // the type of every quantity. Returns false and sets error() if the
+    // source is malformed or reads an attribute the mesh does not have per
+    // vertex.
+    bool compile(
+        const std::string& source,
+        const MeshComponent& mesh,
+        const std::map<std::string, float>& uniforms = {});
+
+    // Runs the compiled program over the vertices of `mesh` and replaces
+    // the assigned attributes. Returns false and sets error() if an input
+    // no longer has one value per vertex.
+    bool run(MeshComponent& mesh);
+
+    const std::string& error() const
+    {
+        return error_;
+    }
+    size_t instruction_count() const;
+
+    // Bytecode and attribute bindings, defined in attribute_expression.cpp.
+    struct Code;
+
+   private:
+    std::unique_ptr<Code> code_;
+    std::string error_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "GCore/algorithms/triangulate.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Mesh denoising by bilateral normal filtering (Zheng, Fu, Au and Tai,
+// "Bilateral Normal Filtering for Mesh Denoising", 2011, local iterative
+// scheme): face normals are averaged over a neighborhood with weights
+// falling off with centroid distance (sigma_c) and normal difference
+// (sigma_s), then the vertices are moved to fit the filtered normals (Sun et
+// al., "Fast and Effective Feature-Preserving Mesh Denoising", 2007).
+//
+// Face neighborhoods are stored once per topology in one flat CSR table.
+// Both stages are Jacobi sweeps, parallel over faces or vertices, reading
+// one buffer and writing the other; all buffers are members, so repeated
+// runs on the same topology allocate nothing.
+//
+// Polygons are fan-triangulated; boundary vertices stay in place.
+class GEOMETRY_API BilateralNormalFilter {
+   public:
+    enum class Neighborhood {
+        Edge,    // Faces sharing an edge.
+        Vertex,  // Faces sharing at least one vertex.
+    };
+
+    // Returns false if the topology refers to vertices outside
+    // [0, vertex_count).
+    bool set_topology(
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        size_t vertex_count,
+        Neighborhood neighborhood);
+    void clear();
+
+    size_t vertex_count() const
+    {
+        return boundary_.size();
+    }
+    const std::vector<std::array<uint32_t, 3>>& triangles() const
+    {
+        return triangles_;
+    }
+    Neighborhood neighborhood() const
+    {
+        return neighborhood_;
+    }
+
+    // Denoises `positions` in place. sigma_c is multiple_sigma_c times the
+    // mean centroid distance between neighboring faces.
+    void denoise(
+        pxr::VtArray<pxr::GfVec3f>& positions,
+        float sigma_s,
+        float multiple_sigma_c,
+        int normal_iterations,
+        int vertex_iterations);
+
+   private:
+    void update_faces(const pxr::VtArray<pxr::GfVec3f>& positions);
+
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    VertexTriangles vertex_triangles_;
+    std::vector<uint8_t> boundary_;
+    // Neighbors of face f: neighbors_[neighbor_offsets_[f], [f + 1]).
+    std::vector<uint32_t> neighbor_offsets_;
+    std::vector<uint32_t> neighbors_;
+    Neighborhood neighborhood_ = Neighborhood::Edge;
+
+    // Per-face attributes, one array each.
+    std::vector<float> area_;
+    std::vector<pxr::GfVec3f> centroid_;
+    std::vector<pxr::GfVec3f> normals_[2];
+    std::vector<pxr::GfVec3f> positions_[2];
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
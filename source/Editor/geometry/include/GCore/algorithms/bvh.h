@@ -0,0 +1,125 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Bounding volume hierarchy over triangles. Polygon faces are fan-triangulated
+// and every hit reports the source face. Construction splits at the centroid
+// median of the widest axis and builds large subtrees in parallel; when only
+// positions change, refit() updates the boxes without touching the tree.
+class GEOMETRY_API TriangleBVH {
+   public:
+    static constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+    struct ClosestHit {
+        int face = -1;
+        int triangle = -1;
+        float distance2 = kInfinity;
+        pxr::GfVec3f point;
+        // Weights of the triangle corners at `point`.
+        pxr::GfVec3f barycentric;
+
+        explicit operator bool() const
+        {
+            return face >= 0;
+        }
+    };
+
+    struct RayHit {
+        int face = -1;
+        int triangle = -1;
+        float t = kInfinity;
+        // Hit point is (1 - u - v) * p0 + u * p1 + v * p2.
+        float u = 0.0f;
+        float v = 0.0f;
+
+        explicit operator bool() const
+        {
+            return face >= 0;
+        }
+    };
+
+    // Builds over a USD-style polygon mesh. Faces with fewer than three
+    // corners are skipped. Returns false and leaves the BVH empty if the
+    // counts do not match the indices or an index is out of range.
+    bool build(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices);
+
+    // Recomputes the bounds for new positions of the same vertices.
+    void refit(const pxr::VtArray<pxr::GfVec3f>& positions);
+
+    void clear();
+
+    bool empty() const
+    {
+        return nodes_.empty();
+    }
+    size_t triangle_count() const
+    {
+        return triangles_.size();
+    }
+    // Corner vertices of the triangle that ClosestHit::triangle or
+    // RayHit::triangle refer to.
+    const std::array<uint32_t, 3>& triangle(int i) const
+    {
+        return triangles_[i];
+    }
+
+    ClosestHit closest_point(
+        const pxr::GfVec3f& query,
+        float max_distance = kInfinity) const;
+
+    // Nearest intersection with t in [t_min, t_max]. `direction` need not be
+    // normalized; t is measured in its units.
+    RayHit intersect(
+        const pxr::GfVec3f& origin,
+        const pxr::GfVec3f& direction,
+        float t_min = 0.0f,
+        float t_max = kInfinity) const;
+
+    // Batched queries, evaluated in parallel. `out` must hold `count` entries.
+    void closest_points(
+        const pxr::GfVec3f* queries,
+        size_t count,
+        ClosestHit* out,
+        float max_distance = kInfinity) const;
+    void intersect_rays(
+        const pxr::GfVec3f* origins,
+        const pxr::GfVec3f* directions,
+        size_t count,
+        RayHit* out,
+        float t_max = kInfinity) const;
+
+    struct Node {
+        float lower[3];
+        // Inner node: index of the left child, the right one follows it.
+        // Leaf: first triangle.
+        uint32_t first;
+        float upper[3];
+        // Number of triangles; 0 for inner nodes.
+        uint32_t count;
+    };
+
+   private:
+    void refit_nodes();
+
+    pxr::VtArray<pxr::GfVec3f> positions_;
+    // Corner indices and source face of each triangle, in leaf order.
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    std::vector<int> faces_;
+    // Children are always stored after their parent.
+    std::vector<Node> nodes_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Face topology stored with the narrowest index type that can address every
+// vertex. When all faces share one arity (all triangles, all quads) the
+// per-face counts are dropped and face f occupies corners
+// [f * arity, (f + 1) * arity); otherwise a prefix-sum offset table is kept.
+// For a triangle mesh below 65536 vertices this is 6 bytes per face instead
+// of the 16 bytes of USD counts + indices.
+class GEOMETRY_API CompactTopology {
+   public:
+    enum class IndexWidth : uint8_t { U16, U32 };
+
+    CompactTopology() = default;
+
+    // Builds from USD-style counts and indices. Returns false and leaves the
+    // topology empty if a count is not positive, the counts do not sum to the
+    // number of indices, or an index is outside [0, vertex_count).
+    bool build(
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        size_t vertex_count);
+
+    void clear();
+
+    size_t vertex_count() const
+    {
+        return vertex_count_;
+    }
+    size_t face_count() const
+    {
+        return face_count_;
+    }
+    size_t corner_count() const
+    {
+        return corner_count_;
+    }
+
+    // Common face size, or 0 when faces differ in size (or there are none).
+    int uniform_arity() const
+    {
+        return arity_;
+    }
+    bool is_uniform() const
+    {
+        return arity_ != 0;
+    }
+    bool is_triangle_mesh() const
+    {
+        return arity_ == 3;
+    }
+
+    IndexWidth index_width() const
+    {
+        return width_;
+    }
+    // Bytes held by the index and offset tables.
+    size_t memory_bytes() const;
+
+    size_t face_begin(size_t face) const
+    {
+        return arity_ ? face * arity_ : offsets_[face];
+    }
+    int face_size(size_t face) const
+    {
+        return arity_ ? arity_ : int(offsets_[face + 1] - offsets_[face]);
+    }
+    uint32_t corner_vertex(size_t corner) const
+    {
+        return width_ == IndexWidth::U16 ? indices16_[corner]
+                                         : indices32_[corner];
+    }
+
+    // Calls fn(const Index* indices) with the stored index type, so hot loops
+    // are instantiated once per width instead of branching per corner.
+    template<typename Fn>
+    decltype(auto) visit_indices(Fn&& fn) const
+    {
+        if (width_ == IndexWidth::U16) {
+            return fn(indices16_.data());
+        }
+        return fn(indices32_.data());
+    }
+
+    // Calls fn(face, const Index* corners, int size) for every face.
+    template<typename Fn>
+    void for_each_face(Fn&& fn) const
+    {
+        visit_indices([&](const auto* indices) {
+            for (size_t f = 0; f < face_count_; ++f) {
+                fn(f, indices + face_begin(f), face_size(f));
+            }
+        });
+    }
+
+    // Fixed-size face list for a uniform topology of arity N, e.g. to hand
+    // triangles to polyscope without building nested vectors. Returns an empty
+    // list if the arity is not N.
+    template<int N>
+    std::vector<std::array<uint32_t, N>> fixed_faces() const
+    {
+        std::vector<std::array<uint32_t, N>> faces;
+        if (arity_ != N) {
+            return faces;
+        }
+        faces.resize(face_count_);
+        visit_indices([&](const auto* indices) {
+            for (size_t f = 0; f < face_count_; ++f) {
+                for (int k = 0; k < N; ++k) {
+                    faces[f][k] = indices[f * N + k];
+                }
+            }
+        });
+        return faces;
+    }
+
+    // Converters back to the USD representation stored in MeshComponent.
+    pxr::VtArray<int> face_vertex_counts() const;
+    pxr::VtArray<int> face_vertex_indices() const;
+
+   private:
+    size_t vertex_count_ = 0;
+    size_t face_count_ = 0;
+    size_t corner_count_ = 0;
+    int arity_ = 0;
+    IndexWidth width_ = IndexWidth::U16;
+
+    std::vector<uint16_t> indices16_;
+    std::vector<uint32_t> indices32_;
+    // face_count + 1 prefix sums; empty for uniform topologies.
+    std::vector<uint32_t> offsets_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Smooth N-RoSy fields on the faces of a polygon mesh: N unit vectors per
+// face, symmetric under rotation by 2 pi / N (a cross field for N = 4). Each
+// face stores z = u^N for any of its vectors u, as a complex number in a
+// tangent frame, i.e. the N-PolyVector z^N - u^N. Smoothness is the least
+// squares fit of z_f conj(e_f)^N = z_g conj(e_g)^N over the interior edges,
+// with e_f and e_g the direction of the shared edge in the two frames; faces
+// with a boundary edge have z prescribed. A connected component without a
+// boundary gets its first face prescribed instead.
+//
+// Like LaplacianSolver, it is meant to live in node storage: prepare()
+// rebuilds the face adjacency and the symbolic factorization of the normal
+// equations for a new topology, only the numeric factorization for moved
+// vertices or a new N, and nothing otherwise. solve() is then
+// back-substitution for the prescribed directions.
+class GEOMETRY_API CrossFieldSolver {
+   public:
+    // Returns false if the topology refers to missing vertices, an edge has
+    // more than two faces, or the factorization fails.
+    bool prepare(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        uint64_t topology_version,
+        uint64_t position_version,
+        int symmetry = 4);
+    void clear();
+
+    size_t face_count() const
+    {
+        return free_row_.size();
+    }
+    int symmetry() const
+    {
+        return symmetry_;
+    }
+    // The faces whose vectors solve() takes as given.
+    const std::vector<uint32_t>& constrained_faces() const
+    {
+        return constrained_;
+    }
+    // How often each factorization step has run, for checking reuse.
+    size_t symbolic_count() const
+    {
+        return symbolic_count_;
+    }
+    size_t numeric_count() const
+    {
+        return numeric_count_;
+    }
+
+    // One direction per constrained face: perpendicular to its boundary edge
+    // within the face, or the first axis of its frame without one.
+    void boundary_directions(std::vector<pxr::GfVec3f>& directions) const;
+
+    // directions has one vector per constrained face, projected onto the
+    // face. field receives face_count() * symmetry() unit vectors, face by
+    // face, counterclockwise around the face normal.
+    bool solve(
+        const std::vector<pxr::GfVec3f>& directions,
+        pxr::VtArray<pxr::GfVec3f>& field) const;
+
+   private:
+    using Complex = std::complex<double>;
+    using Solver = Eigen::SimplicialLDLT<Eigen::SparseMatrix<Complex>>;
+
+    bool build(
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        size_t vertex_count);
+    bool refactor(const pxr::VtArray<pxr::GfVec3f>& positions, bool symbolic);
+    // The field value z = u^N of direction u in the frame of face f.
+    Complex encode(uint32_t f, const pxr::GfVec3f& u) const;
+
+    uint64_t topology_version_ = 0;
+    uint64_t position_version_ = 0;
+    int symmetry_ = 0;
+
+    // Polygon corners in compressed sparse row form.
+    std::vector<uint32_t> face_offsets_;
+    std::vector<uint32_t> face_vertices_;
+    // Faces and vertices of each interior edge, two entries per edge.
+    std::vector<uint32_t> edge_faces_;
+    std::vector<uint32_t> edge_vertices_;
+    // Row of each face among the free (>= 0) or constrained (< 0, as
+    // -1 - row) faces.
+    std::vector<int> free_row_;
+    std::vector<uint32_t> constrained_;
+    // Vertices of a boundary edge of each constrained face, two entries per
+    // face, kInvalid for those without.
+    std::vector<uint32_t> constraint_edges_;
+
+    // Orthonormal tangent frame of each face.
+    std::vector<pxr::GfVec3f> axis_x_;
+    std::vector<pxr::GfVec3f> axis_y_;
+    std::vector<pxr::GfVec3f> boundary_directions_;
+
+    Eigen::SparseMatrix<Complex> free_free_;
+    Eigen::SparseMatrix<Complex> free_fixed_;
+    std::shared_ptr<Solver> solver_;
+    size_t symbolic_count_ = 0;
+    size_t numeric_count_ = 0;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
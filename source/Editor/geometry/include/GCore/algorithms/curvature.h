@@ -0,0 +1,95 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "GCore/algorithms/triangulate.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Per-vertex curvatures of a triangle mesh. Mean curvature is positive where
+// the surface bends away from the normal, e.g. 1/r on a sphere with outward
+// normals.
+struct CurvatureField {
+    pxr::VtArray<float> area;  // Mixed Voronoi area.
+    pxr::VtArray<pxr::GfVec3f> normal;
+    pxr::VtArray<float> mean;
+    pxr::VtArray<float> gaussian;
+    // Only filled when principal curvatures are requested; k1 >= k2, with
+    // direction1 and direction2 the corresponding unit tangents.
+    pxr::VtArray<float> k1;
+    pxr::VtArray<float> k2;
+    pxr::VtArray<pxr::GfVec3f> direction1;
+    pxr::VtArray<pxr::GfVec3f> direction2;
+};
+
+// Discrete curvature operators after Meyer, Desbrun, Schroder and Barr,
+// "Discrete Differential-Geometry Operators for Triangulated 2-Manifolds"
+// (2003): cotangent mean curvature normal and angle defect over the mixed
+// Voronoi area. Principal directions follow Rusinkiewicz, "Estimating
+// Curvatures and Their Derivatives on Triangle Meshes" (2004): a second
+// fundamental form per triangle from the vertex normals, averaged in the
+// tangent plane of each vertex; the principal curvatures themselves are
+// taken from the mean and Gaussian curvature so that all outputs agree.
+//
+// Mean and Gaussian curvature take one parallel pass over the vertices and
+// principal directions a second, each vertex gathering its triangles through
+// a vertex-to-triangle table, so no two threads write the same entry and
+// nothing is stored per triangle. The table and the vertex kinds
+// (interior, boundary, non-manifold) only depend on the topology and are
+// kept between calls.
+//
+// Boundary vertices get zero mean curvature, and the angle defect against
+// pi instead of 2 pi. Vertices whose triangles do not form a single
+// consistently oriented fan, open or closed, are non-manifold (e.g. a pinch
+// where two closed fans meet) and get zero mean and Gaussian curvature.
+class GEOMETRY_API CurvatureKernel {
+   public:
+    // Fan-triangulates the faces. Returns false if the topology refers to
+    // vertices outside [0, vertex_count).
+    bool set_topology(
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        size_t vertex_count);
+    void clear();
+
+    size_t vertex_count() const
+    {
+        return vertex_triangles_.offsets.empty()
+                   ? 0
+                   : vertex_triangles_.offsets.size() - 1;
+    }
+
+    // Vertices left without curvature, see above.
+    size_t non_manifold_vertex_count() const
+    {
+        return non_manifold_vertex_count_;
+    }
+
+    // positions must match the vertex count given to set_topology().
+    void compute(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        CurvatureField& out,
+        bool principal = false) const;
+
+   private:
+    enum class VertexKind : uint8_t { Interior, Boundary, NonManifold };
+
+    // Kind of a vertex from the (after, before) neighbors of its triangles;
+    // sorts `fan`.
+    static VertexKind classify(
+        std::vector<std::pair<uint32_t, uint32_t>>& fan);
+
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    VertexTriangles vertex_triangles_;
+    std::vector<VertexKind> kinds_;
+    size_t non_manifold_vertex_count_ = 0;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Implicit D-ary min-heap over a std::vector. With D = 4 and 16-byte entries
+// the children of a node fill one cache line, and the tree is half as deep as
+// a binary heap, which is what dominates large priority queues (edge
+// collapses, Dijkstra). Less(a, b) orders by priority; the smallest is on top.
+template<typename T, typename Less = std::less<T>, size_t D = 4>
+class DaryHeap {
+   public:
+    explicit DaryHeap(Less less = Less()) : less_(std::move(less))
+    {
+    }
+
+    bool empty() const
+    {
+        return items_.empty();
+    }
+    size_t size() const
+    {
+        return items_.size();
+    }
+    void reserve(size_t n)
+    {
+        items_.reserve(n);
+    }
+    void clear()
+    {
+        items_.clear();
+    }
+
+    const T& top() const
+    {
+        return items_.front();
+    }
+
+    void push(const T& item)
+    {
+        items_.push_back(item);
+        sift_up(items_.size() - 1);
+    }
+
+    T pop()
+    {
+        T result = std::move(items_.front());
+        if (items_.size() > 1) {
+            items_.front() = std::move(items_.back());
+            items_.pop_back();
+            sift_down(0);
+        }
+        else {
+            items_.pop_back();
+        }
+        return result;
+    }
+
+    // Replaces the contents and heapifies in O(n).
+    void assign(std::vector<T> items)
+    {
+        items_ = std::move(items);
+        heapify();
+    }
+
+    // Drops every item for which keep(item) is false, then re-heapifies.
+    // Used to shed entries invalidated lazily.
+    template<typename Keep>
+    void filter(Keep&& keep)
+    {
+        size_t out = 0;
+        for (size_t i = 0; i < items_.size(); ++i) {
+            if (keep(items_[i])) {
+                items_[out++] = std::move(items_[i]);
+            }
+        }
+        items_.resize(out);
+        heapify();
+    }
+
+   private:
+    void heapify()
+    {
+        if (items_.size() < 2) {
+            return;
+        }
+        for (size_t i = (items_.size() - 2) / D + 1; i-- > 0;) {
+            sift_down(i);
+        }
+    }
+
+    void sift_up(size_t i)
+    {
+        T item = std::move(items_[i]);
+        while (i > 0) {
+            const size_t parent = (i - 1) / D;
+            if (!less_(item, items_[parent])) {
+                break;
+            }
+            items_[i] = std::move(items_[parent]);
+            i = parent;
+        }
+        items_[i] = std::move(item);
+    }
+
+    void sift_down(size_t i)
+    {
+        const size_t n = items_.size();
+        T item = std::move(items_[i]);
+        while (true) {
+            const size_t first = D * i + 1;
+            if (first >= n) {
+                break;
+            }
+            const size_t last = first + D < n ? first + D : n;
+            size_t best = first;
+            for (size_t c = first + 1; c < last; ++c) {
+                if (less_(items_[c], items_[best])) {
+                    best = c;
+                }
+            }
+            if (!less_(items_[best], item)) {
+                break;
+            }
+            items_[i] = std::move(items_[best]);
+            i = best;
+        }
+        items_[i] = std::move(item);
+    }
+
+    std::vector<T> items_;
+    Less less_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
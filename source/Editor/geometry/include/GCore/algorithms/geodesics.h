@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Eigen/SparseCholesky>
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "GCore/algorithms/triangulate.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Geodesic distances by the heat method (Crane, Weischedel and Wardetzky,
+// "Geodesics in Heat", 2013): diffuse heat from the sources for a short time
+// t, normalize its gradient and recover the distance whose gradient best
+// matches it. Both linear systems depend only on the mesh, so build()
+// factors them once and every compute() is two back-substitutions plus a
+// gradient and a divergence pass.
+//
+// Polygons are fan-triangulated. Vertices not connected to a source get
+// arbitrary values.
+class GEOMETRY_API HeatGeodesics {
+   public:
+    // t = time_scale * h^2 with h the mean edge length; larger values give
+    // smoother, less accurate distances. Returns false if the topology
+    // refers to missing vertices or a factorization fails.
+    bool build(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        double time_scale = 1.0);
+    void clear();
+
+    bool empty() const
+    {
+        return positions_.empty();
+    }
+    double time_scale() const
+    {
+        return time_scale_;
+    }
+
+    // Distance from the nearest of `sources` to every vertex. Out-of-range
+    // sources are ignored.
+    void compute(const std::vector<uint32_t>& sources, std::vector<float>& out)
+        const;
+
+   private:
+    // Per triangle: the gradient of each corner's hat function and the
+    // cotangent of each corner's angle.
+    struct TriangleData {
+        pxr::GfVec3d gradient[3];
+        double cot[3];
+    };
+
+    pxr::VtArray<pxr::GfVec3f> positions_;
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    std::vector<TriangleData> triangle_data_;
+    VertexTriangles vertex_triangles_;
+    // Factors of M + tL and L + eps M, with L the cotan stiffness and M the
+    // lumped mass. Shared so that copies stay cheap; they are never modified
+    // after build().
+    using Solver = Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>>;
+    std::shared_ptr<const Solver> heat_solver_;
+    std::shared_ptr<const Solver> poisson_solver_;
+    double time_scale_ = 0.0;
+};
+
+// Geodesic distances by the Fast Marching Method on triangle meshes
+// (Kimmel and Sethian, 1998): Dijkstra's order, but each vertex is updated
+// from the planar wavefront through two accepted neighbors of a triangle
+// instead of along a single edge. Updates whose wavefront does not arrive
+// from inside the triangle, as happens at obtuse angles, fall back to the
+// edge update, so distances there lean towards the graph distance.
+class GEOMETRY_API FastMarching {
+   public:
+    // Returns false if the topology refers to missing vertices.
+    bool build(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices);
+    void clear();
+
+    bool empty() const
+    {
+        return positions_.empty();
+    }
+
+    // Distance from the nearest of `sources` to every vertex, infinity where
+    // none is reachable. Out-of-range sources are ignored.
+    void compute(const std::vector<uint32_t>& sources, std::vector<float>& out)
+        const;
+
+   private:
+    pxr::VtArray<pxr::GfVec3f> positions_;
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    VertexTriangles vertex_triangles_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
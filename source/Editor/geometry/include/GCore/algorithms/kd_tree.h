@@ -0,0 +1,82 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Balanced 3D k-d tree over a point set, stored implicitly: the node of a
+// range [begin, end) is its middle element, split on the widest axis of the
+// range. Points are reordered into tree order for locality; results report
+// indices into the original array.
+class GEOMETRY_API PointKdTree {
+   public:
+    static constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+    struct Neighbor {
+        int index = -1;
+        float distance2 = kInfinity;
+
+        explicit operator bool() const
+        {
+            return index >= 0;
+        }
+    };
+
+    void build(const pxr::VtArray<pxr::GfVec3f>& points);
+    void clear();
+
+    bool empty() const
+    {
+        return points_.empty();
+    }
+    size_t size() const
+    {
+        return points_.size();
+    }
+
+    Neighbor nearest(
+        const pxr::GfVec3f& query,
+        float max_distance = kInfinity) const;
+
+    // Up to k nearest points within max_distance, closest first.
+    void k_nearest(
+        const pxr::GfVec3f& query,
+        size_t k,
+        std::vector<Neighbor>& out,
+        float max_distance = kInfinity) const;
+
+    // All points within radius, in no particular order.
+    void radius_search(
+        const pxr::GfVec3f& query,
+        float radius,
+        std::vector<Neighbor>& out) const;
+
+    // Batched nearest-point queries, evaluated in parallel.
+    void nearest_batch(
+        const pxr::GfVec3f* queries,
+        size_t count,
+        Neighbor* out,
+        float max_distance = kInfinity) const;
+
+   private:
+    template<typename Visit>
+    void search(
+        const pxr::GfVec3f& query,
+        size_t begin,
+        size_t end,
+        float& bound2,
+        Visit& visit) const;
+
+    std::vector<pxr::GfVec3f> points_;
+    std::vector<int> indices_;
+    std::vector<uint8_t> axes_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
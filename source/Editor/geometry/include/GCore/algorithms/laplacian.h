@@ -0,0 +1,129 @@
+#pragma once
+
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseLU>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "GCore/algorithms/shortest_path.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Cotangent stiffness matrix of a triangle mesh: L(i, j) = -(cot a + cot b) / 2
+// for the angles opposite edge ij, with diagonal entries making rows sum to
+// zero. Positive semi-definite, so -L is the usual discrete Laplacian.
+GEOMETRY_API void cotan_laplacian(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const std::vector<std::array<uint32_t, 3>>& triangles,
+    Eigen::SparseMatrix<double>& L);
+
+// Lumped mass: a third of the area of every triangle around each vertex.
+GEOMETRY_API void barycentric_mass(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const std::vector<std::array<uint32_t, 3>>& triangles,
+    Eigen::VectorXd& mass);
+
+// Graph Laplacian with unit weights on the edges of `graph`.
+GEOMETRY_API void uniform_laplacian(
+    const MeshGraph& graph,
+    Eigen::SparseMatrix<double>& L);
+
+// Mean value weights (Floater, 2003): w_ij = (tan(a / 2) + tan(b / 2)) /
+// |x_j - x_i| with a and b the angles at i next to edge ij. Positive on any
+// mesh but not symmetric.
+GEOMETRY_API void mean_value_laplacian(
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    const std::vector<std::array<uint32_t, 3>>& triangles,
+    Eigen::SparseMatrix<double>& L);
+
+enum class LaplacianWeights {
+    Uniform,
+    Cotangent,
+    MeanValue,
+};
+
+// Dirichlet problems L x = 0 on the free vertices of a mesh, with the values
+// on the fixed vertices prescribed. Meant to live in node storage: prepare()
+// only redoes what changed since the last call. A new topology or fixed set
+// rebuilds the matrices and the symbolic factorization; new weights, i.e.
+// moved vertices with a position-dependent scheme, only the numeric one;
+// otherwise nothing. solve() is then back-substitution for all columns of
+// the fixed values at once.
+//
+// Uniform and cotangent weights are factored with SimplicialLDLT, mean value
+// weights with SparseLU.
+class GEOMETRY_API LaplacianSolver {
+   public:
+    // Returns false if the topology refers to missing vertices, nothing is
+    // free or fixed, or the factorization fails.
+    bool prepare(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        uint64_t topology_version,
+        uint64_t position_version,
+        LaplacianWeights weights,
+        const std::vector<uint32_t>& fixed);
+    void clear();
+
+    size_t vertex_count() const
+    {
+        return free_row_.size();
+    }
+    // How often each factorization step has run, for checking reuse.
+    size_t symbolic_count() const
+    {
+        return symbolic_count_;
+    }
+    size_t numeric_count() const
+    {
+        return numeric_count_;
+    }
+
+    // fixed_values has one row per fixed vertex, in the order given to
+    // prepare(), and any number of columns; out gets one row per vertex.
+    bool solve(const Eigen::MatrixXd& fixed_values, Eigen::MatrixXd& out)
+        const;
+    // Same for L x = rhs on the free vertices; rhs has one row per vertex
+    // and its rows for fixed vertices are ignored.
+    bool solve(
+        const Eigen::MatrixXd& fixed_values,
+        const Eigen::MatrixXd& rhs,
+        Eigen::MatrixXd& out) const;
+
+   private:
+    bool refactor(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        bool symbolic);
+    void solve_symmetric(const Eigen::MatrixXd& rhs, Eigen::MatrixXd& out)
+        const;
+
+    using SymmetricSolver = Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>>;
+    using GeneralSolver = Eigen::SparseLU<Eigen::SparseMatrix<double>>;
+
+    uint64_t topology_version_ = 0;
+    uint64_t position_version_ = 0;
+    LaplacianWeights weights_ = LaplacianWeights::Uniform;
+    std::vector<uint32_t> fixed_;
+
+    MeshGraph graph_;
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    // Row of each vertex among the free (>= 0) or fixed (< 0, as -1 - row)
+    // vertices.
+    std::vector<int> free_row_;
+    Eigen::SparseMatrix<double> free_free_;
+    Eigen::SparseMatrix<double> free_fixed_;
+    std::shared_ptr<SymmetricSolver> symmetric_;
+    std::shared_ptr<GeneralSolver> general_;
+    size_t symbolic_count_ = 0;
+    size_t numeric_count_ = 0;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <pxr/base/gf/vec2f.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Mean value coordinates (Floater, 2003) with respect to a closed 2D polygon,
+// in the signed form of Hormann and Floater (2006) that stays valid inside
+// concave polygons and outside the polygon.
+//
+// The polygon is kept as structure of arrays, padded with its first vertex
+// so that the per-edge terms are straight loops without wrap-around, which
+// the compiler vectorizes. Points on a vertex or an edge, within a small
+// fraction of the polygon size, get the exact interpolating coordinates
+// instead. Evaluation is const and safe to run from several threads.
+class GEOMETRY_API MeanValueCoordinates {
+   public:
+    // Returns false for fewer than three vertices.
+    bool set_polygon(const std::vector<pxr::GfVec2f>& polygon);
+
+    size_t vertex_count() const
+    {
+        return edge_length_.size();
+    }
+
+    // Coordinates of one point into weights[0, vertex_count()).
+    void evaluate(const pxr::GfVec2f& point, float* weights) const;
+    // Coordinates of `count` points into the row-major count x
+    // vertex_count() matrix `weights`, in parallel over batches of points.
+    void evaluate(const pxr::GfVec2f* points, size_t count, float* weights)
+        const;
+
+   private:
+    // `scratch` holds 4 * (vertex_count() + 1) values.
+    void evaluate(const pxr::GfVec2f& point, float* weights, double* scratch)
+        const;
+
+    // Vertex coordinates, vertex_count() + 1 of them with the first repeated.
+    std::vector<double> x_;
+    std::vector<double> y_;
+    // Length of the edge from vertex i to vertex i + 1.
+    std::vector<double> edge_length_;
+    // Distance below which a point counts as on a vertex or an edge.
+    double tolerance_ = 0;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// dst[i] = src[i] + offset for i in [0, count). Used to rebase face vertex
+// indices when concatenating meshes. src and dst may alias.
+GEOMETRY_API void
+offset_indices(const int* src, int* dst, size_t count, int offset);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Connectivity of a polygon mesh: connected components, boundary loops,
+// non-manifold edges and vertices, invalid polygons and the Euler
+// characteristic, all found in one pass.
+//
+// The corners around each vertex are gathered into a compressed sparse row
+// table, then every vertex is visited in parallel. A vertex classifies the
+// edges to its higher-numbered neighbours by how many faces use them and in
+// which direction, joins their ends in a lock-free union-find, and counts
+// the fans its faces form. Boundary loops are walked from the boundary
+// half-edges found on the way. Apart from sorting each vertex's few
+// neighbours, the work is linear in the size of the mesh.
+//
+// Meant to persist between executions, e.g. in node storage: analyze()
+// keeps its results while the topology version and vertex count stay the
+// same.
+class GEOMETRY_API MeshTopology {
+   public:
+    static constexpr uint32_t kNoComponent = UINT32_MAX;
+
+    // Returns false and clears the results if a face count is negative, the
+    // counts do not sum to the number of indices, an index is outside
+    // [0, vertex_count), or the mesh has 2^32 - 1 or more corners or
+    // vertices.
+    bool analyze(
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        size_t vertex_count,
+        uint64_t topology_version);
+    void clear();
+
+    size_t vertex_count() const
+    {
+        return vertex_components_.size();
+    }
+    size_t face_count() const
+    {
+        return face_components_.size();
+    }
+    size_t edge_count() const
+    {
+        return edge_count_;
+    }
+
+    // Vertices joined by an edge share a component, and a vertex no face
+    // uses is a component of its own. Components are numbered in the order
+    // of their lowest vertex.
+    uint32_t component_count() const
+    {
+        return component_count_;
+    }
+    const std::vector<uint32_t>& vertex_components() const
+    {
+        return vertex_components_;
+    }
+    // kNoComponent for faces without corners.
+    const std::vector<uint32_t>& face_components() const
+    {
+        return face_components_;
+    }
+
+    // Closed boundary loops with the order and orientation boundary_loops()
+    // gives them; loop l is loop_vertices()[loop_offsets()[l],
+    // loop_offsets()[l + 1]).
+    size_t loop_count() const
+    {
+        return loop_offsets_.size() - 1;
+    }
+    const std::vector<uint32_t>& loop_offsets() const
+    {
+        return loop_offsets_;
+    }
+    const std::vector<uint32_t>& loop_vertices() const
+    {
+        return loop_vertices_;
+    }
+    // Edges used by exactly one face.
+    size_t boundary_edge_count() const
+    {
+        return boundary_edge_count_;
+    }
+
+    // Edges used by more than two faces as (lower, higher) vertex pairs, in
+    // increasing order.
+    const std::vector<std::array<uint32_t, 2>>& non_manifold_edges() const
+    {
+        return non_manifold_edges_;
+    }
+    // 1 for a vertex on a non-manifold edge or whose faces form more than one
+    // fan, like the shared tip of two cones; 0 otherwise.
+    const std::vector<uint8_t>& non_manifold_vertices() const
+    {
+        return non_manifold_vertices_;
+    }
+    size_t non_manifold_vertex_count() const
+    {
+        return non_manifold_vertex_count_;
+    }
+    // Edges whose two faces traverse them in the same direction.
+    size_t inconsistent_edge_count() const
+    {
+        return inconsistent_edge_count_;
+    }
+    // Faces with fewer than three corners or a repeated vertex.
+    size_t invalid_face_count() const
+    {
+        return invalid_face_count_;
+    }
+
+    // V - E + F over all vertices, edges and faces.
+    int64_t euler_characteristic() const
+    {
+        return int64_t(vertex_count()) - int64_t(edge_count_) +
+               int64_t(face_count());
+    }
+    bool is_manifold() const
+    {
+        return non_manifold_vertex_count_ == 0 && invalid_face_count_ == 0;
+    }
+    bool is_closed() const
+    {
+        return boundary_edge_count_ == 0;
+    }
+
+   private:
+    uint64_t topology_version_ = 0;
+
+    std::vector<uint32_t> vertex_components_;
+    std::vector<uint32_t> face_components_;
+    uint32_t component_count_ = 0;
+    size_t edge_count_ = 0;
+
+    std::vector<uint32_t> loop_offsets_ = { 0 };
+    std::vector<uint32_t> loop_vertices_;
+    size_t boundary_edge_count_ = 0;
+
+    std::vector<std::array<uint32_t, 2>> non_manifold_edges_;
+    std::vector<uint8_t> non_manifold_vertices_;
+    size_t non_manifold_vertex_count_ = 0;
+    size_t inconsistent_edge_count_ = 0;
+    size_t invalid_face_count_ = 0;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <pxr/base/gf/vec2f.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <cstdint>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Generators for procedural meshes at any resolution.
+//
+// Every array is sized up front from closed-form element counts, and
+// vertices and faces are filled in parallel with index arithmetic instead
+// of lookups, so meshes with tens of millions of faces take about as long as
+// writing the arrays. Closed surfaces share their vertices across seams;
+// normals and texture coordinates are written in the same passes, per
+// vertex where the surface is smooth and its parameterization has no seam,
+// and per face corner otherwise. All surfaces face outwards. The generators
+// return false and log the reason if a count is out of range, including
+// meshes whose indices would not fit in an int.
+
+struct PrimitiveMesh {
+    pxr::VtArray<pxr::GfVec3f> positions;
+    pxr::VtArray<int> face_vertex_counts;
+    pxr::VtArray<int> face_vertex_indices;
+    // One per vertex or one per face corner, see above.
+    pxr::VtArray<pxr::GfVec3f> normals;
+    pxr::VtArray<pxr::GfVec2f> texcoords;
+};
+
+// Quads spanning origin + [0, 1] * edge_u + [0, 1] * edge_v. Vertex (i, j)
+// has index i * (cells_v + 1) + j and texture coordinate (i / cells_u,
+// j / cells_v); the normal is the direction of edge_v x edge_u.
+GEOMETRY_API bool make_grid(
+    const pxr::GfVec3f& origin,
+    const pxr::GfVec3f& edge_u,
+    const pxr::GfVec3f& edge_v,
+    int cells_u,
+    int cells_v,
+    PrimitiveMesh& mesh);
+
+// Sphere around the origin with poles on the z axis: `rings` bands of
+// `segments` quads, triangle fans at the poles.
+GEOMETRY_API bool make_uv_sphere(
+    float radius,
+    int segments,
+    int rings,
+    PrimitiveMesh& mesh);
+
+// Geodesic sphere: every icosahedron face split into frequency^2 triangles
+// and projected onto the sphere, 20 * frequency^2 triangles in total. A
+// frequency of 2^n gives the vertices of n midpoint subdivisions.
+GEOMETRY_API bool
+make_icosphere(float radius, int frequency, PrimitiveMesh& mesh);
+
+// Torus around the z axis with `segments` quads along the ring and `sides`
+// around the tube.
+GEOMETRY_API bool make_torus(
+    float major_radius,
+    float minor_radius,
+    int segments,
+    int sides,
+    PrimitiveMesh& mesh);
+
+// Axis-aligned cube centered at the origin with cells x cells quads per
+// side.
+GEOMETRY_API bool make_cube(float size, int cells, PrimitiveMesh& mesh);
+
+// Cylinder along the z axis, centered at the origin, with `rings` bands of
+// `segments` quads and triangle-fan caps.
+GEOMETRY_API bool make_cylinder(
+    float radius,
+    float height,
+    int segments,
+    int rings,
+    PrimitiveMesh& mesh);
+
+// Fractal sum of gradient noise.
+struct TerrainNoise {
+    float amplitude = 1.0f;
+    // Features per unit length of the first octave.
+    float frequency = 1.0f;
+    int octaves = 4;
+    float lacunarity = 2.0f;
+    float gain = 0.5f;
+    uint32_t seed = 0;
+};
+
+// Square height field of cells x cells quads in the xy plane, centered at
+// the origin, displaced along z by `noise`. Normals come from the
+// differences of neighbouring heights.
+GEOMETRY_API bool make_terrain(
+    float size,
+    int cells,
+    const TerrainNoise& noise,
+    PrimitiveMesh& mesh);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
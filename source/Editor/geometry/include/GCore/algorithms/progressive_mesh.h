@@ -0,0 +1,142 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GCore/algorithms/qem.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Progressive mesh after Hoppe, "Progressive Meshes" (1996): a coarse base
+// mesh plus the QEM collapse sequence replayed backwards as vertex splits.
+//
+// Vertices and triangles are renumbered so that every level of detail is a
+// prefix of both buffers: the base mesh comes first, split i adds vertex
+// base_vertex_count() + i and appends the triangles its collapse removed.
+// A split then only moves two vertices and retargets the few corners listed
+// in its record, so moving between levels costs O(delta) in either direction
+// and never re-simplifies.
+//
+// build() simplifies partition-parallel. Triangles are cut into spatially
+// coherent patches along a Morton curve; each patch is simplified on its own
+// thread with the vertices it shares with other patches locked, and a final
+// seam pass over the union releases the locks and carries on down to the
+// target. Non-edge pairs are only formed in the seam pass, where the whole
+// mesh is visible.
+class GEOMETRY_API ProgressiveMesh {
+   public:
+    struct VertexSplit {
+        // Vertex that is split; the new vertex is base_vertex_count() plus
+        // the index of the split.
+        uint32_t vertex;
+        pxr::GfVec3f vertex_position;     // After the split.
+        pxr::GfVec3f new_position;        // Of the new vertex.
+        pxr::GfVec3f collapsed_position;  // Of `vertex` before the split.
+        // Corners (triangle * 3 + corner) that move from `vertex` to the new
+        // vertex, as a range of corners().
+        uint32_t first_corner, corner_count;
+        // Triangles appended by the split.
+        uint32_t added_faces;
+    };
+
+    // Simplifies to ratio * the number of input triangles (after
+    // fan-triangulation) and leaves the mesh at the coarsest level.
+    // `partitions` = 0 picks one per worker thread. Returns false if the
+    // counts do not match the indices or the topology refers to missing
+    // vertices.
+    bool build(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        float ratio,
+        const QemSimplifier::Options& options,
+        size_t partitions = 0);
+
+    size_t base_vertex_count() const
+    {
+        return base_vertex_count_;
+    }
+    size_t base_face_count() const
+    {
+        return face_offsets_.empty() ? 0 : face_offsets_.front();
+    }
+    size_t split_count() const
+    {
+        return splits_.size();
+    }
+    const std::vector<VertexSplit>& splits() const
+    {
+        return splits_;
+    }
+    const std::vector<uint32_t>& corners() const
+    {
+        return corners_;
+    }
+
+    // Number of splits applied; 0 is the base mesh, split_count() the input.
+    size_t level() const
+    {
+        return level_;
+    }
+    void set_level(size_t level);
+    // Smallest level with at least `faces` triangles.
+    size_t level_for_face_count(size_t faces) const;
+
+    size_t vertex_count() const
+    {
+        return base_vertex_count_ + level_;
+    }
+    size_t face_count() const
+    {
+        return face_offsets_.empty() ? 0 : face_offsets_[level_];
+    }
+
+    // The mesh at the current level.
+    void extract(
+        pxr::VtArray<pxr::GfVec3f>& positions,
+        pxr::VtArray<int>& face_vertex_counts,
+        pxr::VtArray<int>& face_vertex_indices) const;
+
+    // Aggregated over the patches and the seam pass. Setup covers
+    // triangulation, partitioning and assembly; the patch phase is counted
+    // as simplification wall time.
+    const QemSimplifier::Stats& stats() const
+    {
+        return stats_;
+    }
+
+    // Binary stream: header, base positions, the index buffer at level 0
+    // for all triangles, the split records and their corners, all in host
+    // byte order. Independent of the current level.
+    std::vector<uint8_t> serialize() const;
+    // Returns false if the stream is malformed; leaves the mesh at level 0.
+    bool deserialize(const uint8_t* data, size_t size);
+
+    // Return false and log the reason on failure.
+    bool write(const std::string& path) const;
+    bool read(const std::string& path);
+
+   private:
+    void apply_split(size_t split);
+    void undo_split(size_t split);
+
+    size_t base_vertex_count_ = 0;
+    std::vector<VertexSplit> splits_;
+    std::vector<uint32_t> corners_;
+    // Triangle count at each level; split_count() + 1 entries.
+    std::vector<uint32_t> face_offsets_;
+
+    // Working buffers, sized for the finest level.
+    std::vector<pxr::GfVec3f> positions_;
+    std::vector<uint32_t> indices_;
+    size_t level_ = 0;
+
+    QemSimplifier::Stats stats_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
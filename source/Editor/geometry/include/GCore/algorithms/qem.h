@@ -0,0 +1,235 @@
+#pragma once
+
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "GCore/algorithms/dary_heap.h"
+#include "GCore/algorithms/kd_tree.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Symmetric 4x4 error quadric of Garland and Heckbert, "Surface
+// Simplification Using Quadric Error Metrics" (1997), stored as its ten
+// distinct coefficients.
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0;
+    double c = 0;
+
+    // weight * squared distance to the plane n.x + d = 0, n unit length.
+    static Quadric from_plane(const pxr::GfVec3d& n, double d, double weight);
+
+    bool is_zero() const
+    {
+        return a00 == 0 && a11 == 0 && a22 == 0 && c == 0;
+    }
+    Quadric& operator+=(const Quadric& q);
+    double evaluate(const pxr::GfVec3d& p) const;
+    // Minimizer of the quadric; false if the linear part is near singular.
+    bool optimize(pxr::GfVec3d& p) const;
+};
+
+// Quadric-error edge-collapse simplification of a triangle mesh. Polygon faces
+// are fan-triangulated on input.
+//
+// Vertex quadrics are gathered in parallel over a flat vertex-to-triangle
+// adjacency, which is also what the link-condition and flip checks walk.
+// Candidate pairs live in a 4-ary heap with lazy invalidation: every vertex
+// carries a version that is bumped when it changes, entries remember the
+// versions they were computed with, and stale entries are dropped when popped
+// instead of being searched for and removed. The heap is swept once stale
+// entries outnumber live ones.
+class GEOMETRY_API QemSimplifier {
+   public:
+    struct Options {
+        // Non-edge vertex pairs closer than this fraction of the bounding box
+        // diagonal are also contraction candidates; 0 disables them. They are
+        // only formed between different connected components or between
+        // boundary vertices, i.e. to aggregate parts and close cracks.
+        float pair_distance = 0.0f;
+        // Weight of the planes that pin boundary edges, relative to face
+        // planes.
+        float boundary_weight = 100.0f;
+        // Optional per-vertex flags. A locked vertex never moves: it can only
+        // absorb an unlocked neighbor, and pairs of locked vertices are never
+        // contracted.
+        std::vector<uint8_t> locked;
+        // Optional quadrics to start from, one per vertex, e.g. those of an
+        // earlier pass. Vertices given a zero quadric get the one computed
+        // from their faces.
+        std::vector<Quadric> quadrics;
+        // Optional k-d tree over the input positions for finding non-edge
+        // pairs, e.g. the cached one of a SpatialIndexComponent. Built here
+        // when missing or not holding one point per vertex.
+        std::shared_ptr<const PointKdTree> point_tree;
+        // Keep the collapse sequence, see collapses().
+        bool record = false;
+    };
+
+    // One recorded contraction. `removed` was merged into `survivor`, which
+    // moved from survivor_position to position. The corners that referred to
+    // `removed` and now refer to `survivor` are
+    // collapse_corners()[first_corner, first_corner + corner_count), encoded
+    // as triangle * 3 + corner; the triangles that died are
+    // collapse_triangles()[first_triangle, first_triangle + triangle_count).
+    struct Collapse {
+        uint32_t survivor, removed;
+        pxr::GfVec3f survivor_position, removed_position, position;
+        uint32_t first_corner, corner_count;
+        uint32_t first_triangle, triangle_count;
+    };
+
+    struct Stats {
+        size_t input_faces = 0;
+        size_t output_faces = 0;
+        size_t collapses = 0;
+        size_t non_edge_pairs = 0;
+        double setup_seconds = 0;
+        double simplify_seconds = 0;
+
+        double collapses_per_second() const
+        {
+            return simplify_seconds > 0 ? collapses / simplify_seconds : 0;
+        }
+    };
+
+    // Returns false if the counts do not match the indices or the topology
+    // refers to missing vertices.
+    bool build(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        const Options& options);
+    bool build(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        std::vector<std::array<uint32_t, 3>> triangles,
+        const Options& options);
+
+    // Collapses pairs until at most target_faces triangles remain or no valid
+    // pair is left.
+    void simplify(size_t target_faces);
+
+    size_t face_count() const
+    {
+        return alive_faces_;
+    }
+
+    // The simplified mesh, with unreferenced vertices dropped.
+    void extract(
+        pxr::VtArray<pxr::GfVec3f>& positions,
+        pxr::VtArray<int>& face_vertex_counts,
+        pxr::VtArray<int>& face_vertex_indices) const;
+
+    const Stats& stats() const
+    {
+        return stats_;
+    }
+
+    // Current state, indexed like the input. Dead triangles keep the corners
+    // they had when they were removed.
+    const std::vector<std::array<uint32_t, 3>>& triangles() const
+    {
+        return triangles_;
+    }
+    const std::vector<uint8_t>& triangle_alive() const
+    {
+        return triangle_alive_;
+    }
+    const std::vector<pxr::GfVec3d>& positions() const
+    {
+        return positions_;
+    }
+    const std::vector<Quadric>& quadrics() const
+    {
+        return quadrics_;
+    }
+
+    // Filled when Options::record is set.
+    const std::vector<Collapse>& collapses() const
+    {
+        return collapses_;
+    }
+    const std::vector<uint32_t>& collapse_corners() const
+    {
+        return collapse_corners_;
+    }
+    const std::vector<uint32_t>& collapse_triangles() const
+    {
+        return collapse_triangles_;
+    }
+
+   private:
+    struct Candidate {
+        float cost;
+        uint32_t a, b;
+        // Sum of the versions of a and b when the cost was computed. Versions
+        // only grow, so an unchanged sum means both are unchanged.
+        uint32_t stamp;
+
+        bool operator<(const Candidate& o) const
+        {
+            return cost < o.cost;
+        }
+    };
+
+    Candidate evaluate(uint32_t a, uint32_t b) const;
+    bool is_current(const Candidate& c) const;
+    // q is the sum of the quadrics of a and b.
+    pxr::GfVec3d target_position(const Quadric& q, uint32_t a, uint32_t b)
+        const;
+    bool link_condition(uint32_t a, uint32_t b) const;
+    bool flips(uint32_t a, uint32_t b, const pxr::GfVec3d& p) const;
+    void collapse(uint32_t a, uint32_t b, const pxr::GfVec3d& p);
+    void push_pairs(uint32_t v);
+    void compact_references();
+
+    void build_references();
+    void build_quadrics(double boundary_weight);
+    void build_edge_pairs();
+    void build_non_edge_pairs(
+        float pair_distance,
+        std::shared_ptr<const PointKdTree> tree);
+
+    std::vector<pxr::GfVec3d> positions_;
+    std::vector<Quadric> quadrics_;
+    std::vector<uint32_t> versions_;
+    std::vector<uint8_t> vertex_alive_;
+    std::vector<uint8_t> boundary_;
+    std::vector<uint8_t> locked_;
+
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    std::vector<uint8_t> triangle_alive_;
+    size_t alive_faces_ = 0;
+
+    // Triangles around vertex v: references_[ref_begin_[v] + i] for
+    // i < ref_count_[v]. A collapse appends the merged list at the end;
+    // compact_references() reclaims the dead space.
+    std::vector<uint32_t> references_;
+    std::vector<uint32_t> ref_begin_;
+    std::vector<uint32_t> ref_count_;
+
+    // Non-edge partners per vertex; empty unless pair_distance > 0.
+    std::vector<std::vector<uint32_t>> partners_;
+
+    DaryHeap<Candidate> heap_;
+
+    // Scratch marks for neighborhood checks, stamped per query.
+    mutable std::vector<uint32_t> marks_;
+    mutable uint32_t mark_epoch_ = 0;
+
+    bool record_ = false;
+    std::vector<Collapse> collapses_;
+    std::vector<uint32_t> collapse_corners_;
+    std::vector<uint32_t> collapse_triangles_;
+
+    Stats stats_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "GCore/algorithms/bvh.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Isotropic remeshing after Botsch and Kobbelt, "A Remeshing Approach to
+// Multiresolution Modeling" (2004). Every iteration splits edges longer than
+// 4/3 of the target length, collapses those shorter than 4/5, flips edges
+// towards valence 6 (4 on the boundary) and relaxes the vertices
+// tangentially, projecting them back onto the input surface through a
+// TriangleBVH.
+//
+// The mesh is a corner table: half-edge h runs from the vertex of corner h
+// to that of the next corner of its triangle, and twin_[h] is the opposite
+// half-edge. Splits, collapses and flips run in rounds of deterministic
+// reservations: every candidate edge claims the vertices its operation
+// reads or writes with an atomic max of a (priority, hash) key, the
+// candidates holding all of their claims are applied in parallel, and the
+// rest are reconsidered in the next round. Removed elements are only
+// flagged, and the arrays are compacted once at the end of each iteration.
+//
+// Boundary vertices stay in place; boundary edges are split, and collapsed
+// only along the boundary, removing the endpoint where it is straighter.
+// The input must be an oriented edge-manifold without non-manifold
+// vertices; polygons are fan-triangulated and unreferenced vertices
+// dropped.
+class GEOMETRY_API IsotropicRemesher {
+   public:
+    struct Options {
+        float target_length = 0.1f;
+        int iterations = 10;
+        // Step towards the tangential centroid, in [0, 1].
+        float relaxation = 1.0f;
+        // With a positive tolerance the target length adapts to the
+        // curvature, so that edges stay within about tolerance *
+        // target_length of the surface (Dunyach et al., "Adaptive Remeshing
+        // for Real-Time Mesh Deformation", 2013); target_length is then the
+        // upper bound and a tenth of it the lower one.
+        float adaptive_tolerance = 0.0f;
+        // Curvature magnitude per input vertex for the adaptive length, e.g.
+        // the largest absolute principal curvature; estimated from the
+        // input when empty.
+        pxr::VtArray<float> curvature;
+        // Optional BVH over the input mesh, e.g. the cached one of a
+        // SpatialIndexComponent. Built here when missing or not holding one
+        // triangle per fan triangle of the input.
+        std::shared_ptr<const TriangleBVH> reference;
+    };
+
+    struct Stats {
+        size_t input_faces = 0;
+        size_t output_faces = 0;
+        size_t splits = 0;
+        size_t collapses = 0;
+        size_t flips = 0;
+        // Reservation rounds over all operations and iterations.
+        size_t rounds = 0;
+        double seconds = 0;
+    };
+
+    // Returns false if the topology refers to missing vertices or is not an
+    // oriented manifold.
+    bool remesh(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices,
+        const Options& options);
+
+    void extract(
+        pxr::VtArray<pxr::GfVec3f>& positions,
+        pxr::VtArray<int>& face_vertex_counts,
+        pxr::VtArray<int>& face_vertex_indices) const;
+
+    const Stats& stats() const
+    {
+        return stats_;
+    }
+
+   private:
+    struct CollapsePlan {
+        // From the removed vertex to the one that stays.
+        uint32_t half_edge;
+        pxr::GfVec3f position;
+    };
+
+    bool build(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices);
+    void set_sizing(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices);
+    // Outgoing half-edge, valence and boundary flag of every vertex.
+    void update_vertices();
+    // The same for one vertex, starting from any of its outgoing
+    // half-edges.
+    void update_vertex(uint32_t v);
+
+    template<typename Fn>
+    void for_each_outgoing(uint32_t v, Fn&& fn) const;
+    template<typename Fn>
+    void for_each_neighbor(uint32_t v, Fn&& fn) const;
+
+    // One operation until no candidate is left. `evaluate(h, claims)`
+    // returns the priority of edge h, or a negative value if it is not a
+    // candidate, and lists the vertices it claims. `apply(h, vertex, face)`
+    // runs for the winners, each with new_vertices fresh vertices and
+    // new_faces fresh triangles starting at the given indices; it leaves a
+    // live outgoing half-edge in vertex_half_edge_ for every vertex it
+    // touched, from which update_vertex() restores the rest.
+    template<typename Evaluate, typename Apply>
+    size_t run_rounds(
+        Evaluate&& evaluate,
+        Apply&& apply,
+        size_t new_vertices,
+        size_t new_faces);
+
+    float edge_target(uint32_t a, uint32_t b) const;
+    // claims receives both endpoints and their neighbors.
+    bool plan_collapse(
+        uint32_t h,
+        CollapsePlan& plan,
+        std::vector<uint32_t>& claims) const;
+    int flip_gain(uint32_t h) const;
+
+    size_t split_edges();
+    size_t collapse_edges();
+    size_t flip_edges();
+    void relax();
+    void collect_garbage();
+
+    Options options_;
+    Stats stats_;
+
+    std::vector<pxr::GfVec3f> positions_;
+    // Target edge length at each vertex.
+    std::vector<float> sizing_;
+    // Vertex of each corner, kInvalid for all three corners of a removed
+    // triangle.
+    std::vector<uint32_t> corner_vertex_;
+    std::vector<uint32_t> twin_;
+    // For boundary vertices the outgoing boundary half-edge, so that turning
+    // from it visits the whole fan; kInvalid for removed vertices.
+    std::vector<uint32_t> vertex_half_edge_;
+    std::vector<uint32_t> valence_;
+    std::vector<uint8_t> boundary_;
+
+    // Reservation state: the best key claiming each vertex, and the key of
+    // each candidate in the current round (0 if it is none).
+    std::vector<uint64_t> owner_;
+    std::vector<uint64_t> key_;
+
+    // The input surface, for projection and the sizing field.
+    std::shared_ptr<const TriangleBVH> reference_;
+    std::vector<float> reference_sizing_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "GCore/algorithms/dary_heap.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Vertex graph of a polygon mesh in compressed sparse row form: the
+// neighbors of v are neighbors()[offsets()[v], offsets()[v + 1]), with the
+// Euclidean edge lengths alongside in weights(). Every polygon edge is one
+// undirected edge, stored in both directions.
+class GEOMETRY_API MeshGraph {
+   public:
+    // Returns false if the topology refers to missing vertices.
+    bool build(
+        const pxr::VtArray<pxr::GfVec3f>& positions,
+        const pxr::VtArray<int>& face_vertex_counts,
+        const pxr::VtArray<int>& face_vertex_indices);
+    // Recomputes the weights for moved vertices on the same topology.
+    void update_weights(const pxr::VtArray<pxr::GfVec3f>& positions);
+    void clear();
+
+    size_t vertex_count() const
+    {
+        return positions_.size();
+    }
+    size_t edge_count() const
+    {
+        return neighbors_.size() / 2;
+    }
+    const std::vector<uint32_t>& offsets() const
+    {
+        return offsets_;
+    }
+    const std::vector<uint32_t>& neighbors() const
+    {
+        return neighbors_;
+    }
+    const std::vector<float>& weights() const
+    {
+        return weights_;
+    }
+    const pxr::VtArray<pxr::GfVec3f>& positions() const
+    {
+        return positions_;
+    }
+
+   private:
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> neighbors_;
+    std::vector<float> weights_;
+    pxr::VtArray<pxr::GfVec3f> positions_;
+};
+
+// Single-pair shortest paths on a MeshGraph. One instance is meant to serve
+// many queries: its per-vertex buffers are stamped with a query epoch rather
+// than cleared, so a query only pays for the vertices it touches. Not safe
+// to share between threads.
+class GEOMETRY_API ShortestPathSearch {
+   public:
+    static constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+    enum class Method {
+        Dijkstra,
+        // Dijkstra from both ends, stopping once the frontiers prove the best
+        // meeting point.
+        Bidirectional,
+        // Dijkstra guided by the straight-line distance to the target, which
+        // never overestimates on Euclidean edge weights.
+        AStar,
+    };
+
+    struct Result {
+        std::vector<uint32_t> path;  // From source to target, both included.
+        float distance = kInfinity;
+        size_t settled = 0;  // Vertices taken off the heap.
+
+        explicit operator bool() const
+        {
+            return !path.empty();
+        }
+    };
+
+    // Empty result if target is unreachable or either vertex is out of range.
+    Result find(
+        const MeshGraph& graph,
+        uint32_t source,
+        uint32_t target,
+        Method method = Method::AStar);
+
+    // Graph distance from the nearest of `sources` to every vertex, infinity
+    // where none is reachable. Out-of-range sources are ignored.
+    void distances(
+        const MeshGraph& graph,
+        const std::vector<uint32_t>& sources,
+        std::vector<float>& out);
+
+   private:
+    struct Entry {
+        float key;
+        uint32_t vertex;
+
+        bool operator<(const Entry& o) const
+        {
+            return key < o.key;
+        }
+    };
+
+    // Tentative distances and parents of one search direction, valid where
+    // stamp equals the current epoch.
+    struct Frontier {
+        std::vector<float> distance;
+        std::vector<uint32_t> parent;
+        std::vector<uint32_t> stamp;
+        std::vector<uint32_t> settled;
+        DaryHeap<Entry> heap;
+
+        float get(uint32_t v, uint32_t epoch) const
+        {
+            return stamp[v] == epoch ? distance[v] : kInfinity;
+        }
+        void set(uint32_t v, float d, uint32_t p, uint32_t epoch)
+        {
+            distance[v] = d;
+            parent[v] = p;
+            stamp[v] = epoch;
+        }
+    };
+
+    void begin_query(size_t vertex_count);
+    Result unidirectional(
+        const MeshGraph& graph,
+        uint32_t source,
+        uint32_t target,
+        bool guided);
+    Result
+    bidirectional(const MeshGraph& graph, uint32_t source, uint32_t target);
+    static void trace(
+        const Frontier& frontier,
+        uint32_t from,
+        std::vector<uint32_t>& path);
+
+    Frontier forward_;
+    Frontier backward_;
+    uint32_t epoch_ = 0;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
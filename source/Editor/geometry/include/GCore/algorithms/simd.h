@@ -0,0 +1,28 @@
+#pragma once
+
+#include "GCore/api.h"
+
+// Helpers for kernels with an AVX2 path and a scalar fallback. The AVX2
+// functions are compiled with a per-function target attribute, so the rest of
+// the module does not require -mavx2 and the choice is made at runtime.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define USTC_CG_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define USTC_CG_TARGET_AVX2
+#else
+#define USTC_CG_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#else
+#define USTC_CG_SIMD_X86 0
+#define USTC_CG_TARGET_AVX2
+#endif
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// True if the CPU and OS support AVX2 and FMA. Evaluated once.
+GEOMETRY_API bool cpu_has_avx2();
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
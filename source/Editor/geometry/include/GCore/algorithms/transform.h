@@ -0,0 +1,33 @@
+#pragma once
+
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/vec3f.h>
+
+#include <cstddef>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Batch kernels for applying a transform to packed float3 arrays in place.
+//
+// The matrix follows the USD row-vector convention (p' = p * M). Affine
+// matrices are handled by an AVX2 kernel when the CPU supports it, with a
+// scalar fallback otherwise; projective matrices fall back to
+// GfMatrix4d::Transform. Large arrays are split into blocks and processed in
+// parallel.
+
+// Positions: p' = p * M, including the translation part.
+GEOMETRY_API void transform_points(
+    const pxr::GfMatrix4d& transform,
+    pxr::GfVec3f* points,
+    size_t count);
+
+// Normals: n' = normalize(n * inverse_transpose(M3x3)). Zero-length normals
+// are kept as zero.
+GEOMETRY_API void transform_normals(
+    const pxr::GfMatrix4d& transform,
+    pxr::GfVec3f* normals,
+    size_t count);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
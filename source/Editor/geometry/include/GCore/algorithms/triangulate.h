@@ -0,0 +1,62 @@
+#pragma once
+
+#include <pxr/base/vt/array.h>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Fan-triangulates polygon faces into `triangles`; face_of_triangle, if
+// given, receives the polygon each triangle came from. Returns false if the
+// counts do not sum to the number of indices or the topology refers to
+// vertices outside [0, vertex_count).
+GEOMETRY_API bool fan_triangulate(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count,
+    std::vector<std::array<uint32_t, 3>>& triangles,
+    std::vector<uint32_t>* face_of_triangle = nullptr);
+
+// Vertices on an edge that only one face uses, in increasing order. Returns
+// false if the topology refers to vertices outside [0, vertex_count).
+GEOMETRY_API bool boundary_vertices(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count,
+    std::vector<uint32_t>& boundary);
+
+// Closed boundary loops, each oriented like the faces it bounds, longest
+// (by vertex count) first. A vertex where several loops touch may appear in
+// more than one. Returns false if the topology refers to vertices outside
+// [0, vertex_count).
+GEOMETRY_API bool boundary_loops(
+    const pxr::VtArray<int>& face_vertex_counts,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count,
+    std::vector<std::vector<uint32_t>>& loops);
+
+// Walks boundary half-edges (from, to), sorted, into the loops
+// boundary_loops() returns: each loop follows the first unused half-edge
+// leaving the end of the last one, and chains that do not close are dropped.
+GEOMETRY_API void walk_boundary_loops(
+    const std::vector<std::pair<uint32_t, uint32_t>>& half_edges,
+    std::vector<std::vector<uint32_t>>& loops);
+
+// Triangles around each vertex in compressed sparse row form: the corners of
+// v are corners[offsets[v], offsets[v + 1]), each encoded as triangle * 3 +
+// the position of v in that triangle.
+struct GEOMETRY_API VertexTriangles {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> corners;
+
+    void build(
+        const std::vector<std::array<uint32_t, 3>>& triangles,
+        size_t vertex_count);
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "GCore/GOP.h"
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Native binary cache for the mesh, points and curve columns of a Geometry.
+//
+// Every column (vertices, face indices, normals, widths, each named polyscope
+// quantity, ...) is stored as one contiguous chunk starting on a 64-byte
+// boundary, followed by a directory of column names, types, offsets and
+// counts. Reading maps the file and hands out read-only VtArrays that point
+// straight into the mapping, so nothing is copied or parsed and the OS only
+// pages in the columns that are actually touched. Writing to such an array
+// detaches it into an ordinary copy, as for any shared VtArray. The mapping
+// stays alive for as long as any array refers to it.
+//
+// Column names are "<component>/<column>", e.g. "mesh/vertices",
+// "mesh/vertex_scalar/<name>", "points/width" or "curve/vert_count". Only the
+// first component of each kind is stored. The file is written in host byte
+// order and refused on a mismatching host.
+
+// Writes to "<path>.tmp" and renames it over `path`, so arrays still mapping
+// an earlier version of the file keep its old contents. That guarantee is
+// POSIX-only: Windows refuses to replace a file that is open or mapped, so
+// there the write fails while any array read from `path` is alive. Returns
+// false and logs the reason if the file cannot be written or replaced.
+GEOMETRY_API bool write_geometry_cache(
+    const Geometry& geometry,
+    const std::string& path);
+
+// Maps `path` into `geometry`. If `columns` is not empty only columns whose
+// names start with one of its entries are attached, e.g. {"mesh/vertices",
+// "mesh/face_"} for positions and topology only. Returns false and logs the
+// reason if the file is missing or malformed.
+GEOMETRY_API bool read_geometry_cache(
+    const std::string& path,
+    Geometry& geometry,
+    const std::vector<std::string>& columns = {});
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
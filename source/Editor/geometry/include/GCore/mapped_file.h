@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Read-only mapping of a whole file. The OS pages the contents in on demand,
+// so readers can hand out views into it or scan it from several threads
+// without copying.
+class GEOMETRY_API MappedFile {
+   public:
+    // Returns nullptr if the file is missing, empty or cannot be mapped.
+    static std::shared_ptr<MappedFile> open(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* data() const
+    {
+        return data_;
+    }
+    size_t size() const
+    {
+        return size_;
+    }
+
+   private:
+    MappedFile() = default;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    // File and mapping HANDLEs, kept opaque to spare users <windows.h>.
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Out-of-core processing of mesh files that do not fit in memory.
+//
+// MeshStreamReader reads an OBJ or PLY file as a sequence of batches, each a
+// run of consecutive vertices or faces in file order, and MeshStreamWriter
+// appends such batches to a new file. Memory is bounded by the batch size,
+// so per-element operations (transforms, colors, quantities computed from
+// the position) can run over files of any size; anything that needs
+// neighbours has to load the mesh as usual. USD files are not supported,
+// since attributes are always read as whole arrays.
+
+// A run of vertices or faces. Either part may be empty.
+struct MeshBatch {
+    // Index of the first vertex and face in the whole mesh.
+    size_t first_vertex = 0;
+    size_t first_face = 0;
+
+    pxr::VtArray<pxr::GfVec3f> positions;
+    // Empty, or one per position.
+    pxr::VtArray<pxr::GfVec3f> colors;
+    pxr::VtArray<float> scalars;
+
+    pxr::VtArray<int> face_vertex_counts;
+    // Indices into the whole mesh.
+    pxr::VtArray<int> face_vertex_indices;
+};
+
+class GEOMETRY_API MeshStreamReader {
+   public:
+    MeshStreamReader();
+    ~MeshStreamReader();
+
+    // Opens an ".obj" file or an ASCII or binary little-endian ".ply" file.
+    // Every batch covers about `batch_bytes` of the file. Returns false and
+    // logs the reason if the file cannot be opened or has a bad header.
+    bool open(const std::string& path, size_t batch_bytes = size_t(64) << 20);
+
+    // Returns false at the end of the file and on errors, which are logged
+    // and reported by failed().
+    bool next(MeshBatch& batch);
+    bool failed() const
+    {
+        return failed_;
+    }
+
+    // Parser of one file format, defined in mesh_stream.cpp.
+    class Format;
+
+   private:
+    std::unique_ptr<Format> format_;
+    bool failed_ = false;
+};
+
+class GEOMETRY_API MeshStreamWriter {
+   public:
+    MeshStreamWriter();
+    ~MeshStreamWriter();
+
+    // Creates an ".obj" or a binary ".ply" file. Colors are written if the
+    // first batch with vertices has them, scalars only to PLY (as the
+    // "quality" property). For PLY, faces are spooled to "<path>.faces"
+    // until close(), since the format puts all vertices first.
+    bool open(const std::string& path);
+    bool write(const MeshBatch& batch);
+    // Returns false and logs the reason if anything failed to be written.
+    bool close();
+
+    // Encoder of one file format, defined in mesh_stream.cpp.
+    class Format;
+
+   private:
+    std::unique_ptr<Format> format_;
+};
+
+struct MeshStreamStats {
+    size_t vertices = 0;
+    size_t faces = 0;
+    size_t batches = 0;
+    double seconds = 0.0;
+};
+
+// Reads `input` batch by batch, calls `process` on each batch and writes it
+// to `output`. Stops and returns false if reading or writing fails or
+// `process` returns false.
+GEOMETRY_API bool stream_mesh(
+    const std::string& input,
+    const std::string& output,
+    const std::function<bool(MeshBatch&)>& process,
+    MeshStreamStats* stats = nullptr,
+    size_t batch_bytes = size_t(64) << 20);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+
+#include "GCore/GOP.h"
+#include "GCore/api.h"
+#include "GCore/mesh_stream.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Wavefront OBJ reader for large scans.
+//
+// The file is mapped and split into chunks on line boundaries. A first
+// parallel pass counts the elements of every chunk, a prefix sum turns the
+// counts into offsets, and a second parallel pass parses each chunk straight
+// into its slice of the final VtArrays, so the file is read twice but nothing
+// is copied in between and the second pass is served from the page cache.
+//
+// Supported are "v", "vt", "vn" and "f" lines with positive or relative
+// indices in all of the i, i/j, i//k and i/j/k forms; every other statement
+// (groups, materials, lines, ...) is skipped. A "v" line is either x y z
+// with an optional w, which is skipped, or x y z r g b with a vertex color.
+// Texture coordinates and normals become vertex primvars when they are
+// indexed like the positions and face-varying ones otherwise; corners
+// without them get zero. Line continuations are not supported.
+
+// Creates a MeshComponent in `geometry`; vertex colors, if any vertex has
+// one, become its display color. Returns false and logs the reason if the
+// file cannot be mapped, a statement is malformed or an index is out of
+// range.
+GEOMETRY_API bool read_obj(const std::string& path, Geometry& geometry);
+
+// Running element counts of an OBJ file.
+struct ObjCounts {
+    size_t positions = 0;
+    size_t texcoords = 0;
+    size_t normals = 0;
+    size_t faces = 0;
+    size_t corners = 0;
+};
+
+// Parses the lines in [begin, end), which has to end on a line boundary, into
+// the positions and faces of `batch` with the same chunked parallel parser.
+// `counts` holds the elements before `begin` and is advanced past the range,
+// so a file can be parsed piecewise; faces may only refer to elements of
+// this or earlier pieces. If any vertex of the range has a color, the colors
+// go to `batch.colors` with zero for the others; texture coordinates and
+// normals are counted but not kept. On failure `error`, if given, receives
+// the offending line.
+GEOMETRY_API bool parse_obj_batch(
+    const char* begin,
+    const char* end,
+    ObjCounts& counts,
+    MeshBatch& batch,
+    const char** error = nullptr);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
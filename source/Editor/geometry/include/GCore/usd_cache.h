@@ -0,0 +1,110 @@
+#pragma once
+
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/usd/usd/attribute.h>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/usd/timeCode.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GCore/api.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Opens `path` through a process-wide pxr::UsdStageCache. The stage is reused
+// for as long as the file keeps its modification time, and reopened (and the
+// old one dropped from the cache) once it changes, so nodes reading the same
+// file every frame pay for opening and composing it only once. Only the 16
+// most recently used files stay cached; evicted stages live on while callers
+// hold them. Files are opened without holding the cache lock. Layers the new
+// stage shares with stages still alive elsewhere are reloaded if they changed
+// on disk, which first stops the UsdPointsPrefetchers whose stage uses any of
+// them. Returns null if the file cannot be opened.
+GEOMETRY_API pxr::UsdStageRefPtr open_cached_stage(const std::string& path);
+
+// Reads the time samples of a points attribute ahead of playback.
+//
+// A background thread keeps the `capacity` samples from the last requested
+// one onwards in a ring buffer, so stepping through an animation finds the
+// next frame already read. Times between samples, and samples outside the
+// window, are read on the calling thread. The samples are listed once, when
+// the prefetcher is created. open_cached_stage() stops the thread before it
+// reloads a layer of the prefetcher's stage; the prefetcher then reads every
+// request on the calling thread and should be recreated.
+class GEOMETRY_API UsdPointsPrefetcher {
+   public:
+    // `stage` owns `points` and is kept alive by the prefetcher.
+    UsdPointsPrefetcher(
+        pxr::UsdStageRefPtr stage,
+        const pxr::UsdAttribute& points,
+        size_t capacity);
+    ~UsdPointsPrefetcher();
+
+    UsdPointsPrefetcher(const UsdPointsPrefetcher&) = delete;
+    UsdPointsPrefetcher& operator=(const UsdPointsPrefetcher&) = delete;
+
+    // Points at `time`; moves the prefetch window to start there.
+    bool get(pxr::UsdTimeCode time, pxr::VtArray<pxr::GfVec3f>& points);
+
+    // Stops and joins the background thread.
+    void stop();
+    bool stopped() const
+    {
+        return stopped_;
+    }
+
+    const pxr::UsdStageRefPtr& stage() const
+    {
+        return stage_;
+    }
+    const pxr::UsdAttribute& attribute() const
+    {
+        return attribute_;
+    }
+    size_t capacity() const
+    {
+        return slots_.size();
+    }
+    // Requests answered from the ring and read directly.
+    size_t hits() const
+    {
+        return hits_;
+    }
+    size_t misses() const
+    {
+        return misses_;
+    }
+
+   private:
+    struct Slot {
+        // Index into samples_ of the held sample, or -1.
+        ptrdiff_t sample = -1;
+        pxr::VtArray<pxr::GfVec3f> points;
+    };
+
+    void run();
+
+    pxr::UsdStageRefPtr stage_;
+    pxr::UsdAttribute attribute_;
+    std::vector<double> samples_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<Slot> slots_;
+    // First sample of the window.
+    ptrdiff_t cursor_ = 0;
+    bool stop_ = false;
+    std::thread thread_;
+    std::atomic<bool> stopped_ = false;
+
+    std::atomic<size_t> hits_ = 0;
+    std::atomic<size_t> misses_ = 0;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
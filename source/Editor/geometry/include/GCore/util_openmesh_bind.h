@@ -10,6 +10,9 @@ USTC_CG_NAMESPACE_OPEN_SCOPE
 using PolyMesh = OpenMesh::PolyMesh_ArrayKernelT<>;
 using TriMesh = OpenMesh::TriMesh_ArrayKernelT<>;
 
+// The operand_to_openmesh* conversions return nullptr and log a warning if
+// the face counts or indices of the mesh are invalid.
+
 GEOMETRY_API std::shared_ptr<PolyMesh> operand_to_openmesh(
     Geometry* mesh_oeprand);
 
@@ -0,0 +1,86 @@
+#include "GCore/mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path)
+{
+    std::shared_ptr<MappedFile> mapped(new MappedFile);
+#ifdef _WIN32
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    mapped->file_ = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        return nullptr;
+    }
+    mapped->mapping_ =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapped->mapping_) {
+        return nullptr;
+    }
+    mapped->data_ = static_cast<const char*>(
+        MapViewOfFile(mapped->mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!mapped->data_) {
+        return nullptr;
+    }
+    mapped->size_ = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    mapped->data_ = static_cast<const char*>(data);
+    mapped->size_ = static_cast<size_t>(st.st_size);
+#endif
+    return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_) {
+        CloseHandle(file_);
+    }
+#else
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,1067 @@
+#include "GCore/mesh_stream.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "GCore/obj_io.h"
+#include "Logger/Logger.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string extension(const std::string& path)
+{
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+        return char(std::tolower(c));
+    });
+    return ext;
+}
+
+// Sequential read access to a file through a window of bounded size.
+class InputWindow {
+   public:
+    ~InputWindow()
+    {
+        if (file_) {
+            std::fclose(file_);
+        }
+    }
+
+    bool open(const std::string& path)
+    {
+        file_ = std::fopen(path.c_str(), "rb");
+        return file_ != nullptr;
+    }
+
+    // Makes at least `bytes` bytes available, fewer only at the end of the
+    // file. Returns false on read errors.
+    bool fill(size_t bytes)
+    {
+        if (size() >= bytes || eof_) {
+            return true;
+        }
+        if (begin_ > 0) {
+            std::memmove(data_.data(), data_.data() + begin_, size());
+            end_ -= begin_;
+            begin_ = 0;
+        }
+        if (data_.size() < bytes) {
+            data_.resize(bytes);
+        }
+        while (end_ < bytes && !eof_) {
+            end_ += std::fread(
+                data_.data() + end_, 1, data_.size() - end_, file_);
+            if (std::ferror(file_)) {
+                return false;
+            }
+            eof_ = std::feof(file_) != 0;
+        }
+        return true;
+    }
+
+    const char* begin() const
+    {
+        return data_.data() + begin_;
+    }
+    const char* end() const
+    {
+        return data_.data() + end_;
+    }
+    size_t size() const
+    {
+        return end_ - begin_;
+    }
+    // True once the window holds the rest of the file.
+    bool at_end_of_file() const
+    {
+        return eof_;
+    }
+    // Offset of begin() in the file.
+    size_t offset() const
+    {
+        return consumed_;
+    }
+
+    void consume(size_t bytes)
+    {
+        begin_ += bytes;
+        consumed_ += bytes;
+    }
+
+    // Returns `bytes` bytes and consumes them, or nullptr if the file ends
+    // before. The pointer is valid until the next call.
+    const char* take(size_t bytes)
+    {
+        if (size() < bytes && (!fill(bytes) || size() < bytes)) {
+            return nullptr;
+        }
+        const char* p = begin();
+        consume(bytes);
+        return p;
+    }
+
+    // The next line without its line break, consumed. False at the end of
+    // the file.
+    bool line(const char*& first, const char*& last)
+    {
+        size_t scanned = 0;
+        while (true) {
+            auto newline = size() > scanned
+                               ? static_cast<const char*>(std::memchr(
+                                     begin() + scanned,
+                                     '\n',
+                                     size() - scanned))
+                               : nullptr;
+            if (newline) {
+                first = begin();
+                last = newline;
+                consume(newline - first + 1);
+                break;
+            }
+            if (eof_) {
+                if (size() == 0) {
+                    return false;
+                }
+                first = begin();
+                last = end();
+                consume(size());
+                break;
+            }
+            scanned = size();
+            if (!fill(std::max<size_t>(2 * size(), 1 << 16))) {
+                return false;
+            }
+        }
+        if (last > first && last[-1] == '\r') {
+            --last;
+        }
+        return true;
+    }
+
+   private:
+    std::FILE* file_ = nullptr;
+    std::vector<char> data_;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    size_t consumed_ = 0;
+    bool eof_ = false;
+};
+
+enum class PlyType {
+    None,
+    Int8,
+    Uint8,
+    Int16,
+    Uint16,
+    Int32,
+    Uint32,
+    Float32,
+    Float64,
+};
+
+PlyType ply_type(const std::string& name)
+{
+    if (name == "char" || name == "int8") {
+        return PlyType::Int8;
+    }
+    if (name == "uchar" || name == "uint8") {
+        return PlyType::Uint8;
+    }
+    if (name == "short" || name == "int16") {
+        return PlyType::Int16;
+    }
+    if (name == "ushort" || name == "uint16") {
+        return PlyType::Uint16;
+    }
+    if (name == "int" || name == "int32") {
+        return PlyType::Int32;
+    }
+    if (name == "uint" || name == "uint32") {
+        return PlyType::Uint32;
+    }
+    if (name == "float" || name == "float32") {
+        return PlyType::Float32;
+    }
+    if (name == "double" || name == "float64") {
+        return PlyType::Float64;
+    }
+    return PlyType::None;
+}
+
+size_t ply_size(PlyType type)
+{
+    switch (type) {
+        case PlyType::Int8:
+        case PlyType::Uint8: return 1;
+        case PlyType::Int16:
+        case PlyType::Uint16: return 2;
+        case PlyType::Int32:
+        case PlyType::Uint32:
+        case PlyType::Float32: return 4;
+        case PlyType::Float64: return 8;
+        case PlyType::None: break;
+    }
+    return 0;
+}
+
+// Little-endian binary value of the given type.
+double ply_value(PlyType type, const char* p)
+{
+    auto load = [p](auto value) {
+        std::memcpy(&value, p, sizeof(value));
+        return double(value);
+    };
+    switch (type) {
+        case PlyType::Int8: return load(int8_t());
+        case PlyType::Uint8: return load(uint8_t());
+        case PlyType::Int16: return load(int16_t());
+        case PlyType::Uint16: return load(uint16_t());
+        case PlyType::Int32: return load(int32_t());
+        case PlyType::Uint32: return load(uint32_t());
+        case PlyType::Float32: return load(float());
+        case PlyType::Float64: return load(double());
+        case PlyType::None: break;
+    }
+    return 0.0;
+}
+
+// Where a vertex property goes in a batch.
+enum class Slot { None, X, Y, Z, Red, Green, Blue, Scalar };
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::None;
+    // Type of the element count for list properties.
+    PlyType count_type = PlyType::None;
+    Slot slot = Slot::None;
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+};
+
+}  // namespace
+
+class MeshStreamReader::Format {
+   public:
+    virtual ~Format() = default;
+    virtual bool open(const std::string& path) = 0;
+    // False at the end; sets `failed` on errors.
+    virtual bool next(MeshBatch& batch, bool& failed) = 0;
+
+    size_t batch_bytes = 0;
+};
+
+namespace {
+
+class ObjStreamFormat : public MeshStreamReader::Format {
+   public:
+    bool open(const std::string& path) override
+    {
+        path_ = path;
+        if (!window_.open(path)) {
+            log::warning("Cannot open OBJ file %s", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool next(MeshBatch& batch, bool& failed) override
+    {
+        size_t wanted = batch_bytes;
+        const char* cut = nullptr;
+        while (true) {
+            if (!window_.fill(wanted)) {
+                log::warning("Failed to read %s", path_.c_str());
+                failed = true;
+                return false;
+            }
+            if (window_.size() == 0) {
+                return false;
+            }
+            if (window_.at_end_of_file()) {
+                cut = window_.end();
+                break;
+            }
+            // Stop after the last complete line.
+            for (const char* p = window_.end(); p > window_.begin(); --p) {
+                if (p[-1] == '\n') {
+                    cut = p;
+                    break;
+                }
+            }
+            if (cut) {
+                break;
+            }
+            wanted = 2 * window_.size();
+        }
+
+        const char* error = nullptr;
+        if (!parse_obj_batch(window_.begin(), cut, counts_, batch, &error)) {
+            log::warning(
+                "Malformed OBJ statement in %s at byte %zu",
+                path_.c_str(),
+                window_.offset() + size_t(error - window_.begin()));
+            failed = true;
+            return false;
+        }
+        window_.consume(cut - window_.begin());
+        return true;
+    }
+
+   private:
+    std::string path_;
+    InputWindow window_;
+    ObjCounts counts_;
+};
+
+class PlyStreamFormat : public MeshStreamReader::Format {
+   public:
+    bool open(const std::string& path) override
+    {
+        path_ = path;
+        if (!window_.open(path)) {
+            log::warning("Cannot open PLY file %s", path.c_str());
+            return false;
+        }
+        if (!parse_header()) {
+            log::warning(
+                "Unsupported or malformed PLY header in %s", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool next(MeshBatch& batch, bool& failed) override
+    {
+        batch.first_vertex = vertices_;
+        batch.first_face = faces_;
+        batch.positions.clear();
+        batch.colors.clear();
+        batch.scalars.clear();
+        batch.face_vertex_counts.clear();
+        batch.face_vertex_indices.clear();
+
+        while (element_ < elements_.size()) {
+            const PlyElement& element = elements_[element_];
+            if (remaining_ == 0) {
+                if (++element_ < elements_.size()) {
+                    remaining_ = elements_[element_].count;
+                }
+                continue;
+            }
+            bool ok;
+            if (element.name == "vertex") {
+                ok = read_vertices(element, batch);
+            }
+            else if (element.name == "face") {
+                ok = read_faces(element, batch);
+            }
+            else {
+                ok = skip(element);
+                if (ok) {
+                    continue;
+                }
+            }
+            if (!ok) {
+                log::warning(
+                    "Malformed or truncated PLY element %s in %s",
+                    element.name.c_str(),
+                    path_.c_str());
+                failed = true;
+                return false;
+            }
+            return true;
+        }
+        return false;
+    }
+
+   private:
+    bool parse_header()
+    {
+        const char* first;
+        const char* last;
+        if (!window_.line(first, last) || std::string(first, last) != "ply") {
+            return false;
+        }
+        while (window_.line(first, last)) {
+            std::vector<std::string> words;
+            for (const char* p = first; p < last;) {
+                while (p < last && (*p == ' ' || *p == '\t')) {
+                    ++p;
+                }
+                const char* word = p;
+                while (p < last && *p != ' ' && *p != '\t') {
+                    ++p;
+                }
+                if (p > word) {
+                    words.emplace_back(word, p);
+                }
+            }
+            if (words.empty() || words[0] == "comment" ||
+                words[0] == "obj_info") {
+                continue;
+            }
+            if (words[0] == "end_header") {
+                if (elements_.empty()) {
+                    return false;
+                }
+                // Vertices are read in batches sized by their fixed record
+                // length, which needs at least one property and no lists.
+                for (const PlyElement& element : elements_) {
+                    if (element.name != "vertex") {
+                        continue;
+                    }
+                    if (element.properties.empty()) {
+                        return false;
+                    }
+                    for (const PlyProperty& property : element.properties) {
+                        if (property.count_type != PlyType::None) {
+                            return false;
+                        }
+                    }
+                }
+                remaining_ = elements_[0].count;
+                return true;
+            }
+            if (words[0] == "format" && words.size() >= 2) {
+                if (words[1] == "ascii") {
+                    binary_ = false;
+                }
+                else if (
+                    words[1] == "binary_little_endian" &&
+                    std::endian::native == std::endian::little) {
+                    binary_ = true;
+                }
+                else {
+                    return false;
+                }
+            }
+            else if (words[0] == "element" && words.size() == 3) {
+                PlyElement element;
+                element.name = words[1];
+                if (std::from_chars(
+                        words[2].data(),
+                        words[2].data() + words[2].size(),
+                        element.count)
+                        .ec != std::errc()) {
+                    return false;
+                }
+                elements_.push_back(std::move(element));
+            }
+            else if (
+                words[0] == "property" && !elements_.empty() &&
+                words.size() >= 3) {
+                PlyProperty property;
+                if (words[1] == "list" && words.size() == 5) {
+                    property.count_type = ply_type(words[2]);
+                    property.type = ply_type(words[3]);
+                    property.name = words[4];
+                    if (property.count_type == PlyType::None) {
+                        return false;
+                    }
+                }
+                else {
+                    property.type = ply_type(words[1]);
+                    property.name = words[2];
+                }
+                if (property.type == PlyType::None) {
+                    return false;
+                }
+                property.slot = slot(elements_.back().name, property);
+                elements_.back().properties.push_back(property);
+            }
+            else {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    static Slot slot(const std::string& element, const PlyProperty& property)
+    {
+        if (element != "vertex" || property.count_type != PlyType::None) {
+            return Slot::None;
+        }
+        const std::string& name = property.name;
+        return name == "x"                           ? Slot::X
+               : name == "y"                         ? Slot::Y
+               : name == "z"                         ? Slot::Z
+               : name == "red"                       ? Slot::Red
+               : name == "green"                     ? Slot::Green
+               : name == "blue"                      ? Slot::Blue
+               : name == "quality" || name == "scalar" ? Slot::Scalar
+                                                     : Slot::None;
+    }
+
+    // Reads the values of one record into `values`, lists flattened after
+    // their count.
+    bool read_record(const PlyElement& element, std::vector<double>& values)
+    {
+        values.clear();
+        if (binary_) {
+            for (const PlyProperty& property : element.properties) {
+                size_t count = 1;
+                if (property.count_type != PlyType::None) {
+                    const char* p = window_.take(ply_size(property.count_type));
+                    if (!p) {
+                        return false;
+                    }
+                    const double n = ply_value(property.count_type, p);
+                    if (n < 0) {
+                        return false;
+                    }
+                    count = size_t(n);
+                    values.push_back(n);
+                }
+                const size_t size = ply_size(property.type);
+                const char* p = window_.take(count * size);
+                if (!p) {
+                    return false;
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    values.push_back(ply_value(property.type, p + i * size));
+                }
+            }
+            return true;
+        }
+
+        const char* first;
+        const char* last;
+        if (!window_.line(first, last)) {
+            return false;
+        }
+        auto token = [&](double& value) {
+            while (first < last && (*first == ' ' || *first == '\t')) {
+                ++first;
+            }
+            auto [next, error] = std::from_chars(first, last, value);
+            first = next;
+            return error == std::errc();
+        };
+        for (const PlyProperty& property : element.properties) {
+            double value;
+            if (!token(value)) {
+                return false;
+            }
+            values.push_back(value);
+            if (property.count_type != PlyType::None) {
+                if (value < 0) {
+                    return false;
+                }
+                for (size_t i = 0, n = size_t(value); i < n; ++i) {
+                    if (!token(value)) {
+                        return false;
+                    }
+                    values.push_back(value);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool read_vertices(const PlyElement& element, MeshBatch& batch)
+    {
+        bool has_color = false;
+        bool has_scalar = false;
+        bool byte_color = false;
+        size_t record_bytes = 0;
+        for (const PlyProperty& property : element.properties) {
+            has_color |= property.slot == Slot::Red;
+            has_scalar |= property.slot == Slot::Scalar;
+            byte_color |= property.slot == Slot::Red &&
+                          property.type == PlyType::Uint8;
+            record_bytes += ply_size(property.type);
+        }
+        const size_t count = std::min(
+            remaining_, std::max<size_t>(batch_bytes / record_bytes, 1));
+        batch.positions.resize(count);
+        if (has_color) {
+            batch.colors.resize(count);
+        }
+        if (has_scalar) {
+            batch.scalars.resize(count);
+        }
+        const double color_scale = byte_color ? 1.0 / 255.0 : 1.0;
+        std::vector<double> values;
+        for (size_t v = 0; v < count; ++v) {
+            if (!read_record(element, values)) {
+                return false;
+            }
+            for (size_t i = 0; i < element.properties.size(); ++i) {
+                const double value = values[i];
+                switch (element.properties[i].slot) {
+                    case Slot::X: batch.positions[v][0] = float(value); break;
+                    case Slot::Y: batch.positions[v][1] = float(value); break;
+                    case Slot::Z: batch.positions[v][2] = float(value); break;
+                    case Slot::Red:
+                        batch.colors[v][0] = float(value * color_scale);
+                        break;
+                    case Slot::Green:
+                        batch.colors[v][1] = float(value * color_scale);
+                        break;
+                    case Slot::Blue:
+                        batch.colors[v][2] = float(value * color_scale);
+                        break;
+                    case Slot::Scalar: batch.scalars[v] = float(value); break;
+                    case Slot::None: break;
+                }
+            }
+        }
+        remaining_ -= count;
+        vertices_ += count;
+        return true;
+    }
+
+    bool read_faces(const PlyElement& element, MeshBatch& batch)
+    {
+        size_t list = element.properties.size();
+        for (size_t i = 0; i < element.properties.size(); ++i) {
+            const std::string& name = element.properties[i].name;
+            if (element.properties[i].count_type != PlyType::None &&
+                (name == "vertex_indices" || name == "vertex_index")) {
+                list = i;
+            }
+        }
+        if (list == element.properties.size()) {
+            return false;
+        }
+        const size_t count =
+            std::min(remaining_, std::max<size_t>(batch_bytes / 16, 1));
+        batch.face_vertex_counts.reserve(count);
+        batch.face_vertex_indices.reserve(3 * count);
+        std::vector<double> values;
+        for (size_t f = 0; f < count; ++f) {
+            if (!read_record(element, values)) {
+                return false;
+            }
+            // Position of the list among the flattened values.
+            size_t at = 0;
+            for (size_t i = 0; i < list; ++i) {
+                at += element.properties[i].count_type != PlyType::None
+                          ? size_t(values[at]) + 1
+                          : 1;
+            }
+            const size_t n = size_t(values[at]);
+            for (size_t i = 0; i < n; ++i) {
+                const double index = values[at + 1 + i];
+                if (index < 0 || index >= double(INT32_MAX)) {
+                    return false;
+                }
+                batch.face_vertex_indices.push_back(int(index));
+            }
+            batch.face_vertex_counts.push_back(int(n));
+        }
+        remaining_ -= count;
+        faces_ += count;
+        return true;
+    }
+
+    bool skip(const PlyElement& element)
+    {
+        std::vector<double> values;
+        for (; remaining_ > 0; --remaining_) {
+            if (!read_record(element, values)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string path_;
+    InputWindow window_;
+    bool binary_ = false;
+    std::vector<PlyElement> elements_;
+    size_t element_ = 0;
+    // Records left in the current element.
+    size_t remaining_ = 0;
+    size_t vertices_ = 0;
+    size_t faces_ = 0;
+};
+
+}  // namespace
+
+MeshStreamReader::MeshStreamReader() = default;
+MeshStreamReader::~MeshStreamReader() = default;
+
+bool MeshStreamReader::open(const std::string& path, size_t batch_bytes)
+{
+    failed_ = false;
+    const std::string ext = extension(path);
+    if (ext == ".obj") {
+        format_ = std::make_unique<ObjStreamFormat>();
+    }
+    else if (ext == ".ply") {
+        format_ = std::make_unique<PlyStreamFormat>();
+    }
+    else {
+        log::warning("Cannot stream %s: only OBJ and PLY are supported",
+                     path.c_str());
+        format_.reset();
+        return false;
+    }
+    format_->batch_bytes = std::max<size_t>(batch_bytes, 1 << 16);
+    if (!format_->open(path)) {
+        format_.reset();
+        return false;
+    }
+    return true;
+}
+
+bool MeshStreamReader::next(MeshBatch& batch)
+{
+    if (!format_ || failed_) {
+        return false;
+    }
+    return format_->next(batch, failed_);
+}
+
+class MeshStreamWriter::Format {
+   public:
+    virtual ~Format()
+    {
+        if (file) {
+            std::fclose(file);
+        }
+    }
+    virtual bool write(const MeshBatch& batch) = 0;
+    virtual bool close() = 0;
+
+    bool put(const std::string& bytes)
+    {
+        return std::fwrite(bytes.data(), 1, bytes.size(), file) ==
+               bytes.size();
+    }
+
+    std::string path;
+    std::FILE* file = nullptr;
+};
+
+namespace {
+
+void append_float(std::string& out, float value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void append_int(std::string& out, long long value)
+{
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+class ObjWriteFormat : public MeshStreamWriter::Format {
+   public:
+    bool write(const MeshBatch& batch) override
+    {
+        std::string out;
+        out.reserve(
+            32 * batch.positions.size() +
+            8 * batch.face_vertex_indices.size());
+        const bool colors = batch.colors.size() == batch.positions.size();
+        for (size_t v = 0; v < batch.positions.size(); ++v) {
+            out += 'v';
+            for (int k = 0; k < 3; ++k) {
+                out += ' ';
+                append_float(out, batch.positions[v][k]);
+            }
+            for (int k = 0; colors && k < 3; ++k) {
+                out += ' ';
+                append_float(out, batch.colors[v][k]);
+            }
+            out += '\n';
+        }
+        size_t corner = 0;
+        for (int count : batch.face_vertex_counts) {
+            out += 'f';
+            for (int i = 0; i < count; ++i) {
+                out += ' ';
+                append_int(out, batch.face_vertex_indices[corner++] + 1ll);
+            }
+            out += '\n';
+        }
+        return put(out);
+    }
+
+    bool close() override
+    {
+        const bool ok = std::fclose(file) == 0;
+        file = nullptr;
+        return ok;
+    }
+};
+
+// Binary little-endian PLY. The header is written with the first vertices,
+// with the element counts padded so they can be patched in place.
+class PlyWriteFormat : public MeshStreamWriter::Format {
+    // Positions, scalars and indices are copied in host byte order.
+    static_assert(
+        std::endian::native == std::endian::little,
+        "PlyWriteFormat writes binary_little_endian without swapping");
+
+   public:
+    ~PlyWriteFormat() override
+    {
+        if (spool_) {
+            std::fclose(spool_);
+            std::remove(spool_path_.c_str());
+        }
+    }
+
+    bool write(const MeshBatch& batch) override
+    {
+        if (!batch.positions.empty() && !header_written_) {
+            colors_ = batch.colors.size() == batch.positions.size();
+            scalars_ = batch.scalars.size() == batch.positions.size();
+            if (!write_header()) {
+                return false;
+            }
+        }
+        if (!batch.positions.empty()) {
+            const bool colors =
+                batch.colors.size() == batch.positions.size();
+            const bool scalars =
+                batch.scalars.size() == batch.positions.size();
+            std::string out;
+            out.reserve(batch.positions.size() * 19);
+            for (size_t v = 0; v < batch.positions.size(); ++v) {
+                out.append(
+                    reinterpret_cast<const char*>(batch.positions[v].data()),
+                    3 * sizeof(float));
+                for (int k = 0; colors_ && k < 3; ++k) {
+                    const float c = colors ? batch.colors[v][k] : 0.0f;
+                    out += char(uint8_t(
+                        std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f));
+                }
+                if (scalars_) {
+                    const float s = scalars ? batch.scalars[v] : 0.0f;
+                    out.append(reinterpret_cast<const char*>(&s), sizeof(s));
+                }
+            }
+            if (!put(out)) {
+                return false;
+            }
+            vertices_ += batch.positions.size();
+        }
+
+        if (!batch.face_vertex_counts.empty()) {
+            if (!spool_) {
+                spool_path_ = path + ".faces";
+                spool_ = std::fopen(spool_path_.c_str(), "wb+");
+                if (!spool_) {
+                    return false;
+                }
+            }
+            std::string out;
+            out.reserve(
+                batch.face_vertex_counts.size() +
+                4 * batch.face_vertex_indices.size());
+            size_t corner = 0;
+            for (int count : batch.face_vertex_counts) {
+                if (count > 255) {
+                    return false;
+                }
+                out += char(uint8_t(count));
+                out.append(
+                    reinterpret_cast<const char*>(
+                        batch.face_vertex_indices.data() + corner),
+                    count * sizeof(int));
+                corner += count;
+            }
+            if (std::fwrite(out.data(), 1, out.size(), spool_) !=
+                out.size()) {
+                return false;
+            }
+            faces_ += batch.face_vertex_counts.size();
+        }
+        return true;
+    }
+
+    bool close() override
+    {
+        if (!header_written_ && !write_header()) {
+            return false;
+        }
+        if (spool_) {
+            std::rewind(spool_);
+            std::vector<char> buffer(size_t(1) << 20);
+            size_t read;
+            while ((read = std::fread(
+                        buffer.data(), 1, buffer.size(), spool_)) > 0) {
+                if (std::fwrite(buffer.data(), 1, read, file) != read) {
+                    return false;
+                }
+            }
+            if (std::ferror(spool_)) {
+                return false;
+            }
+        }
+        if (!patch_count(vertex_count_at_, vertices_) ||
+            !patch_count(face_count_at_, faces_)) {
+            return false;
+        }
+        const bool ok = std::fclose(file) == 0;
+        file = nullptr;
+        return ok;
+    }
+
+   private:
+    static constexpr int kCountWidth = 20;
+
+    bool write_header()
+    {
+        std::string header =
+            "ply\nformat binary_little_endian 1.0\nelement vertex ";
+        vertex_count_at_ = header.size();
+        header += std::string(kCountWidth, ' ') +
+                  "\nproperty float x\nproperty float y\nproperty float z\n";
+        if (colors_) {
+            header +=
+                "property uchar red\nproperty uchar green\n"
+                "property uchar blue\n";
+        }
+        if (scalars_) {
+            header += "property float quality\n";
+        }
+        header += "element face ";
+        face_count_at_ = header.size();
+        header += std::string(kCountWidth, ' ') +
+                  "\nproperty list uchar int vertex_indices\nend_header\n";
+        header_written_ = true;
+        return put(header);
+    }
+
+    // Writes the number left-aligned into its padded field; readers split
+    // header lines on whitespace.
+    bool patch_count(size_t at, size_t count)
+    {
+        const std::string text = std::to_string(count);
+        return std::fseek(file, long(at), SEEK_SET) == 0 &&
+               std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    }
+
+    bool header_written_ = false;
+    bool colors_ = false;
+    bool scalars_ = false;
+    size_t vertex_count_at_ = 0;
+    size_t face_count_at_ = 0;
+    size_t vertices_ = 0;
+    size_t faces_ = 0;
+    std::string spool_path_;
+    std::FILE* spool_ = nullptr;
+};
+
+}  // namespace
+
+MeshStreamWriter::MeshStreamWriter() = default;
+MeshStreamWriter::~MeshStreamWriter() = default;
+
+bool MeshStreamWriter::open(const std::string& path)
+{
+    const std::string ext = extension(path);
+    if (ext == ".obj") {
+        format_ = std::make_unique<ObjWriteFormat>();
+    }
+    else if (ext == ".ply") {
+        format_ = std::make_unique<PlyWriteFormat>();
+    }
+    else {
+        log::warning("Cannot stream to %s: only OBJ and PLY are supported",
+                     path.c_str());
+        format_.reset();
+        return false;
+    }
+    format_->path = path;
+    format_->file = std::fopen(path.c_str(), "wb");
+    if (!format_->file) {
+        log::warning("Cannot open %s for writing", path.c_str());
+        format_.reset();
+        return false;
+    }
+    return true;
+}
+
+bool MeshStreamWriter::write(const MeshBatch& batch)
+{
+    if (!format_ || !format_->write(batch)) {
+        log::warning("Failed to write to %s",
+                     format_ ? format_->path.c_str() : "closed stream");
+        return false;
+    }
+    return true;
+}
+
+bool MeshStreamWriter::close()
+{
+    if (!format_) {
+        return false;
+    }
+    const bool ok = format_->close();
+    if (!ok) {
+        log::warning("Failed to finish %s", format_->path.c_str());
+    }
+    format_.reset();
+    return ok;
+}
+
+bool stream_mesh(
+    const std::string& input,
+    const std::string& output,
+    const std::function<bool(MeshBatch&)>& process,
+    MeshStreamStats* stats,
+    size_t batch_bytes)
+{
+    const auto start = Clock::now();
+    MeshStreamReader reader;
+    MeshStreamWriter writer;
+    if (!reader.open(input, batch_bytes) || !writer.open(output)) {
+        return false;
+    }
+
+    MeshStreamStats local;
+    MeshBatch batch;
+    while (reader.next(batch)) {
+        if (process && !process(batch)) {
+            return false;
+        }
+        if (!writer.write(batch)) {
+            return false;
+        }
+        local.vertices += batch.positions.size();
+        local.faces += batch.face_vertex_counts.size();
+        ++local.batches;
+    }
+    if (reader.failed() || !writer.close()) {
+        return false;
+    }
+    local.seconds = seconds_since(start);
+    if (stats) {
+        *stats = local;
+    }
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,710 @@
+#include "GCore/obj_io.h"
+
+#include <pxr/base/gf/vec2f.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/mapped_file.h"
+#include "Logger/Logger.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr size_t kChunkSize = size_t(1) << 22;
+constexpr size_t kParallelGrain = 1 << 14;
+
+// Powers of ten that are exact in a double.
+constexpr double kPow10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                              1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                              1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                              1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// Fraction bits of a double below the 23 of a float, and the pattern of a
+// double exactly halfway between two floats. The fast path only produces
+// values in the normal float range.
+constexpr uint64_t kBelowFloat = (uint64_t(1) << 29) - 1;
+constexpr uint64_t kHalfFloat = uint64_t(1) << 28;
+
+enum class Statement { Other, Position, Texcoord, Normal, Face };
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    ObjCounts counts;
+    // Elements before the chunk, including those before the parsed range.
+    ObjCounts offsets;
+    bool corner_texcoords = false;
+    bool corner_normals = false;
+    // Set while parsing if a position has a color.
+    bool colors = false;
+    // Start of the first line that failed to parse.
+    const char* error = nullptr;
+};
+
+bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool is_digit(char c)
+{
+    return unsigned(c - '0') < 10;
+}
+
+const char* skip_blanks(const char* p, const char* end)
+{
+    while (p < end && is_blank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char* line_end(const char* p, const char* end)
+{
+    auto newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return newline ? newline : end;
+}
+
+// Classifies the line starting at p and advances p past its keyword.
+Statement statement(const char*& p, const char* end)
+{
+    p = skip_blanks(p, end);
+    if (end - p < 2) {
+        return Statement::Other;
+    }
+    if (p[0] == 'f' && is_blank(p[1])) {
+        p += 2;
+        return Statement::Face;
+    }
+    if (p[0] != 'v') {
+        return Statement::Other;
+    }
+    if (is_blank(p[1])) {
+        p += 2;
+        return Statement::Position;
+    }
+    if (end - p < 3 || !is_blank(p[2])) {
+        return Statement::Other;
+    }
+    p += 3;
+    return p[-2] == 't'   ? Statement::Texcoord
+           : p[-2] == 'n' ? Statement::Normal
+                          : Statement::Other;
+}
+
+// Value of eight ASCII digits at p, read as one little-endian word, or false
+// if any of them is not a digit.
+bool parse_eight_digits(const char* p, uint64_t& value)
+{
+    if constexpr (std::endian::native != std::endian::little) {
+        return false;
+    }
+    uint64_t word;
+    std::memcpy(&word, p, 8);
+    if (((word & 0xF0F0F0F0F0F0F0F0) |
+         (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) !=
+        0x3333333333333333) {
+        return false;
+    }
+    word -= 0x3030303030303030;
+    word = word * 10 + (word >> 8);
+    word = ((word & 0x000000FF000000FF) * (100 + (1000000ull << 32)) +
+            ((word >> 16) & 0x000000FF000000FF) * (1 + (10000ull << 32))) >>
+           32;
+    value = uint32_t(word);
+    return true;
+}
+
+// Parses a decimal number at p. Numbers with at most 19 significant digits
+// and a small exponent, i.e. practically all OBJ coordinates, are first
+// rounded to double, which is exact for them. Rounding that double to float
+// gives the correctly rounded float unless the double lies exactly halfway
+// between two floats; those, and all other numbers including inf and nan,
+// go through from_chars.
+const char* parse_float(const char* p, const char* end, float& value)
+{
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any_digit = false;
+    while (p < end && is_digit(*p)) {
+        mantissa = mantissa * 10 + uint64_t(*p - '0');
+        digits += mantissa != 0;
+        any_digit = true;
+        ++p;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        uint64_t eight;
+        while (end - p >= 8 && digits <= 11 && parse_eight_digits(p, eight)) {
+            mantissa = mantissa * 100000000 + eight;
+            digits += mantissa != 0 ? 8 : 0;
+            exponent -= 8;
+            any_digit = true;
+            p += 8;
+        }
+        while (p < end && is_digit(*p)) {
+            mantissa = mantissa * 10 + uint64_t(*p - '0');
+            digits += mantissa != 0;
+            --exponent;
+            any_digit = true;
+            ++p;
+        }
+    }
+    if (any_digit && p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negative_exponent = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            negative_exponent = *q == '-';
+            ++q;
+        }
+        if (q < end && is_digit(*q)) {
+            int e = 0;
+            while (q < end && is_digit(*q)) {
+                e = std::min(e * 10 + (*q - '0'), 10000);
+                ++q;
+            }
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+
+    if (any_digit && digits <= 19 && mantissa <= (uint64_t(1) << 53) &&
+        exponent >= -22 && exponent <= 22) {
+        double v = double(mantissa);
+        v = exponent < 0 ? v / kPow10[-exponent] : v * kPow10[exponent];
+        const uint64_t below_float = std::bit_cast<uint64_t>(v) & kBelowFloat;
+        if (below_float != kHalfFloat) {
+            value = float(negative ? -v : v);
+            return p;
+        }
+    }
+    if (*start == '+') {
+        ++start;
+    }
+    auto [next, error] = std::from_chars(start, end, value);
+    return error == std::errc() ? next : nullptr;
+}
+
+// Parses a possibly negative integer at p.
+const char* parse_int(const char* p, const char* end, int64_t& value)
+{
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    if (p == end || !is_digit(*p)) {
+        return nullptr;
+    }
+    int64_t v = 0;
+    while (p < end && is_digit(*p)) {
+        v = std::min<int64_t>(v * 10 + (*p - '0'), int64_t(1) << 40);
+        ++p;
+    }
+    value = negative ? -v : v;
+    return p;
+}
+
+// End of a token: the next character has to separate it from the next one.
+bool at_separator(const char* p, const char* end)
+{
+    return p == end || is_blank(*p) || *p == '#';
+}
+
+// Zero-based index of an OBJ reference, or -1 if it is zero or out of range.
+int resolve(int64_t index, size_t before, size_t total)
+{
+    const int64_t resolved = index > 0 ? index - 1 : int64_t(before) + index;
+    return index != 0 && resolved >= 0 && resolved < int64_t(total)
+               ? int(resolved)
+               : -1;
+}
+
+void count_chunk(Chunk& chunk)
+{
+    ObjCounts& counts = chunk.counts;
+    for (const char* line = chunk.begin; line < chunk.end;) {
+        const char* end = line_end(line, chunk.end);
+        const char* p = line;
+        switch (statement(p, end)) {
+            case Statement::Position: ++counts.positions; break;
+            case Statement::Texcoord: ++counts.texcoords; break;
+            case Statement::Normal: ++counts.normals; break;
+            case Statement::Face:
+                ++counts.faces;
+                while (true) {
+                    p = skip_blanks(p, end);
+                    if (p == end || *p == '#') {
+                        break;
+                    }
+                    ++counts.corners;
+                    const char* token = p;
+                    while (p < end && !is_blank(*p)) {
+                        ++p;
+                    }
+                    auto slash = static_cast<const char*>(
+                        std::memchr(token, '/', p - token));
+                    if (slash) {
+                        chunk.corner_texcoords |=
+                            slash + 1 < p && slash[1] != '/';
+                        chunk.corner_normals |= std::memchr(
+                                                    slash + 1,
+                                                    '/',
+                                                    p - slash - 1) != nullptr;
+                    }
+                }
+                break;
+            case Statement::Other: break;
+        }
+        line = end + 1;
+    }
+}
+
+// Arrays for the elements after `base`; colors, texcoords and normals may be
+// null to skip them.
+struct Output {
+    pxr::GfVec3f* positions;
+    // One per position, left untouched for positions without a color.
+    pxr::GfVec3f* colors;
+    pxr::GfVec2f* texcoords;
+    pxr::GfVec3f* normals;
+    int* face_vertex_counts;
+    int* face_vertex_indices;
+    // Per corner, null if no face refers to texture coordinates or normals.
+    int* corner_texcoords;
+    int* corner_normals;
+    ObjCounts base;
+    // Elements up to the end of the parsed range, for checking indices.
+    ObjCounts totals;
+};
+
+// Parses the float components of a "v", "vt" or "vn" line into `values`;
+// components past `size` are ignored and missing optional ones are zero.
+// Returns the number of components present up to `size`, or -1 if the line
+// is malformed.
+int parse_components(
+    const char* p,
+    const char* end,
+    float* values,
+    int size,
+    int required)
+{
+    int present = 0;
+    for (int i = 0; i < size; ++i) {
+        p = skip_blanks(p, end);
+        if (p == end || *p == '#') {
+            if (i < required) {
+                return -1;
+            }
+            values[i] = 0.0f;
+            continue;
+        }
+        p = parse_float(p, end, values[i]);
+        if (!p || !at_separator(p, end)) {
+            return -1;
+        }
+        ++present;
+    }
+    return present;
+}
+
+bool parse_face(
+    const char* p,
+    const char* end,
+    const Chunk& chunk,
+    ObjCounts& local,
+    const Output& out)
+{
+    const size_t first =
+        chunk.offsets.corners + local.corners - out.base.corners;
+    size_t corner = first;
+    while (true) {
+        p = skip_blanks(p, end);
+        if (p == end || *p == '#') {
+            break;
+        }
+        int64_t index;
+        p = parse_int(p, end, index);
+        if (!p) {
+            return false;
+        }
+        const int position = resolve(
+            index,
+            chunk.offsets.positions + local.positions,
+            out.totals.positions);
+        if (position < 0) {
+            return false;
+        }
+        out.face_vertex_indices[corner] = position;
+
+        int texcoord = -1;
+        int normal = -1;
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') {
+                p = parse_int(p, end, index);
+                if (!p) {
+                    return false;
+                }
+                texcoord = resolve(
+                    index,
+                    chunk.offsets.texcoords + local.texcoords,
+                    out.totals.texcoords);
+                if (texcoord < 0) {
+                    return false;
+                }
+            }
+            if (p < end && *p == '/') {
+                p = parse_int(p + 1, end, index);
+                if (!p) {
+                    return false;
+                }
+                normal = resolve(
+                    index,
+                    chunk.offsets.normals + local.normals,
+                    out.totals.normals);
+                if (normal < 0) {
+                    return false;
+                }
+            }
+        }
+        if (!at_separator(p, end)) {
+            return false;
+        }
+        if (out.corner_texcoords) {
+            out.corner_texcoords[corner] = texcoord;
+        }
+        if (out.corner_normals) {
+            out.corner_normals[corner] = normal;
+        }
+        ++corner;
+    }
+    if (corner == first) {
+        return false;
+    }
+    out.face_vertex_counts
+        [chunk.offsets.faces + local.faces - out.base.faces] =
+            int(corner - first);
+    local.corners += corner - first;
+    ++local.faces;
+    return true;
+}
+
+void parse_chunk(Chunk& chunk, const Output& out)
+{
+    ObjCounts local;
+    const ObjCounts& base = out.base;
+    for (const char* line = chunk.begin; line < chunk.end;) {
+        const char* end = line_end(line, chunk.end);
+        const char* p = line;
+        bool ok = true;
+        switch (statement(p, end)) {
+            case Statement::Position: {
+                // x y z, optionally followed by a weight, which is dropped,
+                // or by an r g b color.
+                float values[6];
+                const int present = parse_components(p, end, values, 6, 3);
+                const size_t v =
+                    chunk.offsets.positions + local.positions - base.positions;
+                std::copy_n(values, 3, out.positions[v].data());
+                if (out.colors && present == 6) {
+                    out.colors[v] =
+                        pxr::GfVec3f(values[3], values[4], values[5]);
+                    chunk.colors = true;
+                }
+                ok = present >= 0;
+                ++local.positions;
+                break;
+            }
+            case Statement::Texcoord:
+                ok = !out.texcoords ||
+                     parse_components(
+                         p,
+                         end,
+                         out.texcoords
+                             [chunk.offsets.texcoords + local.texcoords -
+                              base.texcoords]
+                                 .data(),
+                         2,
+                         1) >= 0;
+                ++local.texcoords;
+                break;
+            case Statement::Normal:
+                ok = !out.normals ||
+                     parse_components(
+                         p,
+                         end,
+                         out.normals
+                             [chunk.offsets.normals + local.normals -
+                              base.normals]
+                                 .data(),
+                         3,
+                         3) >= 0;
+                ++local.normals;
+                break;
+            case Statement::Face:
+                ok = parse_face(p, end, chunk, local, out);
+                break;
+            case Statement::Other: break;
+        }
+        if (!ok) {
+            chunk.error = line;
+            return;
+        }
+        line = end + 1;
+    }
+}
+
+// Splits [begin, end) into chunks on line boundaries and counts their
+// elements in parallel. Returns the element counts up to `end`, starting
+// from `base`.
+ObjCounts count_chunks(
+    const char* begin,
+    const char* end,
+    const ObjCounts& base,
+    std::vector<Chunk>& chunks,
+    bool& corner_texcoords,
+    bool& corner_normals)
+{
+    // Chunks start after the newline that ends the previous one.
+    chunks.clear();
+    for (const char* p = begin; p < end;) {
+        const char* last = end;
+        if (size_t(end - p) > kChunkSize) {
+            last = std::min(line_end(p + kChunkSize, end) + 1, end);
+        }
+        chunks.push_back({ p, last });
+        p = last;
+    }
+
+    pxr::WorkParallelForN(
+        chunks.size(),
+        [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                count_chunk(chunks[i]);
+            }
+        },
+        1);
+
+    ObjCounts totals = base;
+    for (Chunk& chunk : chunks) {
+        chunk.offsets = totals;
+        totals.positions += chunk.counts.positions;
+        totals.texcoords += chunk.counts.texcoords;
+        totals.normals += chunk.counts.normals;
+        totals.faces += chunk.counts.faces;
+        totals.corners += chunk.counts.corners;
+        corner_texcoords |= chunk.corner_texcoords;
+        corner_normals |= chunk.corner_normals;
+    }
+    return totals;
+}
+
+// Parses the chunks in parallel. Returns the first line that failed, or
+// nullptr.
+const char* parse_chunks(std::vector<Chunk>& chunks, const Output& out)
+{
+    pxr::WorkParallelForN(
+        chunks.size(),
+        [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                parse_chunk(chunks[i], out);
+            }
+        },
+        1);
+    for (const Chunk& chunk : chunks) {
+        if (chunk.error) {
+            return chunk.error;
+        }
+    }
+    return nullptr;
+}
+
+bool any_colors(const std::vector<Chunk>& chunks)
+{
+    return std::any_of(chunks.begin(), chunks.end(), [](const Chunk& chunk) {
+        return chunk.colors;
+    });
+}
+
+// Values per vertex if there is one for each vertex and every corner refers
+// to the one of its vertex, values per corner otherwise.
+template<typename T>
+pxr::VtArray<T> to_primvar(
+    const pxr::VtArray<T>& values,
+    const std::vector<int>& corner_values,
+    const pxr::VtArray<int>& face_vertex_indices,
+    size_t vertex_count)
+{
+    const size_t corners = corner_values.size();
+    bool per_vertex = values.size() == vertex_count;
+    for (size_t c = 0; c < corners && per_vertex; ++c) {
+        per_vertex = corner_values[c] == face_vertex_indices[c];
+    }
+    if (per_vertex) {
+        return values;
+    }
+    pxr::VtArray<T> expanded(corners);
+    T* data = expanded.data();
+    pxr::WorkParallelForN(
+        corners,
+        [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                const int i = corner_values[c];
+                data[c] = i >= 0 ? values[i] : T(0.0f);
+            }
+        },
+        kParallelGrain);
+    return expanded;
+}
+
+}  // namespace
+
+bool read_obj(const std::string& path, Geometry& geometry)
+{
+    auto file = MappedFile::open(path);
+    if (!file) {
+        log::warning("Cannot map OBJ file %s", path.c_str());
+        return false;
+    }
+    const char* data = file->data();
+    const char* data_end = data + file->size();
+
+    std::vector<Chunk> chunks;
+    bool corner_texcoords = false;
+    bool corner_normals = false;
+    const ObjCounts totals = count_chunks(
+        data, data_end, {}, chunks, corner_texcoords, corner_normals);
+    if (totals.positions > size_t(INT32_MAX) ||
+        totals.corners > size_t(INT32_MAX)) {
+        log::warning(
+            "OBJ file %s is too large for 32-bit indices", path.c_str());
+        return false;
+    }
+
+    pxr::VtArray<pxr::GfVec3f> positions(totals.positions);
+    pxr::VtArray<pxr::GfVec3f> colors(totals.positions);
+    pxr::VtArray<pxr::GfVec2f> texcoords(totals.texcoords);
+    pxr::VtArray<pxr::GfVec3f> normals(totals.normals);
+    pxr::VtArray<int> face_vertex_counts(totals.faces);
+    pxr::VtArray<int> face_vertex_indices(totals.corners);
+    std::vector<int> texcoord_corners(
+        corner_texcoords && totals.texcoords ? totals.corners : 0);
+    std::vector<int> normal_corners(
+        corner_normals && totals.normals ? totals.corners : 0);
+
+    Output out = { positions.data(),
+                   colors.data(),
+                   texcoords.data(),
+                   normals.data(),
+                   face_vertex_counts.data(),
+                   face_vertex_indices.data(),
+                   texcoord_corners.empty() ? nullptr
+                                            : texcoord_corners.data(),
+                   normal_corners.empty() ? nullptr : normal_corners.data(),
+                   {},
+                   totals };
+    if (const char* error = parse_chunks(chunks, out)) {
+        const size_t line = std::count(data, error, '\n') + size_t(1);
+        log::warning(
+            "Malformed OBJ statement in %s at line %zu", path.c_str(), line);
+        return false;
+    }
+
+    auto mesh = std::make_shared<MeshComponent>(&geometry);
+    mesh->set_vertices(positions);
+    mesh->set_face_vertex_counts(face_vertex_counts);
+    mesh->set_face_vertex_indices(face_vertex_indices);
+    if (any_colors(chunks)) {
+        mesh->set_display_color(colors);
+    }
+    if (!texcoord_corners.empty()) {
+        mesh->set_texcoords_array(
+            to_primvar(
+                texcoords,
+                texcoord_corners,
+                face_vertex_indices,
+                positions.size()));
+    }
+    if (!normal_corners.empty()) {
+        mesh->set_normals(
+            to_primvar(
+                normals,
+                normal_corners,
+                face_vertex_indices,
+                positions.size()));
+    }
+    geometry.attach_component(mesh);
+    return true;
+}
+
+bool parse_obj_batch(
+    const char* begin,
+    const char* end,
+    ObjCounts& counts,
+    MeshBatch& batch,
+    const char** error)
+{
+    std::vector<Chunk> chunks;
+    bool corner_texcoords = false;
+    bool corner_normals = false;
+    const ObjCounts totals = count_chunks(
+        begin, end, counts, chunks, corner_texcoords, corner_normals);
+    if (totals.positions > size_t(INT32_MAX)) {
+        if (error) {
+            *error = begin;
+        }
+        return false;
+    }
+
+    batch.first_vertex = counts.positions;
+    batch.first_face = counts.faces;
+    batch.positions.resize(totals.positions - counts.positions);
+    batch.colors.assign(batch.positions.size(), pxr::GfVec3f(0.0f));
+    batch.scalars.clear();
+    batch.face_vertex_counts.resize(totals.faces - counts.faces);
+    batch.face_vertex_indices.resize(totals.corners - counts.corners);
+
+    Output out = { batch.positions.data(),
+                   batch.colors.data(),
+                   nullptr,
+                   nullptr,
+                   batch.face_vertex_counts.data(),
+                   batch.face_vertex_indices.data(),
+                   nullptr,
+                   nullptr,
+                   counts,
+                   totals };
+    const char* failed = parse_chunks(chunks, out);
+    if (failed) {
+        if (error) {
+            *error = failed;
+        }
+        return false;
+    }
+    if (!any_colors(chunks)) {
+        batch.colors.clear();
+    }
+    counts = totals;
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,257 @@
+#include "GCore/usd_cache.h"
+
+#include <pxr/usd/sdf/layer.h>
+#include <pxr/usd/usd/stageCache.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Stages kept for files nobody asked for recently. Evicted stages live on for
+// as long as callers hold them.
+constexpr size_t kMaxCachedStages = 16;
+
+struct CachedStage {
+    std::filesystem::file_time_type modified;
+    pxr::UsdStageCache::Id id;
+    // StageRegistry::clock when the stage was last handed out.
+    uint64_t used = 0;
+};
+
+struct StageRegistry {
+    std::mutex mutex;
+    pxr::UsdStageCache cache;
+    std::unordered_map<std::string, CachedStage> stages;
+    uint64_t clock = 0;
+    // Prefetchers with a running thread, stopped before a reload of one of
+    // their layers.
+    std::vector<UsdPointsPrefetcher*> prefetchers;
+};
+
+StageRegistry& stage_registry()
+{
+    static StageRegistry registry;
+    return registry;
+}
+
+// The cached stage of `path` if it was opened from the file as modified at
+// `modified`. Called with the registry locked.
+pxr::UsdStageRefPtr find_stage(
+    StageRegistry& registry,
+    const std::string& path,
+    std::filesystem::file_time_type modified)
+{
+    auto found = registry.stages.find(path);
+    if (found == registry.stages.end() || found->second.modified != modified) {
+        return nullptr;
+    }
+    auto stage = registry.cache.Find(found->second.id);
+    if (stage) {
+        found->second.used = ++registry.clock;
+    }
+    return stage;
+}
+
+void forget_stage(StageRegistry& registry, const std::string& path)
+{
+    auto found = registry.stages.find(path);
+    if (found != registry.stages.end()) {
+        registry.cache.Erase(found->second.id);
+        registry.stages.erase(found);
+    }
+}
+
+// Drops the least recently used stages beyond kMaxCachedStages.
+void evict_stages(StageRegistry& registry)
+{
+    while (registry.stages.size() > kMaxCachedStages) {
+        auto oldest = std::min_element(
+            registry.stages.begin(),
+            registry.stages.end(),
+            [](const auto& a, const auto& b) {
+                return a.second.used < b.second.used;
+            });
+        registry.cache.Erase(oldest->second.id);
+        registry.stages.erase(oldest);
+    }
+}
+
+bool shares_layers(
+    const pxr::UsdStageRefPtr& stage,
+    const pxr::SdfLayerHandleVector& layers)
+{
+    for (const pxr::SdfLayerHandle& layer : stage->GetUsedLayers()) {
+        if (std::find(layers.begin(), layers.end(), layer) != layers.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+pxr::UsdStageRefPtr open_cached_stage(const std::string& path)
+{
+    StageRegistry& registry = stage_registry();
+    std::error_code error;
+    const auto modified = std::filesystem::last_write_time(path, error);
+    if (error) {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        forget_stage(registry, path);
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (auto stage = find_stage(registry, path, modified)) {
+            return stage;
+        }
+    }
+
+    // Opening and composing is the slow part, so other files are looked up
+    // and opened meanwhile. Two threads may open the same file; the first to
+    // finish is cached.
+    auto stage = pxr::UsdStage::Open(path);
+    if (!stage) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (auto cached = find_stage(registry, path, modified)) {
+        return cached;
+    }
+    forget_stage(registry, path);
+
+    // Layers still held elsewhere (by another stage, or a caller of an older
+    // version of this one) are shared with the new stage and may be out of
+    // date. Reloading skips the unchanged ones, but must not run while a
+    // prefetcher thread reads from any of them.
+    const pxr::SdfLayerHandleVector layers = stage->GetUsedLayers();
+    std::erase_if(
+        registry.prefetchers, [&](UsdPointsPrefetcher* prefetcher) {
+            if (!shares_layers(prefetcher->stage(), layers)) {
+                return false;
+            }
+            prefetcher->stop();
+            return true;
+        });
+    stage->Reload();
+
+    registry.stages[path] = { modified,
+                              registry.cache.Insert(stage),
+                              ++registry.clock };
+    evict_stages(registry);
+    return stage;
+}
+
+UsdPointsPrefetcher::UsdPointsPrefetcher(
+    pxr::UsdStageRefPtr stage,
+    const pxr::UsdAttribute& points,
+    size_t capacity)
+    : stage_(std::move(stage)),
+      attribute_(points),
+      slots_(capacity)
+{
+    attribute_.GetTimeSamples(&samples_);
+    if (!slots_.empty() && samples_.size() > 1) {
+        StageRegistry& registry = stage_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        thread_ = std::thread([this] { run(); });
+        registry.prefetchers.push_back(this);
+    }
+}
+
+UsdPointsPrefetcher::~UsdPointsPrefetcher()
+{
+    {
+        StageRegistry& registry = stage_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        std::erase(registry.prefetchers, this);
+    }
+    stop();
+}
+
+void UsdPointsPrefetcher::stop()
+{
+    stopped_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool UsdPointsPrefetcher::get(
+    pxr::UsdTimeCode time,
+    pxr::VtArray<pxr::GfVec3f>& points)
+{
+    ptrdiff_t sample = -1;
+    // thread_ itself may be joined concurrently by open_cached_stage().
+    const bool threaded = !slots_.empty() && samples_.size() > 1;
+    if (!time.IsDefault() && threaded && !stopped_) {
+        auto it = std::lower_bound(
+            samples_.begin(), samples_.end(), time.GetValue());
+        if (it != samples_.end() && *it == time.GetValue()) {
+            sample = it - samples_.begin();
+        }
+    }
+    if (sample >= 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cursor_ = sample;
+        const Slot& slot = slots_[sample % slots_.size()];
+        const bool hit = slot.sample == sample;
+        if (hit) {
+            points = slot.points;
+        }
+        lock.unlock();
+        wake_.notify_one();
+        if (hit) {
+            ++hits_;
+            return true;
+        }
+    }
+
+    ++misses_;
+    return attribute_.Get(&points, time);
+}
+
+void UsdPointsPrefetcher::run()
+{
+    const ptrdiff_t capacity = ptrdiff_t(slots_.size());
+    const ptrdiff_t count = ptrdiff_t(samples_.size());
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        // The first sample of the window that is not in its slot yet.
+        ptrdiff_t wanted = -1;
+        const ptrdiff_t last = std::min(cursor_ + capacity, count);
+        for (ptrdiff_t i = cursor_; i < last; ++i) {
+            if (slots_[i % capacity].sample != i) {
+                wanted = i;
+                break;
+            }
+        }
+        if (wanted < 0) {
+            wake_.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        pxr::VtArray<pxr::GfVec3f> points;
+        attribute_.Get(&points, samples_[wanted]);
+        lock.lock();
+        // The window may have moved on while reading.
+        if (wanted >= cursor_ && wanted < cursor_ + capacity) {
+            slots_[wanted % capacity] = { wanted, std::move(points) };
+        }
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -1,8 +1,55 @@
 #include "GCore/util_openmesh_bind.h"
 
 #include "GCore/Components/MeshOperand.h"
+#include "GCore/algorithms/compact_topology.h"
+#include "Logger/Logger.h"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Adds the faces of `topology` to `openmesh`, whose vertices must already be
+// in place. Goes through CompactTopology so triangle faces use the
+// three-handle add_face and no per-face handle vector is allocated. Returns
+// false if the topology is invalid.
+template<typename Mesh>
+bool add_faces(Mesh& openmesh, const MeshComponent& topology)
+{
+    CompactTopology compact;
+    if (!compact.build(
+            topology.get_face_vertex_counts(),
+            topology.get_face_vertex_indices(),
+            openmesh.n_vertices())) {
+        log::warning(
+            "Cannot convert mesh to OpenMesh: invalid face counts or "
+            "indices");
+        return false;
+    }
+    openmesh.reserve(
+        openmesh.n_vertices(),
+        compact.corner_count(),  // Upper bound on the number of edges.
+        compact.face_count());
+
+    std::vector<typename Mesh::VertexHandle> face_vhandles;
+    compact.for_each_face([&](size_t, const auto* corners, int size) {
+        if (size == 3) {
+            openmesh.add_face(
+                openmesh.vertex_handle(corners[0]),
+                openmesh.vertex_handle(corners[1]),
+                openmesh.vertex_handle(corners[2]));
+            return;
+        }
+        face_vhandles.clear();
+        for (int j = 0; j < size; j++) {
+            face_vhandles.push_back(openmesh.vertex_handle(corners[j]));
+        }
+        openmesh.add_face(face_vhandles);
+    });
+    return true;
+}
+
+}  // namespace
+
 std::shared_ptr<PolyMesh> operand_to_openmesh(Geometry* mesh_oeprand)
 {
     auto openmesh = std::make_shared<PolyMesh>();
@@ -16,23 +63,8 @@ std::shared_ptr<PolyMesh> operand_to_openmesh(Geometry* mesh_oeprand)
         openmesh->add_vertex(v);
     }
 
-    auto faceVertexIndices = topology->get_face_vertex_indices();
-    auto faceVertexCounts = topology->get_face_vertex_counts();
-
-    int vertexIndex = 0;
-    for (int i = 0; i < faceVertexCounts.size(); i++) {
-        // Create a vector of vertex handles for the face
-        std::vector<PolyMesh::VertexHandle> face_vhandles;
-        for (int j = 0; j < faceVertexCounts[i]; j++) {
-            int index = faceVertexIndices[vertexIndex];
-            // Get the vertex handle from the index
-            PolyMesh::VertexHandle vh = openmesh->vertex_handle(index);
-            // Add it to the vector
-            face_vhandles.push_back(vh);
-            vertexIndex++;
-        }
-        // Add the face to the mesh
-        openmesh->add_face(face_vhandles);
+    if (!add_faces(*openmesh, *topology)) {
+        return nullptr;
     }
     return openmesh;
 }
@@ -83,23 +115,8 @@ std::shared_ptr<TriMesh> operand_to_openmesh_trimesh(Geometry* mesh_oeprand)
         openmesh->add_vertex(v);
     }
 
-    auto faceVertexIndices = topology->get_face_vertex_indices();
-    auto faceVertexCounts = topology->get_face_vertex_counts();
-
-    int vertexIndex = 0;
-    for (int i = 0; i < faceVertexCounts.size(); i++) {
-        // Create a vector of vertex handles for the face
-        std::vector<TriMesh::VertexHandle> face_vhandles;
-        for (int j = 0; j < faceVertexCounts[i]; j++) {
-            int index = faceVertexIndices[vertexIndex];
-            // Get the vertex handle from the index
-            TriMesh::VertexHandle vh = openmesh->vertex_handle(index);
-            // Add it to the vector
-            face_vhandles.push_back(vh);
-            vertexIndex++;
-        }
-        // Add the face to the mesh
-        openmesh->add_face(face_vhandles);
+    if (!add_faces(*openmesh, *topology)) {
+        return nullptr;
     }
     return openmesh;
 }
@@ -5,3 +5,22 @@
 #include "nodes/core/def/node_def.hpp"
 #include "pxr/base/gf/vec3f.h"
 #include "pxr/base/vt/array.h"
+
+// Ownership of pxr::VtArray sockets
+//
+// A VtArray is a reference-counted, copy-on-write handle. Passing one
+// through a socket, get_input<VtArray<T>>() or a MeshComponent getter or
+// setter shares its storage instead of copying the elements; the executor
+// keeps the value in the input socket for display, so an array a node
+// receives is never uniquely owned.
+//
+// - Read through a const reference (or cdata()). operator[], begin(),
+//   end() and data() on a non-const array detach it first, which copies
+//   every element of a shared array even if nothing is written.
+// - Writing to an array you received costs exactly one copy, made when it
+//   is first detached; later writes go to the private copy.
+// - Hand arrays on with std::move() into set_output() or a setter, and
+//   take a large input you only read with get_input<const T&>() to avoid
+//   touching the reference count at all.
+// - Never const_cast a shared array to write it in place: the same storage
+//   is visible through the upstream socket and the source component.
@@ -1,68 +1,24 @@
-#include <Eigen/Dense>
-#include <Eigen/Sparse>
-#include <Eigen/SparseLU>
-#include <algorithm>
-#include <cassert>
-#include <cmath>
+#include <array>
 #include <cstddef>
-#include <memory>
+#include <iostream>
 #include <vector>
 
-#include "Eigen/src/Core/Matrix.h"
 #include "GCore/Components/MeshOperand.h"
-#include "GCore/util_openmesh_bind.h"
+#include "GCore/algorithms/arap.h"
 #include "geom_node_base.h"
 #include "nodes/core/def/node_def.hpp"
 
-typedef OpenMesh::PolyMesh_ArrayKernelT<> MyMesh;
+NODE_DEF_OPEN_SCOPE
 
-void arap_deformation(
-    std::shared_ptr<MyMesh> halfedge_mesh,
-    std::vector<size_t> indices,
-    std::vector<std::array<float, 3>> new_positions)
-{
-    // TODO: Implement ARAP Deformation Algorithm.
-
-    /* ------------- ARAP Deformation Implementation -----------
-     ** Implement ARAP mesh deformation to preserve local rigidity.
-     **
-     ** Steps:
-     ** 1. Initial Setup:
-     **    - Build cotangent‐weighted Laplacian L of the input mesh.
-     **    - Apply Dirichlet constraints: for each control index i, enforce
-     **      L(i,i)=1.
-     **
-     ** 2. Pre‐Factorization:
-     **    - Factorize L (e.g. with Eigen::SparseLU) once for fast solves.
-     **
-     ** 3. Initialization:
-     **    - Record original positions P0 (n×3).
-     **    - Initialize deformed positions P = P0.
-     **    - Enforce control points: for each t, P(indices[t]) =
-     **      new_positions[t].
-     **
-     ** 4. Iteration (Local–Global):
-     **    Local Phase:
-     **      For each vertex i ∉ control:
-     **        • Compute covariance Ci = Σ_{j∈N(i)} w_ij (P_i−P_j)(P0_i−P0_j)^T.
-     **        • SVD(Ci) → U,Σ,Vᵀ; set rotation R_i = U·Vᵀ.
-     **
-     **    Global Phase:
-     **      • Assemble RHS vectors bx,by,bz (size n):
-     **          – If i ∈ control, b*(i)=P(i,*).
-     **          – Else b*(i)=½ Σ_{j∈N(i)} w_ij·(R_i+R_j)·(P0_i−P0_j).
-     **      • Solve L·ux=bx, L·uy=by, L·uz=bz.
-     **      • Update free P_i = (ux_i,uy_i,uz_i); re‐enforce control points.
-     **
-     **    Repeat until max_iter or convergence.
-     **
-     ** 5. Finalization:
-     **    - Write P back into halfedge_mesh→point(vh) for all vertices.
-     **
-     */
-}
+// The deformer persists while control points are dragged: its factorization
+// is kept as long as the input mesh and the set of control indices stay the
+// same, and each drag event starts from the previous result.
+struct ArapDeformationStorage {
+    static constexpr bool has_storage = false;
+
+    ArapDeformer deformer;
+};
 
-NODE_DEF_OPEN_SCOPE
 NODE_DECLARATION_FUNCTION(arap_deformation)
 {
     // Input-1: Original 3D mesh with boundary
@@ -74,6 +30,12 @@ NODE_DECLARATION_FUNCTION(arap_deformation)
     // Input-3: New positions for the control vertices
     b.add_input<std::vector<std::array<float, 3>>>("New Positions");
 
+    // Input-4: Local/global iterations per execution
+    b.add_input<int>("Iterations").default_val(4).min(1).max(100);
+
+    // Input-5: Continue from the previous result instead of the rest shape
+    b.add_input<bool>("Warm Start").default_val(true);
+
     // Output-1: Deformed mesh
     b.add_output<Geometry>("Output");
 }
@@ -99,23 +61,61 @@ NODE_EXECUTION_FUNCTION(arap_deformation)
         return false;
     }
 
-    /* ----------------------------- Preprocess -------------------------------
-     ** Create a halfedge structure (using OpenMesh) for the input mesh. The
-     ** half-edge data structure is a widely used data structure in geometric
-     ** processing, offering convenient operations for traversing and modifying
-     ** mesh elements.
-     */
+    auto mesh = input.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << "ARAP Deformation: Need Geometry Input." << std::endl;
+        return false;
+    }
 
-    // Initialization
-    auto halfedge_mesh = operand_to_openmesh(&input);
+    // Checked before narrowing, so that an index past 2^32 does not wrap
+    // around onto a valid vertex.
+    const size_t vertex_count = mesh->get_vertices().size();
+    for (size_t index : indices) {
+        if (index >= vertex_count) {
+            std::cerr << "ARAP Deformation: Control index " << index
+                      << " is out of range." << std::endl;
+            return false;
+        }
+    }
+    std::vector<uint32_t> handles(indices.begin(), indices.end());
+    std::vector<pxr::GfVec3f> handle_positions;
+    handle_positions.reserve(new_positions.size());
+    for (const auto& p : new_positions) {
+        handle_positions.emplace_back(p[0], p[1], p[2]);
+    }
+
+    auto& deformer = params.get_storage<ArapDeformationStorage&>().deformer;
+    if (!deformer.prepare(
+            mesh->get_vertices(),
+            mesh->get_face_vertex_counts(),
+            mesh->get_face_vertex_indices(),
+            mesh->topology_version(),
+            mesh->position_version(),
+            handles)) {
+        std::cerr << "ARAP Deformation: Invalid mesh or control indices."
+                  << std::endl;
+        return false;
+    }
 
     // ARAP deformation
-    arap_deformation(halfedge_mesh, indices, new_positions);
+    pxr::VtArray<pxr::GfVec3f> deformed;
+    if (!deformer.deform(
+            handle_positions,
+            params.get_input<int>("Iterations"),
+            params.get_input<bool>("Warm Start"),
+            deformed)) {
+        return false;
+    }
 
-    auto geometry = openmesh_to_operand(halfedge_mesh.get());
+    Geometry geometry;
+    auto deformed_mesh = std::make_shared<MeshComponent>(&geometry);
+    deformed_mesh->set_vertices(deformed);
+    deformed_mesh->set_face_vertex_counts(mesh->get_face_vertex_counts());
+    deformed_mesh->set_face_vertex_indices(mesh->get_face_vertex_indices());
+    geometry.attach_component(deformed_mesh);
 
     // Set the output of the nodes
-    params.set_output("Output", std::move(*geometry));
+    params.set_output("Output", std::move(geometry));
     return true;
 }
 
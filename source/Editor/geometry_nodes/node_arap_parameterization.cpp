@@ -1,54 +1,41 @@
-#include <Eigen/Dense>
-#include <Eigen/Sparse>
-#include <Eigen/SparseLU>
-#include <cmath>
+#include <algorithm>
+#include <iostream>
 #include <memory>
 
 #include "GCore/Components/MeshOperand.h"
-#include "GCore/util_openmesh_bind.h"
+#include "GCore/algorithms/arap.h"
+#include "Logger/Logger.h"
 #include "geom_node_base.h"
+#include "nodes/core/def/node_def.hpp"
 
-typedef OpenMesh::PolyMesh_ArrayKernelT<> MyMesh;
+NODE_DEF_OPEN_SCOPE
 
-void arap(
-    std::shared_ptr<MyMesh> halfedge_mesh,
-    std::shared_ptr<MyMesh> iter_mesh)
-{
-    // TODO: Implement ARAP Parameterization Algorithm.
-
-    /* ------------- ARAP Parameterization Implementation -----------
-     ** Implement ARAP mesh parameterization to minimize local distortion.
-     **
-     ** Steps:
-     ** 1. Initial Setup: Use a HW4 parameterization result as initial setup.
-     **
-     ** 2. Local Phase: For each triangle, compute local orthogonal
-     *approximation
-     **    (Lt) by computing SVD of Jacobian(Jt) with fixed u.
-     **
-     ** 3. Global Phase: With Lt fixed, update parameter coordinates(u) by
-     *solving
-     **    a pre-factored global sparse linear system.
-     **
-     ** 4. Iteration: Repeat Steps 2 and 3 to refine parameterization.
-     **
-     */
-}
+// The factored cotangent Laplacian of the last mesh, so that changing the
+// initialization or the iteration settings only reruns the iterations.
+struct ArapParameterizationStorage {
+    static constexpr bool has_storage = false;
+
+    ArapParameterizer parameterizer;
+};
 
-NODE_DEF_OPEN_SCOPE
 NODE_DECLARATION_FUNCTION(arap_parameterization)
 {
     // Input-1: Original 3D mesh with boundary
     b.add_input<Geometry>("Input");
 
     // Input-2: An embedding result of the mesh. Use the XY coordinates of the
-    // embedding as the initialization of the ARAP algorithm
-    //
-    // Here we use **the result of Assignment 4** as the initialization
+    // embedding as the initialization of the ARAP algorithm; without one, a
+    // harmonic map onto a disk is used
     b.add_input<Geometry>("Initialization");
 
+    // 0: as-rigid-as-possible, 1: as-similar-as-possible
+    b.add_input<int>("Method").default_val(0).min(0).max(1);
+    b.add_input<int>("Iterations").default_val(20).min(1).max(1000);
+    // Relative energy decrease below which the iterations stop
+    b.add_input<float>("Tolerance").default_val(1e-4f).min(0.0f).max(0.1f);
+
     // Output-1: Like the result of Assignment 4, output the 2D embedding of the
-    // mesh
+    // mesh, with the distortion of every face as face quantities
     b.add_output<Geometry>("Output");
 }
 
@@ -59,29 +46,92 @@ NODE_EXECUTION_FUNCTION(arap_parameterization)
     auto iters = params.get_input<Geometry>("Initialization");
 
     // Avoid processing the node when there is no input
-    if (!input.get_component<MeshComponent>() ||
-        !iters.get_component<MeshComponent>()) {
+    auto mesh = input.get_component<MeshComponent>();
+    if (!mesh) {
         std::cerr << "ARAP Parameterization: Need Geometry Input." << std::endl;
+        return false;
     }
 
-    /* ----------------------------- Preprocess -------------------------------
-    ** Create a halfedge structure (using OpenMesh) for the input mesh. The
-    ** half-edge data structure is a widely used data structure in geometric
-    ** processing, offering convenient operations for traversing and modifying
-    ** mesh elements.
-    */
+    const auto mode = params.get_input<int>("Method") == 1
+                          ? ArapParameterizer::Mode::Asap
+                          : ArapParameterizer::Mode::Arap;
+    auto& parameterizer =
+        params.get_storage<ArapParameterizationStorage&>().parameterizer;
+    if (!parameterizer.prepare(
+            mesh->get_vertices(),
+            mesh->get_face_vertex_counts(),
+            mesh->get_face_vertex_indices(),
+            mesh->topology_version(),
+            mesh->position_version(),
+            mode)) {
+        std::cerr << "ARAP Parameterization: Invalid mesh topology."
+                  << std::endl;
+        return false;
+    }
 
     // Initialization
-    auto halfedge_mesh = operand_to_openmesh(&input);
-    auto iter_mesh = operand_to_openmesh(&iters);
+    pxr::VtArray<pxr::GfVec2f> initial;
+    if (auto init_mesh = iters.get_component<MeshComponent>()) {
+        const auto& init_vertices = init_mesh->get_vertices();
+        if (init_vertices.size() != mesh->get_vertices().size()) {
+            std::cerr << "ARAP Parameterization: The initialization should "
+                         "have the same vertices as the input."
+                      << std::endl;
+            return false;
+        }
+        initial.resize(init_vertices.size());
+        std::transform(
+            init_vertices.begin(),
+            init_vertices.end(),
+            initial.begin(),
+            [](const pxr::GfVec3f& p) { return pxr::GfVec2f(p[0], p[1]); });
+    }
+    else if (!parameterizer.harmonic_initialization(initial)) {
+        std::cerr << "ARAP Parameterization: Need a mesh with boundary."
+                  << std::endl;
+        return false;
+    }
 
     // ARAP parameterization
-    arap(halfedge_mesh, iter_mesh);
+    ArapParameterizer::Options options;
+    options.max_iterations = params.get_input<int>("Iterations");
+    options.tolerance = params.get_input<float>("Tolerance");
+    pxr::VtArray<pxr::GfVec2f> uv;
+    if (!parameterizer.parameterize(initial, options, uv)) {
+        std::cerr << "ARAP Parameterization: Global solve failed."
+                  << std::endl;
+        return false;
+    }
+
+    const auto& stats = parameterizer.stats();
+    log::info(
+        "ARAP Parameterization: %d iterations, energy %g -> %g, %zu flipped, "
+        "%g s",
+        stats.iterations,
+        stats.initial_energy,
+        stats.energy,
+        stats.flipped,
+        stats.seconds);
+
+    Geometry geometry;
+    auto embedded = std::make_shared<MeshComponent>(&geometry);
+    pxr::VtArray<pxr::GfVec3f> vertices(uv.size());
+    for (size_t v = 0; v < uv.size(); ++v) {
+        vertices[v] = pxr::GfVec3f(uv[v][0], uv[v][1], 0.0f);
+    }
+    embedded->set_vertices(vertices);
+    embedded->set_face_vertex_counts(mesh->get_face_vertex_counts());
+    embedded->set_face_vertex_indices(mesh->get_face_vertex_indices());
 
-    auto geometry = openmesh_to_operand(iter_mesh.get());
+    pxr::VtArray<float> energy, area_ratio, conformal_ratio;
+    parameterizer.face_distortion(energy, area_ratio, conformal_ratio);
+    embedded->add_face_scalar_quantity("arap_energy", energy);
+    embedded->add_face_scalar_quantity("area_distortion", area_ratio);
+    embedded->add_face_scalar_quantity("angle_distortion", conformal_ratio);
+    geometry.attach_component(embedded);
 
     // Set the output of the nodes
-    params.set_output("Output", std::move(*geometry));
+    params.set_output("Output", std::move(geometry));
     return true;
 }
 
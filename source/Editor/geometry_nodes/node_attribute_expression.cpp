@@ -0,0 +1,53 @@
+#include <iostream>
+#include <map>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/algorithms/attribute_expression.h"
+#include "geom_node_base.h"
+#include "nodes/core/def/node_def.hpp"
+
+NODE_DEF_OPEN_SCOPE
+
+// Edits per-vertex attributes with an expression (see
+// GCore/algorithms/attribute_expression.h), so a chain of set_vert_color,
+// transform_geom and math nodes becomes a single pass over the vertices.
+NODE_DECLARATION_FUNCTION(attribute_expression)
+{
+    b.add_input<Geometry>("Geometry");
+    b.add_input<std::string>("Expression").default_val("P = P");
+    // Available in the expression as a, b and c
+    b.add_input<float>("A").min(-10).max(10).default_val(0);
+    b.add_input<float>("B").min(-10).max(10).default_val(0);
+    b.add_input<float>("C").min(-10).max(10).default_val(0);
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(attribute_expression)
+{
+    auto geometry = params.get_input<Geometry>("Geometry");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << "Attribute Expression: No input mesh provided."
+                  << std::endl;
+        return false;
+    }
+
+    const std::map<std::string, float> uniforms = {
+        { "a", params.get_input<float>("A") },
+        { "b", params.get_input<float>("B") },
+        { "c", params.get_input<float>("C") },
+    };
+    AttributeProgram program;
+    if (!program.compile(
+            params.get_input<std::string>("Expression"), *mesh, uniforms) ||
+        !program.run(*mesh)) {
+        std::cerr << "Attribute Expression: " << program.error() << std::endl;
+        return false;
+    }
+
+    params.set_output("Geometry", std::move(geometry));
+    return true;
+}
+
+NODE_DECLARATION_UI(attribute_expression);
+NODE_DEF_CLOSE_SCOPE
@@ -1,65 +1,208 @@
 // #define __GNUC__
+#include <pxr/base/work/loops.h>
+
 #include "GCore/Components/CurveComponent.h"
 #include "GCore/Components/MeshOperand.h"
+#include "GCore/algorithms/primitives.h"
 #include "geom_node_base.h"
 
 NODE_DEF_OPEN_SCOPE
 
+// Wraps a generated mesh in a geometry.
+static Geometry primitive_geometry(const PrimitiveMesh& primitive)
+{
+    Geometry geometry;
+    std::shared_ptr<MeshComponent> mesh =
+        std::make_shared<MeshComponent>(&geometry);
+    geometry.attach_component(mesh);
+
+    mesh->set_vertices(primitive.positions);
+    mesh->set_face_vertex_counts(primitive.face_vertex_counts);
+    mesh->set_face_vertex_indices(primitive.face_vertex_indices);
+    mesh->set_normals(primitive.normals);
+    mesh->set_texcoords_array(primitive.texcoords);
+    return geometry;
+}
+
 NODE_DECLARATION_FUNCTION(create_grid)
 {
-    b.add_input<int>("resolution").min(1).max(20).default_val(2);
+    b.add_input<int>("resolution").min(1).max(10000).default_val(2);
     b.add_input<float>("size").min(1).max(20);
     b.add_output<Geometry>("Geometry");
 }
 
 NODE_EXECUTION_FUNCTION(create_grid)
 {
-    int resolution = params.get_input<int>("resolution") + 1;
+    int resolution = params.get_input<int>("resolution");
     float size = params.get_input<float>("size");
-    Geometry geometry;
-    std::shared_ptr<MeshComponent> mesh =
-        std::make_shared<MeshComponent>(&geometry);
-    geometry.attach_component(mesh);
 
-    pxr::VtArray<pxr::GfVec3f> points;
-    pxr::VtArray<pxr::GfVec2f> texcoord;
-    pxr::VtArray<int> faceVertexIndices;
-    pxr::VtArray<int> faceVertexCounts;
+    // In the x = 0 plane, from the origin towards +y and +z
+    PrimitiveMesh primitive;
+    if (!make_grid(
+            pxr::GfVec3f(0),
+            pxr::GfVec3f(0, size, 0),
+            pxr::GfVec3f(0, 0, size),
+            resolution,
+            resolution,
+            primitive)) {
+        return false;
+    }
 
-    for (int i = 0; i < resolution; ++i) {
-        for (int j = 0; j < resolution; ++j) {
-            float y = size * static_cast<float>(i) / (resolution - 1);
-            float z = size * static_cast<float>(j) / (resolution - 1);
+    params.set_output("Geometry", primitive_geometry(primitive));
+    return true;
+}
 
-            float u = static_cast<float>(i) / (resolution - 1);
-            float v = static_cast<float>(j) / (resolution - 1);
-            points.push_back(pxr::GfVec3f(0, y, z));
-            texcoord.push_back(pxr::GfVec2f(u, v));
-        }
+NODE_DECLARATION_FUNCTION(create_uv_sphere)
+{
+    b.add_input<float>("Radius").min(0.1).max(20).default_val(1);
+    b.add_input<int>("Segments").min(3).max(10000).default_val(32);
+    b.add_input<int>("Rings").min(2).max(10000).default_val(16);
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(create_uv_sphere)
+{
+    PrimitiveMesh primitive;
+    if (!make_uv_sphere(
+            params.get_input<float>("Radius"),
+            params.get_input<int>("Segments"),
+            params.get_input<int>("Rings"),
+            primitive)) {
+        return false;
     }
 
-    for (int i = 0; i < resolution - 1; ++i) {
-        for (int j = 0; j < resolution - 1; ++j) {
-            faceVertexCounts.push_back(4);
-            faceVertexIndices.push_back(i * resolution + j);
-            faceVertexIndices.push_back(i * resolution + j + 1);
-            faceVertexIndices.push_back((i + 1) * resolution + j + 1);
-            faceVertexIndices.push_back((i + 1) * resolution + j);
-        }
+    params.set_output("Geometry", primitive_geometry(primitive));
+    return true;
+}
+
+NODE_DECLARATION_FUNCTION(create_icosphere)
+{
+    b.add_input<float>("Radius").min(0.1).max(20).default_val(1);
+    // Edge subdivisions of the icosahedron, 20 * Frequency^2 triangles
+    b.add_input<int>("Frequency").min(1).max(2000).default_val(4);
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(create_icosphere)
+{
+    PrimitiveMesh primitive;
+    if (!make_icosphere(
+            params.get_input<float>("Radius"),
+            params.get_input<int>("Frequency"),
+            primitive)) {
+        return false;
     }
 
-    mesh->set_vertices(points);
-    mesh->set_face_vertex_indices(faceVertexIndices);
-    mesh->set_face_vertex_counts(faceVertexCounts);
-    mesh->set_texcoords_array(texcoord);
+    params.set_output("Geometry", primitive_geometry(primitive));
+    return true;
+}
+
+NODE_DECLARATION_FUNCTION(create_torus)
+{
+    b.add_input<float>("Major Radius").min(0.1).max(20).default_val(1);
+    b.add_input<float>("Minor Radius").min(0.01).max(10).default_val(0.25);
+    b.add_input<int>("Segments").min(3).max(10000).default_val(48);
+    b.add_input<int>("Sides").min(3).max(10000).default_val(24);
+    b.add_output<Geometry>("Geometry");
+}
 
-    params.set_output("Geometry", std::move(geometry));
+NODE_EXECUTION_FUNCTION(create_torus)
+{
+    PrimitiveMesh primitive;
+    if (!make_torus(
+            params.get_input<float>("Major Radius"),
+            params.get_input<float>("Minor Radius"),
+            params.get_input<int>("Segments"),
+            params.get_input<int>("Sides"),
+            primitive)) {
+        return false;
+    }
+
+    params.set_output("Geometry", primitive_geometry(primitive));
+    return true;
+}
+
+NODE_DECLARATION_FUNCTION(create_cube)
+{
+    b.add_input<float>("Size").min(0.1).max(20).default_val(1);
+    b.add_input<int>("Cells").min(1).max(4000).default_val(1);
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(create_cube)
+{
+    PrimitiveMesh primitive;
+    if (!make_cube(
+            params.get_input<float>("Size"),
+            params.get_input<int>("Cells"),
+            primitive)) {
+        return false;
+    }
+
+    params.set_output("Geometry", primitive_geometry(primitive));
+    return true;
+}
+
+NODE_DECLARATION_FUNCTION(create_cylinder)
+{
+    b.add_input<float>("Radius").min(0.1).max(20).default_val(1);
+    b.add_input<float>("Height").min(0.1).max(20).default_val(2);
+    b.add_input<int>("Segments").min(3).max(10000).default_val(32);
+    b.add_input<int>("Rings").min(1).max(10000).default_val(1);
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(create_cylinder)
+{
+    PrimitiveMesh primitive;
+    if (!make_cylinder(
+            params.get_input<float>("Radius"),
+            params.get_input<float>("Height"),
+            params.get_input<int>("Segments"),
+            params.get_input<int>("Rings"),
+            primitive)) {
+        return false;
+    }
+
+    params.set_output("Geometry", primitive_geometry(primitive));
+    return true;
+}
+
+NODE_DECLARATION_FUNCTION(create_terrain)
+{
+    b.add_input<float>("Size").min(0.1).max(100).default_val(10);
+    b.add_input<int>("Cells").min(1).max(10000).default_val(256);
+    b.add_input<float>("Amplitude").min(0).max(10).default_val(1);
+    b.add_input<float>("Frequency").min(0.01).max(10).default_val(0.2);
+    b.add_input<int>("Octaves").min(1).max(12).default_val(5);
+    b.add_input<int>("Seed").min(0).max(1000).default_val(0);
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(create_terrain)
+{
+    TerrainNoise noise;
+    noise.amplitude = params.get_input<float>("Amplitude");
+    noise.frequency = params.get_input<float>("Frequency");
+    noise.octaves = params.get_input<int>("Octaves");
+    noise.seed = uint32_t(params.get_input<int>("Seed"));
+
+    PrimitiveMesh primitive;
+    if (!make_terrain(
+            params.get_input<float>("Size"),
+            params.get_input<int>("Cells"),
+            noise,
+            primitive)) {
+        return false;
+    }
+
+    params.set_output("Geometry", primitive_geometry(primitive));
     return true;
 }
 
 NODE_DECLARATION_FUNCTION(create_circle)
 {
-    b.add_input<int>("resolution").min(1).max(100).default_val(10);
+    b.add_input<int>("resolution").min(1).max(1000000).default_val(10);
     b.add_input<float>("radius").min(1).max(20);
     b.add_output<Geometry>("Circle");
 }
@@ -73,26 +216,25 @@ NODE_EXECUTION_FUNCTION(create_circle)
         std::make_shared<CurveComponent>(&geometry);
     geometry.attach_component(curve);
 
-    pxr::VtArray<pxr::GfVec3f> points;
+    pxr::VtArray<pxr::GfVec3f> points(resolution);
 
     pxr::GfVec3f center(0.0f, 0.0f, 0.0f);
 
     float angleStep = 2.0f * M_PI / resolution;
 
-    for (int i = 0; i < resolution; ++i) {
-        float angle = i * angleStep;
-        pxr::GfVec3f point(
-            radius * std::cos(angle) + center[0],
-            radius * std::sin(angle) + center[1],
-            center[2]);
-        points.push_back(point);
-    }
-
-    pxr::VtArray<pxr::GfVec3f> normals;
+    pxr::GfVec3f* out = points.data();
+    pxr::WorkParallelForN(resolution, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float angle = i * angleStep;
+            out[i] = pxr::GfVec3f(
+                radius * std::cos(angle) + center[0],
+                radius * std::sin(angle) + center[1],
+                center[2]);
+        }
+    });
 
-    for (int i = 0; i < resolution; ++i) {
-        normals.push_back(pxr::GfVec3f(0.0f, 0.0f, 1.0f));
-    }
+    pxr::VtArray<pxr::GfVec3f> normals(
+        resolution, pxr::GfVec3f(0.0f, 0.0f, 1.0f));
 
     curve->set_vertices(points);
     curve->set_curve_normals(normals);
@@ -106,7 +248,7 @@ NODE_EXECUTION_FUNCTION(create_circle)
 
 NODE_DECLARATION_FUNCTION(create_spiral)
 {
-    b.add_input<int>("resolution").min(1).max(100).default_val(10);
+    b.add_input<int>("resolution").min(1).max(1000000).default_val(10);
     b.add_input<float>("R1").min(0.1).max(10).default_val(1);
     b.add_input<float>("R2").min(0.1).max(10).default_val(1);
     b.add_input<float>("Circle Count").min(0.1).max(10).default_val(2);
@@ -127,26 +269,25 @@ NODE_EXECUTION_FUNCTION(create_spiral)
         std::make_shared<CurveComponent>(&geometry);
     geometry.attach_component(curve);
 
-    pxr::VtArray<pxr::GfVec3f> points;
+    pxr::VtArray<pxr::GfVec3f> points(resolution);
 
     float angleStep = circleCount * 2.0f * M_PI / resolution;
     float radiusIncrement = (R2 - R1) / resolution;
     float heightIncrement = height / resolution;
 
-    for (int i = 0; i < resolution; ++i) {
-        float angle = i * angleStep;
-        float radius = R1 + radiusIncrement * i;
-        float z = heightIncrement * i;
-        pxr::GfVec3f point(
-            radius * std::cos(angle), radius * std::sin(angle), z);
-        points.push_back(point);
-    }
-
-    pxr::VtArray<pxr::GfVec3f> normals;
+    pxr::GfVec3f* out = points.data();
+    pxr::WorkParallelForN(resolution, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float angle = i * angleStep;
+            float radius = R1 + radiusIncrement * i;
+            float z = heightIncrement * i;
+            out[i] = pxr::GfVec3f(
+                radius * std::cos(angle), radius * std::sin(angle), z);
+        }
+    });
 
-    for (int i = 0; i < resolution; ++i) {
-        normals.push_back(pxr::GfVec3f(0.0f, 0.0f, 1.0f));
-    }
+    pxr::VtArray<pxr::GfVec3f> normals(
+        resolution, pxr::GfVec3f(0.0f, 0.0f, 1.0f));
 
     curve->set_vertices(points);
     curve->set_vert_count({ resolution });
@@ -1,75 +1,92 @@
+#include <iostream>
+#include <vector>
+
 #include "GCore/Components/MeshOperand.h"
-#include "GCore/util_openmesh_bind.h"
-#include "cross_field.h"
+#include "GCore/algorithms/cross_field.h"
+#include "Logger/Logger.h"
 #include "geom_node_base.h"
 #include "nodes/core/def/node_def.hpp"
 
 NODE_DEF_OPEN_SCOPE
 
+// The factorization of the smoothness system is kept while the mesh stays the
+// same, so changing the prescribed directions only costs a back-substitution.
+struct CrossFieldStorage {
+    static constexpr bool has_storage = false;
+
+    CrossFieldSolver solver;
+};
+
 NODE_DECLARATION_FUNCTION(cross_field)
 {
     // Input-1: Original 3D mesh
     b.add_input<Geometry>("Input");
-    // Output-1: Cross field
-    b.add_output<std::vector<std::vector<Eigen::Vector3d>>>("Cross Field");
+    // Input-2: Number of vectors per face, 4 for a cross field
+    b.add_input<int>("Symmetry").default_val(4).min(1).max(8);
+    // Input-3: Optional direction per face, used on the boundary faces (and
+    // one face of each closed component) instead of the boundary tangents
+    b.add_input<pxr::VtArray<pxr::GfVec3f>>("Directions");
+    // Output-1: Symmetry vectors per face, face after face
+    b.add_output<pxr::VtArray<pxr::GfVec3f>>("Cross Field");
 }
 
 NODE_EXECUTION_FUNCTION(cross_field)
-{  // Get the input mesh
+{
+    // Get the input mesh
     auto input_mesh = params.get_input<Geometry>("Input");
+    auto mesh = input_mesh.get_component<MeshComponent>();
 
     // Avoid processing the node when there is no input
-    if (!input_mesh.get_component<MeshComponent>()) {
+    if (!mesh) {
         std::cerr << "Cross field: No input mesh provided." << std::endl;
         return false;
     }
 
-    /* ----------------------------- Preprocess
-     *-------------------------------
-     ** Create a halfedge structure (using OpenMesh) for the input mesh. The
-     ** half-edge data structure is a widely used data structure in
-     *geometric
-     ** processing, offering convenient operations for traversing and
-     *modifying
-     ** mesh elements.
-     */
-
-    // Initialization
-    auto openmesh = std::make_shared<EigenPolyMesh>();
-    auto topology = input_mesh.get_component<MeshComponent>();
-
-    for (const auto& vv : topology->get_vertices()) {
-        Eigen::Vector3d v(vv[0], vv[1], vv[2]);
-        openmesh->add_vertex(v);
+    auto& solver = params.get_storage<CrossFieldStorage&>().solver;
+    const size_t symbolic = solver.symbolic_count();
+    const size_t numeric = solver.numeric_count();
+    if (!solver.prepare(
+            mesh->get_vertices(),
+            mesh->get_face_vertex_counts(),
+            mesh->get_face_vertex_indices(),
+            mesh->topology_version(),
+            mesh->position_version(),
+            params.get_input<int>("Symmetry"))) {
+        std::cerr << "Cross field: The input must be a manifold mesh."
+                  << std::endl;
+        return false;
     }
 
-    auto faceVertexIndices = topology->get_face_vertex_indices();
-    auto faceVertexCounts = topology->get_face_vertex_counts();
-
-    int vertexIndex = 0;
-    for (int i = 0; i < faceVertexCounts.size(); i++) {
-        // Create a vector of vertex handles for the face
-        std::vector<EigenPolyMesh::VertexHandle> face_vhandles;
-        for (int j = 0; j < faceVertexCounts[i]; j++) {
-            int index = faceVertexIndices[vertexIndex];
-            // Get the vertex handle from the index
-            EigenPolyMesh::VertexHandle vh = openmesh->vertex_handle(index);
-            // Add it to the vector
-            face_vhandles.push_back(vh);
-            vertexIndex++;
+    std::vector<pxr::GfVec3f> directions;
+    solver.boundary_directions(directions);
+    auto custom = params.get_input<pxr::VtArray<pxr::GfVec3f>>("Directions");
+    if (!custom.empty()) {
+        if (custom.size() != solver.face_count()) {
+            std::cerr << "Cross field: Expected one direction per face."
+                      << std::endl;
+            return false;
+        }
+        const auto& faces = solver.constrained_faces();
+        for (size_t i = 0; i < faces.size(); ++i) {
+            directions[i] = custom[faces[i]];
         }
-        // Add the face to the mesh
-        openmesh->add_face(face_vhandles);
     }
 
-    // Create the cross field
-    CrossField cross_field(*openmesh);
-    cross_field.generateBoundaryConstrain();
-    cross_field.generateCrossField();
-    auto cross_fields = cross_field.getCrossFields();
+    pxr::VtArray<pxr::GfVec3f> field;
+    if (!solver.solve(directions, field)) {
+        std::cerr << "Cross field: Failed to solve for the field." << std::endl;
+        return false;
+    }
+    log::info(
+        "Cross field: %zu faces, %zu constrained, %zu symbolic and %zu "
+        "numeric factorizations",
+        solver.face_count(),
+        solver.constrained_faces().size(),
+        solver.symbolic_count() - symbolic,
+        solver.numeric_count() - numeric);
 
     // Set the output
-    params.set_output("Cross Field", cross_fields);
+    params.set_output("Cross Field", std::move(field));
 
     return true;
 }
@@ -1,32 +1,65 @@
 #include <pxr/base/vt/array.h>
 
-#include <vector>
+#include <iostream>
 
 #include "GCore/Components/MeshOperand.h"
-#include "OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh"
+#include "GCore/algorithms/curvature.h"
 #include "geom_node_base.h"
 #include "nodes/core/def/node_def.hpp"
 
-typedef OpenMesh::TriMesh_ArrayKernelT<> MyMesh;
+NODE_DEF_OPEN_SCOPE
 
-void compute_mean_curvature(
-    const MyMesh& omesh,
-    pxr::VtArray<float>& mean_curvature)
+// The curvature kernel keeps the triangle table of the last mesh, so only a
+// topology change pays for rebuilding it; the field is reused as long as the
+// positions do not move either.
+struct CurvatureStorage {
+    static constexpr bool has_storage = false;
+
+    CurvatureKernel kernel;
+    CurvatureField field;
+    uint64_t topology_version = 0;
+    uint64_t position_version = 0;
+    bool principal = false;
+};
+
+static const CurvatureField* evaluate_curvature(
+    ExeParams& params,
+    bool principal)
 {
-    // TODO: Implement the mean curvature computation
-    //  You need to fill in `mean_curvature`
-}
+    auto geometry = params.get_input<Geometry>("Mesh");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << "Curvature: no input mesh" << std::endl;
+        return nullptr;
+    }
 
-void compute_gaussian_curvature(
-    const MyMesh& omesh,
-    pxr::VtArray<float>& gaussian_curvature)
-{
-    // TODO: Implement the Gaussian curvature computation
-    //  You need to fill in `gaussian_curvature`
+    auto& storage = params.get_storage<CurvatureStorage&>();
+    if (storage.topology_version != mesh->topology_version()) {
+        if (!storage.kernel.set_topology(
+                mesh->get_face_vertex_counts(),
+                mesh->get_face_vertex_indices(),
+                mesh->get_vertices().size())) {
+            storage.topology_version = 0;
+            std::cerr << "Curvature: invalid mesh topology" << std::endl;
+            return nullptr;
+        }
+        if (size_t count = storage.kernel.non_manifold_vertex_count()) {
+            std::cerr << "Curvature: " << count
+                      << " non-manifold vertices get zero curvature"
+                      << std::endl;
+        }
+        storage.topology_version = mesh->topology_version();
+        storage.position_version = 0;
+    }
+    if (storage.position_version != mesh->position_version() ||
+        (principal && !storage.principal)) {
+        storage.kernel.compute(mesh->get_vertices(), storage.field, principal);
+        storage.position_version = mesh->position_version();
+        storage.principal = principal;
+    }
+    return &storage.field;
 }
 
-NODE_DEF_OPEN_SCOPE
-
 NODE_DECLARATION_FUNCTION(mean_curvature)
 {
     b.add_input<Geometry>("Mesh");
@@ -35,44 +68,11 @@ NODE_DECLARATION_FUNCTION(mean_curvature)
 
 NODE_EXECUTION_FUNCTION(mean_curvature)
 {
-    auto geometry = params.get_input<Geometry>("Mesh");
-    auto mesh = geometry.get_component<MeshComponent>();
-    auto vertices = mesh->get_vertices();
-    auto face_vertex_indices = mesh->get_face_vertex_indices();
-    auto face_vertex_counts = mesh->get_face_vertex_counts();
-
-    // Convert the mesh to OpenMesh
-    MyMesh omesh;
-
-    // Add vertices
-    std::vector<OpenMesh::VertexHandle> vhandles;
-    vhandles.reserve(vertices.size());
-
-    for (auto vertex : vertices) {
-        omesh.add_vertex(OpenMesh::Vec3f(vertex[0], vertex[1], vertex[2]));
+    auto field = evaluate_curvature(params, false);
+    if (!field) {
+        return false;
     }
-
-    // Add faces
-    size_t start = 0;
-    for (int face_vertex_count : face_vertex_counts) {
-        std::vector<OpenMesh::VertexHandle> face;
-        face.reserve(face_vertex_count);
-        for (int j = 0; j < face_vertex_count; j++) {
-            face.push_back(
-                OpenMesh::VertexHandle(face_vertex_indices[start + j]));
-        }
-        omesh.add_face(face);
-        start += face_vertex_count;
-    }
-
-    // Compute mean curvature
-    pxr::VtArray<float> mean_curvature;
-    mean_curvature.reserve(omesh.n_vertices());
-
-    compute_mean_curvature(omesh, mean_curvature);
-
-    params.set_output("Mean Curvature", mean_curvature);
-
+    params.set_output("Mean Curvature", field->mean);
     return true;
 }
 
@@ -86,47 +86,39 @@ NODE_DECLARATION_FUNCTION(gaussian_curvature)
 
 NODE_EXECUTION_FUNCTION(gaussian_curvature)
 {
-    auto geometry = params.get_input<Geometry>("Mesh");
-    auto mesh = geometry.get_component<MeshComponent>();
-    auto vertices = mesh->get_vertices();
-    auto face_vertex_indices = mesh->get_face_vertex_indices();
-    auto face_vertex_counts = mesh->get_face_vertex_counts();
-
-    // Convert the mesh to OpenMesh
-    MyMesh omesh;
-
-    // Add vertices
-    std::vector<OpenMesh::VertexHandle> vhandles;
-    vhandles.reserve(vertices.size());
-
-    for (auto vertex : vertices) {
-        omesh.add_vertex(OpenMesh::Vec3f(vertex[0], vertex[1], vertex[2]));
-    }
-
-    // Add faces
-    size_t start = 0;
-    for (int face_vertex_count : face_vertex_counts) {
-        std::vector<OpenMesh::VertexHandle> face;
-        face.reserve(face_vertex_count);
-        for (int j = 0; j < face_vertex_count; j++) {
-            face.push_back(
-                OpenMesh::VertexHandle(face_vertex_indices[start + j]));
-        }
-        omesh.add_face(face);
-        start += face_vertex_count;
+    auto field = evaluate_curvature(params, false);
+    if (!field) {
+        return false;
     }
+    params.set_output("Gaussian Curvature", field->gaussian);
+    return true;
+}
 
-    // Compute Gaussian curvature
-    pxr::VtArray<float> gaussian_curvature;
-    gaussian_curvature.reserve(omesh.n_vertices());
-
-    compute_gaussian_curvature(omesh, gaussian_curvature);
+NODE_DECLARATION_UI(gaussian_curvature);
 
-    params.set_output("Gaussian Curvature", gaussian_curvature);
+// Principal curvatures k1 >= k2 and their unit tangent directions.
+NODE_DECLARATION_FUNCTION(principal_curvature)
+{
+    b.add_input<Geometry>("Mesh");
+    b.add_output<pxr::VtArray<float>>("Maximum Curvature");
+    b.add_output<pxr::VtArray<float>>("Minimum Curvature");
+    b.add_output<pxr::VtVec3fArray>("Maximum Direction");
+    b.add_output<pxr::VtVec3fArray>("Minimum Direction");
+}
 
+NODE_EXECUTION_FUNCTION(principal_curvature)
+{
+    auto field = evaluate_curvature(params, true);
+    if (!field) {
+        return false;
+    }
+    params.set_output("Maximum Curvature", field->k1);
+    params.set_output("Minimum Curvature", field->k2);
+    params.set_output("Maximum Direction", field->direction1);
+    params.set_output("Minimum Direction", field->direction2);
     return true;
 }
 
-NODE_DECLARATION_UI(gaussian_curvature);
+NODE_DECLARATION_UI(principal_curvature);
 
 NODE_DEF_CLOSE_SCOPE
@@ -0,0 +1,216 @@
+#include <pxr/base/vt/array.h>
+
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/algorithms/geodesics.h"
+#include "GCore/algorithms/shortest_path.h"
+#include "geom_node_base.h"
+#include "nodes/core/def/node_def.hpp"
+
+NODE_DEF_OPEN_SCOPE
+
+// Each node keeps what it derived from the last mesh, so that picking other
+// sources on the same mesh only runs the query.
+struct GeodesicDijkstraStorage {
+    static constexpr bool has_storage = false;
+
+    MeshGraph graph;
+    uint64_t topology_version = 0;
+    uint64_t position_version = 0;
+    ShortestPathSearch search;
+};
+
+struct GeodesicFastMarchingStorage {
+    static constexpr bool has_storage = false;
+
+    FastMarching solver;
+    uint64_t topology_version = 0;
+    uint64_t position_version = 0;
+};
+
+struct GeodesicHeatStorage {
+    static constexpr bool has_storage = false;
+
+    HeatGeodesics solver;
+    uint64_t topology_version = 0;
+    uint64_t position_version = 0;
+};
+
+static void declare_geodesic_distance(NodeDeclarationBuilder& b)
+{
+    b.add_input<Geometry>("Mesh");
+    b.add_input<size_t>("Source Vertex");
+    // Optional further sources, e.g. a path from shortest_path.
+    b.add_input<std::list<size_t>>("Source Vertices");
+    b.add_input<std::string>("Quantity Name").default_val("geodesic_distance");
+}
+
+static void declare_geodesic_distance_outputs(NodeDeclarationBuilder& b)
+{
+    // The input mesh with the distances as a vertex scalar quantity.
+    b.add_output<Geometry>("Mesh");
+    b.add_output<pxr::VtArray<float>>("Distance");
+}
+
+static std::vector<uint32_t> geodesic_sources(ExeParams& params)
+{
+    std::vector<uint32_t> sources;
+    sources.push_back(uint32_t(params.get_input<size_t>("Source Vertex")));
+    for (size_t v : params.get_input<std::list<size_t>>("Source Vertices")) {
+        sources.push_back(uint32_t(v));
+    }
+    return sources;
+}
+
+static void set_geodesic_outputs(
+    ExeParams& params,
+    Geometry& geometry,
+    const std::vector<float>& distance)
+{
+    pxr::VtArray<float> field(distance.begin(), distance.end());
+    auto mesh = geometry.get_component<MeshComponent>();
+    mesh->add_vertex_scalar_quantity(
+        params.get_input<std::string>("Quantity Name"), field);
+    params.set_output("Mesh", std::move(geometry));
+    params.set_output("Distance", std::move(field));
+}
+
+// Exact shortest distances along mesh edges. Overestimates the geodesic
+// distance, depending on how the edges are oriented, but never fails.
+NODE_DECLARATION_FUNCTION(geodesic_distance_dijkstra)
+{
+    declare_geodesic_distance(b);
+    declare_geodesic_distance_outputs(b);
+}
+
+NODE_EXECUTION_FUNCTION(geodesic_distance_dijkstra)
+{
+    auto geometry = params.get_input<Geometry>("Mesh");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << "Geodesic distance: no input mesh" << std::endl;
+        return false;
+    }
+
+    auto& storage = params.get_storage<GeodesicDijkstraStorage&>();
+    if (storage.topology_version != mesh->topology_version()) {
+        if (!storage.graph.build(
+                mesh->get_vertices(),
+                mesh->get_face_vertex_counts(),
+                mesh->get_face_vertex_indices())) {
+            storage.topology_version = 0;
+            std::cerr << "Geodesic distance: invalid mesh topology"
+                      << std::endl;
+            return false;
+        }
+        storage.topology_version = mesh->topology_version();
+        storage.position_version = mesh->position_version();
+    }
+    else if (storage.position_version != mesh->position_version()) {
+        storage.graph.update_weights(mesh->get_vertices());
+        storage.position_version = mesh->position_version();
+    }
+
+    std::vector<float> distance;
+    storage.search.distances(storage.graph, geodesic_sources(params), distance);
+    set_geodesic_outputs(params, geometry, distance);
+    return true;
+}
+
+NODE_DECLARATION_UI(geodesic_distance_dijkstra);
+
+// Fast Marching on the triangulated mesh: first-order accurate, one pass.
+NODE_DECLARATION_FUNCTION(geodesic_distance_fast_marching)
+{
+    declare_geodesic_distance(b);
+    declare_geodesic_distance_outputs(b);
+}
+
+NODE_EXECUTION_FUNCTION(geodesic_distance_fast_marching)
+{
+    auto geometry = params.get_input<Geometry>("Mesh");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << "Geodesic distance: no input mesh" << std::endl;
+        return false;
+    }
+
+    auto& storage = params.get_storage<GeodesicFastMarchingStorage&>();
+    if (storage.topology_version != mesh->topology_version() ||
+        storage.position_version != mesh->position_version()) {
+        if (!storage.solver.build(
+                mesh->get_vertices(),
+                mesh->get_face_vertex_counts(),
+                mesh->get_face_vertex_indices())) {
+            storage.topology_version = 0;
+            std::cerr << "Geodesic distance: invalid mesh topology"
+                      << std::endl;
+            return false;
+        }
+        storage.topology_version = mesh->topology_version();
+        storage.position_version = mesh->position_version();
+    }
+
+    std::vector<float> distance;
+    storage.solver.compute(geodesic_sources(params), distance);
+    set_geodesic_outputs(params, geometry, distance);
+    return true;
+}
+
+NODE_DECLARATION_UI(geodesic_distance_fast_marching);
+
+// Heat method. The first run on a mesh factors two sparse systems; later runs
+// with other sources are two back-substitutions.
+NODE_DECLARATION_FUNCTION(geodesic_distance_heat)
+{
+    declare_geodesic_distance(b);
+    // Diffusion time in units of the squared mean edge length.
+    b.add_input<float>("Time Step Scale")
+        .default_val(1.0f)
+        .min(0.1f)
+        .max(10.0f);
+    declare_geodesic_distance_outputs(b);
+}
+
+NODE_EXECUTION_FUNCTION(geodesic_distance_heat)
+{
+    auto geometry = params.get_input<Geometry>("Mesh");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << "Geodesic distance: no input mesh" << std::endl;
+        return false;
+    }
+    auto time_scale = params.get_input<float>("Time Step Scale");
+
+    auto& storage = params.get_storage<GeodesicHeatStorage&>();
+    if (storage.topology_version != mesh->topology_version() ||
+        storage.position_version != mesh->position_version() ||
+        storage.solver.time_scale() != time_scale) {
+        if (!storage.solver.build(
+                mesh->get_vertices(),
+                mesh->get_face_vertex_counts(),
+                mesh->get_face_vertex_indices(),
+                time_scale)) {
+            storage.topology_version = 0;
+            std::cerr << "Geodesic distance: invalid mesh or failed "
+                         "factorization"
+                      << std::endl;
+            return false;
+        }
+        storage.topology_version = mesh->topology_version();
+        storage.position_version = mesh->position_version();
+    }
+
+    std::vector<float> distance;
+    storage.solver.compute(geodesic_sources(params), distance);
+    set_geodesic_outputs(params, geometry, distance);
+    return true;
+}
+
+NODE_DECLARATION_UI(geodesic_distance_heat);
+
+NODE_DEF_CLOSE_SCOPE
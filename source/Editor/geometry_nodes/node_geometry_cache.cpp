@@ -0,0 +1,67 @@
+#include <sstream>
+
+#include "GCore/GOP.h"
+#include "GCore/geometry_cache.h"
+#include "geom_node_base.h"
+
+NODE_DEF_OPEN_SCOPE
+
+// Writes the geometry to a memory-mappable cache file and passes it through,
+// so the node can sit in the middle of a chain.
+NODE_DECLARATION_FUNCTION(write_geometry_cache)
+{
+    b.add_input<Geometry>("Geometry");
+    b.add_input<std::string>("File Name").default_val("geometry.cache");
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(write_geometry_cache)
+{
+    auto geometry = params.get_input<Geometry>("Geometry");
+    auto file_name = params.get_input<std::string>("File Name");
+
+    if (!write_geometry_cache(geometry, file_name)) {
+        return false;
+    }
+
+    params.set_output("Geometry", std::move(geometry));
+    return true;
+}
+
+NODE_DECLARATION_UI(write_geometry_cache);
+
+// Maps a cache written by write_geometry_cache. "Columns" is a comma-separated
+// list of column name prefixes (e.g. "mesh/vertices,mesh/face_"); empty loads
+// every column.
+NODE_DECLARATION_FUNCTION(read_geometry_cache)
+{
+    b.add_input<std::string>("File Name").default_val("geometry.cache");
+    b.add_input<std::string>("Columns").default_val("");
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(read_geometry_cache)
+{
+    auto file_name = params.get_input<std::string>("File Name");
+    auto column_list = params.get_input<std::string>("Columns");
+
+    std::vector<std::string> columns;
+    std::istringstream stream(column_list);
+    std::string column;
+    while (std::getline(stream, column, ',')) {
+        if (!column.empty()) {
+            columns.push_back(column);
+        }
+    }
+
+    Geometry geometry;
+    if (!read_geometry_cache(file_name, geometry, columns)) {
+        return false;
+    }
+
+    params.set_output("Geometry", std::move(geometry));
+    return true;
+}
+
+NODE_DECLARATION_UI(read_geometry_cache);
+NODE_DEF_CLOSE_SCOPE
@@ -1,49 +1,14 @@
 #include <iostream>
-#include <unordered_set>
-#include <utility>
+#include <memory>
+#include <string>
 
 #include "GCore/Components/MeshOperand.h"
-#include "GCore/util_openmesh_bind.h"
-#include "OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh"
+#include "GCore/Components/SpatialIndexComponent.h"
+#include "GCore/algorithms/remeshing.h"
+#include "Logger/Logger.h"
 #include "geom_node_base.h"
 #include "nodes/core/def/node_def.hpp"
 
-typedef OpenMesh::TriMesh_ArrayKernelT<> MyMesh;
-
-void split_edges(std::shared_ptr<MyMesh> halfedge_mesh, float upper_bound)
-{
-    // TODO: split all edges at their midpoint that are longer then upper_bound
-}
-
-void collapse_edges(std::shared_ptr<MyMesh> halfedge_mesh, float lower_bound)
-{
-    // TODO: collapse all edges shorter than lower_bound into their midpoint
-}
-
-void flip_edges(std::shared_ptr<MyMesh> halfedge_mesh)
-{
-    // TODO: flip edges in order to minimize the deviation from valence 6
-    // (or 4 on boundaries)
-}
-
-void relocate_vertices(std::shared_ptr<MyMesh> halfedge_mesh, float lambda)
-{
-    // TODO: relocate vertices towards its gravity-weighted centroid
-}
-
-void isotropic_remeshing(
-    std::shared_ptr<MyMesh> halfedge_mesh,
-    float target_edge_length,
-    int num_iterations,
-    float lambda)
-{
-    for (int i = 0; i < num_iterations; ++i) {
-        split_edges(halfedge_mesh, target_edge_length * 4.0f / 3.0f);
-        collapse_edges(halfedge_mesh, target_edge_length * 4.0f / 5.0f);
-        flip_edges(halfedge_mesh);
-        relocate_vertices(halfedge_mesh, lambda);
-    }
-}
 NODE_DEF_OPEN_SCOPE
 NODE_DECLARATION_FUNCTION(isotropic_remeshing)
 {
@@ -62,6 +27,17 @@ NODE_DECLARATION_FUNCTION(isotropic_remeshing)
     // The input-4 is the lambda value for vertex relocation
     b.add_input<float>("Lambda").default_val(1.0f).min(0.0f).max(1.0f);
 
+    // The input-5 makes the edge length follow the curvature when positive:
+    // the allowed distance to the surface, relative to the target length
+    b.add_input<float>("Adaptive Tolerance")
+        .default_val(0.0f)
+        .min(0.0f)
+        .max(1.0f);
+
+    // The input-6 optionally names a vertex scalar quantity with the
+    // curvature to adapt to; it is estimated from the mesh otherwise
+    b.add_input<std::string>("Curvature Quantity").default_val("");
+
     // The output is a remeshed version of the input mesh
     b.add_output<Geometry>("Remeshed Mesh");
 }
@@ -77,42 +53,76 @@ NODE_EXECUTION_FUNCTION(isotropic_remeshing)
                   << std::endl;
         return false;
     }
-    auto halfedge_mesh = operand_to_openmesh_trimesh(&geometry);
 
-    // Get the target edge length and number of iterations
-    float target_edge_length = params.get_input<float>("Target Edge Length");
-    int num_iterations = params.get_input<int>("Iterations");
-    float lambda = params.get_input<float>("Lambda");
-    if (target_edge_length <= 0.0f) {
+    IsotropicRemesher::Options options;
+    options.target_length = params.get_input<float>("Target Edge Length");
+    options.iterations = params.get_input<int>("Iterations");
+    options.relaxation = params.get_input<float>("Lambda");
+    options.adaptive_tolerance = params.get_input<float>("Adaptive Tolerance");
+    if (options.target_length <= 0.0f) {
         std::cerr << "Isotropic Remeshing Node: Target edge length must be "
                      "greater than zero."
                   << std::endl;
         return false;
     }
 
-    if (num_iterations < 0) {
+    if (options.iterations < 0) {
         std::cerr << "Isotropic Remeshing Node: Number of iterations must be "
                      "greater than zero."
                   << std::endl;
         return false;
     }
 
-    halfedge_mesh->request_vertex_status();
-    halfedge_mesh->request_edge_status();
-    halfedge_mesh->request_face_status();
-    halfedge_mesh->request_halfedge_status();
-    halfedge_mesh->request_face_normals();
-    halfedge_mesh->request_vertex_normals();
-    halfedge_mesh->request_halfedge_normals();
+    const auto quantity = params.get_input<std::string>("Curvature Quantity");
+    if (options.adaptive_tolerance > 0.0f && !quantity.empty()) {
+        options.curvature = mesh->get_vertex_scalar_quantity(quantity);
+        if (options.curvature.size() != mesh->get_vertices().size()) {
+            std::cerr << "Isotropic Remeshing Node: No vertex quantity named "
+                      << quantity << "." << std::endl;
+            return false;
+        }
+    }
+
+    options.reference =
+        SpatialIndexComponent::get_or_create(geometry)->triangle_bvh(*mesh);
+
+    IsotropicRemesher remesher;
+    if (!remesher.remesh(
+            mesh->get_vertices(),
+            mesh->get_face_vertex_counts(),
+            mesh->get_face_vertex_indices(),
+            options)) {
+        std::cerr << "Isotropic Remeshing Node: The input must be an "
+                     "oriented manifold mesh."
+                  << std::endl;
+        return false;
+    }
 
-    // Isotropic remeshing
-    isotropic_remeshing(
-        halfedge_mesh, target_edge_length, num_iterations, lambda);
+    const auto& stats = remesher.stats();
+    log::info(
+        "Isotropic Remeshing: %zu -> %zu triangles, %zu splits, %zu "
+        "collapses, %zu flips in %zu rounds, %g s",
+        stats.input_faces,
+        stats.output_faces,
+        stats.splits,
+        stats.collapses,
+        stats.flips,
+        stats.rounds,
+        stats.seconds);
+
+    pxr::VtArray<pxr::GfVec3f> vertices;
+    pxr::VtArray<int> face_vertex_counts, face_vertex_indices;
+    remesher.extract(vertices, face_vertex_counts, face_vertex_indices);
+
+    Geometry remeshed;
+    auto remeshed_mesh = std::make_shared<MeshComponent>(&remeshed);
+    remeshed_mesh->set_vertices(vertices);
+    remeshed_mesh->set_face_vertex_counts(face_vertex_counts);
+    remeshed_mesh->set_face_vertex_indices(face_vertex_indices);
+    remeshed.attach_component(remeshed_mesh);
 
-    // Convert the remeshed halfedge mesh back to Geometry
-    auto remeshed_geometry = openmesh_to_operand_trimesh(halfedge_mesh.get());
     // Set the output of the node
-    params.set_output("Remeshed Mesh", std::move(*remeshed_geometry));
+    params.set_output("Remeshed Mesh", std::move(remeshed));
 
     return true;
 }
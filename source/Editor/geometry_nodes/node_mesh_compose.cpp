@@ -1,3 +1,5 @@
+#include <iostream>
+
 #include "GCore/Components/MeshOperand.h"
 #include "geom_node_base.h"
 
@@ -13,34 +15,37 @@ NODE_DECLARATION_FUNCTION(mesh_compose)
     b.add_output<Geometry>("Mesh");
 }
 
+// The new mesh adopts the input arrays without copying their elements (see
+// geom_node_base.h) and is moved, not copied, into the output.
 NODE_EXECUTION_FUNCTION(mesh_compose)
 {
-    Geometry geometry;
-    auto mesh_component = std::make_shared<MeshComponent>(&geometry);
+    const auto& vertices =
+        params.get_input<const pxr::VtVec3fArray&>("Vertices");
+    const auto& faceVertexCounts =
+        params.get_input<const pxr::VtArray<int>&>("FaceVertexCounts");
+    const auto& faceVertexIndices =
+        params.get_input<const pxr::VtArray<int>&>("FaceVertexIndices");
 
-    auto vertices = params.get_input<pxr::VtVec3fArray>("Vertices");
-    auto faceVertexCounts =
-        params.get_input<pxr::VtArray<int>>("FaceVertexCounts");
-    auto faceVertexIndices =
-        params.get_input<pxr::VtArray<int>>("FaceVertexIndices");
-    auto normals = params.get_input<pxr::VtArray<pxr::GfVec3f>>("Normals");
-    auto texcoordsArray =
-        params.get_input<pxr::VtArray<pxr::GfVec2f>>("Texcoords");
-
-    if (vertices.size() > 0 && faceVertexCounts.size() > 0 &&
-        faceVertexIndices.size() > 0) {
-        mesh_component->set_vertices(vertices);
-        mesh_component->set_face_vertex_counts(faceVertexCounts);
-        mesh_component->set_face_vertex_indices(faceVertexIndices);
-        mesh_component->set_normals(normals);
-        mesh_component->set_texcoords_array(texcoordsArray);
-        geometry.attach_component(mesh_component);
-    }
-    else {
-        // TODO: Throw something
+    if (vertices.empty() || faceVertexCounts.empty() ||
+        faceVertexIndices.empty()) {
+        std::cerr << "Mesh Compose: Vertices, FaceVertexCounts and "
+                     "FaceVertexIndices must not be empty."
+                  << std::endl;
+        return false;
     }
 
-    params.set_output("Mesh", geometry);
+    Geometry geometry;
+    auto mesh_component = std::make_shared<MeshComponent>(&geometry);
+    mesh_component->set_vertices(vertices);
+    mesh_component->set_face_vertex_counts(faceVertexCounts);
+    mesh_component->set_face_vertex_indices(faceVertexIndices);
+    mesh_component->set_normals(
+        params.get_input<const pxr::VtArray<pxr::GfVec3f>&>("Normals"));
+    mesh_component->set_texcoords_array(
+        params.get_input<const pxr::VtArray<pxr::GfVec2f>&>("Texcoords"));
+    geometry.attach_component(mesh_component);
+
+    params.set_output("Mesh", std::move(geometry));
     return true;
 }
 
@@ -1,3 +1,5 @@
+#include <iostream>
+
 #include "GCore/Components/MeshOperand.h"
 #include "geom_node_base.h"
 
@@ -13,27 +15,26 @@ NODE_DECLARATION_FUNCTION(mesh_decompose)
     b.add_output<pxr::VtArray<pxr::GfVec2f>>("Texcoords");
 }
 
+// The outputs share storage with the input mesh (see geom_node_base.h), so
+// decomposing costs no element copies; the mesh is read in place rather
+// than copied out of the socket.
 NODE_EXECUTION_FUNCTION(mesh_decompose)
 {
-    Geometry geometry = params.get_input<Geometry>("Mesh");
+    const auto& geometry = params.get_input<const Geometry&>("Mesh");
     auto mesh_component = geometry.get_component<MeshComponent>();
 
-    if (mesh_component) {
-        auto vertices = mesh_component->get_vertices();
-        auto faceVertexCounts = mesh_component->get_face_vertex_counts();
-        auto faceVertexIndices = mesh_component->get_face_vertex_indices();
-        auto normals = mesh_component->get_normals();
-        auto texcoordsArray = mesh_component->get_texcoords_array();
-
-        params.set_output("Vertices", vertices);
-        params.set_output("FaceVertexCounts", faceVertexCounts);
-        params.set_output("FaceVertexIndices", faceVertexIndices);
-        params.set_output("Normals", normals);
-        params.set_output("Texcoords", texcoordsArray);
-    }
-    else {
-        // TODO: Throw something
+    if (!mesh_component) {
+        std::cerr << "Mesh Decompose: No input mesh provided." << std::endl;
+        return false;
     }
+
+    params.set_output("Vertices", mesh_component->get_vertices());
+    params.set_output(
+        "FaceVertexCounts", mesh_component->get_face_vertex_counts());
+    params.set_output(
+        "FaceVertexIndices", mesh_component->get_face_vertex_indices());
+    params.set_output("Normals", mesh_component->get_normals());
+    params.set_output("Texcoords", mesh_component->get_texcoords_array());
     return true;
 }
 
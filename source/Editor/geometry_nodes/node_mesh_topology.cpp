@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/algorithms/mesh_topology.h"
+#include "geom_node_base.h"
+#include "nodes/core/def/node_def.hpp"
+
+NODE_DEF_OPEN_SCOPE
+
+// The analysis of the last input mesh, redone only when its topology
+// version or vertex count changes.
+struct MeshTopologyStorage {
+    static constexpr bool has_storage = false;
+
+    MeshTopology topology;
+};
+
+static const MeshTopology* analyze_mesh(
+    ExeParams& params,
+    const Geometry& geometry,
+    const char* node_name)
+{
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << node_name << ": No input mesh provided." << std::endl;
+        return nullptr;
+    }
+    auto& topology = params.get_storage<MeshTopologyStorage&>().topology;
+    if (!topology.analyze(
+            mesh->get_face_vertex_counts(),
+            mesh->get_face_vertex_indices(),
+            mesh->get_vertices().size(),
+            mesh->topology_version())) {
+        std::cerr << node_name << ": Invalid mesh topology." << std::endl;
+        return nullptr;
+    }
+    return &topology;
+}
+
+template<typename T>
+static pxr::VtArray<int> to_int_array(const std::vector<T>& values)
+{
+    pxr::VtArray<int> result(values.size());
+    std::copy(values.begin(), values.end(), result.begin());
+    return result;
+}
+
+// Summary of the mesh connectivity. The output geometry carries the
+// component of every vertex and its non-manifold flag as the vertex scalar
+// quantities "component" and "non_manifold".
+NODE_DECLARATION_FUNCTION(mesh_topology)
+{
+    b.add_input<Geometry>("Geometry");
+
+    b.add_output<Geometry>("Geometry");
+    b.add_output<int>("Euler Characteristic");
+    b.add_output<int>("Component Count");
+    b.add_output<int>("Boundary Loop Count");
+    b.add_output<bool>("Manifold");
+    b.add_output<bool>("Closed");
+}
+
+NODE_EXECUTION_FUNCTION(mesh_topology)
+{
+    auto geometry = params.get_input<Geometry>("Geometry");
+    auto topology = analyze_mesh(params, geometry, "Mesh Topology");
+    if (!topology) {
+        return false;
+    }
+
+    pxr::VtArray<float> component(topology->vertex_count());
+    pxr::VtArray<float> non_manifold(topology->vertex_count());
+    std::copy(
+        topology->vertex_components().begin(),
+        topology->vertex_components().end(),
+        component.begin());
+    std::copy(
+        topology->non_manifold_vertices().begin(),
+        topology->non_manifold_vertices().end(),
+        non_manifold.begin());
+    auto mesh = geometry.get_component<MeshComponent>();
+    mesh->add_vertex_scalar_quantity("component", component);
+    mesh->add_vertex_scalar_quantity("non_manifold", non_manifold);
+
+    params.set_output("Geometry", std::move(geometry));
+    params.set_output(
+        "Euler Characteristic", int(topology->euler_characteristic()));
+    params.set_output("Component Count", int(topology->component_count()));
+    params.set_output("Boundary Loop Count", int(topology->loop_count()));
+    params.set_output("Manifold", topology->is_manifold());
+    params.set_output("Closed", topology->is_closed());
+    return true;
+}
+
+NODE_DECLARATION_UI(mesh_topology);
+
+// Components are numbered from 0 in the order of their lowest vertex; a
+// vertex that no face uses is a component of its own.
+NODE_DECLARATION_FUNCTION(mesh_connected_components)
+{
+    b.add_input<Geometry>("Geometry");
+
+    b.add_output<pxr::VtArray<int>>("Vertex Components");
+    b.add_output<pxr::VtArray<int>>("Face Components");
+    b.add_output<int>("Component Count");
+}
+
+NODE_EXECUTION_FUNCTION(mesh_connected_components)
+{
+    const auto& geometry = params.get_input<const Geometry&>("Geometry");
+    auto topology = analyze_mesh(params, geometry, "Connected Components");
+    if (!topology) {
+        return false;
+    }
+
+    params.set_output(
+        "Vertex Components", to_int_array(topology->vertex_components()));
+    params.set_output(
+        "Face Components", to_int_array(topology->face_components()));
+    params.set_output("Component Count", int(topology->component_count()));
+    return true;
+}
+
+NODE_DECLARATION_UI(mesh_connected_components);
+
+// Closed boundary loops, longest first, each oriented like the faces it
+// bounds.
+NODE_DECLARATION_FUNCTION(mesh_boundary_loops)
+{
+    b.add_input<Geometry>("Geometry");
+
+    b.add_output<std::vector<std::vector<int>>>("Boundary Loops");
+}
+
+NODE_EXECUTION_FUNCTION(mesh_boundary_loops)
+{
+    const auto& geometry = params.get_input<const Geometry&>("Geometry");
+    auto topology = analyze_mesh(params, geometry, "Boundary Loops");
+    if (!topology) {
+        return false;
+    }
+
+    const auto& offsets = topology->loop_offsets();
+    const auto& vertices = topology->loop_vertices();
+    std::vector<std::vector<int>> loops(topology->loop_count());
+    for (size_t l = 0; l < loops.size(); ++l) {
+        loops[l].assign(
+            vertices.begin() + offsets[l], vertices.begin() + offsets[l + 1]);
+    }
+
+    params.set_output("Boundary Loops", std::move(loops));
+    return true;
+}
+
+NODE_DECLARATION_UI(mesh_boundary_loops);
+
+// Non-Manifold Vertices holds a 0/1 flag per vertex, Non-Manifold Edges the
+// vertex pairs of edges used by more than two faces.
+NODE_DECLARATION_FUNCTION(mesh_non_manifold)
+{
+    b.add_input<Geometry>("Geometry");
+
+    b.add_output<pxr::VtArray<int>>("Non-Manifold Vertices");
+    b.add_output<pxr::VtArray<int>>("Non-Manifold Edges");
+    b.add_output<int>("Invalid Face Count");
+    b.add_output<int>("Inconsistent Edge Count");
+}
+
+NODE_EXECUTION_FUNCTION(mesh_non_manifold)
+{
+    const auto& geometry = params.get_input<const Geometry&>("Geometry");
+    auto topology = analyze_mesh(params, geometry, "Non-Manifold");
+    if (!topology) {
+        return false;
+    }
+
+    pxr::VtArray<int> edges;
+    edges.reserve(topology->non_manifold_edges().size() * 2);
+    for (const auto& edge : topology->non_manifold_edges()) {
+        edges.push_back(int(edge[0]));
+        edges.push_back(int(edge[1]));
+    }
+
+    params.set_output(
+        "Non-Manifold Vertices",
+        to_int_array(topology->non_manifold_vertices()));
+    params.set_output("Non-Manifold Edges", std::move(edges));
+    params.set_output(
+        "Invalid Face Count", int(topology->invalid_face_count()));
+    params.set_output(
+        "Inconsistent Edge Count", int(topology->inconsistent_edge_count()));
+    return true;
+}
+
+NODE_DECLARATION_UI(mesh_non_manifold);
+NODE_DEF_CLOSE_SCOPE
@@ -1,79 +1,44 @@
-#include <Eigen/Dense>
-#include <Eigen/Sparse>
-#include <Eigen/SparseLU>
 #include <cmath>
 #include <iostream>
 #include <memory>
+#include <string>
 
 #include "GCore/Components/MeshOperand.h"
-#include "GCore/util_openmesh_bind.h"
+#include "GCore/Components/SpatialIndexComponent.h"
+#include "GCore/algorithms/progressive_mesh.h"
+#include "GCore/algorithms/qem.h"
+#include "Logger/Logger.h"
 #include "geom_node_base.h"
 #include "nodes/core/def/node_def.hpp"
 
-typedef OpenMesh::PolyMesh_ArrayKernelT<> MyMesh;
+NODE_DEF_OPEN_SCOPE
 
-void qem(
-    std::shared_ptr<MyMesh> halfedge_mesh,
-    float simplification_ratio,
-    float distance_threshold)
-{
-    // TODO: Implement QEM mesh simplification algorithm.
-
-    /*
-     * QEM (Quadric Error Metrics) Mesh Simplification Algorithm
-     *
-     * 1. Compute the Q matrices for all the initial vertices.
-     *    - For each vertex, accumulate the quadric error matrices derived from
-     *      the planes of its adjacent faces.
-     *    - The quadric for a face is constructed from its plane equation.
-     *
-     * 2. Select all valid pairs.
-     *    - For each edge (v1, v2), consider the pair as valid for contraction.
-     *    - Optional: Consider non-edge vertex pairs based on distance
-     *      threshold.
-     *
-     * 3. Compute the optimal contraction target v_bar for each valid pair
-     *    (v1, v2).
-     *    - The optimal position minimizes the quadric error
-     *      v_bar^T (Q1 + Q2) v_bar.
-     *    - The cost of contracting the pair is the error at this optimal
-     *      position.
-     *
-     * 4. Place all the pairs in a heap keyed on cost with the minimum cost pair
-     *    at the top.
-     *    - Use a priority queue to efficiently extract the pair with the lowest
-     *      cost.
-     *
-     * 5. Iteratively remove the pair (v1, v2) of least cost from the heap,
-     *    contract this pair, and update the costs of all valid pairs involving
-     *    v1.
-     *    - After contraction, update the affected quadrics and heap entries.
-     *
-     * 6. Iterate until the number of faces in the mesh is less than
-     *    simplification ratio * number of faces in the original mesh.
-     *
-     * The initial Q matrices are computed by summing the outer products of the
-     * plane equations of all faces adjacent to each vertex.
-     */
-
-    // Placeholder. You need to implement the QEM algorithm here.
-    return;
-}
+// Keeps the progressive mesh of the last input so that moving the level of
+// detail only replays vertex splits.
+struct ProgressiveQemStorage {
+    static constexpr bool has_storage = false;
 
-NODE_DEF_OPEN_SCOPE
+    ProgressiveMesh mesh;
+    uint64_t topology_version = 0;
+    uint64_t position_version = 0;
+    float ratio = -1;
+    float distance_threshold = -1;
+    std::string written_file;
+};
 
 NODE_DECLARATION_FUNCTION(qem)
 {
     // Input-1: Original 3D mesh
     b.add_input<Geometry>("Input");
     // Input-2: Mesh simplification ratio, AKA the ratio of the number of
-    // vertices in the simplified mesh to the number of vertices in the original
-    // mesh
+    // triangles in the simplified mesh to the number of triangles in the
+    // (triangulated) original mesh
     b.add_input<float>("Simplification Ratio")
         .default_val(0.5f)
         .min(0.0f)
         .max(1.0f);
-    // Input-3: Distance threshold for non-edge vertex pairs
+    // Input-3: Distance threshold for non-edge vertex pairs, as a fraction of
+    // the bounding box diagonal; 0 contracts along edges only
     b.add_input<float>("Non-edge Distance Threshold")
         .default_val(0.01f)
         .min(0.0f)
@@ -91,43 +56,169 @@ NODE_EXECUTION_FUNCTION(qem)
         params.get_input<float>("Non-edge Distance Threshold");
 
     // Avoid processing the node when there is no input
-    if (!input_mesh.get_component<MeshComponent>()) {
+    auto mesh = input_mesh.get_component<MeshComponent>();
+    if (!mesh) {
         std::cerr << "QEM: No input mesh provided." << std::endl;
         return false;
     }
 
-    /* ----------------------------- Preprocess
-     *-------------------------------
-     ** Create a halfedge structure (using OpenMesh) for the input mesh. The
-     ** half-edge data structure is a widely used data structure in
-     *geometric
-     ** processing, offering convenient operations for traversing and
-     *modifying
-     ** mesh elements.
-     */
+    QemSimplifier::Options options;
+    options.pair_distance = distance_threshold;
+    if (options.pair_distance > 0) {
+        options.point_tree =
+            SpatialIndexComponent::get_or_create(input_mesh)->point_tree(*mesh);
+    }
 
-    // Initialization
-    auto halfedge_mesh = operand_to_openmesh(&input_mesh);
+    QemSimplifier simplifier;
+    if (!simplifier.build(
+            mesh->get_vertices(),
+            mesh->get_face_vertex_counts(),
+            mesh->get_face_vertex_indices(),
+            options)) {
+        std::cerr << "QEM: Invalid mesh topology." << std::endl;
+        return false;
+    }
 
-    halfedge_mesh->request_vertex_status();
-    halfedge_mesh->request_edge_status();
-    halfedge_mesh->request_face_status();
-    halfedge_mesh->request_halfedge_status();
+    const auto& stats = simplifier.stats();
+    simplifier.simplify(
+        size_t(std::floor(simplification_ratio * stats.input_faces)));
+
+    Geometry geometry;
+    auto simplified = std::make_shared<MeshComponent>(&geometry);
+    geometry.attach_component(simplified);
+
+    pxr::VtArray<pxr::GfVec3f> vertices;
+    pxr::VtArray<int> face_vertex_counts;
+    pxr::VtArray<int> face_vertex_indices;
+    simplifier.extract(vertices, face_vertex_counts, face_vertex_indices);
+    simplified->set_vertices(vertices);
+    simplified->set_face_vertex_counts(face_vertex_counts);
+    simplified->set_face_vertex_indices(face_vertex_indices);
+
+    log::info(
+        "QEM: %zu -> %zu triangles, %zu collapses (%zu non-edge pairs), "
+        "setup %g s, simplify %g s, %zu collapses/s",
+        stats.input_faces,
+        stats.output_faces,
+        stats.collapses,
+        stats.non_edge_pairs,
+        stats.setup_seconds,
+        stats.simplify_seconds,
+        size_t(stats.collapses_per_second()));
 
-    // QEM simplification
-    qem(halfedge_mesh, simplification_ratio, distance_threshold);
+    // Set the output of the nodes
+    params.set_output("Output", std::move(geometry));
 
-    // Convert the simplified mesh back to the operand
-    auto geometry = openmesh_to_operand(halfedge_mesh.get());
+    return true;
+}
 
-    auto mesh = geometry->get_component<MeshComponent>();
+NODE_DECLARATION_UI(qem);
 
-    // Set the output of the nodes
-    params.set_output("Output", std::move(*geometry));
+// Same simplification, recorded as a progressive mesh. "Level of Detail" picks
+// any level between the simplified mesh (0) and the input (1) without
+// simplifying again; "File Name", if set, receives the progressive mesh as a
+// binary stream.
+NODE_DECLARATION_FUNCTION(qem_progressive)
+{
+    b.add_input<Geometry>("Input");
+    b.add_input<float>("Simplification Ratio")
+        .default_val(0.5f)
+        .min(0.0f)
+        .max(1.0f);
+    b.add_input<float>("Non-edge Distance Threshold")
+        .default_val(0.01f)
+        .min(0.0f)
+        .max(1.0f);
+    b.add_input<float>("Level of Detail").default_val(0.0f).min(0.0f).max(1.0f);
+    b.add_input<std::string>("File Name").default_val("");
+    b.add_output<Geometry>("Output");
+}
+
+NODE_EXECUTION_FUNCTION(qem_progressive)
+{
+    auto input_mesh = params.get_input<Geometry>("Input");
+    auto simplification_ratio = params.get_input<float>("Simplification Ratio");
+    auto distance_threshold =
+        params.get_input<float>("Non-edge Distance Threshold");
+    auto level_of_detail = params.get_input<float>("Level of Detail");
+    auto file_name = params.get_input<std::string>("File Name");
 
+    auto mesh = input_mesh.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << "QEM: No input mesh provided." << std::endl;
+        return false;
+    }
+
+    auto& storage = params.get_storage<ProgressiveQemStorage&>();
+    if (storage.topology_version != mesh->topology_version() ||
+        storage.position_version != mesh->position_version() ||
+        storage.ratio != simplification_ratio ||
+        storage.distance_threshold != distance_threshold) {
+        QemSimplifier::Options options;
+        options.pair_distance = distance_threshold;
+        if (options.pair_distance > 0) {
+            options.point_tree =
+                SpatialIndexComponent::get_or_create(input_mesh)->point_tree(
+                    *mesh);
+        }
+        if (!storage.mesh.build(
+                mesh->get_vertices(),
+                mesh->get_face_vertex_counts(),
+                mesh->get_face_vertex_indices(),
+                simplification_ratio,
+                options)) {
+            storage = ProgressiveQemStorage();
+            std::cerr << "QEM: Invalid mesh topology." << std::endl;
+            return false;
+        }
+        storage.topology_version = mesh->topology_version();
+        storage.position_version = mesh->position_version();
+        storage.ratio = simplification_ratio;
+        storage.distance_threshold = distance_threshold;
+        storage.written_file.clear();
+
+        const auto& stats = storage.mesh.stats();
+        log::info(
+            "QEM: %zu -> %zu triangles, %zu vertex splits, setup %g s, "
+            "simplify %g s, %zu collapses/s",
+            stats.input_faces,
+            stats.output_faces,
+            storage.mesh.split_count(),
+            stats.setup_seconds,
+            stats.simplify_seconds,
+            size_t(stats.collapses_per_second()));
+    }
+
+    if (!file_name.empty() && file_name != storage.written_file) {
+        if (!storage.mesh.write(file_name)) {
+            return false;
+        }
+        storage.written_file = file_name;
+    }
+
+    auto& progressive = storage.mesh;
+    const size_t base_faces = progressive.base_face_count();
+    const size_t full_faces = progressive.stats().input_faces;
+    progressive.set_level(progressive.level_for_face_count(
+        base_faces +
+        size_t(std::round(level_of_detail * (full_faces - base_faces)))));
+
+    Geometry geometry;
+    auto simplified = std::make_shared<MeshComponent>(&geometry);
+    geometry.attach_component(simplified);
+
+    pxr::VtArray<pxr::GfVec3f> vertices;
+    pxr::VtArray<int> face_vertex_counts;
+    pxr::VtArray<int> face_vertex_indices;
+    progressive.extract(vertices, face_vertex_counts, face_vertex_indices);
+    simplified->set_vertices(vertices);
+    simplified->set_face_vertex_counts(face_vertex_counts);
+    simplified->set_face_vertex_indices(face_vertex_indices);
+
+    params.set_output("Output", std::move(geometry));
     return true;
 }
 
-NODE_DECLARATION_UI(qem);
+NODE_DECLARATION_UI(qem_progressive);
 
 NODE_DEF_CLOSE_SCOPE
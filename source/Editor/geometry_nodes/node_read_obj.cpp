@@ -7,6 +7,7 @@
 #include <iostream>
 
 #include "GCore/Components/MeshOperand.h"
+#include "GCore/obj_io.h"
 #include "igl/readOBJ.h"
 #include "nodes/core/def/node_def.hpp"
 
@@ -284,4 +285,58 @@ NODE_EXECUTION_FUNCTION(read_obj_pxr)
 
 NODE_DECLARATION_UI(read_obj_pxr);
 
+// Parses the file in parallel straight into a MeshComponent; meant for large
+// scans, where the nodes above spend most of their time in per-vertex
+// containers and copies.
+NODE_DECLARATION_FUNCTION(read_obj)
+{
+    b.add_input<std::string>("Path").default_val("Default");
+    b.add_output<Geometry>("Geometry");
+}
+
+NODE_EXECUTION_FUNCTION(read_obj)
+{
+    std::filesystem::path executable_path;
+
+#ifdef _WIN32
+    char p[MAX_PATH];
+    GetModuleFileNameA(NULL, p, MAX_PATH);
+    executable_path = std::filesystem::path(p).parent_path();
+#else
+    char p[PATH_MAX];
+    ssize_t count = readlink("/proc/self/exe", p, PATH_MAX);
+    if (count != -1) {
+        p[count] = '\0';
+        executable_path = std::filesystem::path(p).parent_path();
+    }
+    else {
+        throw std::runtime_error("Failed to get executable path.");
+    }
+#endif
+
+    auto path_str = params.get_input<std::string>("Path");
+    std::filesystem::path abs_path;
+    if (!path_str.empty()) {
+        abs_path = std::filesystem::path(path_str);
+    }
+    else {
+        std::cerr << "Path is empty." << std::endl;
+        return false;
+    }
+    if (!abs_path.is_absolute()) {
+        abs_path = executable_path / abs_path;
+    }
+    abs_path = abs_path.lexically_normal();
+
+    Geometry geometry;
+    if (!read_obj(abs_path.string(), geometry)) {
+        return false;
+    }
+
+    params.set_output("Geometry", std::move(geometry));
+    return true;
+}
+
+NODE_DECLARATION_UI(read_obj);
+
 NODE_DEF_CLOSE_SCOPE
@@ -19,6 +19,7 @@
 #include "GCore/Components/MeshOperand.h"
 #include "GCore/Components/SkelComponent.h"
 #include "GCore/Components/XformComponent.h"
+#include "GCore/usd_cache.h"
 #include "geom_node_base.h"
 #include "pxr/usd/usdSkel/animation.h"
 #include "pxr/usd/usdSkel/bindingAPI.h"
@@ -26,11 +27,21 @@
 
 NODE_DEF_OPEN_SCOPE
 
+// Reads the points of the coming time samples in the background while the
+// time code advances.
+struct ReadUsdStorage {
+    static constexpr bool has_storage = false;
+
+    std::shared_ptr<UsdPointsPrefetcher> prefetcher;
+};
+
 NODE_DECLARATION_FUNCTION(read_usd)
 {
     b.add_input<std::string>("File Name").default_val("Default");
     b.add_input<std::string>("Prim Path").default_val("geometry");
     b.add_input<float>("Time Code").default_val(0).min(0).max(240);
+    // Number of time samples of the points read ahead, 0 to read on demand
+    b.add_input<int>("Prefetch").default_val(0).min(0).max(240);
     b.add_output<Geometry>("Geometry");
 }
 
@@ -81,7 +92,9 @@ NODE_EXECUTION_FUNCTION(read_usd)
     }
     abs_path = abs_path.lexically_normal();
 
-    auto stage = pxr::UsdStage::Open(abs_path.string().c_str());
+    auto stage = open_cached_stage(abs_path.string());
+    auto& prefetcher = params.get_storage<ReadUsdStorage&>().prefetcher;
+    const int prefetch = params.get_input<int>("Prefetch");
 
     if (stage) {
         // Here 'c_str' call is necessary since prim_path
@@ -94,8 +107,21 @@ NODE_EXECUTION_FUNCTION(read_usd)
 #else
             {
                 pxr::VtArray<pxr::GfVec3f> points;
-                if (usdgeom.GetPointsAttr())
-                    usdgeom.GetPointsAttr().Get(&points, time);
+                auto points_attr = usdgeom.GetPointsAttr();
+                if (prefetch <= 0 || !points_attr) {
+                    prefetcher.reset();
+                }
+                else if (
+                    !prefetcher || prefetcher->stopped() ||
+                    prefetcher->attribute() != points_attr ||
+                    prefetcher->capacity() != size_t(prefetch)) {
+                    prefetcher = std::make_shared<UsdPointsPrefetcher>(
+                        stage, points_attr, prefetch);
+                }
+                if (prefetcher)
+                    prefetcher->get(time, points);
+                else if (points_attr)
+                    points_attr.Get(&points, time);
                 mesh->set_vertices(points);
 
                 pxr::VtArray<int> counts;
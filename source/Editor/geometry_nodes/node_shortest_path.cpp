@@ -1,29 +1,27 @@
-#include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
+#include <algorithm>
 #include <cstddef>
+#include <iostream>
+#include <list>
 #include <string>
 
 #include "GCore/Components/MeshOperand.h"
 #include "GCore/GOP.h"
+#include "GCore/algorithms/shortest_path.h"
 #include "nodes/core/def/node_def.hpp"
 
-typedef OpenMesh::TriMesh_ArrayKernelT<> MyMesh;
-
-// Return true if the shortest path exists, and fill in the shortest path
-// vertices and the distance. Otherwise, return false.
-bool find_shortest_path(
-    const MyMesh::VertexHandle& start_vertex_handle,
-    const MyMesh::VertexHandle& end_vertex_handle,
-    const MyMesh& omesh,
-    std::list<size_t>& shortest_path_vertex_indices,
-    float& distance)
-{
-    // TODO: Implement the shortest path algorithm
-    // You need to fill in `shortest_path_vertex_indices` and `distance`
+NODE_DEF_OPEN_SCOPE
 
-    return false;
-}
+// The edge graph of the last picked mesh, rebuilt when its topology changes
+// and reweighted when only its positions do, plus the search buffers that
+// are reused from one pick to the next.
+struct ShortestPathStorage {
+    static constexpr bool has_storage = false;
 
-NODE_DEF_OPEN_SCOPE
+    MeshGraph graph;
+    uint64_t topology_version = 0;
+    uint64_t position_version = 0;
+    ShortestPathSearch search;
+};
 
 NODE_DECLARATION_FUNCTION(shortest_path)
 {
@@ -32,6 +30,8 @@ NODE_DECLARATION_FUNCTION(shortest_path)
     b.add_input<Geometry>("Picked Mesh");
     b.add_input<size_t>("Picked Vertex [0] Index");
     b.add_input<size_t>("Picked Vertex [1] Index");
+    // 0: Dijkstra, 1: bidirectional Dijkstra, 2: A*
+    b.add_input<int>("Method").min(0).max(2).default_val(2);
 
     b.add_output<std::list<size_t>>("Shortest Path Vertex Indices");
     b.add_output<float>("Shortest Path Distance");
@@ -50,60 +50,55 @@ NODE_EXECUTION_FUNCTION(shortest_path)
         return false;
     }
 
-    auto mesh = params.get_input<Geometry>("Picked Mesh")
-                    .get_component<MeshComponent>();
-    auto vertices = mesh->get_vertices();
-    auto face_vertex_counts = mesh->get_face_vertex_counts();
-    auto face_vertex_indices = mesh->get_face_vertex_indices();
-
-    // Convert the mesh to OpenMesh
-    MyMesh omesh;
-
-    // Add vertices
-    std::vector<OpenMesh::VertexHandle> vhandles;
-    vhandles.reserve(vertices.size());
-
-    for (auto vertex : vertices) {
-        omesh.add_vertex(OpenMesh::Vec3f(vertex[0], vertex[1], vertex[2]));
+    auto geometry = params.get_input<Geometry>("Picked Mesh");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        std::cerr << "Shortest path: no mesh picked" << std::endl;
+        return false;
     }
 
-    // Add faces
-    size_t start = 0;
-    for (int face_vertex_count : face_vertex_counts) {
-        std::vector<OpenMesh::VertexHandle> face;
-        face.reserve(face_vertex_count);
-        for (int j = 0; j < face_vertex_count; j++) {
-            face.push_back(
-                OpenMesh::VertexHandle(face_vertex_indices[start + j]));
+    auto& storage = params.get_storage<ShortestPathStorage&>();
+    if (storage.topology_version != mesh->topology_version()) {
+        if (!storage.graph.build(
+                mesh->get_vertices(),
+                mesh->get_face_vertex_counts(),
+                mesh->get_face_vertex_indices())) {
+            storage.topology_version = 0;
+            std::cerr << "Shortest path: invalid mesh topology" << std::endl;
+            return false;
         }
-        omesh.add_face(face);
-        start += face_vertex_count;
+        storage.topology_version = mesh->topology_version();
+        storage.position_version = mesh->position_version();
+    }
+    else if (storage.position_version != mesh->position_version()) {
+        storage.graph.update_weights(mesh->get_vertices());
+        storage.position_version = mesh->position_version();
     }
 
     auto start_vertex_index =
         params.get_input<size_t>("Picked Vertex [0] Index");
     auto end_vertex_index = params.get_input<size_t>("Picked Vertex [1] Index");
+    auto method = ShortestPathSearch::Method(
+        std::clamp(params.get_input<int>("Method"), 0, 2));
+
+    ShortestPathSearch::Result result;
+    if (start_vertex_index < storage.graph.vertex_count() &&
+        end_vertex_index < storage.graph.vertex_count()) {
+        result = storage.search.find(
+            storage.graph,
+            uint32_t(start_vertex_index),
+            uint32_t(end_vertex_index),
+            method);
+    }
 
-    // Turn the vertex indices into OpenMesh vertex handles
-    OpenMesh::VertexHandle start_vertex_handle(start_vertex_index);
-    OpenMesh::VertexHandle end_vertex_handle(end_vertex_index);
-
-    // The indices of the vertices on the shortest path, including the start and
-    // end vertices
-    std::list<size_t> shortest_path_vertex_indices;
-
-    // The distance of the shortest path
-    float distance = 0.0f;
-
-    if (find_shortest_path(
-            start_vertex_handle,
-            end_vertex_handle,
-            omesh,
-            shortest_path_vertex_indices,
-            distance)) {
+    if (result) {
+        // The indices of the vertices on the shortest path, including the
+        // start and end vertices
+        std::list<size_t> shortest_path_vertex_indices(
+            result.path.begin(), result.path.end());
         params.set_output(
             "Shortest Path Vertex Indices", shortest_path_vertex_indices);
-        params.set_output("Shortest Path Distance", distance);
+        params.set_output("Shortest Path Distance", result.distance);
         return true;
     }
     else {
@@ -111,8 +106,6 @@ NODE_EXECUTION_FUNCTION(shortest_path)
         params.set_output("Shortest Path Distance", 0.0f);
         return false;
     }
-
-    return true;
 }
 
 NODE_DECLARATION_UI(shortest_path);
@@ -1,4 +1,7 @@
+#include <pxr/base/tf/hash.h>
 #include <pxr/base/tf/stringUtils.h>
+#include <pxr/usd/sdf/changeBlock.h>
+#include <pxr/usd/sdf/types.h>
 #include <pxr/usd/usd/primRange.h>
 #include <pxr/usd/usdGeom/basisCurves.h>
 #include <pxr/usd/usdGeom/mesh.h>
@@ -8,6 +11,9 @@
 #include <pxr/usd/usdShade/materialBindingAPI.h>
 
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "GCore/Components/CurveComponent.h"
 #include "GCore/Components/MaterialComponent.h"
@@ -20,9 +26,187 @@
 #include "pxr/usd/usd/payloads.h"
 
 NODE_DEF_OPEN_SCOPE
+
+// What write_usd last wrote to one attribute of its prim.
+struct WrittenValue {
+    size_t hash = 0;
+    pxr::VtValue value;
+    // Time of the last Set, and of the last write skipped since then.
+    pxr::UsdTimeCode set_time;
+    pxr::UsdTimeCode seen_time;
+};
+
+// The prim is kept between executions, and only attributes whose content
+// changed since the last write are set again, so a deforming mesh costs one
+// points array per frame instead of a rebuilt prim.
+struct WriteUsdStorage {
+    static constexpr bool has_storage = false;
+
+    pxr::UsdStageRefPtr stage;
+    pxr::SdfPath path;
+    pxr::TfToken type;
+    bool time_sampled = false;
+
+    std::unordered_map<pxr::TfToken, WrittenValue, pxr::TfToken::HashFunctor>
+        values;
+    // Primvar names of the polyscope quantities, per prefix and name.
+    std::unordered_map<std::string, pxr::TfToken> quantity_tokens[8];
+
+    void reset()
+    {
+        stage = nullptr;
+        path = pxr::SdfPath();
+        type = pxr::TfToken();
+        values.clear();
+    }
+};
+
+template<typename T>
+bool identical(const T&, const T&)
+{
+    return false;
+}
+
+// Arrays sharing their buffer are equal without looking at the content.
+template<typename T>
+bool identical(const pxr::VtArray<T>& a, const pxr::VtArray<T>& b)
+{
+    return a.IsIdentical(b);
+}
+
+// Sets attribute values through the storage of one write_usd execution and
+// removes or blocks the attributes of the last write that were not written
+// again.
+class ChangeWriter {
+   public:
+    explicit ChangeWriter(WriteUsdStorage& storage) : storage_(storage)
+    {
+    }
+
+    template<typename T>
+    void set(
+        const pxr::UsdAttribute& attribute,
+        const T& value,
+        pxr::UsdTimeCode time)
+    {
+        const pxr::TfToken& name = attribute.GetName();
+        written_.insert(name);
+        auto [it, added] = storage_.values.try_emplace(name);
+        WrittenValue& last = it->second;
+
+        size_t hash;
+        if (!added && last.value.IsHolding<T>() &&
+            identical(last.value.UncheckedGet<T>(), value)) {
+            hash = last.hash;
+        }
+        else {
+            hash = pxr::TfHash()(value);
+        }
+        update(attribute, added, last, hash, pxr::VtValue(value), time);
+    }
+
+    // Time-sampled attributes are blocked from `time` on, so their samples
+    // at other frames stay; others are removed.
+    void remove_unwritten(pxr::UsdPrim prim, pxr::UsdTimeCode time)
+    {
+        for (auto it = storage_.values.begin(); it != storage_.values.end();) {
+            if (written_.count(it->first)) {
+                ++it;
+                continue;
+            }
+            if (storage_.time_sampled) {
+                update(
+                    prim.GetAttribute(it->first),
+                    false,
+                    it->second,
+                    kBlockHash,
+                    pxr::VtValue(pxr::SdfValueBlock()),
+                    time);
+                ++it;
+            }
+            else {
+                prim.RemoveProperty(it->first);
+                it = storage_.values.erase(it);
+            }
+        }
+    }
+
+   private:
+    // Stands for a blocked value.
+    static constexpr size_t kBlockHash = 0;
+
+    void update(
+        const pxr::UsdAttribute& attribute,
+        bool added,
+        WrittenValue& last,
+        size_t hash,
+        const pxr::VtValue& value,
+        pxr::UsdTimeCode time)
+    {
+        // An unchanged value is already in place for the default time and
+        // from the frame it was set at to the last frame seen since; later
+        // frames only extend that range.
+        const bool rewound = !added && !time.IsDefault() &&
+                             !last.seen_time.IsDefault() &&
+                             time < last.seen_time;
+        if (!added && hash == last.hash) {
+            if (time.IsDefault() ||
+                (last.set_time <= time && time <= last.seen_time)) {
+                return;
+            }
+            if (!rewound && !last.seen_time.IsDefault()) {
+                last.seen_time = time;
+                return;
+            }
+        }
+        if (rewound) {
+            // Samples after a jump back are left from an earlier pass and
+            // would show through the frames skipped from here on.
+            std::vector<double> samples;
+            attribute.GetTimeSamples(&samples);
+            for (double sample : samples) {
+                if (sample > time.GetValue()) {
+                    attribute.ClearAtTime(sample);
+                }
+            }
+        }
+        // Hold the old value up to the last frame that skipped writing it,
+        // so the samples do not interpolate across the unchanged frames.
+        else if (
+            !added && !time.IsDefault() && last.seen_time != last.set_time &&
+            last.seen_time < time) {
+            attribute.Set(last.value, last.seen_time);
+        }
+        attribute.Set(value, time);
+        last = { hash, value, time, time };
+    }
+
+    WriteUsdStorage& storage_;
+    std::unordered_set<pxr::TfToken, pxr::TfToken::HashFunctor> written_;
+};
+
+pxr::UsdGeomPrimvar get_primvar(
+    const pxr::UsdGeomPrimvarsAPI& api,
+    const pxr::TfToken& name,
+    const pxr::SdfValueTypeName& type,
+    const pxr::TfToken& interpolation)
+{
+    auto primvar = api.GetPrimvar(name);
+    if (!primvar || primvar.GetTypeName() != type) {
+        primvar = api.CreatePrimvar(name, type);
+    }
+    if (primvar.GetInterpolation() != interpolation) {
+        primvar.SetInterpolation(interpolation);
+    }
+    return primvar;
+}
+
 NODE_DECLARATION_FUNCTION(write_usd)
 {
     b.add_input<Geometry>("Geometry");
+    // Write every value as a time sample at the current time instead of as
+    // the default value. Points are always time-sampled.
+    b.add_input<bool>("Time Sampled").default_val(false);
 }
 
 bool legal(const std::string& string)
@@ -41,6 +225,7 @@ bool legal(const std::string& string)
 NODE_EXECUTION_FUNCTION(write_usd)
 {
     auto& global_payload = params.get_global_payload<GeomPayload&>();
+    auto& storage = params.get_storage<WriteUsdStorage&>();
 
     auto geometry = params.get_input<Geometry>("Geometry");
 
@@ -53,189 +238,40 @@ NODE_EXECUTION_FUNCTION(write_usd)
     assert(!(points && mesh));
 
     pxr::UsdTimeCode time = global_payload.current_time;
+    const bool time_sampled = params.get_input<bool>("Time Sampled");
+    const pxr::UsdTimeCode value_time =
+        time_sampled ? time : pxr::UsdTimeCode::Default();
 
     auto stage = global_payload.stage;
     auto sdf_path = global_payload.prim_path;
 
-    stage->RemovePrim(sdf_path);
-
+    pxr::TfToken type;
     if (mesh) {
-        pxr::UsdGeomMesh usdgeom = pxr::UsdGeomMesh::Define(stage, sdf_path);
-        if (usdgeom) {
-#if USE_USD_SCRATCH_BUFFER
-            copy_prim(mesh->get_usd_mesh().GetPrim(), usdgeom.GetPrim());
-#else
-            usdgeom.CreatePointsAttr().Set(mesh->get_vertices());
-            usdgeom.CreateFaceVertexCountsAttr().Set(
-                mesh->get_face_vertex_counts());
-            usdgeom.CreateFaceVertexIndicesAttr().Set(
-                mesh->get_face_vertex_indices());
-            usdgeom.CreateNormalsAttr().Set(mesh->get_normals());
-            if (!mesh->get_display_color().empty()) {
-                auto primVarAPI = pxr::UsdGeomPrimvarsAPI(usdgeom);
-                auto colorPrimvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken("displayColor"),
-                    pxr::SdfValueTypeNames->Color3fArray);
-                colorPrimvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-                colorPrimvar.Set(mesh->get_display_color());
-            }
-            if (!mesh->get_texcoords_array().empty()) {
-                auto primVarAPI = pxr::UsdGeomPrimvarsAPI(usdgeom);
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken("UVMap"),
-                    pxr::SdfValueTypeNames->TexCoord2fArray);
-                primvar.Set(mesh->get_texcoords_array());
-                if (mesh->get_texcoords_array().size() ==
-                    mesh->get_vertices().size()) {
-                    primvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-                }
-                else {
-                    primvar.SetInterpolation(pxr::UsdGeomTokens->faceVarying);
-                }
-            }
-
-#endif
-            usdgeom.CreateDoubleSidedAttr().Set(true);
-
-            // Store polyscope quantities
-            auto primVarAPI = pxr::UsdGeomPrimvarsAPI(usdgeom);
-
-            // It's invalid to use pxr::TfToken("some_prefix" + some_string)
-            // directly, so we need to create a new string first.
-
-            for (const std::string& name :
-                 mesh->get_vertex_scalar_quantity_names()) {
-                auto values = mesh->get_vertex_scalar_quantity(name);
-                const std::string primvar_name =
-                    "polyscope:vertex:scalar:" + name;
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken(primvar_name.c_str()),
-                    pxr::SdfValueTypeNames->FloatArray);
-                primvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-                primvar.Set(values);
-            }
-
-            for (const std::string& name :
-                 mesh->get_face_scalar_quantity_names()) {
-                auto values = mesh->get_face_scalar_quantity(name);
-                const std::string primvar_name =
-                    "polyscope:face:scalar:" + name;
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken(primvar_name.c_str()),
-                    pxr::SdfValueTypeNames->FloatArray);
-                primvar.SetInterpolation(pxr::UsdGeomTokens->uniform);
-                primvar.Set(values);
-            }
-
-            for (std::string& name : mesh->get_vertex_color_quantity_names()) {
-                auto values = mesh->get_vertex_color_quantity(name);
-                const std::string primvar_name =
-                    "polyscope:vertex:color:" + name;
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken(primvar_name.c_str()),
-                    pxr::SdfValueTypeNames->Color3fArray);
-                primvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-                primvar.Set(values);
-            }
-
-            for (const std::string& name :
-                 mesh->get_face_color_quantity_names()) {
-                auto values = mesh->get_face_color_quantity(name);
-                const std::string primvar_name = "polyscope:face:color:" + name;
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken(primvar_name.c_str()),
-                    pxr::SdfValueTypeNames->Color3fArray);
-                primvar.SetInterpolation(pxr::UsdGeomTokens->uniform);
-                primvar.Set(values);
-            }
-
-            for (const std::string& name :
-                 mesh->get_vertex_vector_quantity_names()) {
-                auto values = mesh->get_vertex_vector_quantity(name);
-                const std::string primvar_name =
-                    "polyscope:vertex:vector:" + name;
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken(primvar_name.c_str()),
-                    pxr::SdfValueTypeNames->Vector3fArray);
-                primvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-                primvar.Set(values);
-            }
-
-            for (const std::string& name :
-                 mesh->get_face_vector_quantity_names()) {
-                auto values = mesh->get_face_vector_quantity(name);
-                const std::string primvar_name =
-                    "polyscope:face:vector:" + name;
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken(primvar_name.c_str()),
-                    pxr::SdfValueTypeNames->Vector3fArray);
-                primvar.SetInterpolation(pxr::UsdGeomTokens->uniform);
-                primvar.Set(values);
-            }
-
-            for (const std::string& name :
-                 mesh->get_face_corner_parameterization_quantity_names()) {
-                auto values =
-                    mesh->get_face_corner_parameterization_quantity(name);
-                const std::string primvar_name =
-                    "polyscope:face_corner:parameterization:" + name;
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken(primvar_name.c_str()),
-                    pxr::SdfValueTypeNames->TexCoord2fArray);
-                primvar.SetInterpolation(pxr::UsdGeomTokens->faceVarying);
-                primvar.Set(values);
-            }
-
-            for (const std::string& name :
-                 mesh->get_vertex_parameterization_quantity_names()) {
-                auto values = mesh->get_vertex_parameterization_quantity(name);
-                const std::string primvar_name =
-                    "polyscope:vertex:parameterization:" + name;
-                auto primvar = primVarAPI.CreatePrimvar(
-                    pxr::TfToken(primvar_name.c_str()),
-                    pxr::SdfValueTypeNames->TexCoord2fArray);
-                primvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-                primvar.Set(values);
-            }
-        }
+        type = pxr::TfToken("Mesh");
     }
     else if (points) {
-        pxr::UsdGeomPoints usdpoints =
-            pxr::UsdGeomPoints::Define(stage, sdf_path);
-
-        usdpoints.CreatePointsAttr().Set(points->get_vertices(), time);
-
-        if (points->get_width().size() > 0) {
-            usdpoints.CreateWidthsAttr().Set(points->get_width(), time);
-        }
-
-        auto PrimVarAPI = pxr::UsdGeomPrimvarsAPI(usdpoints);
-        if (points->get_display_color().size() > 0) {
-            pxr::UsdGeomPrimvar colorPrimvar = PrimVarAPI.CreatePrimvar(
-                pxr::TfToken("displayColor"),
-                pxr::SdfValueTypeNames->Color3fArray);
-            colorPrimvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-            colorPrimvar.Set(points->get_display_color(), time);
-        }
+        type = pxr::TfToken("Points");
     }
     else if (curve) {
-        pxr::UsdGeomBasisCurves usd_curve =
-            pxr::UsdGeomBasisCurves::Define(stage, sdf_path);
-        if (usd_curve) {
-#if USE_USD_SCRATCH_BUFFER
-            copy_prim(curve->get_usd_curve().GetPrim(), usd_curve.GetPrim());
-#else
-            usd_curve.CreatePointsAttr().Set(curve->get_vertices());
-            usd_curve.CreateWidthsAttr().Set(curve->get_width());
-            usd_curve.CreateCurveVertexCountsAttr().Set(
-                curve->get_vert_count());
-            usd_curve.CreateNormalsAttr().Set(curve->get_curve_normals());
-            usd_curve.CreateDisplayColorAttr().Set(curve->get_display_color());
-            usd_curve.CreateWrapAttr().Set(
-                curve->get_periodic() ? pxr::UsdGeomTokens->periodic
-                                      : pxr::UsdGeomTokens->nonperiodic);
-#endif
+        type = pxr::TfToken("BasisCurves");
+    }
+
+    // The prim is only rebuilt when it is written for the first time or
+    // changes its type; otherwise the last write is updated in place.
+    pxr::UsdPrim prim = stage->GetPrimAtPath(sdf_path);
+    if (!prim || prim.GetTypeName() != type || storage.stage != stage ||
+        storage.path != sdf_path || storage.type != type ||
+        storage.time_sampled != time_sampled) {
+        storage.reset();
+        stage->RemovePrim(sdf_path);
+        if (type.IsEmpty()) {
+            return true;
         }
+        prim = stage->DefinePrim(sdf_path, type);
+        storage.stage = stage;
+        storage.path = sdf_path;
+        storage.type = type;
+        storage.time_sampled = time_sampled;
     }
 
     // Material and Texture
@@ -325,45 +361,264 @@ NODE_EXECUTION_FUNCTION(write_usd)
         }
     }
 
+
+    // Everything below only edits properties of the existing prim, so the
+    // edits are sent to the stage and Hydra as a single change.
+    pxr::SdfChangeBlock change_block;
+    ChangeWriter writer(storage);
+
+    if (mesh) {
+        pxr::UsdGeomMesh usdgeom(prim);
+#if USE_USD_SCRATCH_BUFFER
+        copy_prim(mesh->get_usd_mesh().GetPrim(), usdgeom.GetPrim());
+#else
+        writer.set(
+            usdgeom.CreatePointsAttr(), mesh->get_vertices(), value_time);
+        writer.set(
+            usdgeom.CreateFaceVertexCountsAttr(),
+            mesh->get_face_vertex_counts(),
+            value_time);
+        writer.set(
+            usdgeom.CreateFaceVertexIndicesAttr(),
+            mesh->get_face_vertex_indices(),
+            value_time);
+        writer.set(
+            usdgeom.CreateNormalsAttr(), mesh->get_normals(), value_time);
+        auto primVarAPI = pxr::UsdGeomPrimvarsAPI(usdgeom);
+        if (!mesh->get_display_color().empty()) {
+            static const pxr::TfToken display_color("displayColor");
+            auto colorPrimvar = get_primvar(
+                primVarAPI,
+                display_color,
+                pxr::SdfValueTypeNames->Color3fArray,
+                pxr::UsdGeomTokens->vertex);
+            writer.set(
+                colorPrimvar.GetAttr(), mesh->get_display_color(), value_time);
+        }
+        if (!mesh->get_texcoords_array().empty()) {
+            static const pxr::TfToken uv_map("UVMap");
+            const bool per_vertex = mesh->get_texcoords_array().size() ==
+                                    mesh->get_vertices().size();
+            auto primvar = get_primvar(
+                primVarAPI,
+                uv_map,
+                pxr::SdfValueTypeNames->TexCoord2fArray,
+                per_vertex ? pxr::UsdGeomTokens->vertex
+                           : pxr::UsdGeomTokens->faceVarying);
+            writer.set(
+                primvar.GetAttr(), mesh->get_texcoords_array(), value_time);
+        }
+#endif
+        writer.set(usdgeom.CreateDoubleSidedAttr(), true, value_time);
+
+        // Store polyscope quantities. The primvar names are built once per
+        // quantity and kept in the storage.
+        auto quantity_primvar = [&](int kind,
+                                    const char* prefix,
+                                    const std::string& name,
+                                    const pxr::SdfValueTypeName& value_type,
+                                    const pxr::TfToken& interpolation) {
+            auto& tokens = storage.quantity_tokens[kind];
+            auto it = tokens.find(name);
+            if (it == tokens.end()) {
+                it = tokens.emplace(name, pxr::TfToken(prefix + name)).first;
+            }
+            return get_primvar(
+                pxr::UsdGeomPrimvarsAPI(usdgeom),
+                it->second,
+                value_type,
+                interpolation);
+        };
+
+        for (const std::string& name :
+             mesh->get_vertex_scalar_quantity_names()) {
+            auto primvar = quantity_primvar(
+                0,
+                "polyscope:vertex:scalar:",
+                name,
+                pxr::SdfValueTypeNames->FloatArray,
+                pxr::UsdGeomTokens->vertex);
+            writer.set(
+                primvar.GetAttr(),
+                mesh->get_vertex_scalar_quantity(name),
+                value_time);
+        }
+
+        for (const std::string& name : mesh->get_face_scalar_quantity_names()) {
+            auto primvar = quantity_primvar(
+                1,
+                "polyscope:face:scalar:",
+                name,
+                pxr::SdfValueTypeNames->FloatArray,
+                pxr::UsdGeomTokens->uniform);
+            writer.set(
+                primvar.GetAttr(),
+                mesh->get_face_scalar_quantity(name),
+                value_time);
+        }
+
+        for (const std::string& name :
+             mesh->get_vertex_color_quantity_names()) {
+            auto primvar = quantity_primvar(
+                2,
+                "polyscope:vertex:color:",
+                name,
+                pxr::SdfValueTypeNames->Color3fArray,
+                pxr::UsdGeomTokens->vertex);
+            writer.set(
+                primvar.GetAttr(),
+                mesh->get_vertex_color_quantity(name),
+                value_time);
+        }
+
+        for (const std::string& name : mesh->get_face_color_quantity_names()) {
+            auto primvar = quantity_primvar(
+                3,
+                "polyscope:face:color:",
+                name,
+                pxr::SdfValueTypeNames->Color3fArray,
+                pxr::UsdGeomTokens->uniform);
+            writer.set(
+                primvar.GetAttr(),
+                mesh->get_face_color_quantity(name),
+                value_time);
+        }
+
+        for (const std::string& name :
+             mesh->get_vertex_vector_quantity_names()) {
+            auto primvar = quantity_primvar(
+                4,
+                "polyscope:vertex:vector:",
+                name,
+                pxr::SdfValueTypeNames->Vector3fArray,
+                pxr::UsdGeomTokens->vertex);
+            writer.set(
+                primvar.GetAttr(),
+                mesh->get_vertex_vector_quantity(name),
+                value_time);
+        }
+
+        for (const std::string& name :
+             mesh->get_face_vector_quantity_names()) {
+            auto primvar = quantity_primvar(
+                5,
+                "polyscope:face:vector:",
+                name,
+                pxr::SdfValueTypeNames->Vector3fArray,
+                pxr::UsdGeomTokens->uniform);
+            writer.set(
+                primvar.GetAttr(),
+                mesh->get_face_vector_quantity(name),
+                value_time);
+        }
+
+        for (const std::string& name :
+             mesh->get_face_corner_parameterization_quantity_names()) {
+            auto primvar = quantity_primvar(
+                6,
+                "polyscope:face_corner:parameterization:",
+                name,
+                pxr::SdfValueTypeNames->TexCoord2fArray,
+                pxr::UsdGeomTokens->faceVarying);
+            writer.set(
+                primvar.GetAttr(),
+                mesh->get_face_corner_parameterization_quantity(name),
+                value_time);
+        }
+
+        for (const std::string& name :
+             mesh->get_vertex_parameterization_quantity_names()) {
+            auto primvar = quantity_primvar(
+                7,
+                "polyscope:vertex:parameterization:",
+                name,
+                pxr::SdfValueTypeNames->TexCoord2fArray,
+                pxr::UsdGeomTokens->vertex);
+            writer.set(
+                primvar.GetAttr(),
+                mesh->get_vertex_parameterization_quantity(name),
+                value_time);
+        }
+    }
+    else if (points) {
+        pxr::UsdGeomPoints usdpoints(prim);
+
+        writer.set(usdpoints.CreatePointsAttr(), points->get_vertices(), time);
+
+        if (points->get_width().size() > 0) {
+            writer.set(usdpoints.CreateWidthsAttr(), points->get_width(), time);
+        }
+
+        auto PrimVarAPI = pxr::UsdGeomPrimvarsAPI(usdpoints);
+        if (points->get_display_color().size() > 0) {
+            static const pxr::TfToken display_color("displayColor");
+            pxr::UsdGeomPrimvar colorPrimvar = get_primvar(
+                PrimVarAPI,
+                display_color,
+                pxr::SdfValueTypeNames->Color3fArray,
+                pxr::UsdGeomTokens->vertex);
+            writer.set(
+                colorPrimvar.GetAttr(), points->get_display_color(), time);
+        }
+    }
+    else if (curve) {
+        pxr::UsdGeomBasisCurves usd_curve(prim);
+#if USE_USD_SCRATCH_BUFFER
+        copy_prim(curve->get_usd_curve().GetPrim(), usd_curve.GetPrim());
+#else
+        writer.set(
+            usd_curve.CreatePointsAttr(), curve->get_vertices(), value_time);
+        writer.set(
+            usd_curve.CreateWidthsAttr(), curve->get_width(), value_time);
+        writer.set(
+            usd_curve.CreateCurveVertexCountsAttr(),
+            curve->get_vert_count(),
+            value_time);
+        writer.set(
+            usd_curve.CreateNormalsAttr(),
+            curve->get_curve_normals(),
+            value_time);
+        writer.set(
+            usd_curve.CreateDisplayColorAttr(),
+            curve->get_display_color(),
+            value_time);
+        writer.set(
+            usd_curve.CreateWrapAttr(),
+            curve->get_periodic() ? pxr::UsdGeomTokens->periodic
+                                  : pxr::UsdGeomTokens->nonperiodic,
+            value_time);
+#endif
+    }
+
     auto xform_component = geometry.get_component<XformComponent>();
+    auto usdgeom = pxr::UsdGeomXformable(prim);
+    auto xform_op = usdgeom.GetTransformOp();
+    if (!xform_op) {
+        xform_op = usdgeom.AddTransformOp();
+    }
     if (xform_component) {
-        auto usdgeom = pxr::UsdGeomXformable ::Get(stage, sdf_path);
         // Transform
         assert(
             xform_component->translation.size() ==
             xform_component->rotation.size());
 
         pxr::GfMatrix4d final_transform = xform_component->get_transform();
-
-        auto xform_op = usdgeom.GetTransformOp();
-        if (!xform_op) {
-            xform_op = usdgeom.AddTransformOp();
-        }
-        xform_op.Set(final_transform, time);
+        writer.set(xform_op.GetAttr(), final_transform, time);
     }
     else {
-        auto usdgeom = pxr::UsdGeomXformable ::Get(stage, sdf_path);
-        auto xform_op = usdgeom.GetTransformOp();
-        if (!xform_op) {
-            xform_op = usdgeom.AddTransformOp();
-        }
-        xform_op.Set(pxr::GfMatrix4d(1), time);
+        writer.set(xform_op.GetAttr(), pxr::GfMatrix4d(1), time);
     }
 
-    if (global_payload.has_simulation) {
-        pxr::UsdPrim prim = stage->GetPrimAtPath(sdf_path);
-        prim.CreateAttribute(
-                pxr::TfToken("Animatable"), pxr::SdfValueTypeNames->Bool)
-            .Set(true);
-    }
-    else {
-        pxr::UsdPrim prim = stage->GetPrimAtPath(sdf_path);
+    writer.set(
         prim.CreateAttribute(
-                pxr::TfToken("Animatable"), pxr::SdfValueTypeNames->Bool)
-            .Set(false);
-    }
+            pxr::TfToken("Animatable"), pxr::SdfValueTypeNames->Bool),
+        global_payload.has_simulation,
+        pxr::UsdTimeCode::Default());
+
+    // Quantities and primvars that are gone since the last write.
+    writer.remove_unwritten(prim, time);
 
-    pxr::UsdGeomImageable(stage->GetPrimAtPath(sdf_path)).MakeVisible();
+    pxr::UsdGeomImageable(prim).MakeVisible();
     return true;
 }
 
@@ -3,9 +3,11 @@
 
 #include <Eigen/Core>
 #include <functional>
+#include <memory>
 
 #include "GCore/Components/MeshOperand.h"
 #include "GCore/GOP.h"
+#include "GCore/algorithms/mean_value_coordinates.h"
 #include "GCore/geom_payload.hpp"
 #include "nodes/core/def/node_def.hpp"
 #include "polyscope/surface_mesh.h"
@@ -20,6 +22,8 @@ NODE_DECLARATION_FUNCTION(visualize_2d_function)
     b.add_input<Geometry>("geometry");
     // 输入一个二维函数，返回一个标量
     b.add_input<std::function<float(float, float)>>("function");
+    // 可选：批量求值的重心坐标（如均值坐标），每个分量输出为一个顶点标量
+    b.add_input<std::shared_ptr<const MeanValueCoordinates>>("coordinates");
     // 三角形最大面积的倒数
     b.add_input<int>("fineness").min(2).max(5).default_val(5);
     b.add_output<Geometry>("geometry");
@@ -70,6 +74,15 @@ NODE_EXECUTION_FUNCTION(visualize_2d_function)
     // 获取输入的二维函数
     auto function =
         params.get_input<std::function<float(float, float)>>("function");
+    auto coordinates =
+        params.get_input<std::shared_ptr<const MeanValueCoordinates>>(
+            "coordinates");
+    if (!function && !coordinates) {
+        std::cerr << "Visualize 2D Function Node: Need a function or "
+                     "coordinates to visualize."
+                  << std::endl;
+        return false;
+    }
 
     // 获取三角形最大面积的倒数
     auto fineness = params.get_input<int>("fineness");
@@ -128,13 +141,35 @@ NODE_EXECUTION_FUNCTION(visualize_2d_function)
     geometry_2.attach_component(mesh_2);
 
     // 添加顶点标量
-    pxr::VtArray<float> vertex_scalar(V2.rows());
-    for (int i = 0; i < V2.rows(); ++i) {
-        vertex_scalar[i] = function(V2(i, 0), V2(i, 1));
+    if (function) {
+        pxr::VtArray<float> vertex_scalar(V2.rows());
+        for (int i = 0; i < V2.rows(); ++i) {
+            vertex_scalar[i] = function(V2(i, 0), V2(i, 1));
+        }
+        // surface_mesh->addVertexScalarQuantity("function", vertex_scalar);
+
+        mesh_2->add_vertex_scalar_quantity("function", vertex_scalar);
     }
-    // surface_mesh->addVertexScalarQuantity("function", vertex_scalar);
 
-    mesh_2->add_vertex_scalar_quantity("function", vertex_scalar);
+    // 所有顶点一次批量求值，得到 顶点数 x 分量数 的行主序矩阵
+    if (coordinates) {
+        const size_t rows = V2.rows();
+        const size_t cols = coordinates->vertex_count();
+        std::vector<pxr::GfVec2f> points(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            points[i] = { V2(i, 0), V2(i, 1) };
+        }
+        std::vector<float> weights(rows * cols);
+        coordinates->evaluate(points.data(), rows, weights.data());
+        for (size_t j = 0; j < cols; ++j) {
+            pxr::VtArray<float> component(rows);
+            for (size_t i = 0; i < rows; ++i) {
+                component[i] = weights[i * cols + j];
+            }
+            mesh_2->add_vertex_scalar_quantity(
+                "coordinate_" + std::to_string(j), component);
+        }
+    }
 
     params.set_output("geometry", geometry_2);
 
@@ -1,13 +1,10 @@
-
 #include <pxr/base/vt/array.h>
 
-#include <vector>
+#include <algorithm>
 
-#include "Eigen/Core"
 #include "GCore/Components/CurveComponent.h"
 #include "GCore/Components/MeshOperand.h"
 #include "GCore/GOP.h"
-#include "GCore/util_openmesh_bind.h"
 #include "nodes/core/def/node_def.hpp"
 #include "polyscope_widget/polyscope_renderer.h"
 
@@ -17,9 +14,8 @@ NODE_DECLARATION_FUNCTION(visualize_n_pv_field)
 {
     // Input-1: Original 3D mesh
     b.add_input<Geometry>("Original Mesh");
-    // Input-2: N-PolyVector field
-    b.add_input<std::vector<std::vector<Eigen::Vector3d>>>(
-        "N-PolyVector Field");
+    // Input-2: N-PolyVector field, N vectors per face, face after face
+    b.add_input<pxr::VtArray<pxr::GfVec3f>>("N-PolyVector Field");
     // Output-1: Node curve
     b.add_output<Geometry>("Output");
 }
@@ -29,8 +25,7 @@ NODE_EXECUTION_FUNCTION(visualize_n_pv_field)
     // Get the input
     auto input_mesh = params.get_input<Geometry>("Original Mesh");
     auto n_pv_field =
-        params.get_input<std::vector<std::vector<Eigen::Vector3d>>>(
-            "N-PolyVector Field");
+        params.get_input<pxr::VtArray<pxr::GfVec3f>>("N-PolyVector Field");
 
     // Avoid processing the node when there is no input
     if (!input_mesh.get_component<MeshComponent>()) {
@@ -40,35 +35,60 @@ NODE_EXECUTION_FUNCTION(visualize_n_pv_field)
     }
 
     auto mesh = input_mesh.get_component<MeshComponent>();
+    const auto& positions = mesh->get_vertices();
+    const auto& face_vertex_counts = mesh->get_face_vertex_counts();
+    const auto& face_vertex_indices = mesh->get_face_vertex_indices();
+    const size_t face_count = face_vertex_counts.size();
 
     // Check if the N-PolyVector field is valid
-    if (n_pv_field.empty() ||
-        n_pv_field.size() != mesh->get_face_vertex_counts().size()) {
+    if (n_pv_field.empty() || face_count == 0 ||
+        n_pv_field.size() % face_count != 0) {
         std::cerr
             << "N-PolyVector field visualizer: Invalid N-PolyVector field."
             << std::endl;
         return false;
     }
+    const size_t n = n_pv_field.size() / face_count;
+
+    // Check the topology before walking it
+    bool counts_valid = true;
+    size_t corner_count = 0;
+    for (int count : face_vertex_counts) {
+        counts_valid &= count >= 0;
+        corner_count += size_t(std::max(count, 0));
+    }
+    if (!counts_valid || corner_count != face_vertex_indices.size()) {
+        std::cerr << "N-PolyVector field visualizer: Face vertex counts do "
+                     "not match the face vertex indices."
+                  << std::endl;
+        return false;
+    }
+    for (int index : face_vertex_indices) {
+        if (index < 0 || size_t(index) >= positions.size()) {
+            std::cerr << "N-PolyVector field visualizer: Face vertex index "
+                      << index << " is out of range." << std::endl;
+            return false;
+        }
+    }
+
+    // Draw every vector as a segment starting at the center of its face
+    pxr::VtArray<pxr::GfVec3f> vertices(2 * n_pv_field.size());
+    pxr::VtArray<int> vertex_counts(n_pv_field.size(), 2);
 
-    pxr::VtArray<pxr::GfVec3f> vertices;
-    pxr::VtArray<int> vertex_counts;
-
-    auto halfedge_mesh = operand_to_openmesh(&input_mesh);
-
-    for (auto it = halfedge_mesh->faces_sbegin();
-         it != halfedge_mesh->faces_end();
-         it++) {
-        auto fh = *it;
-        auto centroid = halfedge_mesh->calc_face_centroid(fh);
-        auto frame_fields = n_pv_field[fh.idx()];
-        for (const auto& field : frame_fields) {
-            vertices.push_back({ static_cast<float>(centroid[0]),
-                                 static_cast<float>(centroid[1]),
-                                 static_cast<float>(centroid[2]) });
-            vertices.push_back({ static_cast<float>(centroid[0] + field[0]),
-                                 static_cast<float>(centroid[1] + field[1]),
-                                 static_cast<float>(centroid[2] + field[2]) });
-            vertex_counts.push_back(2);
+    size_t corner = 0;
+    for (size_t f = 0; f < face_count; ++f) {
+        pxr::GfVec3f centroid(0.0f);
+        const int count = face_vertex_counts[f];
+        for (int i = 0; i < count; ++i) {
+            centroid += positions[face_vertex_indices[corner + i]];
+        }
+        corner += count;
+        if (count > 0) {
+            centroid /= float(count);
+        }
+        for (size_t k = f * n; k < (f + 1) * n; ++k) {
+            vertices[2 * k] = centroid;
+            vertices[2 * k + 1] = centroid + n_pv_field[k];
         }
     }
 
@@ -6,6 +6,7 @@
 #include "GCore/Components/PointsComponent.h"
 #include "GCore/Components/XformComponent.h"
 #include "GCore/GOP.h"
+#include "GCore/algorithms/compact_topology.h"
 #include "GCore/geom_payload.hpp"
 #include "glm/fwd.hpp"
 #include "nodes/core/def/node_def.hpp"
@@ -73,22 +74,35 @@ NODE_EXECUTION_FUNCTION(write_polyscope)
         auto faceVertexCounts = mesh->get_face_vertex_counts();
         auto faceVertexIndices = mesh->get_face_vertex_indices();
         auto display_color = mesh->get_display_color();
-        // 转换为nested array
-        std::vector<std::vector<size_t>> faceVertexIndicesNested;
-        faceVertexIndicesNested.resize(faceVertexCounts.size());
-        size_t start = 0;
-        for (int i = 0; i < faceVertexCounts.size(); i++) {
-            std::vector<size_t> face;
-            face.resize(faceVertexCounts[i]);
-            for (int j = 0; j < faceVertexCounts[i]; j++) {
-                face[j] = faceVertexIndices[start + j];
-            }
-            faceVertexIndicesNested[i] = std::move(face);
-            start += faceVertexCounts[i];
+        // Uniform triangle/quad meshes go to polyscope as fixed-size arrays;
+        // only mixed polygon meshes need a nested list.
+        CompactTopology topology;
+        if (!topology.build(
+                faceVertexCounts, faceVertexIndices, vertices.size())) {
+            std::cerr << "Invalid mesh topology!" << std::endl;
+            return false;
         }
 
-        polyscope::SurfaceMesh* surface_mesh = polyscope::registerSurfaceMesh(
-            sdf_path.GetString(), vertices, faceVertexIndicesNested);
+        polyscope::SurfaceMesh* surface_mesh = nullptr;
+        if (topology.uniform_arity() == 3) {
+            surface_mesh = polyscope::registerSurfaceMesh(
+                sdf_path.GetString(), vertices, topology.fixed_faces<3>());
+        }
+        else if (topology.uniform_arity() == 4) {
+            surface_mesh = polyscope::registerSurfaceMesh(
+                sdf_path.GetString(), vertices, topology.fixed_faces<4>());
+        }
+        else {
+            // 转换为nested array
+            std::vector<std::vector<uint32_t>> faceVertexIndicesNested(
+                topology.face_count());
+            topology.for_each_face(
+                [&](size_t f, const auto* corners, int size) {
+                    faceVertexIndicesNested[f].assign(corners, corners + size);
+                });
+            surface_mesh = polyscope::registerSurfaceMesh(
+                sdf_path.GetString(), vertices, faceVertexIndicesNested);
+        }
 
         if (display_color.size() > 0) {
             try {
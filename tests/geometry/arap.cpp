@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "GCore/algorithms/arap.h"
+#include "test_meshes.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+using test::TestMesh;
+
+namespace {
+
+struct RigidMotion {
+    Eigen::Matrix3d rotation;
+    Eigen::Vector3d translation;
+
+    GfVec3f operator()(const GfVec3f& p) const
+    {
+        const Eigen::Vector3d q =
+            rotation * Eigen::Vector3d(p[0], p[1], p[2]) + translation;
+        return GfVec3f(q[0], q[1], q[2]);
+    }
+};
+
+RigidMotion make_motion(double angle, const Eigen::Vector3d& axis)
+{
+    return { Eigen::AngleAxisd(angle, axis.normalized()).toRotationMatrix(),
+             Eigen::Vector3d(0.3, -0.2, 0.5) };
+}
+
+// Largest distance of a vertex from where the motion puts it, and largest
+// edge residual |(x_i - x_j) - R (p_i - p_j)|, whose weighted squares are an
+// upper bound on the ARAP energy.
+void expect_rigid(
+    const TestMesh& rest,
+    const pxr::VtArray<GfVec3f>& deformed,
+    const RigidMotion& motion)
+{
+    ASSERT_EQ(deformed.size(), rest.positions.size());
+    float distance = 0.0f;
+    for (size_t v = 0; v < deformed.size(); ++v) {
+        distance = std::max(
+            distance, (deformed[v] - motion(rest.positions[v])).GetLength());
+    }
+    EXPECT_LT(distance, 1e-4f);
+
+    float residual = 0.0f;
+    size_t corner = 0;
+    for (int count : rest.counts) {
+        for (int k = 0; k < count; ++k) {
+            const int i = rest.indices[corner + k];
+            const int j = rest.indices[corner + (k + 1) % count];
+            const GfVec3f edge = motion(rest.positions[i]) -
+                                 motion(rest.positions[j]);
+            residual = std::max(
+                residual, (deformed[i] - deformed[j] - edge).GetLength());
+        }
+        corner += count;
+    }
+    EXPECT_LT(residual, 1e-4f);
+}
+
+}  // namespace
+
+TEST(ArapDeformer, rigid_handle_motion_moves_the_mesh_rigidly)
+{
+    const TestMesh sphere = test::icosphere(4);
+    const std::vector<uint32_t> handles = { 0, 5, 11, 40, 77 };
+
+    ArapDeformer deformer;
+    ASSERT_TRUE(deformer.prepare(
+        sphere.positions, sphere.counts, sphere.indices, 1, 1, handles));
+
+    // From the rest shape, then warm-started from that result.
+    for (const RigidMotion& motion :
+         { make_motion(0.6, Eigen::Vector3d(1, 2, 3)),
+           make_motion(-0.4, Eigen::Vector3d(0, 1, -1)) }) {
+        std::vector<GfVec3f> targets;
+        for (uint32_t h : handles) {
+            targets.push_back(motion(sphere.positions[h]));
+        }
+        pxr::VtArray<GfVec3f> deformed;
+        ASSERT_TRUE(deformer.deform(targets, 500, true, deformed));
+        expect_rigid(sphere, deformed, motion);
+    }
+}
+
+TEST(ArapDeformer, rejects_bad_handles)
+{
+    const TestMesh sphere = test::icosphere(2);
+    const uint32_t n = uint32_t(sphere.positions.size());
+    ArapDeformer deformer;
+    EXPECT_FALSE(deformer.prepare(
+        sphere.positions, sphere.counts, sphere.indices, 1, 1, { 0, n }));
+    EXPECT_FALSE(deformer.prepare(
+        sphere.positions, sphere.counts, sphere.indices, 1, 1, { 3, 3 }));
+    EXPECT_FALSE(deformer.prepare(
+        sphere.positions, sphere.counts, sphere.indices, 1, 1, {}));
+    ASSERT_TRUE(deformer.prepare(
+        sphere.positions, sphere.counts, sphere.indices, 1, 1, { 0, 1 }));
+
+    // One target per handle.
+    pxr::VtArray<GfVec3f> deformed;
+    EXPECT_FALSE(deformer.deform({ GfVec3f(0.0f) }, 1, false, deformed));
+}
+
+TEST(ArapParameterizer, planar_grid_is_not_distorted)
+{
+    // A jittered grid tilted out of the xy plane has an isometric layout.
+    TestMesh plate = test::grid(12);
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> offset(-0.02f, 0.02f);
+    for (GfVec3f& p : plate.positions) {
+        if (p[0] > 0.0f && p[0] < 1.0f && p[1] > 0.0f && p[1] < 1.0f) {
+            p[0] += offset(random);
+            p[1] += offset(random);
+        }
+        p[2] = 0.3f * p[0] + 0.6f * p[1];
+    }
+
+    ArapParameterizer parameterizer;
+    ASSERT_TRUE(parameterizer.prepare(
+        plate.positions,
+        plate.counts,
+        plate.indices,
+        1,
+        1,
+        ArapParameterizer::Mode::Arap));
+    pxr::VtArray<pxr::GfVec2f> initial, uv;
+    ASSERT_TRUE(parameterizer.harmonic_initialization(initial));
+    ArapParameterizer::Options options;
+    options.max_iterations = 200;
+    options.tolerance = 1e-8;
+    ASSERT_TRUE(parameterizer.parameterize(initial, options, uv));
+    EXPECT_EQ(parameterizer.stats().flipped, 0u);
+    EXPECT_LT(parameterizer.stats().energy, 1e-10);
+
+    pxr::VtArray<float> energy, area_ratio, conformal_ratio;
+    parameterizer.face_distortion(energy, area_ratio, conformal_ratio);
+    ASSERT_EQ(energy.size(), plate.counts.size());
+    for (size_t f = 0; f < energy.size(); ++f) {
+        EXPECT_LT(energy[f], 1e-8f) << f;
+        EXPECT_NEAR(area_ratio[f], 1.0f, 1e-4f) << f;
+        EXPECT_NEAR(conformal_ratio[f], 1.0f, 1e-4f) << f;
+    }
+}
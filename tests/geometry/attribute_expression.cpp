@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/GOP.h"
+#include "GCore/algorithms/attribute_expression.h"
+
+using namespace USTC_CG;
+using pxr::GfVec2f;
+using pxr::GfVec3f;
+
+namespace {
+
+// Vertex i at (i, 2i, 1) with normal (0, 0, 2), texture coordinate
+// (0.5, i) and the scalar quantity h = i / 2.
+std::shared_ptr<MeshComponent> make_mesh(Geometry& geometry, size_t count)
+{
+    auto mesh = std::make_shared<MeshComponent>(&geometry);
+    geometry.attach_component(mesh);
+    pxr::VtArray<GfVec3f> positions(count), normals(count);
+    pxr::VtArray<GfVec2f> texcoords(count);
+    pxr::VtArray<float> heights(count);
+    for (size_t i = 0; i < count; ++i) {
+        positions[i] = GfVec3f(i, 2.0f * i, 1);
+        normals[i] = GfVec3f(0, 0, 2);
+        texcoords[i] = GfVec2f(0.5f, i);
+        heights[i] = 0.5f * i;
+    }
+    mesh->set_vertices(positions);
+    mesh->set_normals(normals);
+    mesh->set_texcoords_array(texcoords);
+    mesh->add_vertex_scalar_quantity("h", heights);
+    return mesh;
+}
+
+}  // namespace
+
+TEST(AttributeExpression, matches_hand_computed_values)
+{
+    // More vertices than one block, and a count that does not fill the last.
+    const size_t count = 1000;
+    Geometry geometry;
+    auto mesh = make_mesh(geometry, count);
+
+    AttributeProgram program;
+    ASSERT_TRUE(program.compile(
+        "# comment\n"
+        "d = normalize(N) * a\n"
+        "q = P\n"
+        "P = P + d * 2; Cd = vec3(P.x, UV.y, @h)\n"
+        "@len = length(P - q)\n"
+        "@v = cross(vec3(1, 0, 0), vec3(0, 1, 0)) + i\n"
+        "UV = vec3(mix(0, 10, 0.5), -UV.x, 7)\n"
+        "@c = clamp(P.y, 0, 5) * 2 + min(3, 4) / 2\n"
+        "@f = fract(2.75) + floor(-0.5) + abs(-2) + sqrt(9) + pow(2, 3)\n"
+        "@t = sin(PI / 2) + cos(0) + exp(0) + log(1) + dot(P, vec3(0, 0, 1))",
+        *mesh,
+        { { "a", 0.5f } }))
+        << program.error();
+    ASSERT_TRUE(program.run(*mesh)) << program.error();
+
+    const auto positions = mesh->get_vertices();
+    const auto colors = mesh->get_display_color();
+    const auto texcoords = mesh->get_texcoords_array();
+    const auto lengths = mesh->get_vertex_scalar_quantity("len");
+    const auto vectors = mesh->get_vertex_vector_quantity("v");
+    const auto clamped = mesh->get_vertex_scalar_quantity("c");
+    const auto functions = mesh->get_vertex_scalar_quantity("f");
+    const auto trigonometry = mesh->get_vertex_scalar_quantity("t");
+    ASSERT_EQ(positions.size(), count);
+    ASSERT_EQ(colors.size(), count);
+    ASSERT_EQ(texcoords.size(), count);
+    ASSERT_EQ(lengths.size(), count);
+    ASSERT_EQ(vectors.size(), count);
+    ASSERT_EQ(clamped.size(), count);
+    ASSERT_EQ(functions.size(), count);
+    ASSERT_EQ(trigonometry.size(), count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const float x = float(i);
+        // d = (0, 0, 0.5), so P moves up by one.
+        EXPECT_EQ(positions[i], GfVec3f(x, 2 * x, 2)) << i;
+        EXPECT_EQ(colors[i], GfVec3f(x, x, 0.5f * x)) << i;
+        EXPECT_NEAR(lengths[i], 1.0f, 1e-6f) << i;
+        EXPECT_EQ(vectors[i], GfVec3f(x, x, 1 + x)) << i;
+        // Only x and y of a vector assigned to UV are kept.
+        EXPECT_EQ(texcoords[i], GfVec2f(5, -0.5f)) << i;
+        EXPECT_EQ(clamped[i], std::min(2 * x, 5.0f) * 2 + 1.5f) << i;
+        // 0.75 - 1 + 2 + 3 + 8
+        EXPECT_NEAR(functions[i], 12.75f, 1e-5f) << i;
+        // 1 + 1 + 1 + 0 + 2
+        EXPECT_NEAR(trigonometry[i], 5.0f, 1e-5f) << i;
+    }
+}
+
+TEST(AttributeExpression, reports_errors)
+{
+    Geometry geometry;
+    auto mesh = make_mesh(geometry, 4);
+    for (const char* source : { "P = foo",
+                                "P = P +",
+                                "x = sin(1, 2)",
+                                "P = @missing",
+                                "i = 2",
+                                "P = 1.x",
+                                "P = N $",
+                                "y = 3\nz = w" }) {
+        AttributeProgram program;
+        EXPECT_FALSE(program.compile(source, *mesh)) << source;
+        EXPECT_FALSE(program.error().empty()) << source;
+    }
+}
+
+TEST(AttributeExpression, run_checks_input_sizes)
+{
+    Geometry geometry;
+    auto mesh = make_mesh(geometry, 8);
+    AttributeProgram program;
+    ASSERT_TRUE(program.compile("@s = @h * 2", *mesh));
+    mesh->add_vertex_scalar_quantity("h", pxr::VtArray<float>(3, 1.0f));
+    EXPECT_FALSE(program.run(*mesh));
+    EXPECT_FALSE(program.error().empty());
+}
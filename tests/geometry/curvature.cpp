@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "GCore/algorithms/curvature.h"
+#include "test_meshes.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+using test::TestMesh;
+
+namespace {
+
+CurvatureField curvature(const TestMesh& mesh, bool principal = false)
+{
+    CurvatureKernel kernel;
+    EXPECT_TRUE(kernel.set_topology(
+        mesh.counts, mesh.indices, mesh.positions.size()));
+    EXPECT_EQ(kernel.non_manifold_vertex_count(), 0u);
+    CurvatureField field;
+    kernel.compute(mesh.positions, field, principal);
+    return field;
+}
+
+}  // namespace
+
+TEST(Curvature, sphere)
+{
+    const float radius = 2.0f;
+    const TestMesh sphere = test::icosphere(16, radius);
+    const CurvatureField field = curvature(sphere, true);
+
+    ASSERT_EQ(field.mean.size(), sphere.positions.size());
+    ASSERT_EQ(field.k1.size(), sphere.positions.size());
+    float area = 0.0f;
+    for (size_t v = 0; v < sphere.positions.size(); ++v) {
+        const GfVec3f normal = sphere.positions[v] / radius;
+        EXPECT_GT(pxr::GfDot(field.normal[v], normal), 0.999f) << v;
+        EXPECT_NEAR(field.mean[v], 1.0f / radius, 0.01f / radius) << v;
+        EXPECT_NEAR(
+            field.gaussian[v], 1.0f / (radius * radius), 0.02f / radius)
+            << v;
+        EXPECT_NEAR(field.k1[v], 1.0f / radius, 0.05f / radius) << v;
+        EXPECT_NEAR(field.k2[v], 1.0f / radius, 0.05f / radius) << v;
+        // Unit tangents, orthogonal to each other.
+        EXPECT_NEAR(field.direction1[v].GetLength(), 1.0f, 1e-4f) << v;
+        EXPECT_NEAR(field.direction2[v].GetLength(), 1.0f, 1e-4f) << v;
+        EXPECT_NEAR(pxr::GfDot(field.direction1[v], field.normal[v]), 0, 1e-4f)
+            << v;
+        EXPECT_NEAR(pxr::GfDot(field.direction2[v], field.normal[v]), 0, 1e-4f)
+            << v;
+        EXPECT_NEAR(
+            pxr::GfDot(field.direction1[v], field.direction2[v]), 0.0f, 1e-4f)
+            << v;
+        area += field.area[v];
+    }
+    // The mixed areas tile the surface.
+    const float sphere_area = 4.0f * float(M_PI) * radius * radius;
+    EXPECT_NEAR(area, sphere_area, 0.01f * sphere_area);
+}
+
+TEST(Curvature, flat_grid)
+{
+    const TestMesh plate = test::grid(6);
+    const CurvatureField field = curvature(plate);
+    for (size_t v = 0; v < plate.positions.size(); ++v) {
+        const GfVec3f& p = plate.positions[v];
+        const bool corner =
+            (p[0] == 0.0f || p[0] == 1.0f) && (p[1] == 0.0f || p[1] == 1.0f);
+        EXPECT_EQ(field.mean[v], 0.0f) << v;
+        // The boundary angle defect is taken against pi, so only the
+        // corners, with a quarter turn, have one.
+        if (corner) {
+            EXPECT_GT(field.gaussian[v], 1.0f) << v;
+        }
+        else {
+            EXPECT_NEAR(field.gaussian[v], 0.0f, 1e-3f) << v;
+        }
+    }
+}
+
+TEST(Curvature, pinch_is_non_manifold)
+{
+    // Two tetrahedra sharing vertex 0; its triangles form two closed fans.
+    TestMesh mesh;
+    mesh.positions = { GfVec3f(0, 0, 0),   GfVec3f(1, 0, 1),
+                       GfVec3f(0, 1, 1),   GfVec3f(-1, -1, 1),
+                       GfVec3f(1, 0, -1),  GfVec3f(-1, -1, -1),
+                       GfVec3f(0, 1, -1) };
+    mesh.counts = pxr::VtArray<int>(8, 3);
+    mesh.indices = { 0, 1, 2, 0, 2, 3, 0, 3, 1, 1, 3, 2,
+                     0, 4, 5, 0, 5, 6, 0, 6, 4, 4, 6, 5 };
+
+    CurvatureKernel kernel;
+    ASSERT_TRUE(kernel.set_topology(mesh.counts, mesh.indices, 7));
+    EXPECT_EQ(kernel.non_manifold_vertex_count(), 1u);
+    CurvatureField field;
+    kernel.compute(mesh.positions, field);
+    EXPECT_EQ(field.mean[0], 0.0f);
+    EXPECT_EQ(field.gaussian[0], 0.0f);
+    // The tips of the tetrahedra are ordinary closed fans.
+    for (size_t v = 1; v < 7; ++v) {
+        EXPECT_GT(field.gaussian[v], 0.0f) << v;
+    }
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <Eigen/Dense>
+#include <random>
+
+#include "GCore/algorithms/laplacian.h"
+#include "GCore/algorithms/triangulate.h"
+#include "test_meshes.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+using test::TestMesh;
+
+namespace {
+
+// A planar 10 x 10 grid, tilted out of the xy plane, with the interior
+// vertices moved by up to a fifth of a cell along the plane.
+TestMesh make_plane(bool jitter)
+{
+    TestMesh mesh = test::grid(10);
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> offset(-0.02f, 0.02f);
+    for (GfVec3f& p : mesh.positions) {
+        const bool border =
+            p[0] == 0.0f || p[0] == 1.0f || p[1] == 0.0f || p[1] == 1.0f;
+        if (jitter && !border) {
+            p[0] += offset(random);
+            p[1] += offset(random);
+        }
+        p[2] = 0.5f * p[0] - 0.25f * p[1];
+    }
+    return mesh;
+}
+
+// Two linear functions of the positions and the positions themselves.
+Eigen::MatrixXd linear_functions(const pxr::VtArray<GfVec3f>& positions)
+{
+    Eigen::MatrixXd values(positions.size(), 5);
+    for (size_t v = 0; v < positions.size(); ++v) {
+        const GfVec3f& p = positions[v];
+        values.row(v) << 2.0 * p[0] - 3.0 * p[1] + 1.0, p[2] - p[0], p[0],
+            p[1], p[2];
+    }
+    return values;
+}
+
+std::vector<uint32_t> boundary_of(const TestMesh& mesh)
+{
+    std::vector<uint32_t> boundary;
+    EXPECT_TRUE(boundary_vertices(
+        mesh.counts, mesh.indices, mesh.positions.size(), boundary));
+    return boundary;
+}
+
+// Fixing a linear function on the boundary of a planar mesh reproduces it
+// inside, in every column of one solve. With the positions as the columns
+// this is the Tutte embedding of the mesh onto its own boundary.
+void expect_linear_precision(const TestMesh& mesh, LaplacianWeights weights)
+{
+    const std::vector<uint32_t> boundary = boundary_of(mesh);
+    ASSERT_EQ(boundary.size(), 40u);
+
+    LaplacianSolver solver;
+    ASSERT_TRUE(solver.prepare(
+        mesh.positions, mesh.counts, mesh.indices, 1, 1, weights, boundary));
+    const Eigen::MatrixXd expected = linear_functions(mesh.positions);
+    Eigen::MatrixXd fixed(boundary.size(), expected.cols());
+    for (size_t i = 0; i < boundary.size(); ++i) {
+        fixed.row(i) = expected.row(boundary[i]);
+    }
+    Eigen::MatrixXd solution;
+    ASSERT_TRUE(solver.solve(fixed, solution));
+    ASSERT_EQ(solution.rows(), expected.rows());
+    ASSERT_EQ(solution.cols(), expected.cols());
+    // Up to the rounding of the float positions, which leaves the grid
+    // regular and planar only to about 1e-8.
+    EXPECT_LT((solution - expected).cwiseAbs().maxCoeff(), 1e-6);
+}
+
+}  // namespace
+
+TEST(LaplacianSolver, uniform_weights_reproduce_linear_functions)
+{
+    // Only on a regular grid, where every neighbor has an opposite one.
+    expect_linear_precision(make_plane(false), LaplacianWeights::Uniform);
+}
+
+TEST(LaplacianSolver, cotangent_weights_reproduce_linear_functions)
+{
+    expect_linear_precision(make_plane(true), LaplacianWeights::Cotangent);
+}
+
+TEST(LaplacianSolver, mean_value_weights_reproduce_linear_functions)
+{
+    expect_linear_precision(make_plane(true), LaplacianWeights::MeanValue);
+}
+
+TEST(LaplacianSolver, reuses_the_factorization)
+{
+    const TestMesh mesh = make_plane(true);
+    const std::vector<uint32_t> boundary = boundary_of(mesh);
+    LaplacianSolver solver;
+    for (uint64_t position_version : { 1, 1, 2 }) {
+        ASSERT_TRUE(solver.prepare(
+            mesh.positions,
+            mesh.counts,
+            mesh.indices,
+            1,
+            position_version,
+            LaplacianWeights::Cotangent,
+            boundary));
+    }
+    EXPECT_EQ(solver.symbolic_count(), 1u);
+    EXPECT_EQ(solver.numeric_count(), 2u);
+
+    // Nothing free.
+    std::vector<uint32_t> all(mesh.positions.size());
+    for (uint32_t v = 0; v < all.size(); ++v) {
+        all[v] = v;
+    }
+    EXPECT_FALSE(solver.prepare(
+        mesh.positions,
+        mesh.counts,
+        mesh.indices,
+        2,
+        1,
+        LaplacianWeights::Cotangent,
+        all));
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "GCore/algorithms/mean_value_coordinates.h"
+
+using namespace USTC_CG;
+using pxr::GfVec2f;
+
+namespace {
+
+// A regular hexagon, and an L with its reflex corner at (1, 1).
+const std::vector<GfVec2f> kHexagon = { { 1.0f, 0.0f },    { 0.5f, 0.866f },
+                                        { -0.5f, 0.866f }, { -1.0f, 0.0f },
+                                        { -0.5f, -0.866f }, { 0.5f, -0.866f } };
+const std::vector<GfVec2f> kEll = { { 0, 0 }, { 2, 0 }, { 2, 1 },
+                                    { 1, 1 }, { 1, 2 }, { 0, 2 } };
+
+// Coordinates sum to one and reproduce the vertices, i.e. every linear
+// function, at each point.
+void expect_linear_precision(
+    const std::vector<GfVec2f>& polygon,
+    const std::vector<GfVec2f>& points)
+{
+    MeanValueCoordinates coordinates;
+    ASSERT_TRUE(coordinates.set_polygon(polygon));
+    const size_t n = polygon.size();
+    ASSERT_EQ(coordinates.vertex_count(), n);
+
+    std::vector<float> batch(points.size() * n);
+    coordinates.evaluate(points.data(), points.size(), batch.data());
+    std::vector<float> single(n);
+    for (size_t p = 0; p < points.size(); ++p) {
+        coordinates.evaluate(points[p], single.data());
+        double sum = 0.0;
+        GfVec2f reproduced(0.0f);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(batch[p * n + i], single[i]) << p << " " << i;
+            sum += single[i];
+            reproduced += single[i] * polygon[i];
+        }
+        EXPECT_NEAR(sum, 1.0, 1e-5) << p;
+        EXPECT_NEAR(reproduced[0], points[p][0], 1e-5f) << p;
+        EXPECT_NEAR(reproduced[1], points[p][1], 1e-5f) << p;
+    }
+}
+
+}  // namespace
+
+TEST(MeanValueCoordinates, convex_polygon)
+{
+    std::vector<GfVec2f> points;
+    for (int i = -4; i <= 4; ++i) {
+        for (int j = -4; j <= 4; ++j) {
+            points.emplace_back(0.2f * i, 0.2f * j);
+        }
+    }
+    // Inside, on an edge and on a vertex.
+    points.emplace_back(0.75f, 0.433f);
+    points.push_back(kHexagon[2]);
+    expect_linear_precision(kHexagon, points);
+
+    // Coordinates are positive inside a convex polygon.
+    MeanValueCoordinates coordinates;
+    ASSERT_TRUE(coordinates.set_polygon(kHexagon));
+    std::vector<float> weights(kHexagon.size());
+    coordinates.evaluate(GfVec2f(0.3f, -0.2f), weights.data());
+    for (float weight : weights) {
+        EXPECT_GT(weight, 0.0f);
+    }
+}
+
+TEST(MeanValueCoordinates, concave_polygon)
+{
+    // Points all over the L, including next to the reflex corner and in the
+    // concavity seen from the other arm, and a few outside it.
+    std::vector<GfVec2f> points;
+    for (int i = 1; i < 20; ++i) {
+        for (int j = 1; j < 20; ++j) {
+            const GfVec2f p(0.1f * i, 0.1f * j);
+            if (p[0] < 1.0f || p[1] < 1.0f) {
+                points.push_back(p);
+            }
+        }
+    }
+    points.emplace_back(1.01f, 1.01f);
+    points.emplace_back(1.5f, 1.5f);
+    points.emplace_back(-0.5f, 1.0f);
+    points.push_back(kEll[3]);
+    expect_linear_precision(kEll, points);
+
+    // The vertex across the concavity gets a negative coordinate.
+    MeanValueCoordinates coordinates;
+    ASSERT_TRUE(coordinates.set_polygon(kEll));
+    std::vector<float> weights(kEll.size());
+    coordinates.evaluate(GfVec2f(1.9f, 0.5f), weights.data());
+    EXPECT_LT(weights[4], 0.0f);
+}
+
+TEST(MeanValueCoordinates, rejects_degenerate_polygons)
+{
+    MeanValueCoordinates coordinates;
+    EXPECT_FALSE(coordinates.set_polygon({ { 0, 0 }, { 1, 0 } }));
+}
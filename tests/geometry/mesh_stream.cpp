@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "GCore/mesh_stream.h"
+#include "test_meshes.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+using test::TestMesh;
+
+namespace {
+
+// Smallest batch size the reader accepts; the meshes below are several
+// times larger in every format.
+constexpr size_t kBatchBytes = size_t(1) << 16;
+
+struct ColoredMesh {
+    TestMesh mesh;
+    pxr::VtArray<GfVec3f> colors;
+    pxr::VtArray<float> scalars;
+    size_t batches = 0;
+};
+
+// A bumpy 120 x 120 grid colored by position. The colors are byte values,
+// which binary PLY stores exactly.
+ColoredMesh make_input()
+{
+    ColoredMesh input;
+    input.mesh = test::grid(120);
+    for (GfVec3f& p : input.mesh.positions) {
+        p[2] = 0.1f * std::sin(6.0f * p[0]) * std::cos(4.0f * p[1]);
+        GfVec3f color(p[0], p[1], 0.5f);
+        for (int k = 0; k < 3; ++k) {
+            color[k] = std::round(color[k] * 255.0f) / 255.0f;
+        }
+        input.colors.push_back(color);
+    }
+    return input;
+}
+
+std::string temporary(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::string write_temporary(const std::string& name, const std::string& text)
+{
+    const std::string path = temporary(name);
+    std::ofstream(path, std::ios::binary) << text;
+    return path;
+}
+
+// Reads `path` batch by batch, checking that every batch starts where the
+// previous one ended.
+ColoredMesh read_all(const std::string& path)
+{
+    ColoredMesh result;
+    MeshStreamReader reader;
+    EXPECT_TRUE(reader.open(path, kBatchBytes));
+    MeshBatch batch;
+    while (reader.next(batch)) {
+        EXPECT_EQ(batch.first_vertex, result.mesh.positions.size());
+        EXPECT_EQ(batch.first_face, result.mesh.counts.size());
+        TestMesh& mesh = result.mesh;
+        mesh.positions.insert(
+            mesh.positions.end(),
+            batch.positions.begin(),
+            batch.positions.end());
+        result.colors.insert(
+            result.colors.end(), batch.colors.begin(), batch.colors.end());
+        result.scalars.insert(
+            result.scalars.end(), batch.scalars.begin(), batch.scalars.end());
+        mesh.counts.insert(
+            mesh.counts.end(),
+            batch.face_vertex_counts.begin(),
+            batch.face_vertex_counts.end());
+        mesh.indices.insert(
+            mesh.indices.end(),
+            batch.face_vertex_indices.begin(),
+            batch.face_vertex_indices.end());
+        ++result.batches;
+    }
+    EXPECT_FALSE(reader.failed());
+    return result;
+}
+
+// Positions and topology are exact, colors up to the rounding of the byte
+// conversion.
+void expect_same(const ColoredMesh& input, const ColoredMesh& output)
+{
+    ASSERT_EQ(output.mesh.positions.size(), input.mesh.positions.size());
+    ASSERT_EQ(output.colors.size(), input.colors.size());
+    for (size_t v = 0; v < input.mesh.positions.size(); ++v) {
+        for (int k = 0; k < 3; ++k) {
+            EXPECT_EQ(output.mesh.positions[v][k], input.mesh.positions[v][k])
+                << v;
+            EXPECT_NEAR(output.colors[v][k], input.colors[v][k], 1e-6f)
+                << v;
+        }
+    }
+    EXPECT_EQ(output.mesh.counts, input.mesh.counts);
+    EXPECT_EQ(output.mesh.indices, input.mesh.indices);
+}
+
+// The number after "element <name>" in the header of a PLY file.
+size_t ply_element_count(const std::string& path, const std::string& name)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+    while (std::getline(in, line) && line != "end_header") {
+        std::istringstream words(line);
+        std::string keyword, element;
+        size_t count = 0;
+        if (words >> keyword >> element >> count && keyword == "element" &&
+            element == name) {
+            return count;
+        }
+    }
+    return size_t(-1);
+}
+
+std::string obj_text(const ColoredMesh& input)
+{
+    std::ostringstream out;
+    out.precision(9);
+    for (size_t v = 0; v < input.mesh.positions.size(); ++v) {
+        const GfVec3f& p = input.mesh.positions[v];
+        const GfVec3f& c = input.colors[v];
+        out << "v " << p[0] << ' ' << p[1] << ' ' << p[2] << ' ' << c[0]
+            << ' ' << c[1] << ' ' << c[2] << '\n';
+    }
+    size_t corner = 0;
+    for (int count : input.mesh.counts) {
+        out << 'f';
+        for (int i = 0; i < count; ++i) {
+            out << ' ' << input.mesh.indices[corner++] + 1;
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+// ASCII PLY with byte colors, double coordinates and an element the reader
+// has to skip between the vertices and the faces.
+std::string ascii_ply_text(const ColoredMesh& input)
+{
+    std::ostringstream out;
+    out.precision(9);
+    out << "ply\nformat ascii 1.0\ncomment streamed\n"
+        << "element vertex " << input.mesh.positions.size() << '\n'
+        << "property double x\nproperty double y\nproperty double z\n"
+        << "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+        << "element material 2\nproperty float shininess\n"
+        << "element face " << input.mesh.counts.size() << '\n'
+        << "property list uchar int vertex_indices\nend_header\n";
+    for (size_t v = 0; v < input.mesh.positions.size(); ++v) {
+        const GfVec3f& p = input.mesh.positions[v];
+        out << p[0] << ' ' << p[1] << ' ' << p[2];
+        for (int k = 0; k < 3; ++k) {
+            out << ' ' << std::lround(input.colors[v][k] * 255.0f);
+        }
+        out << '\n';
+    }
+    out << "0.5\n2\n";
+    size_t corner = 0;
+    for (int count : input.mesh.counts) {
+        out << count;
+        for (int i = 0; i < count; ++i) {
+            out << ' ' << input.mesh.indices[corner++];
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+}  // namespace
+
+TEST(MeshStream, obj_to_ply_to_obj)
+{
+    const ColoredMesh input = make_input();
+    const std::string obj =
+        write_temporary("stream_input.obj", obj_text(input));
+    const std::string ply = temporary("stream_middle.ply");
+    const std::string result = temporary("stream_output.obj");
+
+    // The scalar of every vertex is its index, which only comes out right if
+    // first_vertex follows the batches.
+    MeshStreamStats stats;
+    ASSERT_TRUE(stream_mesh(
+        obj,
+        ply,
+        [](MeshBatch& batch) {
+            batch.scalars.resize(batch.positions.size());
+            for (size_t v = 0; v < batch.positions.size(); ++v) {
+                batch.scalars[v] = float(batch.first_vertex + v);
+            }
+            return true;
+        },
+        &stats,
+        kBatchBytes));
+    EXPECT_GT(stats.batches, 2u);
+    EXPECT_EQ(stats.vertices, input.mesh.positions.size());
+    EXPECT_EQ(stats.faces, input.mesh.counts.size());
+
+    // The faces were spooled and appended, and the padded counts patched.
+    EXPECT_FALSE(std::filesystem::exists(ply + ".faces"));
+    EXPECT_EQ(ply_element_count(ply, "vertex"), input.mesh.positions.size());
+    EXPECT_EQ(ply_element_count(ply, "face"), input.mesh.counts.size());
+
+    const ColoredMesh middle = read_all(ply);
+    EXPECT_GT(middle.batches, 2u);
+    expect_same(input, middle);
+    ASSERT_EQ(middle.scalars.size(), input.mesh.positions.size());
+    for (size_t v = 0; v < middle.scalars.size(); ++v) {
+        EXPECT_EQ(middle.scalars[v], float(v));
+    }
+
+    ASSERT_TRUE(stream_mesh(ply, result, nullptr, &stats, kBatchBytes));
+    EXPECT_GT(stats.batches, 2u);
+    const ColoredMesh output = read_all(result);
+    expect_same(input, output);
+    EXPECT_TRUE(output.scalars.empty());
+
+    std::filesystem::remove(obj);
+    std::filesystem::remove(ply);
+    std::filesystem::remove(result);
+}
+
+TEST(MeshStream, ascii_ply_to_binary_ply)
+{
+    const ColoredMesh input = make_input();
+    const std::string ascii =
+        write_temporary("stream_ascii.ply", ascii_ply_text(input));
+    const std::string binary = temporary("stream_binary.ply");
+
+    const ColoredMesh read = read_all(ascii);
+    EXPECT_GT(read.batches, 2u);
+    expect_same(input, read);
+
+    MeshStreamStats stats;
+    ASSERT_TRUE(stream_mesh(ascii, binary, nullptr, &stats, kBatchBytes));
+    EXPECT_GT(stats.batches, 2u);
+    expect_same(input, read_all(binary));
+
+    std::filesystem::remove(ascii);
+    std::filesystem::remove(binary);
+}
+
+TEST(MeshStream, rejects_unsupported_files)
+{
+    MeshStreamReader reader;
+    EXPECT_FALSE(reader.open(temporary("stream_missing.obj")));
+    EXPECT_FALSE(reader.open(write_temporary("stream.stl", "solid\n")));
+    EXPECT_FALSE(reader.open(write_temporary(
+        "stream_big_endian.ply",
+        "ply\nformat binary_big_endian 1.0\nelement vertex 0\n"
+        "property float x\nend_header\n")));
+
+    // Indices past the vertices fail the stream.
+    const std::string obj =
+        write_temporary("stream_bad.obj", "v 0 0 0\nv 1 0 0\nf 1 2 3\n");
+    const std::string ply = temporary("stream_bad.ply");
+    EXPECT_FALSE(stream_mesh(obj, ply, nullptr, nullptr));
+
+    std::filesystem::remove(obj);
+    std::filesystem::remove(ply);
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+#include "GCore/algorithms/mesh_topology.h"
+#include "GCore/algorithms/triangulate.h"
+#include "test_meshes.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+using test::TestMesh;
+
+namespace {
+
+// Two triangles touching at vertex 2.
+TestMesh make_bowtie()
+{
+    return { pxr::VtArray<GfVec3f>(5), { 3, 3 }, { 0, 1, 2, 2, 3, 4 } };
+}
+
+// Three triangles sharing the edge 0-1.
+TestMesh make_three_face_edge()
+{
+    return { pxr::VtArray<GfVec3f>(5),
+             { 3, 3, 3 },
+             { 0, 1, 2, 1, 0, 3, 0, 1, 4 } };
+}
+
+// 3 x 3 grid of quads without the center one.
+TestMesh make_grid_with_hole()
+{
+    const TestMesh full = test::grid(3);
+    TestMesh mesh;
+    mesh.positions = full.positions;
+    for (int f = 0; f < 9; ++f) {
+        if (f == 4) {
+            continue;
+        }
+        mesh.counts.push_back(4);
+        mesh.indices.insert(
+            mesh.indices.end(),
+            full.indices.begin() + 4 * f,
+            full.indices.begin() + 4 * f + 4);
+    }
+    return mesh;
+}
+
+std::vector<std::vector<uint32_t>> loops_of(const MeshTopology& topology)
+{
+    std::vector<std::vector<uint32_t>> loops;
+    const auto& offsets = topology.loop_offsets();
+    const auto& vertices = topology.loop_vertices();
+    for (size_t l = 0; l < topology.loop_count(); ++l) {
+        loops.emplace_back(
+            vertices.begin() + offsets[l], vertices.begin() + offsets[l + 1]);
+    }
+    return loops;
+}
+
+// MeshTopology and boundary_loops() walk the same loops.
+void expect_loops(
+    const TestMesh& mesh,
+    const std::vector<std::vector<uint32_t>>& expected)
+{
+    EXPECT_EQ(loops_of(test::topology(mesh)), expected);
+
+    std::vector<std::vector<uint32_t>> loops;
+    ASSERT_TRUE(boundary_loops(
+        mesh.counts, mesh.indices, mesh.positions.size(), loops));
+    EXPECT_EQ(loops, expected);
+}
+
+}  // namespace
+
+TEST(MeshTopology, bowtie)
+{
+    const TestMesh mesh = make_bowtie();
+    const MeshTopology topology = test::topology(mesh);
+    EXPECT_EQ(topology.component_count(), 1u);
+    EXPECT_EQ(topology.edge_count(), 6u);
+    EXPECT_EQ(topology.boundary_edge_count(), 6u);
+    EXPECT_EQ(topology.euler_characteristic(), 1);
+    EXPECT_TRUE(topology.non_manifold_edges().empty());
+    EXPECT_EQ(topology.non_manifold_vertex_count(), 1u);
+    EXPECT_EQ(topology.non_manifold_vertices()[2], 1);
+    EXPECT_FALSE(topology.is_manifold());
+    EXPECT_FALSE(topology.is_closed());
+    // The shared vertex is on both loops.
+    expect_loops(mesh, { { 0, 1, 2 }, { 2, 3, 4 } });
+}
+
+TEST(MeshTopology, three_face_edge)
+{
+    const TestMesh mesh = make_three_face_edge();
+    const MeshTopology topology = test::topology(mesh);
+    EXPECT_EQ(topology.component_count(), 1u);
+    EXPECT_EQ(topology.edge_count(), 7u);
+    EXPECT_EQ(topology.boundary_edge_count(), 6u);
+    EXPECT_EQ(topology.euler_characteristic(), 1);
+    const std::vector<std::array<uint32_t, 2>> edges = { { 0, 1 } };
+    EXPECT_EQ(topology.non_manifold_edges(), edges);
+    EXPECT_EQ(topology.non_manifold_vertices()[0], 1);
+    EXPECT_EQ(topology.non_manifold_vertices()[1], 1);
+    EXPECT_FALSE(topology.is_manifold());
+    // 0 -> 3 -> 1 -> 2 closes; 1 -> 4 -> 0 then finds no unused half-edge
+    // leaving 0 and is dropped.
+    expect_loops(mesh, { { 0, 3, 1, 2 } });
+}
+
+TEST(MeshTopology, grid_with_hole)
+{
+    const TestMesh mesh = make_grid_with_hole();
+    const MeshTopology topology = test::topology(mesh);
+    EXPECT_EQ(topology.component_count(), 1u);
+    EXPECT_EQ(topology.edge_count(), 24u);
+    EXPECT_EQ(topology.boundary_edge_count(), 16u);
+    // An annulus.
+    EXPECT_EQ(topology.euler_characteristic(), 0);
+    EXPECT_TRUE(topology.is_manifold());
+    EXPECT_FALSE(topology.is_closed());
+    EXPECT_EQ(topology.inconsistent_edge_count(), 0u);
+    // The outer loop runs with the faces, the hole against them.
+    expect_loops(
+        mesh,
+        { { 0, 1, 2, 3, 7, 11, 15, 14, 13, 12, 8, 4 }, { 5, 9, 10, 6 } });
+}
+
+TEST(MeshTopology, rejects_invalid_input)
+{
+    MeshTopology topology;
+    EXPECT_FALSE(topology.analyze({ 3 }, { 0, 1, 5 }, 3, 1));
+    EXPECT_FALSE(topology.analyze({ 4 }, { 0, 1, 2 }, 3, 1));
+    EXPECT_FALSE(topology.analyze({ -3 }, { 0, 1, 2 }, 3, 1));
+    EXPECT_EQ(topology.loop_count(), 0u);
+}
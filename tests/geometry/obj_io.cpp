@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/GOP.h"
+#include "GCore/obj_io.h"
+
+using namespace USTC_CG;
+using pxr::GfVec2f;
+using pxr::GfVec3f;
+
+namespace {
+
+bool parse(const std::string& text, ObjCounts& counts, MeshBatch& batch)
+{
+    return parse_obj_batch(
+        text.data(), text.data() + text.size(), counts, batch);
+}
+
+const std::string kQuadPositions =
+    "v 0 0 0\n"
+    "v 1 0 0\n"
+    "v 1 1 0\n"
+    "v 0 1 0\n";
+
+std::string write_temporary(const std::string& name, const std::string& text)
+{
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path, std::ios::binary) << text;
+    return path.string();
+}
+
+}  // namespace
+
+TEST(ObjIo, all_index_forms)
+{
+    const std::string text = kQuadPositions +
+                              "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+                              "vn 0 0 1\n"
+                              "f 1 2 3\n"
+                              "f 1/1 3/3 4/4\n"
+                              "f 1//1 2//1 3//1 4//1\n"
+                              "f 4/4/1 3/3/1 2/2/1\n"
+                              "f -4 -3 -2 -1\n"
+                              "f -4/-4 -2/-2 -1/-1\n"
+                              "f -3//-1 -2//-1 -1//-1\n"
+                              "f -4/-4/-1 -3/-3/-1 -2/-2/-1\n";
+    ObjCounts counts;
+    MeshBatch batch;
+    ASSERT_TRUE(parse(text, counts, batch));
+
+    EXPECT_EQ(counts.positions, 4u);
+    EXPECT_EQ(counts.texcoords, 4u);
+    EXPECT_EQ(counts.normals, 1u);
+    EXPECT_EQ(counts.faces, 8u);
+    EXPECT_EQ(counts.corners, 26u);
+
+    pxr::VtArray<int> expected_counts = { 3, 3, 4, 3, 4, 3, 3, 3 };
+    pxr::VtArray<int> expected_indices = { 0, 1, 2, 0, 2, 3, 0, 1, 2, 3,
+                                           3, 2, 1, 0, 1, 2, 3, 0, 2, 3,
+                                           1, 2, 3, 0, 1, 2 };
+    EXPECT_EQ(batch.face_vertex_counts, expected_counts);
+    EXPECT_EQ(batch.face_vertex_indices, expected_indices);
+    ASSERT_EQ(batch.positions.size(), 4u);
+    EXPECT_EQ(batch.positions[2], GfVec3f(1, 1, 0));
+}
+
+TEST(ObjIo, relative_indices_count_from_the_current_line)
+{
+    // -1 refers to the last vertex before the face, not the last one in the
+    // file.
+    const std::string text =
+        "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+        "f -3 -2 -1\n"
+        "v 1 1 0\n"
+        "f -3 -2 -1\n";
+    ObjCounts counts;
+    MeshBatch batch;
+    ASSERT_TRUE(parse(text, counts, batch));
+    pxr::VtArray<int> expected = { 0, 1, 2, 1, 2, 3 };
+    EXPECT_EQ(batch.face_vertex_indices, expected);
+}
+
+TEST(ObjIo, pieces_refer_to_earlier_pieces)
+{
+    ObjCounts counts;
+    MeshBatch batch;
+    ASSERT_TRUE(parse(kQuadPositions, counts, batch));
+    EXPECT_EQ(batch.first_vertex, 0u);
+    EXPECT_EQ(batch.positions.size(), 4u);
+    EXPECT_TRUE(batch.face_vertex_counts.empty());
+
+    ASSERT_TRUE(parse("v 2 0 0\nf 2 5 3\nf -4 -1 -3\n", counts, batch));
+    EXPECT_EQ(batch.first_vertex, 4u);
+    EXPECT_EQ(batch.first_face, 0u);
+    ASSERT_EQ(batch.positions.size(), 1u);
+    EXPECT_EQ(batch.positions[0], GfVec3f(2, 0, 0));
+    pxr::VtArray<int> expected = { 1, 4, 2, 1, 4, 2 };
+    EXPECT_EQ(batch.face_vertex_indices, expected);
+    EXPECT_EQ(counts.positions, 5u);
+    EXPECT_EQ(counts.faces, 2u);
+}
+
+TEST(ObjIo, skips_other_statements)
+{
+    const std::string text =
+        "# comment\n"
+        "mtllib scene.mtl\n"
+        "o quad\r\n"
+        "g group\n"
+        "v 0 0 0 1\n"
+        "v 1 0 0 1\n"
+        "\tv  1 1 0\n"
+        "usemtl red\n"
+        "s off\n"
+        "l 1 2\n"
+        "vp 0.5\n"
+        "f 1 2 3 # trailing comment\n";
+    ObjCounts counts;
+    MeshBatch batch;
+    ASSERT_TRUE(parse(text, counts, batch));
+    EXPECT_EQ(counts.positions, 3u);
+    EXPECT_EQ(counts.faces, 1u);
+    pxr::VtArray<int> expected = { 0, 1, 2 };
+    EXPECT_EQ(batch.face_vertex_indices, expected);
+}
+
+TEST(ObjIo, rejects_bad_indices)
+{
+    for (const char* face : { "f 1 2 5\n",
+                              "f 0 1 2\n",
+                              "f -5 1 2\n",
+                              "f 1/5 2 3\n",
+                              "f 1//2 2 3\n",
+                              "f 1 2 x\n" }) {
+        const std::string text = kQuadPositions + "vt 0 0\nvn 0 0 1\n" + face;
+        ObjCounts counts;
+        MeshBatch batch;
+        const char* error = nullptr;
+        EXPECT_FALSE(parse_obj_batch(
+            text.data(), text.data() + text.size(), counts, batch, &error))
+            << face;
+        ASSERT_NE(error, nullptr);
+        EXPECT_EQ(std::string(error, std::strlen(face)), face);
+    }
+}
+
+TEST(ObjIo, vertex_colors)
+{
+    ObjCounts counts;
+    MeshBatch batch;
+    ASSERT_TRUE(parse(kQuadPositions, counts, batch));
+    EXPECT_TRUE(batch.colors.empty());
+
+    // Vertices without a color get zero once any vertex in the batch has one.
+    ASSERT_TRUE(parse(
+        "v 0 0 1 1 0.5 0\nv 1 0 1\nv 1 1 1 1.0\nv 0 1 1 0 0 1\n",
+        counts,
+        batch));
+    ASSERT_EQ(batch.colors.size(), 4u);
+    EXPECT_EQ(batch.positions[0], GfVec3f(0, 0, 1));
+    EXPECT_EQ(batch.colors[0], GfVec3f(1, 0.5f, 0));
+    EXPECT_EQ(batch.colors[1], GfVec3f(0));
+    EXPECT_EQ(batch.positions[2], GfVec3f(1, 1, 1));
+    EXPECT_EQ(batch.colors[2], GfVec3f(0));
+    EXPECT_EQ(batch.colors[3], GfVec3f(0, 0, 1));
+}
+
+TEST(ObjIo, floats_round_like_from_chars)
+{
+    // The decimal values lie just above or below a point halfway between two
+    // floats, where rounding through double would go the wrong way.
+    const char* values[] = { "1.0000000596046448",
+                             "1.0000000596046446",
+                             "0.5942263305187225",
+                             "-7.196775734086887e+19",
+                             "3.4028235e38",
+                             "1e-40",
+                             "0.1",
+                             "+2.5e-3",
+                             "123456789012345678901234" };
+    for (const char* value : values) {
+        const std::string text =
+            std::string("v ") + value + " " + value + " " + value + "\n";
+        ObjCounts counts;
+        MeshBatch batch;
+        ASSERT_TRUE(parse(text, counts, batch)) << value;
+        float expected = 0;
+        const char* begin = value + (value[0] == '+');
+        std::from_chars(begin, begin + std::strlen(begin), expected);
+        EXPECT_EQ(batch.positions[0][0], expected) << value;
+        EXPECT_EQ(batch.positions[0][2], expected) << value;
+    }
+}
+
+TEST(ObjIo, read_obj_primvars)
+{
+    // Texture coordinates indexed like the positions become a vertex
+    // primvar, normals indexed differently a face-varying one.
+    const std::string path = write_temporary(
+        "obj_io_test.obj",
+        kQuadPositions +
+            "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+            "vn 0 0 1\nvn 0 0 -1\n"
+            "f 1/1/1 2/2/1 3/3/1\n"
+            "f 1/1/2 3/3/2 4/4/2\n");
+    Geometry geometry;
+    ASSERT_TRUE(read_obj(path, geometry));
+    auto mesh = geometry.get_component<MeshComponent>();
+    ASSERT_TRUE(mesh);
+
+    EXPECT_EQ(mesh->get_vertices().size(), 4u);
+    pxr::VtArray<int> expected_counts = { 3, 3 };
+    pxr::VtArray<int> expected_indices = { 0, 1, 2, 0, 2, 3 };
+    EXPECT_EQ(mesh->get_face_vertex_counts(), expected_counts);
+    EXPECT_EQ(mesh->get_face_vertex_indices(), expected_indices);
+
+    auto texcoords = mesh->get_texcoords_array();
+    ASSERT_EQ(texcoords.size(), 4u);
+    EXPECT_EQ(texcoords[2], GfVec2f(1, 1));
+
+    auto normals = mesh->get_normals();
+    ASSERT_EQ(normals.size(), 6u);
+    EXPECT_EQ(normals[0], GfVec3f(0, 0, 1));
+    EXPECT_EQ(normals[5], GfVec3f(0, 0, -1));
+
+    std::filesystem::remove(path);
+}
+
+TEST(ObjIo, read_obj_display_color)
+{
+    const std::string path = write_temporary(
+        "obj_io_color_test.obj",
+        "v 0 0 0 1 0 0\nv 1 0 0 0 1 0\nv 0 1 0 0 0 1\nf 1 2 3\n");
+    Geometry geometry;
+    ASSERT_TRUE(read_obj(path, geometry));
+    auto mesh = geometry.get_component<MeshComponent>();
+    ASSERT_TRUE(mesh);
+    pxr::VtArray<GfVec3f> expected = { GfVec3f(1, 0, 0),
+                                       GfVec3f(0, 1, 0),
+                                       GfVec3f(0, 0, 1) };
+    EXPECT_EQ(mesh->get_display_color(), expected);
+    std::filesystem::remove(path);
+}
+
+TEST(ObjIo, read_obj_reports_errors)
+{
+    Geometry geometry;
+    EXPECT_FALSE(read_obj("missing_obj_io_test.obj", geometry));
+
+    const std::string path =
+        write_temporary("obj_io_bad_test.obj", kQuadPositions + "f 1 2 9\n");
+    EXPECT_FALSE(read_obj(path, geometry));
+    EXPECT_FALSE(geometry.get_component<MeshComponent>());
+    std::filesystem::remove(path);
+}
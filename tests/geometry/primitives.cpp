@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <utility>
+
+#include "GCore/algorithms/primitives.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+
+namespace {
+
+struct Topology {
+    long euler = 0;
+    // Directed edges used by more than one face.
+    size_t repeated = 0;
+    // Directed edges whose opposite is not used by any face.
+    size_t unmatched = 0;
+};
+
+Topology topology(const PrimitiveMesh& mesh)
+{
+    std::map<std::pair<int, int>, int> directed;
+    size_t corner = 0;
+    for (int count : mesh.face_vertex_counts) {
+        for (int k = 0; k < count; ++k) {
+            const int from = mesh.face_vertex_indices[corner + k];
+            const int to = mesh.face_vertex_indices[corner + (k + 1) % count];
+            ++directed[{ from, to }];
+        }
+        corner += count;
+    }
+    EXPECT_EQ(corner, mesh.face_vertex_indices.size());
+
+    Topology result;
+    for (const auto& [edge, count] : directed) {
+        result.repeated += count > 1;
+        result.unmatched += !directed.count({ edge.second, edge.first });
+    }
+    const size_t edges = (directed.size() + result.unmatched) / 2;
+    result.euler = long(mesh.positions.size()) - long(edges) +
+                   long(mesh.face_vertex_counts.size());
+    return result;
+}
+
+void expect_closed(const PrimitiveMesh& mesh, long euler)
+{
+    const Topology result = topology(mesh);
+    EXPECT_EQ(result.euler, euler);
+    EXPECT_EQ(result.repeated, 0u);
+    EXPECT_EQ(result.unmatched, 0u);
+}
+
+// Every face of a surface around the origin that is star-shaped from it
+// faces away from the origin.
+void expect_outward(const PrimitiveMesh& mesh)
+{
+    size_t corner = 0;
+    for (size_t f = 0; f < mesh.face_vertex_counts.size(); ++f) {
+        const int count = mesh.face_vertex_counts[f];
+        GfVec3f area(0.0f), center(0.0f);
+        for (int k = 0; k < count; ++k) {
+            const int from = mesh.face_vertex_indices[corner + k];
+            const int to = mesh.face_vertex_indices[corner + (k + 1) % count];
+            const GfVec3f& a = mesh.positions[from];
+            const GfVec3f& b = mesh.positions[to];
+            area += pxr::GfCross(a, b);
+            center += a;
+        }
+        EXPECT_GT(pxr::GfDot(area, center), 0.0f) << "face " << f;
+        corner += count;
+    }
+}
+
+}  // namespace
+
+TEST(Primitives, grid_is_a_disk)
+{
+    PrimitiveMesh mesh;
+    ASSERT_TRUE(make_grid(
+        GfVec3f(0.0f), GfVec3f(2, 0, 0), GfVec3f(0, 2, 0), 5, 7, mesh));
+    EXPECT_EQ(mesh.positions.size(), 6u * 8u);
+    EXPECT_EQ(mesh.face_vertex_counts.size(), 5u * 7u);
+    const Topology result = topology(mesh);
+    EXPECT_EQ(result.euler, 1);
+    EXPECT_EQ(result.repeated, 0u);
+    // The boundary edges.
+    EXPECT_EQ(result.unmatched, 2u * (5 + 7));
+}
+
+TEST(Primitives, closed_surfaces)
+{
+    PrimitiveMesh mesh;
+    for (auto [segments, rings] : { std::pair(3, 2), std::pair(12, 8) }) {
+        ASSERT_TRUE(make_uv_sphere(1.0f, segments, rings, mesh));
+        EXPECT_EQ(mesh.positions.size(), size_t(segments * (rings - 1) + 2));
+        expect_closed(mesh, 2);
+        expect_outward(mesh);
+    }
+
+    for (int frequency : { 1, 2, 5 }) {
+        ASSERT_TRUE(make_icosphere(1.0f, frequency, mesh));
+        EXPECT_EQ(
+            mesh.face_vertex_counts.size(), size_t(20 * frequency * frequency));
+        expect_closed(mesh, 2);
+        expect_outward(mesh);
+    }
+
+    for (int cells : { 1, 4 }) {
+        ASSERT_TRUE(make_cube(2.0f, cells, mesh));
+        EXPECT_EQ(mesh.face_vertex_counts.size(), size_t(6 * cells * cells));
+        expect_closed(mesh, 2);
+        expect_outward(mesh);
+    }
+
+    ASSERT_TRUE(make_cylinder(1.0f, 2.0f, 10, 3, mesh));
+    expect_closed(mesh, 2);
+    expect_outward(mesh);
+
+    ASSERT_TRUE(make_torus(2.0f, 0.5f, 16, 8, mesh));
+    EXPECT_EQ(mesh.positions.size(), 16u * 8u);
+    EXPECT_EQ(mesh.face_vertex_counts.size(), 16u * 8u);
+    expect_closed(mesh, 0);
+}
+
+TEST(Primitives, terrain_is_a_disk)
+{
+    TerrainNoise noise;
+    noise.amplitude = 0.3f;
+    PrimitiveMesh mesh;
+    ASSERT_TRUE(make_terrain(4.0f, 20, noise, mesh));
+    EXPECT_EQ(mesh.positions.size(), 21u * 21u);
+    const Topology result = topology(mesh);
+    EXPECT_EQ(result.euler, 1);
+    EXPECT_EQ(result.repeated, 0u);
+    EXPECT_EQ(result.unmatched, 4u * 20u);
+}
+
+TEST(Primitives, rejects_bad_counts)
+{
+    PrimitiveMesh mesh;
+    EXPECT_FALSE(make_uv_sphere(1.0f, 2, 8, mesh));
+    EXPECT_FALSE(make_icosphere(1.0f, 0, mesh));
+    EXPECT_FALSE(make_cube(1.0f, 0, mesh));
+    EXPECT_FALSE(make_torus(1.0f, 0.5f, 1 << 20, 1 << 20, mesh));
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "GCore/algorithms/kd_tree.h"
+#include "GCore/algorithms/qem.h"
+#include "test_meshes.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+using test::TestMesh;
+
+namespace {
+
+// Gently curved n x n height field of quads, facing +z.
+TestMesh make_height_field(int n)
+{
+    TestMesh mesh = test::grid(n);
+    for (GfVec3f& p : mesh.positions) {
+        p[2] = 0.1f * std::sin(6 * p[0]) * std::cos(4 * p[1]);
+    }
+    return mesh;
+}
+
+GfVec3f face_normal(const TestMesh& mesh, int face)
+{
+    const GfVec3f& a = mesh.positions[mesh.indices[3 * face]];
+    const GfVec3f& b = mesh.positions[mesh.indices[3 * face + 1]];
+    const GfVec3f& c = mesh.positions[mesh.indices[3 * face + 2]];
+    return pxr::GfCross(b - a, c - a);
+}
+
+TestMesh simplify(
+    const TestMesh& input,
+    size_t target_faces,
+    const QemSimplifier::Options& options = {})
+{
+    QemSimplifier simplifier;
+    EXPECT_TRUE(simplifier.build(
+        input.positions, input.counts, input.indices, options));
+    simplifier.simplify(target_faces);
+
+    TestMesh output;
+    simplifier.extract(output.positions, output.counts, output.indices);
+    EXPECT_EQ(output.counts.size(), simplifier.stats().output_faces);
+    return output;
+}
+
+}  // namespace
+
+TEST(QemSimplifier, sphere_reaches_target_without_flips)
+{
+    const TestMesh sphere = test::uv_sphere(64, 32);
+    const size_t input_faces = 64 * 2 + 64 * 30 * 2;
+
+    for (size_t target : { size_t(2000), size_t(500), size_t(100) }) {
+        const TestMesh output = simplify(sphere, target);
+        // A collapse on a closed mesh removes two triangles.
+        EXPECT_LE(output.counts.size(), target);
+        EXPECT_GE(output.counts.size() + 2, target);
+        EXPECT_LT(output.counts.size(), input_faces);
+        for (int count : output.counts) {
+            EXPECT_EQ(count, 3);
+        }
+        test::expect_closed_manifold(output, 2);
+
+        // The sphere is convex, so every face must still point outward.
+        for (int f = 0; f < int(output.counts.size()); ++f) {
+            const GfVec3f& a = output.positions[output.indices[3 * f]];
+            EXPECT_GT(pxr::GfDot(face_normal(output, f), a), 0.0f)
+                << "face " << f << " flipped at target " << target;
+        }
+    }
+}
+
+TEST(QemSimplifier, height_field_keeps_facing_up)
+{
+    const TestMesh field = make_height_field(40);
+    const TestMesh output = simplify(field, 300);
+    EXPECT_LE(output.counts.size(), 300u);
+    EXPECT_GE(output.counts.size(), 290u);
+    for (int f = 0; f < int(output.counts.size()); ++f) {
+        EXPECT_GT(face_normal(output, f)[2], 0.0f) << "face " << f;
+    }
+}
+
+TEST(QemSimplifier, invalid_topology_is_rejected)
+{
+    const pxr::VtArray<GfVec3f> positions = { GfVec3f(0, 0, 0),
+                                              GfVec3f(1, 0, 0),
+                                              GfVec3f(0, 1, 0) };
+    QemSimplifier simplifier;
+    EXPECT_FALSE(simplifier.build(positions, { 3 }, { 0, 1, 5 }, {}));
+    EXPECT_FALSE(simplifier.build(positions, { 4 }, { 0, 1, 2 }, {}));
+    EXPECT_FALSE(simplifier.build(positions, { -3 }, { 0, 1, 2 }, {}));
+    EXPECT_TRUE(simplifier.build(positions, { 3 }, { 0, 1, 2 }, {}));
+}
+
+TEST(QemSimplifier, given_point_tree_matches_own)
+{
+    // Two spheres close enough for non-edge pairs to join them.
+    TestMesh input = test::uv_sphere(24, 12);
+    const TestMesh other = test::uv_sphere(24, 12, GfVec3f(2.05f, 0, 0));
+    test::append(input, other);
+
+    QemSimplifier::Options options;
+    options.pair_distance = 0.05f;
+    const TestMesh own = simplify(input, 200, options);
+
+    auto tree = std::make_shared<PointKdTree>();
+    tree->build(input.positions);
+    options.point_tree = tree;
+    const TestMesh given = simplify(input, 200, options);
+
+    EXPECT_EQ(given.positions, own.positions);
+    EXPECT_EQ(given.indices, own.indices);
+
+    // A tree over other points is ignored.
+    auto wrong = std::make_shared<PointKdTree>();
+    wrong->build(other.positions);
+    options.point_tree = wrong;
+    const TestMesh rebuilt = simplify(input, 200, options);
+    EXPECT_EQ(rebuilt.indices, own.indices);
+}
+
+TEST(QemSimplifier, rejects_collapses_that_squash_a_triangle)
+{
+    const TestMesh sphere = test::icosphere(2);
+    const auto& indices = sphere.indices;
+
+    // Vertex a = corner 0 of face 0 with its neighbor b = corner 1, and a
+    // face (a, u, w) that does not contain b.
+    const int a = indices[0], b = indices[1];
+    int u = -1, w = -1;
+    for (size_t f = 1; f < sphere.counts.size() && u < 0; ++f) {
+        const int* t = indices.cdata() + 3 * f;
+        for (int k = 0; k < 3; ++k) {
+            if (t[k] == a && t[(k + 1) % 3] != b && t[(k + 2) % 3] != b) {
+                u = t[(k + 1) % 3];
+                w = t[(k + 2) % 3];
+            }
+        }
+    }
+    ASSERT_GE(u, 0);
+
+    // Quadrics of a and b that put the optimum of their collapse, at zero
+    // error, on the edge u-w, which would flatten (a, u, w) to a line.
+    const pxr::GfVec3d target = 0.5 * (pxr::GfVec3d(sphere.positions[u]) +
+                                       pxr::GfVec3d(sphere.positions[w]));
+    Quadric pin;
+    for (int axis = 0; axis < 3; ++axis) {
+        pxr::GfVec3d n(0.0);
+        n[axis] = 1.0;
+        pin += Quadric::from_plane(n, -target[axis], 1.0);
+    }
+    QemSimplifier::Options options;
+    options.quadrics.resize(sphere.positions.size());
+    options.quadrics[a] = pin;
+    options.quadrics[b] = pin;
+
+    QemSimplifier simplifier;
+    ASSERT_TRUE(simplifier.build(
+        sphere.positions,
+        sphere.counts,
+        sphere.indices,
+        options));
+    simplifier.simplify(sphere.counts.size() - 2);
+
+    TestMesh output;
+    simplifier.extract(output.positions, output.counts, output.indices);
+    ASSERT_EQ(output.counts.size(), sphere.counts.size() - 2);
+    for (int f = 0; f < int(output.counts.size()); ++f) {
+        EXPECT_GT(face_normal(output, f).GetLength(), 1e-4f) << "face " << f;
+    }
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+
+#include "GCore/algorithms/remeshing.h"
+#include "test_meshes.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+using test::TestMesh;
+
+namespace {
+
+TestMesh remesh(
+    const TestMesh& input,
+    const IsotropicRemesher::Options& options)
+{
+    IsotropicRemesher remesher;
+    EXPECT_TRUE(remesher.remesh(
+        input.positions, input.counts, input.indices, options));
+    TestMesh output;
+    remesher.extract(output.positions, output.counts, output.indices);
+    EXPECT_EQ(output.counts.size(), remesher.stats().output_faces);
+    for (int count : output.counts) {
+        EXPECT_EQ(count, 3);
+    }
+    return output;
+}
+
+// Fraction of the edges within [4/5, 4/3] of the target length; every edge
+// is visited from both of its faces on a closed mesh.
+double fraction_in_band(const TestMesh& mesh, float target)
+{
+    size_t inside = 0;
+    for (size_t corner = 0; corner < mesh.indices.size(); ++corner) {
+        const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+        const float length =
+            (mesh.positions[mesh.indices[corner]] -
+             mesh.positions[mesh.indices[next]])
+                .GetLength();
+        inside += length >= 0.8f * target && length <= 4.0f / 3.0f * target;
+    }
+    return double(inside) / double(mesh.indices.size());
+}
+
+bool on_unit_square_boundary(const GfVec3f& p)
+{
+    return p[0] == 0.0f || p[0] == 1.0f || p[1] == 0.0f || p[1] == 1.0f;
+}
+
+}  // namespace
+
+TEST(IsotropicRemesher, sphere_stays_a_closed_manifold)
+{
+    const TestMesh sphere = test::uv_sphere(48, 24);
+    IsotropicRemesher::Options options;
+    options.target_length = 0.15f;
+    const TestMesh output = remesh(sphere, options);
+
+    test::expect_closed_manifold(output, 2);
+    // Splits and collapses stop outside the band; only the relaxation of the
+    // last iteration moves a few edges past it.
+    EXPECT_GT(fraction_in_band(output, options.target_length), 0.95);
+    for (const GfVec3f& p : output.positions) {
+        EXPECT_NEAR(p.GetLength(), 1.0f, 0.01f);
+    }
+}
+
+TEST(IsotropicRemesher, given_reference_matches_own)
+{
+    const TestMesh sphere = test::icosphere(8);
+    IsotropicRemesher::Options options;
+    options.target_length = 0.2f;
+    options.iterations = 3;
+    const TestMesh own = remesh(sphere, options);
+
+    auto reference = std::make_shared<TriangleBVH>();
+    ASSERT_TRUE(
+        reference->build(sphere.positions, sphere.counts, sphere.indices));
+    options.reference = reference;
+    const TestMesh given = remesh(sphere, options);
+    EXPECT_EQ(given.positions, own.positions);
+    EXPECT_EQ(given.indices, own.indices);
+}
+
+TEST(IsotropicRemesher, grid_boundary_stays_in_place)
+{
+    const TestMesh plate = test::grid(10);
+    IsotropicRemesher::Options options;
+    options.target_length = 0.05f;
+    const TestMesh output = remesh(plate, options);
+
+    const MeshTopology topology = test::topology(output);
+    EXPECT_TRUE(topology.is_manifold());
+    EXPECT_EQ(topology.inconsistent_edge_count(), 0u);
+    EXPECT_EQ(topology.euler_characteristic(), 1);
+    ASSERT_EQ(topology.loop_count(), 1u);
+
+    // Boundary vertices are only added on the boundary edges and removed
+    // along them, never moved, and the corners stay.
+    int corners = 0;
+    for (uint32_t v : topology.loop_vertices()) {
+        const GfVec3f& p = output.positions[v];
+        EXPECT_TRUE(on_unit_square_boundary(p)) << p[0] << " " << p[1];
+        corners += (p[0] == 0.0f || p[0] == 1.0f) &&
+                   (p[1] == 0.0f || p[1] == 1.0f);
+    }
+    EXPECT_EQ(corners, 4);
+    EXPECT_GT(fraction_in_band(output, options.target_length), 0.9);
+    for (const GfVec3f& p : output.positions) {
+        EXPECT_EQ(p[2], 0.0f);
+    }
+}
+
+TEST(IsotropicRemesher, rejects_non_manifold_input)
+{
+    // Three triangles on one edge.
+    const TestMesh fin = { pxr::VtArray<GfVec3f>(5),
+                           { 3, 3, 3 },
+                           { 0, 1, 2, 1, 0, 3, 0, 1, 4 } };
+    IsotropicRemesher remesher;
+    EXPECT_FALSE(remesher.remesh(fin.positions, fin.counts, fin.indices, {}));
+}
@@ -0,0 +1,396 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/Components/SpatialIndexComponent.h"
+#include "GCore/GOP.h"
+#include "GCore/algorithms/bvh.h"
+#include "GCore/algorithms/kd_tree.h"
+#include "test_meshes.h"
+
+using namespace USTC_CG;
+using pxr::GfVec3f;
+using test::TestMesh;
+
+namespace {
+
+// Closest point on triangle abc, after Ericson, Real-Time Collision
+// Detection 5.1.5.
+GfVec3f closest_on_triangle(
+    const GfVec3f& p,
+    const GfVec3f& a,
+    const GfVec3f& b,
+    const GfVec3f& c)
+{
+    GfVec3f ab = b - a, ac = c - a, ap = p - a;
+    float d1 = pxr::GfDot(ab, ap), d2 = pxr::GfDot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) {
+        return a;
+    }
+    GfVec3f bp = p - b;
+    float d3 = pxr::GfDot(ab, bp), d4 = pxr::GfDot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) {
+        return b;
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        return a + ab * (d1 / (d1 - d3));
+    }
+    GfVec3f cp = p - c;
+    float d5 = pxr::GfDot(ab, cp), d6 = pxr::GfDot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) {
+        return c;
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        return a + ac * (d2 / (d2 - d6));
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+    float denom = 1 / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// Möller-Trumbore; returns infinity on a miss.
+float ray_triangle(
+    const GfVec3f& origin,
+    const GfVec3f& direction,
+    const GfVec3f& a,
+    const GfVec3f& b,
+    const GfVec3f& c)
+{
+    const float miss = TriangleBVH::kInfinity;
+    GfVec3f e1 = b - a, e2 = c - a;
+    GfVec3f h = pxr::GfCross(direction, e2);
+    float det = pxr::GfDot(e1, h);
+    if (std::abs(det) < 1e-12f) {
+        return miss;
+    }
+    float inv = 1 / det;
+    GfVec3f s = origin - a;
+    float u = inv * pxr::GfDot(s, h);
+    if (u < 0 || u > 1) {
+        return miss;
+    }
+    GfVec3f q = pxr::GfCross(s, e1);
+    float v = inv * pxr::GfDot(direction, q);
+    if (v < 0 || u + v > 1) {
+        return miss;
+    }
+    float t = inv * pxr::GfDot(e2, q);
+    return t >= 0 ? t : miss;
+}
+
+GfVec3f random_point(std::mt19937& rng, float lower, float upper)
+{
+    std::uniform_real_distribution<float> d(lower, upper);
+    return GfVec3f(d(rng), d(rng), d(rng));
+}
+
+// A bumpy n x n grid of quads with one triangle and one pentagon mixed in, so
+// the fan triangulation and the face reporting are both exercised.
+TestMesh make_mesh(int n, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> bump(-0.3f, 0.3f);
+    TestMesh mesh = test::grid(n, float(n));
+    for (GfVec3f& p : mesh.positions) {
+        p[2] = bump(rng);
+    }
+    TestMesh extra;
+    extra.positions = { GfVec3f(0, 0, 3),
+                        GfVec3f(2, 0, 3),
+                        GfVec3f(1, 2, 4),
+                        GfVec3f(3, 1, 5),
+                        GfVec3f(4, 3, 5) };
+    extra.counts = { 3, 5 };
+    extra.indices = { 0, 1, 2, 1, 3, 4, 2, 0 };
+    test::append(mesh, extra);
+    return mesh;
+}
+
+// Squared distance from p to the nearest face.
+float brute_force_closest(const TestMesh& mesh, const GfVec3f& p)
+{
+    float best = TriangleBVH::kInfinity;
+    size_t corner = 0;
+    for (int count : mesh.counts) {
+        const GfVec3f& a = mesh.positions[mesh.indices[corner]];
+        for (int k = 1; k + 1 < count; ++k) {
+            const GfVec3f& b = mesh.positions[mesh.indices[corner + k]];
+            const GfVec3f& c = mesh.positions[mesh.indices[corner + k + 1]];
+            GfVec3f q = closest_on_triangle(p, a, b, c);
+            best = std::min(best, (q - p).GetLengthSq());
+        }
+        corner += count;
+    }
+    return best;
+}
+
+float brute_force_ray(
+    const TestMesh& mesh,
+    const GfVec3f& origin,
+    const GfVec3f& direction)
+{
+    float best = TriangleBVH::kInfinity;
+    size_t corner = 0;
+    for (int count : mesh.counts) {
+        const GfVec3f& a = mesh.positions[mesh.indices[corner]];
+        for (int k = 1; k + 1 < count; ++k) {
+            const GfVec3f& b = mesh.positions[mesh.indices[corner + k]];
+            const GfVec3f& c = mesh.positions[mesh.indices[corner + k + 1]];
+            best = std::min(best, ray_triangle(origin, direction, a, b, c));
+        }
+        corner += count;
+    }
+    return best;
+}
+
+// Squared distance from p to face `face` of the mesh.
+float face_distance2(const TestMesh& mesh, int face, const GfVec3f& p)
+{
+    size_t corner = 0;
+    for (int f = 0; f < face; ++f) {
+        corner += mesh.counts[f];
+    }
+    float best = TriangleBVH::kInfinity;
+    const GfVec3f& a = mesh.positions[mesh.indices[corner]];
+    for (int k = 1; k + 1 < mesh.counts[face]; ++k) {
+        const GfVec3f& b = mesh.positions[mesh.indices[corner + k]];
+        const GfVec3f& c = mesh.positions[mesh.indices[corner + k + 1]];
+        GfVec3f q = closest_on_triangle(p, a, b, c);
+        best = std::min(best, (q - p).GetLengthSq());
+    }
+    return best;
+}
+
+}  // namespace
+
+TEST(TriangleBVH, closest_point_matches_brute_force)
+{
+    std::mt19937 rng(1);
+    TestMesh mesh = make_mesh(24, rng);
+    TriangleBVH bvh;
+    ASSERT_TRUE(bvh.build(mesh.positions, mesh.counts, mesh.indices));
+    EXPECT_EQ(bvh.triangle_count(), 24 * 24 * 2 + 1 + 3);
+
+    for (int q = 0; q < 500; ++q) {
+        GfVec3f p = random_point(rng, -4.0f, 28.0f);
+        auto hit = bvh.closest_point(p);
+        ASSERT_TRUE(hit);
+        float expected = brute_force_closest(mesh, p);
+        EXPECT_NEAR(hit.distance2, expected, 1e-4f * (1 + expected));
+        EXPECT_NEAR((hit.point - p).GetLengthSq(), hit.distance2, 1e-3f);
+        // The reported face must contain the reported point.
+        EXPECT_NEAR(face_distance2(mesh, hit.face, hit.point), 0.0f, 1e-4f);
+    }
+}
+
+TEST(TriangleBVH, closest_point_respects_max_distance)
+{
+    std::mt19937 rng(2);
+    TestMesh mesh = make_mesh(8, rng);
+    TriangleBVH bvh;
+    ASSERT_TRUE(bvh.build(mesh.positions, mesh.counts, mesh.indices));
+
+    GfVec3f far_away(100, 100, 100);
+    EXPECT_FALSE(bvh.closest_point(far_away, 1.0f));
+    EXPECT_TRUE(bvh.closest_point(far_away));
+}
+
+TEST(TriangleBVH, ray_matches_brute_force)
+{
+    std::mt19937 rng(3);
+    TestMesh mesh = make_mesh(24, rng);
+    TriangleBVH bvh;
+    ASSERT_TRUE(bvh.build(mesh.positions, mesh.counts, mesh.indices));
+
+    int hits = 0;
+    for (int q = 0; q < 500; ++q) {
+        GfVec3f origin = random_point(rng, -4.0f, 28.0f);
+        GfVec3f target = random_point(rng, 0.0f, 24.0f);
+        GfVec3f direction = target - origin;
+        auto hit = bvh.intersect(origin, direction);
+        float expected = brute_force_ray(mesh, origin, direction);
+        if (expected == TriangleBVH::kInfinity) {
+            EXPECT_FALSE(hit);
+            continue;
+        }
+        ASSERT_TRUE(hit);
+        EXPECT_NEAR(hit.t, expected, 1e-4f * (1 + expected));
+        ++hits;
+    }
+    EXPECT_GT(hits, 100);
+}
+
+TEST(TriangleBVH, batched_queries_match_single_ones)
+{
+    std::mt19937 rng(4);
+    TestMesh mesh = make_mesh(16, rng);
+    TriangleBVH bvh;
+    ASSERT_TRUE(bvh.build(mesh.positions, mesh.counts, mesh.indices));
+
+    std::vector<GfVec3f> queries(300);
+    for (auto& q : queries) {
+        q = random_point(rng, -2.0f, 18.0f);
+    }
+    std::vector<TriangleBVH::ClosestHit> hits(queries.size());
+    bvh.closest_points(queries.data(), queries.size(), hits.data());
+    for (size_t q = 0; q < queries.size(); ++q) {
+        auto single = bvh.closest_point(queries[q]);
+        EXPECT_EQ(hits[q].face, single.face);
+        EXPECT_EQ(hits[q].distance2, single.distance2);
+    }
+}
+
+TEST(TriangleBVH, refit_follows_moved_positions)
+{
+    std::mt19937 rng(5);
+    TestMesh mesh = make_mesh(12, rng);
+    TriangleBVH bvh;
+    ASSERT_TRUE(bvh.build(mesh.positions, mesh.counts, mesh.indices));
+
+    for (auto& p : mesh.positions) {
+        p = GfVec3f(p[0] * 0.5f, p[2] + 1.0f, p[1] * 2.0f);
+    }
+    bvh.refit(mesh.positions);
+    for (int q = 0; q < 200; ++q) {
+        GfVec3f p = random_point(rng, -2.0f, 26.0f);
+        float expected = brute_force_closest(mesh, p);
+        EXPECT_NEAR(
+            bvh.closest_point(p).distance2, expected, 1e-4f * (1 + expected));
+    }
+}
+
+TEST(TriangleBVH, rejects_invalid_topology)
+{
+    pxr::VtArray<GfVec3f> positions = { GfVec3f(0, 0, 0),
+                                        GfVec3f(1, 0, 0),
+                                        GfVec3f(0, 1, 0) };
+    TriangleBVH bvh;
+    EXPECT_FALSE(bvh.build(positions, { 3 }, { 0, 1, 3 }));
+    EXPECT_TRUE(bvh.empty());
+    EXPECT_FALSE(bvh.build(positions, { 4 }, { 0, 1, 2 }));
+    EXPECT_FALSE(bvh.build(positions, { -1, 4 }, { 0, 1, 2 }));
+    EXPECT_TRUE(bvh.build(positions, { 3 }, { 0, 1, 2 }));
+    EXPECT_EQ(bvh.triangle_count(), 1);
+}
+
+TEST(PointKdTree, queries_match_brute_force)
+{
+    std::mt19937 rng(6);
+    pxr::VtArray<GfVec3f> points(2000);
+    for (auto& p : points) {
+        p = random_point(rng, 0.0f, 1.0f);
+    }
+    // Duplicates must be reported once per index.
+    points[10] = points[11];
+
+    PointKdTree tree;
+    tree.build(points);
+    ASSERT_EQ(tree.size(), points.size());
+
+    std::vector<float> distances(points.size());
+    std::vector<PointKdTree::Neighbor> found;
+    for (int q = 0; q < 200; ++q) {
+        GfVec3f query = random_point(rng, -0.2f, 1.2f);
+        for (size_t i = 0; i < points.size(); ++i) {
+            distances[i] = (points[i] - query).GetLengthSq();
+        }
+        std::vector<float> sorted = distances;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto nearest = tree.nearest(query);
+        ASSERT_TRUE(nearest);
+        EXPECT_EQ(nearest.distance2, sorted[0]);
+        EXPECT_EQ(distances[nearest.index], sorted[0]);
+
+        const size_t k = 8;
+        tree.k_nearest(query, k, found);
+        ASSERT_EQ(found.size(), k);
+        for (size_t j = 0; j < k; ++j) {
+            EXPECT_EQ(found[j].distance2, sorted[j]);
+            EXPECT_EQ(distances[found[j].index], found[j].distance2);
+        }
+
+        const float radius = 0.1f;
+        tree.radius_search(query, radius, found);
+        size_t expected = std::upper_bound(
+                              sorted.begin(), sorted.end(), radius * radius) -
+                          sorted.begin();
+        EXPECT_EQ(found.size(), expected);
+        std::vector<bool> seen(points.size(), false);
+        for (const auto& neighbor : found) {
+            EXPECT_LE(distances[neighbor.index], radius * radius);
+            EXPECT_FALSE(seen[neighbor.index]);
+            seen[neighbor.index] = true;
+        }
+    }
+}
+
+TEST(PointKdTree, respects_max_distance)
+{
+    pxr::VtArray<GfVec3f> points = { GfVec3f(0, 0, 0), GfVec3f(1, 0, 0) };
+    PointKdTree tree;
+    tree.build(points);
+
+    EXPECT_FALSE(tree.nearest(GfVec3f(5, 0, 0), 1.0f));
+    EXPECT_EQ(tree.nearest(GfVec3f(5, 0, 0)).index, 1);
+
+    std::vector<PointKdTree::Neighbor> found;
+    tree.k_nearest(GfVec3f(0.1f, 0, 0), 5, found, 0.5f);
+    ASSERT_EQ(found.size(), 1);
+    EXPECT_EQ(found[0].index, 0);
+}
+
+TEST(SpatialIndexComponent, caches_until_the_mesh_changes)
+{
+    std::mt19937 rng(7);
+    TestMesh test_mesh = make_mesh(6, rng);
+    Geometry geometry = Geometry::CreateMesh();
+    auto mesh = geometry.get_component<MeshComponent>();
+    mesh->set_vertices(test_mesh.positions);
+    mesh->set_face_vertex_counts(test_mesh.counts);
+    mesh->set_face_vertex_indices(test_mesh.indices);
+
+    auto index = SpatialIndexComponent::get_or_create(geometry);
+    EXPECT_EQ(SpatialIndexComponent::get_or_create(geometry), index);
+
+    auto bvh = index->triangle_bvh(*mesh);
+    auto tree = index->point_tree(*mesh);
+    ASSERT_TRUE(bvh);
+    ASSERT_TRUE(tree);
+    EXPECT_EQ(index->triangle_bvh(*mesh), bvh);
+    EXPECT_EQ(index->point_tree(*mesh), tree);
+
+    // Copies share the built structures.
+    Geometry copy = geometry;
+    auto copy_mesh = copy.get_component<MeshComponent>();
+    auto copy_index = SpatialIndexComponent::get_or_create(copy);
+    EXPECT_EQ(copy_index->triangle_bvh(*copy_mesh), bvh);
+
+    // Moving the vertices invalidates both structures.
+    auto moved = test_mesh.positions;
+    for (auto& p : moved) {
+        p += GfVec3f(0, 0, 10);
+    }
+    mesh->set_vertices(moved);
+    auto refitted = index->triangle_bvh(*mesh);
+    ASSERT_TRUE(refitted);
+    EXPECT_NE(refitted, bvh);
+    EXPECT_NE(index->point_tree(*mesh), tree);
+    EXPECT_NEAR(
+        refitted->closest_point(GfVec3f(1, 1, 20)).distance2,
+        brute_force_closest({ moved, test_mesh.counts, test_mesh.indices },
+                            GfVec3f(1, 1, 20)),
+        1e-3f);
+
+    // Invalid topology yields no BVH.
+    mesh->set_face_vertex_indices({ 0, 1, 1000 });
+    mesh->set_face_vertex_counts({ 3 });
+    EXPECT_FALSE(index->triangle_bvh(*mesh));
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "GCore/algorithms/mesh_topology.h"
+#include "GCore/algorithms/primitives.h"
+
+// Meshes shared by the geometry tests, built with the primitive generators.
+
+namespace USTC_CG::test {
+
+struct TestMesh {
+    pxr::VtArray<pxr::GfVec3f> positions;
+    pxr::VtArray<int> counts;
+    pxr::VtArray<int> indices;
+};
+
+inline TestMesh from_primitive(const PrimitiveMesh& primitive)
+{
+    return { primitive.positions,
+             primitive.face_vertex_counts,
+             primitive.face_vertex_indices };
+}
+
+// Unit sphere around `center` with poles on the z axis, see
+// make_uv_sphere().
+inline TestMesh uv_sphere(
+    int segments,
+    int rings,
+    const pxr::GfVec3f& center = pxr::GfVec3f(0.0f))
+{
+    PrimitiveMesh primitive;
+    EXPECT_TRUE(make_uv_sphere(1.0f, segments, rings, primitive));
+    for (pxr::GfVec3f& p : primitive.positions) {
+        p += center;
+    }
+    return from_primitive(primitive);
+}
+
+inline TestMesh icosphere(int frequency, float radius = 1.0f)
+{
+    PrimitiveMesh primitive;
+    EXPECT_TRUE(make_icosphere(radius, frequency, primitive));
+    return from_primitive(primitive);
+}
+
+// cells x cells quads covering [0, size]^2 in the xy plane, facing +z.
+// Vertex (i, j) is at (j, i) * size / cells and has index i * (cells + 1) +
+// j; face (i, j) has index i * cells + j.
+inline TestMesh grid(int cells, float size = 1.0f)
+{
+    PrimitiveMesh primitive;
+    EXPECT_TRUE(make_grid(
+        pxr::GfVec3f(0.0f),
+        pxr::GfVec3f(0, size, 0),
+        pxr::GfVec3f(size, 0, 0),
+        cells,
+        cells,
+        primitive));
+    return from_primitive(primitive);
+}
+
+// Adds the vertices and faces of `other` to `mesh`.
+inline void append(TestMesh& mesh, const TestMesh& other)
+{
+    const int offset = int(mesh.positions.size());
+    mesh.positions.insert(
+        mesh.positions.end(), other.positions.begin(), other.positions.end());
+    mesh.counts.insert(
+        mesh.counts.end(), other.counts.begin(), other.counts.end());
+    for (int index : other.indices) {
+        mesh.indices.push_back(index + offset);
+    }
+}
+
+inline MeshTopology topology(const TestMesh& mesh)
+{
+    MeshTopology topology;
+    EXPECT_TRUE(topology.analyze(
+        mesh.counts, mesh.indices, mesh.positions.size(), 1));
+    return topology;
+}
+
+// Closed, manifold and consistently oriented, with the given Euler
+// characteristic.
+inline void expect_closed_manifold(const TestMesh& mesh, int64_t euler)
+{
+    const MeshTopology result = topology(mesh);
+    EXPECT_TRUE(result.is_closed());
+    EXPECT_TRUE(result.is_manifold());
+    EXPECT_EQ(result.inconsistent_edge_count(), 0u);
+    EXPECT_EQ(result.euler_characteristic(), euler);
+}
+
+}  // namespace USTC_CG::test